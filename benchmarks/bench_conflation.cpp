@@ -0,0 +1,142 @@
+/*
+Conflation stage vs. a plain bounded queue in front of a consumer that is slower than the feed.
+A producer thread plays the feed handler (quotes over the whole universe, every 50th message a trade), a
+consumer thread takes messages out at a fixed fraction of the feed rate.
+    conflated   Conflator: ratio of quotes in to quotes delivered, staleness of the delivered quotes,
+                trades are never conflated
+    queue       bounded SPSC queue of the same capacity that drops when full, i.e. what UDP does to a slow
+                reader today: fraction lost and how long the survivors waited
+
+Usage: bench_conflation [rate] [seconds] [symbols]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../src/feedhandler/Conflator.h"
+#include "../src/utils/CustomSpscQueue.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t queue_capacity = 65536;
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    double pct_us(std::vector<uint64_t> v, double p) {
+        if (v.empty()) return 0.0;
+        std::ranges::sort(v);
+        return static_cast<double>(v[static_cast<std::size_t>(p * static_cast<double>(v.size() - 1))]) / 1000.0;
+    }
+
+    // paced feed, push(msg, ts) per message; returns the number of quotes and trades sent
+    template <typename Push>
+    std::pair<uint64_t, uint64_t> produce(uint32_t rate, int seconds, uint32_t symbols, Push&& push) {
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::seconds(seconds);
+        const auto batch = std::max<uint32_t>(rate / 1000, 1);   // one batch per ms
+        uint64_t quotes = 0, trades = 0, i = 0;
+        auto next = start;
+        while (Clock::now() < end) {
+            for (uint32_t b = 0; b < batch; ++b, ++i) {
+                const auto id = static_cast<uint32_t>(1 + (i * 7919) % symbols);
+                if (i % 50 == 49) {
+                    types::Trade t{};
+                    t.symbol_id = id;
+                    t.price = static_cast<double>(i);
+                    push(t, now_ns());
+                    ++trades;
+                } else {
+                    types::Quote q{};
+                    q.symbol_id = id;
+                    q.bid_price = static_cast<double>(i);
+                    push(q, now_ns());
+                    ++quotes;
+                }
+            }
+            next += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(next);
+        }
+        return {quotes, trades};
+    }
+
+    // calls take(max) once per ms with the consumer's budget until done
+    template <typename Take>
+    void consume(uint32_t rate, const std::atomic<bool>& done, Take&& take) {
+        const std::size_t per_tick = std::max<uint32_t>(rate / 1000, 1);
+        auto next = Clock::now();
+        while (!done.load(std::memory_order_acquire)) {
+            take(per_tick);
+            next += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t rate = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 200'000;
+    const int seconds = argc > 2 ? std::atoi(argv[2]) : 2;
+    const uint32_t symbols = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 10'000;
+
+    std::printf("feed %u msg/s over %u symbols for %d s, consumer at a fraction of that, %u hardware threads\n",
+                rate, symbols, seconds, std::thread::hardware_concurrency());
+    std::printf("%-9s | %-48s | %-32s\n", "", "conflated", "drop-when-full queue");
+    std::printf("%-9s | %7s %11s %11s %7s %8s | %7s %11s %11s\n", "consumer", "ratio", "stale p50", "stale p99",
+                "trades", "dropped", "lost", "wait p50", "wait p99");
+
+    for (const double fraction : {1.0, 0.5, 0.25, 0.1}) {
+        const auto consumer_rate = static_cast<uint32_t>(rate * fraction);
+
+        // conflated
+        auto conflator = std::make_unique<BasicConflator<queue_capacity>>(symbols + 1);
+        std::atomic<bool> done{false};
+        uint64_t trades_out = 0;
+        std::thread c_consumer([&] {
+            consume(consumer_rate, done, [&](std::size_t n) {
+                conflator->drain([&](const auto& msg, uint64_t) {
+                    trades_out += std::is_same_v<std::decay_t<decltype(msg)>, types::Trade>;
+                }, n);
+            });
+        });
+        const auto [quotes_in, trades_in] = produce(rate, seconds, symbols, [&](const auto& msg, uint64_t ts) { conflator->push(msg, ts); });
+        done.store(true);
+        c_consumer.join();
+        const auto cs = conflator->stats();
+
+        // drop-when-full queue
+        struct Item {
+            types::MarketDataMsg msg;
+            uint64_t recv_ts;
+        };
+        auto queue = std::make_unique<CustomSpscQueue<Item, queue_capacity>>();
+        std::vector<uint64_t> waits;
+        waits.reserve(static_cast<std::size_t>(consumer_rate) * seconds + 1);
+        uint64_t lost = 0;
+        done.store(false);
+        std::thread q_consumer([&] {
+            consume(consumer_rate, done, [&](std::size_t n) {
+                Item item;
+                for (std::size_t k = 0; k < n && queue->pop(item); ++k) waits.push_back(now_ns() - item.recv_ts);
+            });
+        });
+        const auto [q_quotes, q_trades] = produce(rate, seconds, symbols, [&](const auto& msg, uint64_t ts) {
+            if (!queue->push(Item{msg, ts})) ++lost;
+        });
+        done.store(true);
+        q_consumer.join();
+
+        std::printf("%8.0f%% | %7.2f %9.1fus %9.1fus %6.0f%% %8llu | %6.1f%% %9.1fus %9.1fus\n",
+                    fraction * 100, cs.quotes_out ? static_cast<double>(quotes_in) / static_cast<double>(cs.quotes_out) : 0.0,
+                    pct_us(conflator->quote_staleness(), 0.5), pct_us(conflator->quote_staleness(), 0.99),
+                    trades_in ? 100.0 * static_cast<double>(trades_out) / static_cast<double>(trades_in) : 0.0,
+                    static_cast<unsigned long long>(cs.pass_through_dropped),
+                    100.0 * static_cast<double>(lost) / static_cast<double>(q_quotes + q_trades),
+                    pct_us(waits, 0.5), pct_us(waits, 0.99));
+    }
+    return 0;
+}
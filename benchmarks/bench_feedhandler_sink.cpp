@@ -0,0 +1,128 @@
+/*
+Per-message cost of handing a received packet to the consumer, without any sockets in the way.
+Packets are pre-encoded into one buffer the way the UDP feed handler lays them out, then pushed through
+IFeedHandler::deliver_packet (tag dispatch + receive timestamp + sink call) in a tight loop.
+
+    function / copy      the old path: payload memcpy'd into a stack struct, std::function callback
+    function / in place  std::function callback, payload viewed in the buffer
+    template / copy      inlined sink, payload copied
+    template / in place  inlined sink, payload viewed in the buffer
+
+Usage: bench_feedhandler_sink [messages] [repetitions]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../src/feedhandler/IFeedHandler.h"
+
+namespace {
+    // exposes the delivery path of the base, the receive loop is not needed here
+    template <typename Sink>
+    class BenchFeedHandler final : public IFeedHandler<BenchFeedHandler<Sink>, Sink> {
+    public:
+        explicit BenchFeedHandler(Sink sink = Sink{})
+            : IFeedHandler<BenchFeedHandler<Sink>, Sink>(std::move(sink)) {}
+
+        using IFeedHandler<BenchFeedHandler<Sink>, Sink>::deliver_packet;
+
+        void subscribe_impl(std::string_view) {}
+        void unsubscribe_impl(std::string_view) {}
+        void receive_loop_impl(std::stop_token) {}
+    };
+
+    struct Checksum {
+        double value{0};
+    };
+
+    struct TemplateSink {
+        Checksum* sum;
+
+        void operator()(const types::Quote& q, uint64_t ts) { sum->value += q.bid_price + static_cast<double>(ts & 1); }
+        void operator()(const types::Trade& t, uint64_t ts) { sum->value += t.price + static_cast<double>(ts & 1); }
+    };
+
+    struct Packets {
+        std::vector<std::byte> storage;
+        std::size_t stride{0};
+        std::size_t count{0};
+        std::size_t payload_offset{0};
+        std::size_t base{0};  // first packet, 64 byte aligned
+
+        const std::byte* packet(std::size_t i) const { return storage.data() + base + i * stride; }
+    };
+
+    // stride keeps every payload at payload_offset mod 16
+    Packets make_packets(std::size_t count, std::size_t payload_offset) {
+        Packets p;
+        p.stride = 128;
+        p.count = count;
+        p.payload_offset = payload_offset;
+        p.storage.resize(count * p.stride + 64);
+        p.base = (64 - reinterpret_cast<std::uintptr_t>(p.storage.data()) % 64) % 64;
+        std::byte* base = p.storage.data() + p.base;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            std::byte* packet = base + i * p.stride;
+            if (i % 4 == 3) {
+                types::Trade t{};
+                std::strncpy(t.symbol, "MSFT", sizeof(t.symbol) - 1);
+                t.price = 400.0 + static_cast<double>(i % 100);
+                types::Messages::encode_topic(t, reinterpret_cast<char*>(packet));
+                std::memcpy(packet + payload_offset, &t, sizeof(t));
+                packet[payload_offset - 1] = static_cast<std::byte>(sizeof(t));
+            } else {
+                types::Quote q{};
+                std::strncpy(q.symbol, "AAPL", sizeof(q.symbol) - 1);
+                q.bid_price = 180.0 + static_cast<double>(i % 100);
+                types::Messages::encode_topic(q, reinterpret_cast<char*>(packet));
+                std::memcpy(packet + payload_offset, &q, sizeof(q));
+                packet[payload_offset - 1] = static_cast<std::byte>(sizeof(q));
+            }
+        }
+        return p;
+    }
+
+    template <typename Handler>
+    double run(Handler& handler, const Packets& packets, int repetitions) {
+        double best = 1e300;
+        for (int r = 0; r < repetitions; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < packets.count; ++i) {
+                const std::byte* packet = packets.packet(i);
+                const auto size = static_cast<std::size_t>(packet[packets.payload_offset - 1]);
+                handler.deliver_packet(static_cast<char>(packet[0]), packet + packets.payload_offset, size);
+            }
+            const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+            best = std::min(best, elapsed.count() / static_cast<double>(packets.count));
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::size_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+    const int repetitions = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    // the byte in front of the payload carries its size, the topic only uses the first 10 bytes
+    const Packets unaligned = make_packets(messages, 17);  // payload at 1 mod 16, forces the copy
+    const Packets aligned = make_packets(messages, 32);
+
+    Checksum sum;
+    BenchFeedHandler<FunctionSink> function_handler;
+    function_handler.set_quote_callback([&sum](const types::Quote& q, uint64_t ts) { sum.value += q.bid_price + static_cast<double>(ts & 1); });
+    function_handler.set_trade_callback([&sum](const types::Trade& t, uint64_t ts) { sum.value += t.price + static_cast<double>(ts & 1); });
+    BenchFeedHandler<TemplateSink> template_handler(TemplateSink{&sum});
+
+    std::printf("%-22s %10s\n", "path", "ns/msg");
+    std::printf("%-22s %10.2f\n", "function / copy", run(function_handler, unaligned, repetitions));
+    std::printf("%-22s %10.2f\n", "function / in place", run(function_handler, aligned, repetitions));
+    std::printf("%-22s %10.2f\n", "template / copy", run(template_handler, unaligned, repetitions));
+    std::printf("%-22s %10.2f\n", "template / in place", run(template_handler, aligned, repetitions));
+    std::printf("(checksum %.1f)\n", sum.value);
+    return 0;
+}
@@ -0,0 +1,268 @@
+/*
+Load test for the TCP subscriber gateway: opens many client connections, subscribes each to everything and
+reports fan-out latency, gateway receive (FrameHeader::gateway_ts) to the client having read the frame.
+Client and gateway share the steady clock, so both have to run on the same host.
+
+By default the gateway runs in-process and a publisher thread feeds it quotes at the given rate, standing in for
+the feed handler thread. With a port it connects to a running md_gateway instead and the real feed drives it.
+Slow clients connect and subscribe like the others but never read, to exercise the slow-client policy.
+
+Usage: bench_gateway_fanout [clients] [rate] [seconds] [policy] [loops] [slow_clients] [gateway_port]
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/gateway/TcpGateway.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    // log-linear buckets, 32 per power of two: about 3% resolution without keeping every sample
+    class Histogram {
+    public:
+        void add(uint64_t ns) {
+            ++buckets_[index(ns)];
+            ++count_;
+            max_ = std::max(max_, ns);
+        }
+
+        void merge(const Histogram& other) {
+            for (std::size_t i = 0; i < buckets_.size(); ++i) buckets_[i] += other.buckets_[i];
+            count_ += other.count_;
+            max_ = std::max(max_, other.max_);
+        }
+
+        [[nodiscard]] uint64_t percentile(double p) const {
+            const auto rank = static_cast<uint64_t>(p * static_cast<double>(count_));
+            uint64_t seen = 0;
+            for (std::size_t i = 0; i < buckets_.size(); ++i) {
+                seen += buckets_[i];
+                if (seen > rank) return lower_bound(i);
+            }
+            return max_;
+        }
+
+        [[nodiscard]] uint64_t count() const { return count_; }
+        [[nodiscard]] uint64_t max() const { return max_; }
+
+    private:
+        static constexpr int sub_bits = 5;
+
+        static std::size_t index(uint64_t v) {
+            if (v < (1u << sub_bits)) return v;
+            const int exp = std::bit_width(v) - 1 - sub_bits;
+            return static_cast<std::size_t>((exp + 1) << sub_bits) + ((v >> exp) & ((1u << sub_bits) - 1));
+        }
+
+        static uint64_t lower_bound(std::size_t i) {
+            if (i < (1u << sub_bits)) return i;
+            const int exp = static_cast<int>(i >> sub_bits) - 1;
+            return ((uint64_t{1} << sub_bits) | (i & ((1u << sub_bits) - 1))) << exp;
+        }
+
+        std::array<uint64_t, 64 << sub_bits> buckets_{};
+        uint64_t count_{0};
+        uint64_t max_{0};
+    };
+
+    int connect_client(unsigned short port, int rcvbuf) {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (rcvbuf > 0) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        const char sub[] = "SUB *\n";
+        if (send(fd, sub, sizeof(sub) - 1, 0) != static_cast<ssize_t>(sizeof(sub) - 1)) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    struct Connection {
+        int fd;
+        std::vector<char> buffer = std::vector<char>(256 * 1024);
+        std::size_t filled{0};
+        bool open{true};
+    };
+
+    // one thread reading a share of the connections through its own epoll
+    void read_clients(std::vector<Connection*> connections, const std::atomic<bool>& done, Histogram& latency,
+                      uint64_t& frames, uint64_t& closed) {
+        const int ep = epoll_create1(0);
+        for (Connection* c : connections) {
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.ptr = c;
+            epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+        }
+
+        epoll_event events[64];
+        while (!done.load(std::memory_order_relaxed)) {
+            const int n = epoll_wait(ep, events, 64, 50);
+            for (int i = 0; i < n; ++i) {
+                auto* c = static_cast<Connection*>(events[i].data.ptr);
+                const ssize_t got = recv(c->fd, c->buffer.data() + c->filled, c->buffer.size() - c->filled, MSG_DONTWAIT);
+                if (got <= 0) {
+                    if (got == 0 || (errno != EAGAIN && errno != EINTR)) {
+                        epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, nullptr);
+                        c->open = false;
+                        ++closed;
+                    }
+                    continue;
+                }
+                const uint64_t t = now_ns();
+                c->filled += static_cast<std::size_t>(got);
+
+                std::size_t at = 0;
+                while (c->filled - at >= sizeof(gateway::FrameHeader)) {
+                    gateway::FrameHeader header;
+                    std::memcpy(&header, c->buffer.data() + at, sizeof(header));
+                    const std::size_t size = sizeof(header) + types::topic_header_size + header.payload_size;
+                    if (c->filled - at < size) break;
+                    latency.add(t > header.gateway_ts ? t - header.gateway_ts : 0);
+                    ++frames;
+                    at += size;
+                }
+                std::memmove(c->buffer.data(), c->buffer.data() + at, c->filled - at);
+                c->filled -= at;
+            }
+        }
+        close(ep);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int clients = argc > 1 ? std::atoi(argv[1]) : 200;
+    const uint32_t rate = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 20'000;
+    const int seconds = argc > 3 ? std::atoi(argv[3]) : 5;
+    const auto policy = gateway::parse_policy(argc > 4 ? argv[4] : "disconnect");
+    const std::size_t loops = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 2;
+    const int slow_clients = argc > 6 ? std::atoi(argv[6]) : 0;
+    const auto external_port = static_cast<unsigned short>(argc > 7 ? std::atoi(argv[7]) : 0);
+    if (!policy) {
+        std::fprintf(stderr, "policy must be disconnect, conflate or block\n");
+        return 1;
+    }
+
+    std::unique_ptr<TcpGateway> gw;
+    unsigned short port = external_port;
+    if (external_port == 0) {
+        GatewayConfig config;
+        config.loops = loops;
+        config.policy = *policy;
+        config.client_buffer_bytes = 64 * 1024;
+        config.socket_send_buffer = 64 * 1024;
+        gw = std::make_unique<TcpGateway>(config);
+        gw->start();
+        port = gw->port();
+    }
+
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (int i = 0; i < clients; ++i) {
+        const int fd = connect_client(port, 0);
+        if (fd < 0) {
+            std::fprintf(stderr, "connection %d failed\n", i);
+            return 1;
+        }
+        connections.push_back(std::make_unique<Connection>(Connection{fd}));
+    }
+    std::vector<int> slow;
+    for (int i = 0; i < slow_clients; ++i) slow.push_back(connect_client(port, 4096));
+    if (gw) {
+        while (gw->stats().clients < static_cast<uint64_t>(clients + slow_clients)) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));   // subscriptions applied
+
+    const std::size_t reader_threads = std::min<std::size_t>(4, connections.size());
+    std::vector<Histogram> latencies(reader_threads);
+    std::vector<uint64_t> frames(reader_threads, 0), closed(reader_threads, 0);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (std::size_t t = 0; t < reader_threads; ++t) {
+        std::vector<Connection*> share;
+        for (std::size_t i = t; i < connections.size(); i += reader_threads) share.push_back(connections[i].get());
+        readers.emplace_back(read_clients, std::move(share), std::cref(done), std::ref(latencies[t]), std::ref(frames[t]), std::ref(closed[t]));
+    }
+
+    uint64_t published = 0;
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::seconds(seconds);
+    if (gw) {
+        // paced publisher standing in for the feed handler thread
+        const auto interval = std::chrono::nanoseconds(1'000'000'000 / std::max<uint32_t>(rate, 1));
+        auto next = start;
+        while (Clock::now() < end) {
+            types::Quote q{};
+            std::snprintf(q.symbol, sizeof(q.symbol), "S%u", static_cast<unsigned>(published % 1000));
+            q.symbol_id = static_cast<uint32_t>(published % 1000 + 1);
+            q.bid_price = static_cast<double>(published);
+            gw->publish(q, now_ns());
+            ++published;
+            next += interval;
+            if (next > Clock::now()) std::this_thread::sleep_until(next);
+        }
+    } else {
+        std::this_thread::sleep_until(end);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));   // let the backlog drain
+    done.store(true);
+    for (auto& r : readers) r.join();
+
+    Histogram all;
+    uint64_t total_frames = 0, total_closed = 0;
+    for (std::size_t t = 0; t < reader_threads; ++t) {
+        all.merge(latencies[t]);
+        total_frames += frames[t];
+        total_closed += closed[t];
+    }
+
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    std::printf("%d clients (+%d slow), %s policy, %zu loop(s), %u msg/s for %d s, %u hardware threads\n",
+                clients, slow_clients, argc > 4 ? argv[4] : "disconnect", loops, rate, seconds,
+                std::thread::hardware_concurrency());
+    if (gw) std::printf("published %llu, ", static_cast<unsigned long long>(published));
+    std::printf("received %llu frames (%.0f per client per second), %llu reading clients disconnected\n",
+                static_cast<unsigned long long>(total_frames),
+                static_cast<double>(total_frames) / clients / seconds, static_cast<unsigned long long>(total_closed));
+    std::printf("fan-out latency us: p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                us(all.percentile(0.5)), us(all.percentile(0.9)), us(all.percentile(0.99)),
+                us(all.percentile(0.999)), us(all.max()));
+    if (gw) {
+        const auto s = gw->stats();
+        std::printf("gateway: %llu frames in %llu writev calls (%.1f per call), conflated %llu, slow disconnects %llu, dropped %llu, blocked %.1f ms\n",
+                    static_cast<unsigned long long>(s.frames), static_cast<unsigned long long>(s.writev_calls),
+                    s.writev_calls ? static_cast<double>(s.frames) / static_cast<double>(s.writev_calls) : 0.0,
+                    static_cast<unsigned long long>(s.conflated), static_cast<unsigned long long>(s.slow_disconnects),
+                    static_cast<unsigned long long>(s.dropped), static_cast<double>(s.blocked_ns) / 1e6);
+        gw->stop();
+    }
+    for (auto& c : connections) close(c->fd);
+    for (const int fd : slow) close(fd);
+    return 0;
+}
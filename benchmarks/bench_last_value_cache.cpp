@@ -0,0 +1,123 @@
+/*
+Last value cache over a 10k symbol universe.
+    writer      ns per update into the seqlock cache vs a plain array copy (what the cache costs the receive thread)
+    readers     reads per second per reader thread, with the writer idle and with it updating as fast as it can
+
+Symbols are picked at random on both sides, so readers hit the slot being written only as often as a real
+snapshot consumer would. On a single core box the loaded numbers mostly measure the scheduler.
+
+Usage: bench_last_value_cache [symbols] [max_readers]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/feedhandler/LastValueCache.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<uint32_t> random_ids(uint32_t symbols, std::size_t n, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<uint32_t> pick(1, symbols);
+        std::vector<uint32_t> ids(n);
+        for (auto& id : ids) id = pick(rng);
+        return ids;
+    }
+
+    types::Quote make_quote(uint32_t id, uint64_t i) {
+        types::Quote q{};
+        q.symbol_id = id;
+        q.bid_price = static_cast<double>(i);
+        q.ask_price = static_cast<double>(i) + 0.01;
+        q.enqueue_timestamp = i;
+        return q;
+    }
+
+    template <typename Fn>
+    double ns_per_op(std::size_t n, Fn&& fn) {
+        double best = 1e300;
+        for (int rep = 0; rep < 5; ++rep) {
+            const auto start = Clock::now();
+            fn();
+            best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(n));
+        }
+        return best;
+    }
+
+    // reads per second per reader, averaged over the readers
+    double run_readers(LastValueCache<types::Quote>& cache, uint32_t symbols, int readers, bool with_writer) {
+        std::atomic<bool> done{false};
+        std::atomic<uint64_t> total{0};
+        std::atomic<uint64_t> found{0};
+        std::vector<std::thread> threads;
+
+        std::thread writer;
+        if (with_writer) {
+            writer = std::thread([&] {
+                const std::vector<uint32_t> ids = random_ids(symbols, 1 << 16, 99);
+                uint64_t i = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    const uint32_t id = ids[i++ & (ids.size() - 1)];
+                    cache.store(id, make_quote(id, i));
+                }
+            });
+        }
+
+        for (int r = 0; r < readers; ++r) {
+            threads.emplace_back([&, r] {
+                const std::vector<uint32_t> ids = random_ids(symbols, 1 << 16, 1000 + r);
+                types::Quote q{};
+                uint64_t n = 0, sink = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    for (int k = 0; k < 1024; ++k) {
+                        sink += cache.read(ids[n++ & (ids.size() - 1)], q);
+                    }
+                }
+                total.fetch_add(n, std::memory_order_relaxed);
+                found.fetch_add(sink, std::memory_order_relaxed);
+            });
+        }
+
+        const double seconds = 0.5;
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        done.store(true);
+        for (auto& t : threads) t.join();
+        if (writer.joinable()) writer.join();
+        if (found.load() == 0) std::fprintf(stderr, "cache is empty\n");
+        return static_cast<double>(total.load()) / seconds / readers;
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t symbols = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 10'000;
+    const int max_readers = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    LastValueCache<types::Quote> cache(symbols + 1);
+    std::vector<types::Quote> plain(symbols + 1);
+
+    const std::size_t updates = 2'000'000;
+    const std::vector<uint32_t> ids = random_ids(symbols, updates, 7);
+    const double t_cache = ns_per_op(updates, [&] {
+        for (std::size_t i = 0; i < updates; ++i) cache.store(ids[i], make_quote(ids[i], i));
+    });
+    const double t_plain = ns_per_op(updates, [&] {
+        for (std::size_t i = 0; i < updates; ++i) plain[ids[i]] = make_quote(ids[i], i);
+    });
+
+    std::printf("%u symbols, %zu byte quote, %u hardware threads\n", symbols, sizeof(types::Quote),
+                std::thread::hardware_concurrency());
+    std::printf("writer: seqlock %.2f ns/update, plain copy %.2f ns/update\n", t_cache, t_plain);
+    std::printf("%-8s %16s %16s   (reads/s per reader)\n", "readers", "writer idle", "writer busy");
+    for (int readers = 1; readers <= max_readers; readers *= 2) {
+        const double idle = run_readers(cache, symbols, readers, false);
+        const double busy = run_readers(cache, symbols, readers, true);
+        std::printf("%-8d %16.3e %16.3e\n", readers, idle, busy);
+    }
+    return 0;
+}
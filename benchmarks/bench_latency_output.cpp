@@ -0,0 +1,76 @@
+/*
+What writing the latency records costs, CSV at the end vs. binary columns streamed while the run goes.
+    csv      LatencyMonitor as before: records kept in vectors, save_to_csv() formats them at shutdown
+    binary   stream_binary(): records go into column blocks a writer thread pwrite()s, shutdown only writes the
+             last block
+Records come in batches paced to a feed rate, like a consumer would see them. For each: ns per record on the
+recording thread (the batches only, not the waits between them), how long shutdown takes and the size of the
+output. The binary writer logs a warning if it fell behind and dropped records.
+
+Usage: bench_latency_output [records] [rate] [out_dir]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include "../src/monitor/LatencyMonitor.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point t) { return std::chrono::duration<double>(Clock::now() - t).count(); }
+
+    uint64_t size_of(const std::filesystem::path& dir) {
+        uint64_t bytes = 0;
+        for (const auto& e : std::filesystem::directory_iterator(dir)) bytes += e.file_size();
+        return bytes;
+    }
+
+    void run(const char* name, uint64_t records, uint64_t rate, const std::filesystem::path& dir, bool binary) {
+        std::filesystem::remove_all(dir);
+        double record_s = 0.0, shutdown_s = 0.0;
+        {
+            LatencyMonitor monitor(binary ? 0 : records, dir.string());
+            if (binary) monitor.stream_binary(dir / "latencies.mdlat");
+            types::Quote q{};
+            constexpr uint64_t batch = 1000;
+            const auto batch_interval = std::chrono::nanoseconds(batch * 1'000'000'000 / rate);
+            auto next = Clock::now();
+            for (uint64_t i = 1; i <= records;) {
+                const auto start = Clock::now();
+                for (const uint64_t end = std::min(i + batch, records + 1); i < end; ++i) {
+                    q.sequence = i;
+                    q.symbol_id = static_cast<uint32_t>(i % 500);
+                    q.enqueue_timestamp = i * 1000;
+                    q.disseminate_timestamp = q.enqueue_timestamp + 300 + i % 97;
+                    monitor.on_quote(q, q.disseminate_timestamp + 5000 + i % 1013);
+                }
+                record_s += seconds_since(start);
+                next += batch_interval;
+                std::this_thread::sleep_until(next);
+            }
+            const auto stop = Clock::now();
+            monitor.save_to_csv();
+            shutdown_s = seconds_since(stop);
+        }
+        std::printf("%-8s %8.1f ns/record   shutdown %8.3f s   %8.1f MiB\n", name, record_s * 1e9 / static_cast<double>(records),
+                    shutdown_s, static_cast<double>(size_of(dir)) / (1024.0 * 1024.0));
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint64_t records = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    const uint64_t rate = argc > 2 ? std::max<uint64_t>(std::strtoull(argv[2], nullptr, 10), 1000) : 2'000'000;
+    const std::filesystem::path out = argc > 3 ? argv[3] : std::filesystem::temp_directory_path() / "bench_latency_output";
+    spdlog::set_level(spdlog::level::warn);
+
+    std::printf("%lu quote records at %lu/s\n", static_cast<unsigned long>(records), static_cast<unsigned long>(rate));
+    run("csv", records, rate, out / "csv", false);
+    run("binary", records, rate, out / "binary", true);
+    std::filesystem::remove_all(out);
+    return 0;
+}
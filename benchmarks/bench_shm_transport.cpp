@@ -0,0 +1,213 @@
+/*
+Shared memory ring against UDP multicast over loopback, same host, same message.
+A writer thread publishes quotes at a fixed rate (1 ms batches), reader threads poll and record the one-way
+latency from the publish call to having the message in hand. Readers are threads here, a reader in another
+process maps the same segment and behaves the same.
+    shm   ShmRingWriter::publish -> ShmRingReader::poll, 1..N readers on one ring
+    udp   sendto on a multicast socket -> recvfrom, one receiving socket per reader
+Reports per reader: delivered fraction (lapped records for shm, drops for udp), p50/p99/p99.9.
+
+Usage: bench_shm_transport [rate] [seconds] [max_readers] [slots]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/shm/ShmRing.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    constexpr const char* mcast_group = "239.192.1.77";
+    constexpr unsigned short mcast_port = 5677;
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    struct Result {
+        std::vector<uint64_t> latency_ns;
+        uint64_t received{0};
+    };
+
+    double pct_us(const std::vector<uint64_t>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        return static_cast<double>(sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))]) / 1000.0;
+    }
+
+    // calls send(quote) rate times a second for the given time, returns how many were sent
+    template <typename Send>
+    uint64_t pace(uint32_t rate, int seconds, Send&& send) {
+        types::Quote q{};
+        std::memcpy(q.symbol, "BENCH", 5);
+        q.symbol_id = 1;
+        const auto batch = std::max<uint32_t>(rate / 1000, 1);
+        const auto end = Clock::now() + std::chrono::seconds(seconds);
+        auto next = Clock::now();
+        uint64_t sent = 0;
+        while (Clock::now() < end) {
+            for (uint32_t b = 0; b < batch; ++b) {
+                q.sequence = ++sent;
+                q.disseminate_timestamp = now_ns();
+                send(q);
+            }
+            next += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(next);
+        }
+        return sent;
+    }
+
+    void report(const char* transport, int readers, uint64_t sent, std::vector<Result>& results) {
+        uint64_t worst = sent;
+        std::vector<uint64_t> all;
+        for (Result& r : results) {
+            worst = std::min(worst, r.received);
+            all.insert(all.end(), r.latency_ns.begin(), r.latency_ns.end());
+        }
+        std::ranges::sort(all);
+        std::printf("%-5s %7d %9.2f%% %10.2f %10.2f %10.2f\n", transport, readers,
+                    sent ? 100.0 * static_cast<double>(worst) / static_cast<double>(sent) : 0.0,
+                    pct_us(all, 0.5), pct_us(all, 0.99), pct_us(all, 0.999));
+    }
+
+    void run_shm(uint32_t rate, int seconds, int readers, uint64_t slots) {
+        const std::string name = "/mdds_bench_shm_" + std::to_string(getpid());
+        ShmRingWriter writer(name, slots);
+        std::vector<Result> results(readers);
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < readers; ++i) {
+            threads.emplace_back([&, i] {
+                ShmRingReader reader(name);
+                Result& r = results[i];
+                r.latency_ns.reserve(static_cast<std::size_t>(rate) * seconds);
+                auto take = [&](char, const char*, const std::byte* payload, std::size_t) {
+                    types::Quote q;
+                    std::memcpy(&q, payload, sizeof(q));
+                    r.latency_ns.push_back(now_ns() - q.disseminate_timestamp);
+                };
+                while (!done.load(std::memory_order_acquire)) {
+                    if (reader.poll(take) == 0) std::this_thread::yield();
+                }
+                reader.poll(take, ~std::size_t{0});
+                r.received = reader.received();
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        char topic[types::topic_header_size];
+        const uint64_t sent = pace(rate, seconds, [&](const types::Quote& q) {
+            types::Messages::encode_topic(q, topic);
+            writer.publish(topic, &q, sizeof(q));
+        });
+        done.store(true, std::memory_order_release);
+        for (auto& t : threads) t.join();
+        report("shm", readers, sent, results);
+    }
+
+    int udp_receiver() {
+        const int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        int opt = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        int rcv_buf = 1024 * 1024 * 8;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcv_buf, sizeof(rcv_buf));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(mcast_port);
+        ip_mreq mreq{};
+        inet_pton(AF_INET, mcast_group, &mreq.imr_multiaddr.s_addr);
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            close(fd);
+            return -1;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        return fd;
+    }
+
+    void run_udp(uint32_t rate, int seconds, int readers) {
+        std::vector<int> fds;
+        for (int i = 0; i < readers; ++i) {
+            const int fd = udp_receiver();
+            if (fd < 0) {
+                std::printf("udp   %7d  no multicast on this host\n", readers);
+                for (const int f : fds) close(f);
+                return;
+            }
+            fds.push_back(fd);
+        }
+        const int out = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        unsigned char loop = 1;
+        setsockopt(out, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        sockaddr_in dest{};
+        dest.sin_family = AF_INET;
+        dest.sin_port = htons(mcast_port);
+        inet_pton(AF_INET, mcast_group, &dest.sin_addr);
+
+        std::vector<Result> results(readers);
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < readers; ++i) {
+            threads.emplace_back([&, i] {
+                Result& r = results[i];
+                r.latency_ns.reserve(static_cast<std::size_t>(rate) * seconds);
+                alignas(16) std::byte buf[256];
+                auto take = [&] {
+                    const ssize_t n = recv(fds[i], buf, sizeof(buf), 0);
+                    if (n < static_cast<ssize_t>(types::topic_header_size + sizeof(types::Quote))) return false;
+                    types::Quote q;
+                    std::memcpy(&q, buf + types::topic_header_size, sizeof(q));
+                    r.latency_ns.push_back(now_ns() - q.disseminate_timestamp);
+                    ++r.received;
+                    return true;
+                };
+                while (!done.load(std::memory_order_acquire)) {
+                    if (!take()) std::this_thread::yield();
+                }
+                while (take()) {}
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        char datagram[types::topic_header_size + sizeof(types::Quote)];
+        const uint64_t sent = pace(rate, seconds, [&](const types::Quote& q) {
+            types::Messages::encode_topic(q, datagram);
+            std::memcpy(datagram + types::topic_header_size, &q, sizeof(q));
+            sendto(out, datagram, sizeof(datagram), 0, reinterpret_cast<const sockaddr*>(&dest), sizeof(dest));
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        done.store(true, std::memory_order_release);
+        for (auto& t : threads) t.join();
+        close(out);
+        for (const int fd : fds) close(fd);
+        report("udp", readers, sent, results);
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t rate = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 100'000;
+    const int seconds = argc > 2 ? std::atoi(argv[2]) : 2;
+    const int max_readers = argc > 3 ? std::atoi(argv[3]) : 4;
+    const uint64_t slots = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 65536;
+
+    std::printf("%u quotes/s for %d s, ring of %llu slots (%zu KiB), %u hardware threads\n", rate, seconds,
+                static_cast<unsigned long long>(slots), shm::segment_size(slots) >> 10, std::thread::hardware_concurrency());
+    std::printf("%-5s %7s %10s %10s %10s %10s\n", "", "readers", "delivered", "p50 us", "p99 us", "p99.9 us");
+    for (int readers = 1; readers <= max_readers; readers *= 2) run_shm(rate, seconds, readers, slots);
+    for (int readers = 1; readers <= max_readers; readers *= 2) run_udp(rate, seconds, readers);
+    return 0;
+}
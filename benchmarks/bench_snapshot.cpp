@@ -0,0 +1,136 @@
+/*
+Late-join snapshot for the whole universe, one quote and one trade per symbol.
+    build       server side: read every symbol out of the seqlock caches into the response buffer
+    transfer    client side: request over loopback TCP until the last byte is in (includes build)
+    splice      receive side: filter and deliver every record through the registry dispatch
+
+Build is measured with the disseminator idle and with a thread recording updates as fast as it can.
+
+Usage: bench_snapshot [symbols_file] [rounds]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/feedhandler/SnapshotSplicer.h"
+#include "../src/feedhandler/SubscriptionFilter.h"
+#include "../src/snapshot/SnapshotClient.h"
+#include "../src/snapshot/SnapshotServer.h"
+#include "../src/utils/SymbolDirectory.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double micros(Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); }
+
+    double percentile(std::vector<double> v, double p) {
+        std::ranges::sort(v);
+        return v[static_cast<std::size_t>(p * static_cast<double>(v.size() - 1))];
+    }
+
+    // one quote and one trade per symbol, returns the last sequence
+    uint64_t record_universe(SnapshotServer& server, const SymbolDirectory& directory, uint64_t sequence) {
+        for (uint32_t id = 1; id < directory.id_limit(); ++id) {
+            types::Quote q{};
+            const std::string& symbol = directory.symbol(id);
+            std::memcpy(q.symbol, symbol.data(), std::min(symbol.size(), sizeof(q.symbol)));
+            q.symbol_id = id;
+            q.sequence = ++sequence;
+            q.bid_price = 100.0;
+            q.ask_price = 100.01;
+            server.record(q);
+
+            types::Trade t{};
+            std::memcpy(t.symbol, q.symbol, sizeof(t.symbol));
+            t.symbol_id = id;
+            t.sequence = ++sequence;
+            t.price = 100.0;
+            server.record(t);
+        }
+        return sequence;
+    }
+
+    struct Summary {
+        double p50;
+        double p99;
+    };
+
+    template <typename Fn>
+    Summary time_rounds(int rounds, Fn&& fn) {
+        std::vector<double> us;
+        for (int i = 0; i < rounds; ++i) {
+            const auto start = Clock::now();
+            fn();
+            us.push_back(micros(Clock::now() - start));
+        }
+        return {percentile(us, 0.5), percentile(us, 0.99)};
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> symbols = SymbolDirectory::read_file(argc > 1 ? argv[1] : "../data/tickers.txt");
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 50;
+    if (symbols.empty()) {
+        for (int i = 0; i < 10'000; ++i) symbols.push_back("S" + std::to_string(i));
+    }
+    const SymbolDirectory directory(std::move(symbols));
+
+    SnapshotServer server(0, directory.id_limit());
+    uint64_t sequence = record_universe(server, directory, 0);
+    server.start();
+
+    std::vector<std::byte> buffer;
+    snapshot::ResponseHeader header{};
+    const Summary build_idle = time_rounds(rounds, [&] {
+        buffer.clear();
+        header = server.build(buffer);
+    });
+
+    // a writer updating random symbols while the snapshot is read, readers retry on the slots it hits
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        uint64_t seq = sequence;
+        while (!done.load(std::memory_order_relaxed)) seq = record_universe(server, directory, seq);
+    });
+    const Summary build_busy = time_rounds(rounds, [&] {
+        buffer.clear();
+        (void)server.build(buffer);
+    });
+    done.store(true);
+    writer.join();
+
+    snapshot::Snapshot received;
+    const Summary transfer = time_rounds(rounds, [&] { received = snapshot::fetch("127.0.0.1", server.port()); });
+    server.stop();
+
+    SubscriptionFilter filter;
+    filter.add("*");
+    filter.seal(1);
+    std::size_t delivered = 0;
+    double splice_best = 1e300;
+    for (int i = 0; i < rounds; ++i) {
+        SnapshotSplicer splicer;
+        splicer.begin();
+        splicer.hand_over(received);
+        const auto start = Clock::now();
+        delivered = 0;
+        splicer.splice(filter, [&](char tag, const void* payload, std::size_t size) {
+            types::Messages::dispatch(tag, payload, size, [&](const auto& msg) { delivered += msg.symbol_id != 0; });
+        });
+        splice_best = std::min(splice_best, micros(Clock::now() - start));
+    }
+
+    std::printf("%zu symbols, %u records, %.1f KiB per snapshot\n", directory.size(), header.record_count,
+                static_cast<double>(header.payload_bytes + sizeof(header)) / 1024.0);
+    std::printf("build (writer idle):  p50 %8.1f us, p99 %8.1f us\n", build_idle.p50, build_idle.p99);
+    std::printf("build (writer busy):  p50 %8.1f us, p99 %8.1f us\n", build_busy.p50, build_busy.p99);
+    std::printf("request + transfer:   p50 %8.1f us, p99 %8.1f us\n", transfer.p50, transfer.p99);
+    std::printf("splice:               best %7.1f us (%zu records delivered)\n", splice_best, delivered);
+    return 0;
+}
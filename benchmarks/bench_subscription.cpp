@@ -0,0 +1,107 @@
+/*
+Subscription startup and update cost for a whole symbol universe.
+    startup     bulk subscribe of every symbol: build the filter off-thread, publish, receive thread picks it up
+    update      one symbol added to the full filter (copy-on-write), until the receive thread sees it
+    match       per packet filter check on the receive side, hit and miss
+
+A reader thread spins on FilterPublisher::acquire() like a busy receive loop would.
+
+Usage: bench_subscription [symbols_file] [update_rounds]
+ */
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/feedhandler/SubscriptionFilter.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double micros(Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); }
+
+    std::vector<std::string> load_universe(const char* path) {
+        std::vector<std::string> symbols;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::erase_if(line, [](unsigned char c) { return std::isspace(c); });
+            if (!line.empty() && line.size() < 9) symbols.push_back(line);
+        }
+        if (symbols.empty()) {
+            // no file, synthesise a universe of the same size
+            for (int i = 0; i < 10'000; ++i) symbols.push_back("S" + std::to_string(i));
+        }
+        return symbols;
+    }
+
+    double percentile(std::vector<double> v, double p) {
+        std::ranges::sort(v);
+        return v[static_cast<std::size_t>(p * static_cast<double>(v.size() - 1))];
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::vector<std::string> universe = load_universe(argc > 1 ? argv[1] : "../data/tickers.txt");
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    FilterPublisher publisher;
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            (void)publisher.acquire();
+        }
+    });
+
+    auto wait_applied = [&](uint64_t generation) {
+        while (publisher.acknowledged_generation() < generation) std::this_thread::yield();
+        return Clock::now();
+    };
+
+    // startup
+    const auto start = Clock::now();
+    const uint64_t gen = publisher.update([&](SubscriptionFilter& f) { for (const auto& s : universe) f.add(s); });
+    const auto published = Clock::now();
+    const auto applied = wait_applied(gen);
+    std::printf("universe: %zu symbols\n", universe.size());
+    std::printf("startup: published %.1f us, live %.1f us\n", micros(published - start), micros(applied - start));
+
+    // single symbol updates against the full filter
+    std::vector<double> publish_us, live_us;
+    for (int i = 0; i < rounds; ++i) {
+        const std::string extra = "ZZ" + std::to_string(i);
+        const auto t0 = Clock::now();
+        const uint64_t g = publisher.update([&](SubscriptionFilter& f) { f.add(extra); });
+        const auto t1 = Clock::now();
+        const auto t2 = wait_applied(g);
+        publish_us.push_back(micros(t1 - t0));
+        live_us.push_back(micros(t2 - t0));
+    }
+    std::printf("update publish: p50 %.1f us, p99 %.1f us\n", percentile(publish_us, 0.5), percentile(publish_us, 0.99));
+    std::printf("update live:    p50 %.1f us, p99 %.1f us\n", percentile(live_us, 0.5), percentile(live_us, 0.99));
+
+    done.store(true);
+    reader.join();
+
+    // receive side check, half the probes are subscribed
+    const SubscriptionFilter& filter = publisher.acquire();
+    std::vector<uint64_t> probes;
+    std::mt19937 rng(42);
+    for (int i = 0; i < 1'000'000; ++i) {
+        probes.push_back(i % 2 ? pack_symbol(universe[rng() % universe.size()]) : pack_symbol("NOPE" + std::to_string(i % 1000)));
+    }
+    std::size_t hits = 0;
+    const auto m0 = Clock::now();
+    for (const uint64_t p : probes) hits += filter.matches('Q', p);
+    const auto m1 = Clock::now();
+    std::printf("match: %.2f ns/packet (%zu hits)\n",
+                std::chrono::duration<double, std::nano>(m1 - m0).count() / static_cast<double>(probes.size()), hits);
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+UDP disseminator -> feed handler over loopback multicast, by kernel I/O mode (see src/utils/UdpIo.h).
+    syscall          sendto / recvfrom, one syscall per datagram
+    batched          sendmmsg / recvmmsg, up to batch datagrams per syscall
+    io_uring         WRITE_FIXED sends submitted batch at a time, multishot recv into provided buffers
+    io_uring+sqpoll  same, a kernel thread polls the SQs
+    +gso / +gro      runs of equal sized datagrams sent as one UDP_SEGMENT buffer / received coalesced (UDP_GRO)
+    +timestamps      software SO_TIMESTAMPING on both sockets, what collecting the stage split costs
+The stream is quotes with a trade every 50th message (a trade cuts a GSO run). The queue is fed in 1 ms bursts
+of rate/1000 messages, rate 0 floods it instead. Latency is disseminate stamp -> feed handler callback.
+Reports syscalls per message on each side (the receive side polls, so its count goes up with idle time too),
+delivered packets/s, process CPU time (user + sys, loopback softirq included) per delivered message, delivered
+fraction and p50/p99/p99.9.
+
+Usage: bench_udp_io [rate] [seconds] [batch]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../src/disseminator/UdpDisseminator.h"
+#include "../src/feedhandler/UdpFeedHandler.h"
+#include "../src/utils/CustomSpscQueue.h"
+#include "../src/utils/SpinSpscQueue.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using Queue = SpinSpscQueue<types::MarketDataMsg, CustomSpscQueue<types::MarketDataMsg, 65536>>;
+    constexpr const char* mcast_group = "239.192.1.78";
+    constexpr unsigned short mcast_port = 5678;
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    double pct_us(const std::vector<uint64_t>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        return static_cast<double>(sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))]) / 1000.0;
+    }
+
+    double cpu_seconds() {
+        rusage ru{};
+        getrusage(RUSAGE_SELF, &ru);
+        const auto secs = [](const timeval& tv) { return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6; };
+        return secs(ru.ru_utime) + secs(ru.ru_stime);
+    }
+
+    void run(const char* name, UdpIoOptions io, uint32_t rate, int seconds) {
+        Queue queue;
+        std::vector<uint64_t> latency;
+        latency.reserve(static_cast<std::size_t>(rate ? rate : 1'000'000) * seconds);
+
+        UdpFeedHandler feedhandler(mcast_group, mcast_port, {}, io);
+        UdpDisseminator<Queue> disseminator(queue, mcast_group, mcast_port, io);
+        std::atomic<uint64_t> received{0};
+        auto take = [&](const auto& msg, uint64_t) {
+            latency.push_back(now_ns() - msg.disseminate_timestamp);
+            received.store(latency.size(), std::memory_order_release);
+        };
+        feedhandler.set_quote_callback(take);
+        feedhandler.set_trade_callback(take);
+        feedhandler.subscribe("BENCH");
+        feedhandler.start();
+        disseminator.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        types::Quote q{};
+        std::memcpy(q.symbol, "BENCH", 5);
+        q.symbol_id = 1;
+        types::Trade t{};
+        std::memcpy(t.symbol, "BENCH", 5);
+        t.symbol_id = 1;
+        uint64_t pushed = 0;
+        const auto push = [&] {
+            const bool ok = pushed % 50 == 49 ? queue.push(t) : queue.push(q);
+            if (ok) ++pushed;
+            return ok;
+        };
+
+        const double cpu_start = cpu_seconds();
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::seconds(seconds);
+        if (rate == 0) {
+            while (Clock::now() < end) {
+                for (int i = 0; i < 64; ++i) {
+                    if (!push()) std::this_thread::yield();
+                }
+            }
+        } else {
+            const auto burst = std::max<uint32_t>(rate / 1000, 1);
+            auto next = start;
+            while (Clock::now() < end) {
+                for (uint32_t b = 0; b < burst; ++b) push();
+                next += std::chrono::milliseconds(1);
+                std::this_thread::sleep_until(next);
+            }
+        }
+        // let the backlog drain, until nothing arrived for 100 ms
+        for (uint64_t seen = ~uint64_t{0}; seen != received.load(std::memory_order_acquire);) {
+            seen = received.load(std::memory_order_acquire);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        disseminator.stop();
+        feedhandler.stop();
+        const double cpu = cpu_seconds() - cpu_start;
+        const double wall = std::chrono::duration<double>(Clock::now() - start).count() - 0.1;
+
+        const UdpIoStats tx = disseminator.io_stats();
+        const UdpIoStats rx = feedhandler.io_stats();
+        const double delivered = static_cast<double>(latency.size());
+        std::ranges::sort(latency);
+        const auto per_msg = [](uint64_t calls, uint64_t msgs) {
+            return msgs ? static_cast<double>(calls) / static_cast<double>(msgs) : 0.0;
+        };
+        std::printf("%-20s %9.3f %9.3f %10.0f %8.0f %9.2f%% %9.2f %9.2f %9.2f\n", name,
+                    per_msg(tx.syscalls, tx.messages), per_msg(rx.syscalls, rx.messages),
+                    delivered / wall, delivered > 0 ? cpu * 1e9 / delivered : 0.0,
+                    pushed ? 100.0 * delivered / static_cast<double>(pushed) : 0.0,
+                    pct_us(latency, 0.5), pct_us(latency, 0.99), pct_us(latency, 0.999));
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t rate = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 200'000;
+    const int seconds = argc > 2 ? std::atoi(argv[2]) : 3;
+    const unsigned batch = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 64;
+    spdlog::set_level(spdlog::level::warn);
+
+    if (rate == 0) std::printf("flooding for %d s, batch %u\n", seconds, batch);
+    else std::printf("%u msgs/s for %d s, batch %u\n", rate, seconds, batch);
+    std::printf("%-20s %9s %9s %10s %8s %10s %9s %9s %9s\n",
+                "mode", "tx sc/msg", "rx sc/msg", "pkts/s", "cpu ns", "delivered", "p50 us", "p99 us", "p99.9 us");
+
+    run("syscall", {.mode = UdpIoMode::Syscall, .batch = batch}, rate, seconds);
+    run("syscall+gso", {.mode = UdpIoMode::Syscall, .batch = batch, .gso = true}, rate, seconds);
+    run("syscall+gro", {.mode = UdpIoMode::Syscall, .batch = batch, .gro = true}, rate, seconds);
+    run("syscall+gso+gro", {.mode = UdpIoMode::Syscall, .batch = batch, .gso = true, .gro = true}, rate, seconds);
+    run("batched", {.mode = UdpIoMode::Batched, .batch = batch}, rate, seconds);
+    run("batched+gso", {.mode = UdpIoMode::Batched, .batch = batch, .gso = true}, rate, seconds);
+    run("syscall+timestamps", {.mode = UdpIoMode::Syscall, .batch = batch, .timestamps = KernelTimestamps::Software}, rate, seconds);
+    try {
+        run("io_uring", {.mode = UdpIoMode::IoUring, .batch = batch}, rate, seconds);
+        run("io_uring+sqpoll", {.mode = UdpIoMode::IoUring, .batch = batch, .sqpoll = true}, rate, seconds);
+    } catch (const std::runtime_error& e) {
+        std::printf("io_uring unavailable: %s\n", e.what());
+    }
+    return 0;
+}
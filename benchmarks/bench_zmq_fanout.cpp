@@ -0,0 +1,164 @@
+/*
+ZMQ fan-out matrix: one PUB, 1..N subscribing ZmqFeedHandlers, over tcp, ipc and inproc.
+The publisher thread calls ZmqDisseminator::send_impl at a fixed rate (1 ms batches), every subscriber records
+send-to-sink latency for every quote it gets.
+    delivered   lowest fraction of the stream any subscriber got (HWM drops show up here)
+    msgs/s      total delivered over all subscribers
+    p50/p99/p99.9  latency over all subscribers' samples
+
+Run it at rates past the knee to see where each transport saturates, and with more io threads to see whether the
+PUB side or the subscribers are the limit. inproc shares one context between publisher and subscribers.
+
+Usage: bench_zmq_fanout [rate] [seconds] [max_subscribers] [io_threads] [hwm] [tcp_port]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/disseminator/ZmqDisseminator.h"
+#include "../src/feedhandler/ZmqFeedHandler.h"
+#include "../src/utils/CustomSpscQueue.h"
+#include "../src/utils/SpinSpscQueue.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using Queue = SpinSpscQueue<types::MarketDataMsg, CustomSpscQueue<types::MarketDataMsg, 1024>>;
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    struct Received {
+        std::atomic<uint64_t> count{0};
+        std::atomic<bool> measuring{false};
+        std::vector<uint64_t> latency_ns;
+    };
+
+    struct LatencySink {
+        Received* out;
+        void operator()(const types::Quote& q, uint64_t recv_ts) const {
+            if (out->measuring.load(std::memory_order_relaxed)) out->latency_ns.push_back(recv_ts - q.disseminate_timestamp);
+            out->count.fetch_add(1, std::memory_order_release);
+        }
+    };
+    using Subscriber = BasicZmqFeedHandler<LatencySink>;
+
+    struct Settings {
+        uint32_t rate;
+        int seconds;
+        int io_threads;
+        int hwm;
+    };
+
+    double pct_us(const std::vector<uint64_t>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        return static_cast<double>(sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))]) / 1000.0;
+    }
+
+    void run(const std::string& endpoint, int subscribers, const Settings& s) {
+        const bool inproc = endpoint.starts_with("inproc://");
+        std::unique_ptr<zmq::context_t> shared = inproc ? std::make_unique<zmq::context_t>(s.io_threads) : nullptr;
+
+        Queue queue;
+        ZmqDisseminator<Queue> publisher(queue, endpoint, {.context = shared.get(), .io_threads = s.io_threads, .sndhwm = s.hwm});
+
+        std::vector<std::unique_ptr<Received>> received;
+        std::vector<std::unique_ptr<Subscriber>> subs;
+        for (int i = 0; i < subscribers; ++i) {
+            auto& r = received.emplace_back(std::make_unique<Received>());
+            r->latency_ns.reserve(static_cast<std::size_t>(s.rate) * s.seconds);
+            auto& sub = subs.emplace_back(std::make_unique<Subscriber>(endpoint, LatencySink{r.get()},
+                                                                      ZmqSubscribeOptions{.context = shared.get(), .io_threads = s.io_threads, .rcvhwm = s.hwm}));
+            sub->subscribe("*");
+            sub->start();
+        }
+
+        char topic[types::topic_header_size];
+        types::Quote q{};
+        std::memcpy(q.symbol, "BENCH", 5);
+        q.symbol_id = 1;
+        types::Messages::encode_topic(q, topic);
+
+        // probe until every subscriber's subscription has reached the PUB
+        const auto deadline = Clock::now() + std::chrono::seconds(5);
+        auto all_joined = [&] {
+            return std::ranges::all_of(received, [](const auto& r) { return r->count.load(std::memory_order_acquire) > 0; });
+        };
+        while (!all_joined() && Clock::now() < deadline) {
+            q.disseminate_timestamp = now_ns();
+            publisher.send_impl(topic, &q, sizeof(q));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::vector<uint64_t> base;
+        for (const auto& r : received) {
+            base.push_back(r->count.load(std::memory_order_acquire));
+            r->measuring.store(true);
+        }
+
+        const auto batch = std::max<uint32_t>(s.rate / 1000, 1);
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::seconds(s.seconds);
+        auto next = start;
+        uint64_t sent = 0;
+        while (Clock::now() < end) {
+            for (uint32_t b = 0; b < batch; ++b, ++sent) {
+                q.sequence = sent;
+                q.disseminate_timestamp = now_ns();
+                publisher.send_impl(topic, &q, sizeof(q));
+            }
+            next += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(next);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));   // let the tail arrive
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (auto& sub : subs) sub->stop();
+
+        uint64_t total = 0, worst = sent;
+        std::vector<uint64_t> all;
+        for (std::size_t i = 0; i < received.size(); ++i) {
+            const uint64_t got = received[i]->count.load() - base[i];
+            total += got;
+            worst = std::min(worst, got);
+            all.insert(all.end(), received[i]->latency_ns.begin(), received[i]->latency_ns.end());
+        }
+        std::ranges::sort(all);
+        std::printf("%-7s %5d %9.1f%% %12.0f %10.1f %10.1f %10.1f\n", endpoint.substr(0, endpoint.find(':')).c_str(), subscribers,
+                    sent ? 100.0 * static_cast<double>(worst) / static_cast<double>(sent) : 0.0, static_cast<double>(total) / seconds,
+                    pct_us(all, 0.5), pct_us(all, 0.99), pct_us(all, 0.999));
+        subs.clear();
+    }
+}
+
+int main(int argc, char** argv) {
+    Settings s{};
+    s.rate = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 100'000;
+    s.seconds = argc > 2 ? std::atoi(argv[2]) : 3;
+    const int max_subscribers = argc > 3 ? std::atoi(argv[3]) : 8;
+    s.io_threads = argc > 4 ? std::atoi(argv[4]) : 1;
+    s.hwm = argc > 5 ? std::atoi(argv[5]) : 1000;
+    const int port = argc > 6 ? std::atoi(argv[6]) : 5600;
+
+    std::printf("%u quotes/s for %d s, %d io thread(s) per context, hwm %d, %u hardware threads\n",
+                s.rate, s.seconds, s.io_threads, s.hwm, std::thread::hardware_concurrency());
+    std::printf("%-7s %5s %10s %12s %10s %10s %10s\n", "", "subs", "delivered", "msgs/s", "p50 us", "p99 us", "p99.9 us");
+
+    int next_port = port;
+    for (const char* transport : {"tcp", "ipc", "inproc"}) {
+        for (int subs = 1; subs <= max_subscribers; subs *= 2) {
+            std::string endpoint;
+            if (std::strcmp(transport, "tcp") == 0) endpoint = "tcp://127.0.0.1:" + std::to_string(next_port++);
+            else if (std::strcmp(transport, "ipc") == 0) endpoint = "ipc:///tmp/bench_zmq_fanout.ipc";
+            else endpoint = "inproc://bench_zmq_fanout_" + std::to_string(subs);
+            run(endpoint, subs, s);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ZMQ publish path by framing and buffer handling, over tcp and ipc.
+    two frames          topic frame + payload frame, zmq allocates and copies the payload (the old send_impl)
+    two frames, zc      payload frame handed to zmq from the ZmqBufferPool ring
+    single frame        topic padded to 16 bytes then the payload, one zmq message per market data message
+    single frame, zc    same, built in a pool slot
+
+The publisher thread calls ZmqDisseminator::send_impl directly, a ZmqFeedHandler on the same host receives.
+The publisher keeps at most `window` messages ahead of the receiver so the PUB high water mark never drops
+anything and every run delivers the same messages.
+    send        ns per send_impl call on the publisher thread
+    rate        messages per second end to end
+    latency     send_impl entry to the feed handler's sink, p50/p99
+
+Usage: bench_zmq_publish [messages] [window] [tcp_port]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/disseminator/ZmqDisseminator.h"
+#include "../src/feedhandler/ZmqFeedHandler.h"
+#include "../src/utils/CustomSpscQueue.h"
+#include "../src/utils/SpinSpscQueue.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using Queue = SpinSpscQueue<types::MarketDataMsg, CustomSpscQueue<types::MarketDataMsg, 1024>>;
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    struct Received {
+        std::atomic<uint64_t> count{0};
+        std::vector<uint64_t> latency_ns;
+    };
+
+    // concrete sink, so the receive side costs the same in every mode
+    struct LatencySink {
+        Received* out;
+        void operator()(const types::Quote& q, uint64_t recv_ts) const {
+            out->latency_ns.push_back(recv_ts - q.disseminate_timestamp);
+            out->count.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    double pct_us(std::vector<uint64_t>& v, double p) {
+        if (v.empty()) return 0.0;
+        std::ranges::sort(v);
+        return static_cast<double>(v[static_cast<std::size_t>(p * static_cast<double>(v.size() - 1))]) / 1000.0;
+    }
+
+    void run(const std::string& endpoint, const char* name, ZmqPublishOptions mode, uint64_t messages, uint64_t window) {
+        Queue queue;
+        ZmqDisseminator<Queue> publisher(queue, endpoint, mode);
+
+        Received received;
+        received.latency_ns.reserve(messages);
+        BasicZmqFeedHandler<LatencySink> receiver(endpoint, LatencySink{&received});
+        receiver.subscribe("*");
+        receiver.start();
+
+        // wait for the subscription to reach the publisher, probes are not counted
+        char topic[types::topic_header_size];
+        types::Quote q{};
+        std::memcpy(q.symbol, "BENCH", 5);
+        q.symbol_id = 1;
+        types::Messages::encode_topic(q, topic);
+        const auto deadline = Clock::now() + std::chrono::seconds(5);
+        while (received.count.load(std::memory_order_acquire) == 0 && Clock::now() < deadline) {
+            q.disseminate_timestamp = now_ns();
+            publisher.send_impl(topic, &q, sizeof(q));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const uint64_t base = received.count.load(std::memory_order_acquire);
+        if (base == 0) {
+            std::printf("%-6s %-18s no subscription after 5 s\n", endpoint.substr(0, 3).c_str(), name);
+            return;
+        }
+        received.latency_ns.clear();
+
+        uint64_t send_ns = 0;
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < messages; ++i) {
+            while (i - (received.count.load(std::memory_order_acquire) - base) >= window) std::this_thread::yield();
+            q.sequence = i;
+            q.bid_price = static_cast<double>(i);
+            const uint64_t t0 = now_ns();
+            q.disseminate_timestamp = t0;
+            publisher.send_impl(topic, &q, sizeof(q));
+            send_ns += now_ns() - t0;
+        }
+        while (received.count.load(std::memory_order_acquire) - base < messages && Clock::now() - start < std::chrono::seconds(30)) {
+            std::this_thread::yield();
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        receiver.stop();
+
+        const uint64_t got = received.count.load() - base;
+        std::printf("%-6s %-18s %10.0f %12.0f %10.1f %10.1f %10llu %10llu\n", endpoint.substr(0, 3).c_str(), name,
+                    static_cast<double>(send_ns) / static_cast<double>(messages), static_cast<double>(got) / seconds,
+                    pct_us(received.latency_ns, 0.5), pct_us(received.latency_ns, 0.99),
+                    static_cast<unsigned long long>(messages - got),
+                    static_cast<unsigned long long>(publisher.zero_copy_fallbacks()));
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint64_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500'000;
+    const uint64_t window = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 512;
+    const int port = argc > 3 ? std::atoi(argv[3]) : 5590;
+
+    const struct {
+        const char* name;
+        ZmqPublishOptions options;
+    } modes[] = {
+        {"two frames", {}},
+        {"two frames, zc", {.zero_copy = true}},
+        {"single frame", {.single_frame = true}},
+        {"single frame, zc", {.single_frame = true, .zero_copy = true}},
+    };
+
+    std::printf("%llu quotes of %zu bytes per run, at most %llu in flight\n", static_cast<unsigned long long>(messages),
+                sizeof(types::Quote), static_cast<unsigned long long>(window));
+    std::printf("%-6s %-18s %10s %12s %10s %10s %10s %10s\n", "", "mode", "send ns", "msgs/s", "p50 us", "p99 us", "lost", "copied");
+    int next_port = port;
+    for (const auto& mode : modes) {
+        run("tcp://127.0.0.1:" + std::to_string(next_port++), mode.name, mode.options, messages, window);
+    }
+    for (const auto& mode : modes) {
+        run("ipc:///tmp/bench_zmq_publish.ipc", mode.name, mode.options, messages, window);
+    }
+    return 0;
+}
@@ -7,6 +7,7 @@ import plotly.express as px
 EXECUTABLE_PATH = "../cmake-build-release/main_simulate"
 DATA_DIR = "../data"
 SYMBOLS_FILE = "../data/tickers.txt"
+SUMMARY_FILE = "../data/run_summary.csv"  # md_analyze -o
 
 st.set_page_config(page_title="Benchmark", layout="wide")
 st.set_page_config(page_title="Benchmark", layout="wide")
@@ -100,7 +101,7 @@ st.markdown("Analyze and compare the latency profiles of lock-free queue wait st
 with st.sidebar:
     st.header("1. Configuration")
 
-    transport = st.selectbox("Transport Protocol", ["udp", "zmq"], index=0)
+    transport = st.selectbox("Transport Protocol", ["udp", "zmq", "shm"], index=0)
     queue_type = st.selectbox("Wait Strategy", ["spin", "waitable"], index=0)
     queue_size = st.selectbox("Queue Size", [128, 512, 1024, 4096, 16384, 65536], index=3)
     rate = st.number_input("Message Rate (msgs/sec)", min_value=1000, max_value=1000000, value=50000, step=10000)
@@ -133,7 +134,7 @@ if run_all:
             execute_benchmark(t, q, queue_size, rate, duration)
     st.success("All 4 combinations executed successfully!")
 
-tab1, tab2 = st.tabs(["Comparative Analysis (All Runs)", "Detailed Breakdown (Specific Run)"])
+tab1, tab2, tab3 = st.tabs(["Comparative Analysis (All Runs)", "Detailed Breakdown (Specific Run)", "Run Summaries"])
 
 with tab1:
     if not st.session_state.run_history.empty:
@@ -201,4 +202,30 @@ with tab2:
                 fig_split_box.update_yaxes(type="log")
             st.plotly_chart(fig_split_box, use_container_width=True)
     else:
-        st.info("Execute a benchmark to view detailed visualizations.")
\ No newline at end of file
+        st.info("Execute a benchmark to view detailed visualizations.")
+
+with tab3:
+    # one row per run from md_analyze, no raw samples loaded
+    summary_path = st.text_input("md_analyze summary CSV", SUMMARY_FILE)
+    if os.path.exists(summary_path):
+        summary = pd.read_csv(summary_path)
+        st.dataframe(summary, use_container_width=True, hide_index=True)
+
+        col_pct, col_rate = st.columns(2)
+        with col_pct:
+            pct = summary.melt(id_vars="run", value_vars=["p50_us", "p99_us", "p999_us"],
+                               var_name="Percentile", value_name="Latency (µs)")
+            fig_pct = px.bar(pct, x="run", y="Latency (µs)", color="Percentile", barmode="group",
+                             title="Exact Percentiles per Run")
+            if log_y:
+                fig_pct.update_yaxes(type="log")
+            st.plotly_chart(fig_pct, use_container_width=True)
+        with col_rate:
+            fig_rate = px.scatter(summary, x="rate_mean", y="p99_us", hover_name="run", size="messages",
+                                  labels={'rate_mean': 'Throughput (msgs/sec)', 'p99_us': 'p99 (µs)'},
+                                  title="p99 vs. Throughput")
+            if log_y:
+                fig_rate.update_yaxes(type="log")
+            st.plotly_chart(fig_rate, use_container_width=True)
+    else:
+        st.info(f"No summary at {summary_path}. Create one with `md_analyze <run dirs or sweep dir> -o {summary_path}`.")
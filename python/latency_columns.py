@@ -0,0 +1,77 @@
+"""
+Loader for the binary columnar latency file main_simulate writes with --latency-format binary
+(latencies.mdlat, layout in src/monitor/LatencyColumns.h).
+
+    cols = load("../data/latencies.mdlat")
+    quotes = cols["total_ns"][cols["type"] == b"Q"]
+
+The file is mapped with numpy.memmap, nothing is parsed. Each column comes back as one array of
+record_count values; within a block a column is contiguous, so gathering it over the blocks is one copy.
+"""
+import struct
+import sys
+
+import numpy as np
+import pandas as pd
+
+MAGIC = b"MDLATCOL"
+VERSION = 1
+_HEADER = struct.Struct("<8sIIIIQQQQ")
+_COLUMN = struct.Struct("<16s8sII")
+_MAX_COLUMNS = 16
+CONFLATED_SEQUENCES = 1  # header flag: sequence holes are quotes the conflator merged, not loss
+
+
+def read_header(path):
+    with open(path, "rb") as f:
+        raw = f.read(4096)
+    magic, version, header_size, block_records, column_count, block_bytes, record_count, block_count, dropped = \
+        _HEADER.unpack_from(raw, 0)
+    if magic != MAGIC:
+        raise ValueError(f"{path} is not a latency column file")
+    if version != VERSION:
+        raise ValueError(f"{path} has format version {version}, this loader reads {VERSION}")
+    columns = []
+    for i in range(column_count):
+        name, dtype, width, offset = _COLUMN.unpack_from(raw, _HEADER.size + i * _COLUMN.size)
+        columns.append((name.rstrip(b"\0").decode(), dtype.rstrip(b"\0").decode(), width, offset))
+    (flags,) = struct.unpack_from("<Q", raw, _HEADER.size + _MAX_COLUMNS * _COLUMN.size)
+    return {
+        "header_size": header_size, "block_records": block_records, "block_bytes": block_bytes,
+        "record_count": record_count, "block_count": block_count, "dropped": dropped, "columns": columns,
+        "flags": flags,
+    }
+
+
+def load(path):
+    """dict of column name -> numpy array with one value per record"""
+    h = read_header(path)
+    n, per_block = h["record_count"], h["block_records"]
+    block = np.dtype({
+        "names": [c[0] for c in h["columns"]],
+        "formats": [(np.dtype(c[1]), (per_block,)) for c in h["columns"]],
+        "offsets": [c[3] for c in h["columns"]],
+        "itemsize": h["block_bytes"],
+    })
+    if n == 0:
+        return {c[0]: np.empty(0, dtype=np.dtype(c[1])) for c in h["columns"]}
+    blocks = np.memmap(path, dtype=block, mode="r", offset=h["header_size"], shape=(h["block_count"],))
+    return {c[0]: blocks[c[0]].reshape(-1)[:n] for c in h["columns"]}
+
+
+def load_frame(path, message_type=None):
+    """the columns as a DataFrame, optionally only one message type ('Q', 'T', 'A', ...)"""
+    cols = load(path)
+    df = pd.DataFrame(cols)
+    if message_type is not None:
+        df = df[df["type"] == message_type.encode()].reset_index(drop=True)
+    return df
+
+
+if __name__ == "__main__":
+    for p in sys.argv[1:]:
+        h = read_header(p)
+        print(f"{p}: {h['record_count']} records in {h['block_count']} blocks of {h['block_records']}, "
+              f"{h['dropped']} dropped{', conflated' if h['flags'] & CONFLATED_SEQUENCES else ''}")
+        for name, dtype, width, offset in h["columns"]:
+            print(f"  {name:<12} {dtype:<4} at {offset}")
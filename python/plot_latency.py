@@ -5,6 +5,7 @@ import matplotlib.pyplot as plt
 import seaborn as sns
 from matplotlib.offsetbox import AnchoredText
 import platform
+import latency_columns
 
 if platform.system() == "Windows":
     EXECUTABLE_PATH = "../cmake-build-release-wsl/main_simulate"
@@ -25,17 +26,27 @@ def run_benchmark(rate: int = 50000, duration: int = 10):
         "--rate", str(rate),
         "--duration", str(duration),
         "--symbols", SYMBOLS_FILE,
-        "--out", DATA_DIR
+        "--out", DATA_DIR,
+        "--latency-format", "binary"
     ]
     subprocess.run(cmd, capture_output=True, text=True, check=True)
 
-def plot_latencies(csv_path: str, label: str, output_dir: str):
-    if not os.path.exists(csv_path):
-        print(f"Skipping {label}: {csv_path} not found.")
+def load_latencies(csv_name: str, message_type: str):
+    """the binary columns of the last run if there are any, else the CSV"""
+    binary_path = os.path.join(DATA_DIR, "latencies.mdlat")
+    csv_path = os.path.join(DATA_DIR, csv_name)
+    if os.path.exists(binary_path) and (not os.path.exists(csv_path) or os.path.getmtime(binary_path) >= os.path.getmtime(csv_path)):
+        return latency_columns.load_frame(binary_path, message_type)
+    if os.path.exists(csv_path):
+        return pd.read_csv(csv_path)
+    return None
+
+def plot_latencies(df, label: str, output_dir: str):
+    if df is None or df.empty:
+        print(f"Skipping {label}: no latency data found.")
         return
 
     print(f"\nProcessing {label} Latencies...")
-    df = pd.read_csv(csv_path)
 
     df['queue_us'] = (df['queue_ns'] / 1000.0).replace(0, 0.001)
     df['network_us'] = (df['network_ns'] / 1000.0).replace(0, 0.001)
@@ -119,8 +130,8 @@ def main():
         print(f"Error executing benchmark: {e}")
         return
 
-    plot_latencies(os.path.join(DATA_DIR, "quote_latencies.csv"), "Quotes", PLOT_DIR)
-    plot_latencies(os.path.join(DATA_DIR, "trade_latencies.csv"), "Trades", PLOT_DIR)
+    plot_latencies(load_latencies("quote_latencies.csv", "Q"), "Quotes", PLOT_DIR)
+    plot_latencies(load_latencies("trade_latencies.csv", "T"), "Trades", PLOT_DIR)
 
 if __name__ == "__main__":
     main()
\ No newline at end of file
@@ -42,13 +42,14 @@ def main():
     try:
         df_udp = run_benchmark('udp')
         df_zmq = run_benchmark('zmq')
+        df_shm = run_benchmark('shm')
     except Exception as e:
         print(f"Error running benchmarks: {e}")
         return
 
-    df_all = pd.concat([df_udp, df_zmq], ignore_index=True)
+    df_all = pd.concat([df_udp, df_zmq, df_shm], ignore_index=True)
     stats = []
-    for transport in ['UDP', 'ZMQ']:
+    for transport in ['UDP', 'ZMQ', 'SHM']:
         d = df_all[df_all['Transport'] == transport]['network_us']
         stats.append(f"{transport} Network:")
         stats.append(f"  Mean: {d.mean():.3f} µs")
@@ -73,7 +74,7 @@ def main():
         common_norm=False,
         alpha=0.15,
         linewidth=2,
-        palette=["#2ca02c", "#d62728"],
+        palette=["#2ca02c", "#d62728", "#1f77b4"],
         ax=ax
     )
 
@@ -83,7 +84,7 @@ def main():
     min_val = df_all['network_us'].min() * 0.8
     ax.set_xlim(min_val, p999 * 1.5)
 
-    ax.set_title("Network Latency: UDP Multicast vs. ZeroMQ TCP", pad=20, fontweight='bold')
+    ax.set_title("Network Latency: UDP Multicast vs. ZeroMQ TCP vs. Shared Memory", pad=20, fontweight='bold')
     ax.set_xlabel("Network Latency (Microseconds) - Log Scale", fontweight='bold')
     ax.set_ylabel("Probability Density", fontweight='bold')
 
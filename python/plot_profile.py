@@ -0,0 +1,93 @@
+"""
+Target vs achieved rate and latency over time of main_simulate runs with a load profile, one line per run,
+from the live_latency.csv each of them writes. Shows how long queues and transports take to recover after a burst.
+
+    ./main_simulate --profile spike --rate 500000 --duration 30 --transport udp --out ../data/spike_udp
+    ./main_simulate --profile spike --rate 500000 --duration 30 --transport shm --out ../data/spike_shm
+    python3 plot_profile.py ../data/spike_udp ../data/spike_shm
+"""
+import os
+import sys
+
+import matplotlib.pyplot as plt
+import matplotlib.ticker as ticker
+import pandas as pd
+import seaborn as sns
+
+RUN_DIRS = sys.argv[1:] or ["../data"]
+
+
+def recovery(run):
+    """seconds from the end of each burst (a drop of the target) until p99 is back within 2x of before it"""
+    rows = []
+    drops = run.index[run["target_rate"] < 0.8 * run["target_rate"].shift(1)]
+    for i in drops:
+        start = i - 1
+        while start > 0 and run.loc[start - 1, "target_rate"] >= 0.99 * run.loc[i - 1, "target_rate"]:
+            start -= 1
+        before = run.loc[:start - 1, "p99_us"]
+        if before.empty:
+            continue
+        baseline = before.median()
+        after = run.loc[i:]
+        settled = after[after["p99_us"] <= 2 * baseline]
+        rows.append({
+            "burst_end_s": run.loc[i, "elapsed_s"],
+            "baseline_p99_us": baseline,
+            "burst_p99_us": run.loc[start:i - 1, "p99_us"].max(),
+            "recovered_after_s": settled["elapsed_s"].iloc[0] - run.loc[i, "elapsed_s"] if not settled.empty else float("nan"),
+        })
+    return rows
+
+
+def main():
+    runs = []
+    for d in RUN_DIRS:
+        run = pd.read_csv(os.path.join(d, "live_latency.csv"))
+        if "target_rate" not in run or (run["target_rate"] == 0).all():
+            print(f"{d}: no target rate in live_latency.csv, was it run with --profile?")
+            continue
+        run["run"] = os.path.basename(os.path.normpath(d))
+        run["p99_us"] = run["p99_ns"] / 1000.0
+        run["p999_us"] = run["p999_ns"] / 1000.0
+        runs.append(run)
+        for r in recovery(run):
+            print(f"{run['run'].iloc[0]}: burst ending at {r['burst_end_s']:.0f} s, p99 {r['baseline_p99_us']:.1f} -> "
+                  f"{r['burst_p99_us']:.1f} us, back within 2x after {r['recovered_after_s']:.1f} s")
+    if not runs:
+        sys.exit("nothing to plot")
+    data = pd.concat(runs, ignore_index=True)
+
+    sns.set_theme(style="whitegrid", context="talk")
+    fig, (ax_rate, ax_lat, ax_drops) = plt.subplots(3, 1, figsize=(16, 14), sharex=True)
+    palette = dict(zip(data["run"].unique(), sns.color_palette(n_colors=data["run"].nunique())))
+
+    for name, run in data.groupby("run", sort=False):
+        color = palette[name]
+        ax_rate.plot(run["elapsed_s"], run["target_rate"], color=color, linestyle="--", linewidth=2, label=f"{name} target")
+        ax_rate.plot(run["elapsed_s"], run["rate"], color=color, linewidth=2, label=f"{name} achieved")
+        ax_lat.plot(run["elapsed_s"], run["p99_us"], color=color, linewidth=2, label=f"{name} p99")
+        ax_lat.plot(run["elapsed_s"], run["p999_us"], color=color, linestyle=":", linewidth=2, label=f"{name} p99.9")
+        ax_drops.bar(run["elapsed_s"], run["drops"], color=color, alpha=0.6, width=0.8, label=name)
+
+    ax_rate.yaxis.set_major_formatter(ticker.FuncFormatter(lambda x, pos: f'{x*1e-3:.0f}k'))
+    ax_rate.set_ylabel("Message Rate (msgs/sec)", fontweight='bold')
+    ax_rate.set_title("Target (dashed) vs Achieved Rate per Window", pad=20, fontweight='bold')
+    ax_lat.set_yscale("log")
+    ax_lat.set_ylabel("Latency (µs)", fontweight='bold')
+    ax_lat.set_title("p99 and p99.9 (dotted) per Window", pad=20, fontweight='bold')
+    ax_drops.set_ylabel("Dropped", fontweight='bold')
+    ax_drops.set_xlabel("Elapsed (s)", fontweight='bold')
+    for ax in (ax_rate, ax_lat, ax_drops):
+        ax.legend(loc="upper left", frameon=True, fontsize="x-small")
+
+    sns.despine()
+    output_filename = "../plots/profile_timeline.png"
+    plt.tight_layout()
+    plt.savefig(output_filename, dpi=300)
+    print(f"\nPlot saved successfully to {output_filename}")
+    plt.show()
+
+
+if __name__ == "__main__":
+    main()
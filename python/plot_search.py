@@ -0,0 +1,68 @@
+"""
+Latency and loss curves of a main_simulate --search run: the trials per rate of every combination, the SLO
+limits and the max sustainable rate the search settled on.
+
+    ./main_simulate --search --slo-p99 50 --slo-loss 0.01 --rate 100000 --duration 3 --out ../data/search \
+        --sweep "transport=udp,shm;queue=spin,waitable"
+    python3 plot_search.py ../data/search
+"""
+import os
+import sys
+
+import matplotlib.pyplot as plt
+import matplotlib.ticker as ticker
+import pandas as pd
+import seaborn as sns
+
+SEARCH_DIR = sys.argv[1] if len(sys.argv) > 1 else "../data/search"
+
+
+def main():
+    trials = pd.read_csv(os.path.join(SEARCH_DIR, "search_trials.csv"))
+    results = pd.read_csv(os.path.join(SEARCH_DIR, "search_results.csv"))
+
+    print("\n--- Max Sustainable Rate ---")
+    print(results[["combination", "max_rate", "capped", "first_failed_rate", "p99_us", "loss_pct", "trials"]]
+          .to_string(index=False))
+
+    slo_p99 = results["slo_p99_us"].iloc[0]
+    slo_loss = results["slo_loss_pct"].iloc[0]
+
+    sns.set_theme(style="whitegrid", context="talk")
+    fig, (ax_lat, ax_loss) = plt.subplots(1, 2, figsize=(18, 7))
+    palette = dict(zip(results["combination"], sns.color_palette(n_colors=len(results))))
+
+    sns.lineplot(data=trials, x="rate", y="p99_us", hue="combination", palette=palette, marker="o",
+                 errorbar=("ci", 95), ax=ax_lat)
+    ax_lat.axhline(slo_p99, color="black", linestyle="--", linewidth=2, label=f"SLO p99 {slo_p99:g} µs")
+    sns.lineplot(data=trials, x="rate", y="loss_pct", hue="combination", palette=palette, marker="o",
+                 errorbar=("ci", 95), legend=False, ax=ax_loss)
+    ax_loss.axhline(slo_loss, color="black", linestyle="--", linewidth=2, label=f"SLO loss {slo_loss:g}%")
+
+    for _, row in results.iterrows():
+        if row["max_rate"] > 0:
+            for ax in (ax_lat, ax_loss):
+                ax.axvline(row["max_rate"], color=palette[row["combination"]], linestyle=":", linewidth=2)
+
+    formatter = ticker.FuncFormatter(lambda x, pos: f'{x*1e-6:.1f}M')
+    for ax in (ax_lat, ax_loss):
+        ax.xaxis.set_major_formatter(formatter)
+        ax.set_xlabel("Target Message Rate (msgs/sec)", fontweight='bold')
+    ax_lat.set_yscale("log")
+    ax_lat.set_ylabel("p99 Latency (µs)", fontweight='bold')
+    ax_loss.set_ylabel("Loss (%)", fontweight='bold')
+    ax_lat.set_title("p99 per Trial, dotted: Max Sustainable Rate", pad=20, fontweight='bold')
+    ax_loss.set_title("Loss per Trial", pad=20, fontweight='bold')
+    ax_lat.legend(title="Combination", loc="upper left", frameon=True, fontsize="x-small")
+    ax_loss.legend(loc="upper left", frameon=True)
+
+    sns.despine()
+    output_filename = "../plots/search_curves.png"
+    plt.tight_layout()
+    plt.savefig(output_filename, dpi=300)
+    print(f"\nPlot saved successfully to {output_filename}")
+    plt.show()
+
+
+if __name__ == "__main__":
+    main()
@@ -19,53 +19,38 @@ SYMBOLS_FILE = "../data/tickers.txt"
 TARGET_RATES = [100_000, 500_000, 1_000_000, 1_500_000, 2_000_000, 2_500_000, 3_000_000]
 DURATION = 5
 
-def run_throughput_test(transport: str, rate: int) -> int:
-    print(f"Testing {transport.upper()} at {rate:,} msgs/sec...")
+SWEEP_DIR = os.path.join(DATA_DIR, "throughput_sweep")
+
+
+def run_throughput_sweep() -> pd.DataFrame:
+    """every transport x rate in one main_simulate --sweep, one row per run in sweep_results.csv"""
+    rates = ",".join(str(r) for r in TARGET_RATES)
     cmd = [
         EXECUTABLE_PATH,
         "--underlying", "custom",
         "--queue", "spin",
         "--size", "65536",
-        "--transport", transport,
-        "--rate", str(rate),
         "--duration", str(DURATION),
         "--symbols", SYMBOLS_FILE,
-        "--out", DATA_DIR
+        "--out", SWEEP_DIR,
+        "--latency-format", "binary",
+        "--sweep", f"transport=udp,zmq;rate={rates}"
     ]
-
-    try:
-        subprocess.run(cmd, capture_output=True, text=True, check=True)
-    except subprocess.CalledProcessError as e:
-        print(f"  -> Crash/Error on {transport} at {rate}: {e.stderr}")
-        return 0
-
-    total_received = 0
-
-    q_file = os.path.join(DATA_DIR, "quote_latencies.csv")
-    if os.path.exists(q_file):
-        total_received += sum(1 for line in open(q_file)) - 1
-
-    t_file = os.path.join(DATA_DIR, "trade_latencies.csv")
-    if os.path.exists(t_file):
-        total_received += sum(1 for line in open(t_file)) - 1
-
-    return total_received
+    print(f"Sweeping {len(TARGET_RATES) * 2} runs: {' '.join(cmd)}")
+    subprocess.run(cmd, check=True)
+
+    runs = pd.read_csv(os.path.join(SWEEP_DIR, "sweep_results.csv"))
+    failed = runs[runs["error"].notna()]
+    for _, row in failed.iterrows():
+        print(f"  -> Crash/Error on {row['transport']} at {row['rate']}: {row['error']}")
+    return pd.DataFrame({
+        'Transport': runs['transport'],
+        'Target Rate': runs['rate'],
+        'Achieved Rate': runs['received'] / runs['duration'],
+    })
 
 def main():
-    results = []
-
-    for transport in ['udp', 'zmq']:
-        for rate in TARGET_RATES:
-            received = run_throughput_test(transport, rate)
-            achieved_rate = received / DURATION
-
-            results.append({
-                'Transport': transport.upper(),
-                'Target Rate': rate,
-                'Achieved Rate': achieved_rate
-            })
-
-    df = pd.DataFrame(results)
+    df = run_throughput_sweep()
     print("\n--- Throughput Raw Data ---")
     for index, row in df.iterrows():
         print(f"Transport: {row['Transport']:<4} | Target: {row['Target Rate']:>9,} | Achieved: {row['Achieved Rate']:>9,.0f} msgs/sec")
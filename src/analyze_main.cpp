@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cxxopts.hpp>
+#include <spdlog/spdlog.h>
+
+#include "./monitor/RunAnalysis.h"
+
+/*
+Summary of many finished runs in one table: md_analyze data/sweep -o data/run_summary.csv
+Each argument is a run's output directory, a latencies.mdlat or *_latencies.csv file, or a directory whose
+subdirectories are runs (a sweep). Runs are read in parallel. The CSV is what python/app.py loads under
+"Run Summaries", the same numbers are printed as a table.
+ */
+namespace {
+    double us(double ns) { return ns / 1000.0; }
+
+    void print_table(const std::vector<analysis::RunSummary>& rows) {
+        std::printf("%-32s %6s %11s %9s %9s %9s %9s %9s %9s %12s %9s\n", "run", "source", "messages", "p50 us",
+                    "p99 us", "p99.9 us", "max us", "jitter", "h p99", "msg/s", "loss %");
+        for (const analysis::RunSummary& r : rows) {
+            if (!r.error.empty()) continue;
+            const std::string name = r.run.size() > 32 ? "..." + r.run.substr(r.run.size() - 29) : r.run;
+            std::printf("%-32s %6s %11lu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %12.0f ", name.c_str(), r.source.c_str(),
+                        static_cast<unsigned long>(r.messages), us(r.p50_ns), us(r.p99_ns), us(r.p999_ns), us(r.max_ns),
+                        us(r.jitter_ns), us(r.hist_p99_ns), r.rate_mean);
+            if (r.loss_known) std::printf("%9.3f\n", r.loss_pct);
+            else std::printf("%9s\n", "-");
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    cxxopts::Options options("md_analyze", "Latency, throughput and loss summary of finished main_simulate runs");
+
+    options.add_options()
+        ("runs", "Run directories, latency files or sweep directories", cxxopts::value<std::vector<std::string>>())
+        ("o,output", "Summary CSV to write, - for stdout", cxxopts::value<std::string>()->default_value("run_summary.csv"))
+        ("j,jobs", "Runs read in parallel, 0 = one per core", cxxopts::value<unsigned>()->default_value("0"))
+        ("w,window", "Throughput window in ms", cxxopts::value<uint64_t>()->default_value("1000"))
+        ("type", "Only this message type: Q, T, A, M, X or E", cxxopts::value<std::string>())
+        ("h,help", "Print usage");
+    options.parse_positional({"runs"});
+    options.positional_help("RUN...");
+
+    auto result = options.parse(argc, argv);
+    if (result.count("help") || !result.count("runs")) {
+        std::cout << options.help() << std::endl;
+        return result.count("help") ? 0 : 1;
+    }
+
+    analysis::Options opts;
+    opts.window_ns = std::max<uint64_t>(result["window"].as<uint64_t>(), 1) * 1'000'000;
+    if (result.count("type")) {
+        const std::string t = result["type"].as<std::string>();
+        if (t.size() != 1 || std::string_view("QTAMXE").find(t[0]) == std::string_view::npos) {
+            throw std::invalid_argument("Invalid --type: " + t + " (use Q, T, A, M, X or E)");
+        }
+        opts.type = t[0];
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<std::filesystem::path> runs = analysis::find_runs(result["runs"].as<std::vector<std::string>>());
+    const std::vector<analysis::RunSummary> rows = analysis::analyze(runs, opts, result["jobs"].as<unsigned>());
+
+    int failed = 0;
+    for (const analysis::RunSummary& r : rows) {
+        if (!r.error.empty()) {
+            spdlog::error("{}: {}", r.run, r.error);
+            ++failed;
+        }
+    }
+
+    const std::string output = result["output"].as<std::string>();
+    if (output == "-") {
+        analysis::write_csv(std::cout, rows);
+    } else {
+        std::ofstream out(output);
+        if (!out) throw std::runtime_error("Could not open " + output);
+        analysis::write_csv(out, rows);
+        print_table(rows);
+        spdlog::info("{} runs in {:.2f} s -> {}", rows.size() - failed,
+                     std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), output);
+    }
+    return failed > 0 ? 1 : 0;
+}
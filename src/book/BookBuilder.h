@@ -0,0 +1,195 @@
+#ifndef BOOK_BUILDER_H
+#define BOOK_BUILDER_H
+
+#include "PriceLevelBook.h"
+#include "../utils/types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+Consumer side of the order-by-order feed: applies add/modify/cancel/execute to a PriceLevelBook per symbol.
+Meant to be driven from the IFeedHandler order callbacks, everything runs on the receive thread so there is no locking.
+Order ids are dense (the generator recycles them) so resting orders live in a flat vector indexed by id, and books
+are found by the dense symbol id the feed stamps on every message. The symbol hash is only consulted for messages
+without one and when a book is created.
+Both tables grow to the ids that arrive, so they are capped: a symbol id past symbol_id_limit goes through the symbol
+hash instead, an add with an order id past order_id_limit is dropped and counted. So is a price that is not finite
+or too far from the book for PriceLevelBook::max_window. A corrupt or foreign packet then cannot make the receive
+thread allocate gigabytes.
+ */
+class BookBuilder {
+public:
+    static constexpr uint32_t default_symbol_id_limit = 1u << 20;
+    static constexpr uint64_t default_order_id_limit = 1u << 22;   // 64 orders for each of 65k symbols
+
+    explicit BookBuilder(std::size_t expected_symbols = 0, std::size_t expected_orders = 0,
+                         uint32_t symbol_id_limit = default_symbol_id_limit,
+                         uint64_t order_id_limit = default_order_id_limit)
+        : symbol_id_limit_(symbol_id_limit), order_id_limit_(order_id_limit) {
+        book_index_.reserve(expected_symbols);
+        book_of_id_.reserve(expected_symbols + 1);
+        books_.reserve(expected_symbols);
+        orders_.reserve(expected_orders);
+    }
+
+    inline void apply(const types::OrderAdd& msg) {
+        if (msg.order_id >= order_id_limit_ || !valid_price(msg.price)) [[unlikely]] {
+            ++dropped_;
+            return;
+        }
+        const uint32_t book = book_for(msg.symbol_id, msg.symbol);
+        if (msg.order_id >= orders_.size()) {
+            orders_.resize(msg.order_id + 1);
+        }
+        OrderRef& order = orders_[msg.order_id];
+        if (order.live) {
+            // the id got recycled but we missed the message that removed it
+            books_[order.book].remove(order.side, order.price, order.size, true);
+            order.live = false;
+        }
+        const int64_t price = to_ticks(msg.price);
+        if (!books_[book].add(msg.side, price, msg.size)) [[unlikely]] {
+            ++dropped_;
+            return;
+        }
+        order = {price, msg.size, book, msg.side, true};
+        ++applied_;
+    }
+
+    inline void apply(const types::OrderModify& msg) {
+        if (!valid_price(msg.price)) [[unlikely]] {
+            ++dropped_;
+            return;
+        }
+        OrderRef* order = find(msg.order_id);
+        if (order == nullptr) return;
+
+        PriceLevelBook& book = books_[order->book];
+        const int64_t new_price = to_ticks(msg.price);
+        if (new_price == order->price) {
+            if (msg.size >= order->size) {
+                book.add(order->side, order->price, msg.size - order->size, false);
+            } else {
+                book.remove(order->side, order->price, order->size - msg.size, false);
+            }
+        } else {
+            // add first, a price the book cannot take leaves the order where it was
+            if (!book.add(order->side, new_price, msg.size)) [[unlikely]] {
+                ++dropped_;
+                return;
+            }
+            book.remove(order->side, order->price, order->size, true);
+        }
+        order->price = new_price;
+        order->size = msg.size;
+        ++applied_;
+    }
+
+    inline void apply(const types::OrderCancel& msg) {
+        OrderRef* order = find(msg.order_id);
+        if (order == nullptr) return;
+
+        books_[order->book].remove(order->side, order->price, order->size, true);
+        order->live = false;
+        ++applied_;
+    }
+
+    inline void apply(const types::OrderExecute& msg) {
+        OrderRef* order = find(msg.order_id);
+        if (order == nullptr) return;
+
+        const uint32_t executed = std::min(msg.executed_size, order->size);
+        order->size -= executed;
+        books_[order->book].remove(order->side, order->price, executed, order->size == 0);
+        if (order->size == 0) {
+            order->live = false;
+        }
+        executed_volume_ += executed;
+        ++applied_;
+    }
+
+    [[nodiscard]] const PriceLevelBook* book(std::string_view symbol) const {
+        uint64_t key = 0;
+        std::memcpy(&key, symbol.data(), std::min(symbol.size(), std::size_t{8}));
+        const auto it = book_index_.find(key);
+        return it == book_index_.end() ? nullptr : &books_[it->second];
+    }
+
+    [[nodiscard]] std::size_t book_count() const { return books_.size(); }
+    [[nodiscard]] uint64_t applied() const { return applied_; }
+    [[nodiscard]] uint64_t unknown_orders() const { return unknown_orders_; }
+    [[nodiscard]] uint64_t dropped() const { return dropped_; }   // order id past the limit, bad or far off price
+    [[nodiscard]] uint64_t executed_volume() const { return executed_volume_; }
+
+    [[nodiscard]] std::size_t live_orders() const {
+        std::size_t n = 0;
+        for (const auto& o : orders_) n += o.live;
+        return n;
+    }
+
+private:
+    struct OrderRef {
+        int64_t price{0};   // ticks
+        uint32_t size{0};
+        uint32_t book{0};
+        types::Side side{types::Side::Buy};
+        bool live{false};
+    };
+
+    static int64_t to_ticks(double price) { return std::llround(price / types::price_tick); }
+
+    // finite and small enough that tick arithmetic cannot overflow
+    static bool valid_price(double price) { return std::isfinite(price) && std::abs(price / types::price_tick) < 1e15; }
+
+    static constexpr uint32_t no_book = UINT32_MAX;
+
+    inline uint32_t book_for(uint32_t symbol_id, const char (&symbol)[8]) {
+        if (symbol_id == types::no_symbol_id || symbol_id >= symbol_id_limit_) [[unlikely]] {
+            return book_for(symbol);
+        }
+        if (symbol_id < book_of_id_.size() && book_of_id_[symbol_id] != no_book) [[likely]] {
+            return book_of_id_[symbol_id];
+        }
+        if (symbol_id >= book_of_id_.size()) {
+            book_of_id_.resize(symbol_id + 1, no_book);
+        }
+        return book_of_id_[symbol_id] = book_for(symbol);
+    }
+
+    uint32_t book_for(const char (&symbol)[8]) {
+        uint64_t key;
+        std::memcpy(&key, symbol, sizeof(key));
+        const auto [it, inserted] = book_index_.try_emplace(key, static_cast<uint32_t>(books_.size()));
+        if (inserted) {
+            books_.emplace_back();
+        }
+        return it->second;
+    }
+
+    OrderRef* find(uint64_t order_id) {
+        if (order_id >= orders_.size() || !orders_[order_id].live) {
+            ++unknown_orders_;
+            return nullptr;
+        }
+        return &orders_[order_id];
+    }
+
+    uint32_t symbol_id_limit_;
+    uint64_t order_id_limit_;
+    std::vector<uint32_t> book_of_id_;                   // symbol id -> books_, no_book until first seen
+    std::unordered_map<uint64_t, uint32_t> book_index_;  // packed symbol -> books_
+    std::vector<PriceLevelBook> books_;
+    std::vector<OrderRef> orders_;                       // indexed by order id
+    uint64_t applied_{0};
+    uint64_t unknown_orders_{0};
+    uint64_t dropped_{0};
+    uint64_t executed_volume_{0};
+};
+
+#endif // BOOK_BUILDER_H
@@ -0,0 +1,143 @@
+#ifndef PRICE_LEVEL_BOOK_H
+#define PRICE_LEVEL_BOOK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../utils/types.h"
+
+/*
+Aggregated (level 2) book of one symbol. Each side is a contiguous array of levels indexed by
+price tick - base tick, so applying an order touches one slot and finding the next best level after the
+touch empties is a linear scan over neighbouring cache lines instead of walking a tree.
+The window grows when a price lands outside of it, prices random walk so that is rare. It never grows past
+max_window levels, an add that would need more is refused: one bad price must not allocate gigabytes.
+ */
+class PriceLevelBook {
+public:
+    static constexpr int64_t initial_window = 512;
+    static constexpr int64_t max_window = 1 << 20;     // levels per side, 16 MB
+    static constexpr int64_t no_level = -1;
+
+    struct Level {
+        uint64_t quantity;
+        uint32_t orders;
+    };
+
+    struct Top {
+        int64_t price;      // ticks, only valid if quantity > 0
+        uint64_t quantity;
+        uint32_t orders;
+    };
+
+    // new_order: a new order joins the level rather than an existing one growing.
+    // False, and nothing changes, if the price is too far from the rest of the side to fit in max_window
+    inline bool add(types::Side side, int64_t price, uint32_t quantity, bool new_order = true) {
+        SideLevels& s = side_of(side);
+        Level* level = s.at(price);
+        if (level == nullptr) {
+            return false;
+        }
+        level->quantity += quantity;
+        level->orders += new_order;
+
+        const int64_t idx = price - s.base;
+        if (s.best == no_level || (side == types::Side::Buy ? idx > s.best : idx < s.best)) {
+            s.best = idx;
+        }
+        return true;
+    }
+
+    // order_gone: the order left the book (cancel/full fill) rather than shrinking
+    inline void remove(types::Side side, int64_t price, uint32_t quantity, bool order_gone) {
+        SideLevels& s = side_of(side);
+        const int64_t idx = price - s.base;
+        if (idx < 0 || idx >= static_cast<int64_t>(s.levels.size())) {
+            return;
+        }
+        Level& level = s.levels[idx];
+        level.quantity -= std::min<uint64_t>(quantity, level.quantity);
+        if (order_gone && level.orders > 0) {
+            level.orders -= 1;
+        }
+        if (level.quantity == 0 && idx == s.best) {
+            s.find_next_best(side);
+        }
+    }
+
+    [[nodiscard]] Top best_bid() const { return top(bids_); }
+    [[nodiscard]] Top best_ask() const { return top(asks_); }
+
+    [[nodiscard]] bool crossed() const {
+        const Top bid = best_bid();
+        const Top ask = best_ask();
+        return bid.quantity > 0 && ask.quantity > 0 && bid.price >= ask.price;
+    }
+
+    [[nodiscard]] uint64_t quantity_at(types::Side side, int64_t price) const {
+        const SideLevels& s = side == types::Side::Buy ? bids_ : asks_;
+        const int64_t idx = price - s.base;
+        if (idx < 0 || idx >= static_cast<int64_t>(s.levels.size())) {
+            return 0;
+        }
+        return s.levels[idx].quantity;
+    }
+
+private:
+    struct SideLevels {
+        int64_t base{0};
+        int64_t best{no_level};  // index into levels
+        std::vector<Level> levels;
+
+        // nullptr if reaching price would take the window past max_window
+        Level* at(int64_t price) {
+            if (levels.empty()) {
+                base = price - initial_window / 2;
+                levels.assign(initial_window, Level{});
+            }
+            const int64_t size = static_cast<int64_t>(levels.size());
+            if (price < base) {
+                if (base - price + size > max_window) return nullptr;
+                // grow downwards, double the window so repeated small moves don't keep shifting
+                const int64_t grow = std::min(std::max(base - price, size), max_window - size);
+                levels.insert(levels.begin(), grow, Level{});
+                base -= grow;
+                if (best != no_level) best += grow;
+            } else if (price - base >= size) {
+                const int64_t need = price - base + 1;
+                if (need > max_window) return nullptr;
+                levels.resize(std::min(std::max(need, size * 2), max_window), Level{});
+            }
+            return &levels[price - base];
+        }
+
+        void find_next_best(types::Side side) {
+            if (side == types::Side::Buy) {
+                for (int64_t i = best - 1; i >= 0; --i) {
+                    if (levels[i].quantity > 0) { best = i; return; }
+                }
+            } else {
+                for (int64_t i = best + 1; i < static_cast<int64_t>(levels.size()); ++i) {
+                    if (levels[i].quantity > 0) { best = i; return; }
+                }
+            }
+            best = no_level;
+        }
+    };
+
+    SideLevels& side_of(types::Side side) { return side == types::Side::Buy ? bids_ : asks_; }
+
+    static Top top(const SideLevels& s) {
+        if (s.best == no_level) {
+            return {0, 0, 0};
+        }
+        const Level& level = s.levels[s.best];
+        return {s.base + s.best, level.quantity, level.orders};
+    }
+
+    SideLevels bids_;
+    SideLevels asks_;
+};
+
+#endif // PRICE_LEVEL_BOOK_H
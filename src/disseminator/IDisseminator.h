@@ -6,6 +6,10 @@
 #include <cstring>
 #include <variant>
 #include "../utils/types.h"
+#include "../utils/Trace.h"
+#include "../shm/StatsSegment.h"
+#include "../recorder/CaptureRecorder.h"
+#include "../snapshot/SnapshotServer.h"
 
 template <typename Derived, typename MarketDataQueue>
 class IDisseminator {
@@ -23,6 +27,18 @@ public:
         }
     }
 
+    // optional tap, every message is handed to the recorder after it has been sent. Set before start().
+    void set_recorder(CaptureRecorder* recorder) { recorder_ = recorder; }
+
+    // optional last-value snapshots for late joiners, updated before each send. Set before start().
+    void set_snapshot_server(SnapshotServer* server) { snapshot_ = server; }
+
+    // optional per-stage tracing, every message goes out with its TraceTrailer behind the payload. Set before start().
+    void set_trace(TraceLog* trace) { trace_ = trace; }
+
+    // optional counters in the stats segment, updated from the disseminator thread. Set before start().
+    void set_stats(shm::DisseminatorStats* stats) { stats_ = stats; }
+
 protected:
     // derived classes can instantiate this class only
     explicit IDisseminator(MarketDataQueue& queue) : queue_(queue) {}
@@ -33,31 +49,70 @@ private:
     void run_loop(std::stop_token stoken) {
         typename MarketDataQueue::value_type msg; 
         
-        char topic_buf[10]; 
-        topic_buf[1] = ':'; // e.g., "Q:SYMBOL  " or "T:SYMBOL  "
+        char topic_buf[types::topic_header_size]; // e.g., "Q:SYMBOL  " or "T:SYMBOL  "
 
         while (queue_.pop(msg, stoken)) {
             std::visit([&](auto&& payload) {
                 using T = std::decay_t<decltype(payload)>;
                 payload.disseminate_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
              std::chrono::steady_clock::now().time_since_epoch()).count();
+                payload.sequence = ++sequence_;
+
+                // before the send, so a snapshot is never older than what a receiver has already seen
+                if (snapshot_) {
+                    snapshot_->record(payload);
+                }
+
+                types::Messages::encode_topic(payload, topic_buf);
+
+                if (trace_) [[unlikely]] {
+                    send_traced(topic_buf, payload);
+                } else {
+                    static_cast<Derived*>(this)->send_impl(topic_buf, &payload, sizeof(T));
+                }
 
-                if constexpr (std::is_same_v<T, types::Quote>) {
-                    topic_buf[0] = 'Q';
-                    std::memcpy(&topic_buf[2], payload.symbol, 8);
-                } 
-                else if constexpr (std::is_same_v<T, types::Trade>) {
-                    topic_buf[0] = 'T';
-                    std::memcpy(&topic_buf[2], payload.symbol, 8);
+                if (recorder_) {
+                    recorder_->record(topic_buf, &payload, sizeof(T), payload.disseminate_timestamp);
+                }
+
+                if (stats_) {
+                    shm::bump(stats_->sent);
+                    shm::bump(stats_->bytes, sizeof(T));
                 }
 
-                static_cast<Derived*>(this)->send_impl(topic_buf, &payload, sizeof(T));
-                
             }, msg);
+
+            // transports that batch sends get told when there is nothing more to batch with
+            if constexpr (requires(Derived& d) { d.flush_impl(); }) {
+                if (queue_.empty()) static_cast<Derived*>(this)->flush_impl();
+            }
+        }
+        if constexpr (requires(Derived& d) { d.flush_impl(); }) {
+            static_cast<Derived*>(this)->flush_impl();
         }
     }
 
+    // the trailer the generator started for this sequence, finished here and copied behind the payload
+    template <typename T>
+    void send_traced(const char* topic_buf, const T& payload) {
+        types::TraceTrailer& trailer = trace_->slot(payload.sequence);
+        trace::stamp(trailer, types::TracePoint::Dequeued, payload.disseminate_timestamp);
+        trace::stamp(trailer, types::TracePoint::PreSend);
+
+        alignas(8) std::byte wire[types::max_wire_payload_size];
+        std::memcpy(wire, &payload, sizeof(T));
+        std::memcpy(wire + sizeof(T), &trailer, sizeof(trailer));
+        static_cast<Derived*>(this)->send_impl(topic_buf, wire, sizeof(T) + sizeof(trailer));
+
+        trace_->record_post_send(payload.sequence, trace::now_ns());
+    }
+
     MarketDataQueue& queue_;
+    CaptureRecorder* recorder_{nullptr};
+    SnapshotServer* snapshot_{nullptr};
+    TraceLog* trace_{nullptr};
+    shm::DisseminatorStats* stats_{nullptr};
+    uint64_t sequence_{0};
     std::jthread worker_;
 };
 
@@ -0,0 +1,33 @@
+#ifndef SHM_DISSEMINATOR_H
+#define SHM_DISSEMINATOR_H
+
+#include "IDisseminator.h"
+#include "../shm/ShmRing.h"
+
+#include <string>
+#include <spdlog/spdlog.h>
+
+// Writes the stream into a shared memory ring for feed handlers on the same host, see ShmRing.h
+template <typename MarketDataQueue>
+class ShmDisseminator final : public IDisseminator<ShmDisseminator<MarketDataQueue>, MarketDataQueue> {
+public:
+    ShmDisseminator(MarketDataQueue& queue, const std::string& name, uint64_t slot_count)
+        : IDisseminator<ShmDisseminator<MarketDataQueue>, MarketDataQueue>(queue),
+          ring_(name, slot_count) {
+        spdlog::info("ShmDisseminator writing to shared memory {} ({} slots, {} KiB)", name, slot_count,
+                     shm::segment_size(slot_count) >> 10);
+    }
+
+    ~ShmDisseminator() {
+        this->stop();
+    }
+
+    inline void send_impl(const char* topic_buf, const void* payload_data, size_t payload_size) {
+        ring_.publish(topic_buf, payload_data, payload_size);
+    }
+
+private:
+    ShmRingWriter ring_;
+};
+
+#endif // SHM_DISSEMINATOR_H
@@ -6,6 +6,9 @@
 #define UDP_DISSEMINATOR_H
 
 #include "IDisseminator.h"
+#include "../utils/IoUring.h"
+#include "../utils/Timestamping.h"
+#include "../utils/UdpIo.h"
 #include "../utils/types.h"
 
 #include <cstddef>
@@ -13,18 +16,25 @@
 #include <cstring>
 #include <stdexcept>
 #include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 
 template <typename MarketDataQueue>
 class UdpDisseminator final : public IDisseminator<UdpDisseminator<MarketDataQueue>, MarketDataQueue> {
 public:
-    UdpDisseminator(MarketDataQueue& queue, const std::string& ip, unsigned short port)
-        : IDisseminator<UdpDisseminator<MarketDataQueue>, MarketDataQueue>(queue) {
+    static constexpr size_t datagram_size = types::topic_header_size + types::max_wire_payload_size;
+
+    UdpDisseminator(MarketDataQueue& queue, const std::string& ip, unsigned short port, UdpIoOptions io = {})
+        : IDisseminator<UdpDisseminator<MarketDataQueue>, MarketDataQueue>(queue), io_(io) {
 
         sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
         if (sock_ < 0) {
@@ -48,34 +58,295 @@ public:
         inet_pton(AF_INET, ip.c_str(), &dest_addr.sin_addr);
 
         dest_addr_ = dest_addr;
+
+        if (io_.gso) {
+            setup_gso();
+        } else if (io_.mode == UdpIoMode::Batched) {
+            setup_batched();
+        } else if (io_.mode == UdpIoMode::IoUring) {
+            setup_uring();
+        }
+        if (io_.timestamps != KernelTimestamps::Off) {
+            setup_timestamps();
+        }
+        spdlog::info("UdpDisseminator sending to {}:{} ({} I/O{}{}{})", ip, port, udp_io_mode_name(io_.mode),
+                     io_.mode == UdpIoMode::IoUring && io_.sqpoll ? ", sqpoll" : "", io_.gso ? ", gso" : "",
+                     io_.timestamps != KernelTimestamps::Off ? ", kernel timestamps" : "");
     }
 
     ~UdpDisseminator() {
         this->stop();
+        tx_stamps_.reset(); // its thread reads the socket's error queue
+        if (ring_) {
+            // the kernel still reads from the send slots until the writes complete
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+            while (in_flight_ > 0 && std::chrono::steady_clock::now() < deadline) {
+                ring_->submit(1);
+                reap();
+            }
+        }
         if (sock_ >= 0) {
             close(sock_);
         }
     }
 
     inline void send_impl(const char* topic_buf, const void* payload_data, size_t payload_size) {
-        constexpr size_t buffer_size = types::topic_header_size + std::max(sizeof(types::Quote), sizeof(types::Trade));
+        const size_t size = types::topic_header_size + payload_size; // only send the actual size
+        ++stats_.messages;
+
+        if (io_.gso) {
+            send_gso(topic_buf, payload_data, payload_size);
+            return;
+        }
+        if (io_.mode == UdpIoMode::Batched) {
+            std::byte* datagram = batch_buffer_.data() + batch_count_ * datagram_size;
+            std::memcpy(datagram, topic_buf, types::topic_header_size);
+            std::memcpy(datagram + types::topic_header_size, payload_data, payload_size);
+            batch_iov_[batch_count_].iov_len = size;
+            if (tx_stamps_) tx_stamps_->on_send(sequence_of(payload_data), 1);
+            if (++batch_count_ == io_.batch) flush_impl();
+            return;
+        }
+        if (io_.mode == UdpIoMode::IoUring) {
+            send_uring(topic_buf, payload_data, payload_size);
+            return;
+        }
 
-        std::byte datagram[buffer_size];
+        std::byte datagram[datagram_size];
 
         std::memcpy(datagram, topic_buf, types::topic_header_size);
         std::memcpy(datagram + types::topic_header_size, payload_data, payload_size);
 
-        sendto(sock_,
-               datagram,
-               types::topic_header_size + payload_size, // only send the actual size
-               0,
-               reinterpret_cast<const struct sockaddr*>(&dest_addr_),
-               sizeof(dest_addr_));
+        if (tx_stamps_) tx_stamps_->on_send(sequence_of(payload_data), 1);
+        ++stats_.syscalls;
+        if (sendto(sock_,
+                   datagram,
+                   size,
+                   0,
+                   reinterpret_cast<const struct sockaddr*>(&dest_addr_),
+                   sizeof(dest_addr_)) < 0) {
+            ++stats_.errors;
+        }
+    }
+
+    // called by the run loop whenever the queue is empty, nothing is held back waiting for a full batch
+    inline void flush_impl() {
+        if (io_.gso) {
+            if (gso_count_ > 0) flush_gso();
+        } else if (io_.mode == UdpIoMode::Batched) {
+            std::size_t sent = 0;
+            while (sent < batch_count_) {
+                ++stats_.syscalls;
+                const int n = sendmmsg(sock_, batch_msgs_.data() + sent, static_cast<unsigned>(batch_count_ - sent), 0);
+                if (n <= 0) {
+                    // drop the datagram sendmmsg choked on, like a failed sendto would
+                    ++stats_.errors;
+                    ++sent;
+                    continue;
+                }
+                sent += static_cast<std::size_t>(n);
+            }
+            batch_count_ = 0;
+        } else if (io_.mode == UdpIoMode::IoUring && queued_ > 0) {
+            submit_uring();
+        }
+    }
+
+    // disseminator thread only, or after stop()
+    [[nodiscard]] UdpIoStats io_stats() const {
+        UdpIoStats s = stats_;
+        if (ring_) s.syscalls = ring_->enter_calls();
+        return s;
     }
 
+    // kernel TX stamps by message sequence, nullptr unless io.timestamps is on. Read them after stop()ing it.
+    [[nodiscard]] TxTimestampCollector* tx_timestamps() { return tx_stamps_.get(); }
+
 private:
+    // the run loop has already stamped the sequence into the payload
+    static uint64_t sequence_of(const void* payload_data) {
+        uint64_t sequence;
+        std::memcpy(&sequence, static_cast<const std::byte*>(payload_data) + types::sequence_offset, sizeof(sequence));
+        return sequence;
+    }
+
+    void setup_timestamps() {
+        // io_uring may punt a send to a worker, the kernel's send numbering would no longer follow the SQ order
+        if (io_.mode == UdpIoMode::IoUring) throw std::invalid_argument("Kernel timestamps work with the syscall and batched modes, not io_uring");
+        // the TX stamps queue up on the socket's error queue, which is charged against the receive buffer
+        int rcv_buf = 1024 * 1024 * 8;
+        setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &rcv_buf, sizeof(rcv_buf));
+        tx_stamps_ = std::make_unique<TxTimestampCollector>(sock_, io_.timestamps);
+    }
+
+    void setup_batched() {
+        if (io_.batch == 0) throw std::invalid_argument("UDP batch size must be at least 1");
+        batch_buffer_.resize(io_.batch * datagram_size);
+        batch_iov_.resize(io_.batch);
+        batch_msgs_.resize(io_.batch);
+        for (std::size_t i = 0; i < io_.batch; ++i) {
+            batch_iov_[i].iov_base = batch_buffer_.data() + i * datagram_size;
+            msghdr& hdr = batch_msgs_[i].msg_hdr;
+            hdr = msghdr{};
+            hdr.msg_name = &dest_addr_;
+            hdr.msg_namelen = sizeof(dest_addr_);
+            hdr.msg_iov = &batch_iov_[i];
+            hdr.msg_iovlen = 1;
+        }
+    }
+
+    void setup_gso() {
+        if (io_.mode == UdpIoMode::IoUring) throw std::invalid_argument("UDP GSO works with the syscall and batched modes, not io_uring");
+        if (io_.batch == 0) throw std::invalid_argument("UDP batch size must be at least 1");
+        gso_limit_ = std::min(io_.batch, udp_gso_max_segments);
+        gso_buffer_.resize(gso_limit_ * datagram_size);
+
+        gso_iov_ = {gso_buffer_.data(), 0};
+        gso_msg_ = msghdr{};
+        gso_msg_.msg_name = &dest_addr_;
+        gso_msg_.msg_namelen = sizeof(dest_addr_);
+        gso_msg_.msg_iov = &gso_iov_;
+        gso_msg_.msg_iovlen = 1;
+    }
+
+    /*
+    UDP_SEGMENT cuts the buffer into datagrams of the first one's size, only the last may be shorter. So a run
+    ends at a longer datagram (sent with the next run) or right after a shorter one; trades inside a quote stream
+    split the runs, a quote-only stream goes out batch datagrams per syscall.
+     */
+    inline void send_gso(const char* topic_buf, const void* payload_data, size_t payload_size) {
+        const size_t size = types::topic_header_size + payload_size;
+        if (gso_count_ > 0 && size > gso_segment_) flush_gso();
+        if (gso_count_ == 0) {
+            gso_segment_ = size;
+            gso_first_sequence_ = sequence_of(payload_data);
+        }
+
+        std::byte* datagram = gso_buffer_.data() + gso_used_;
+        std::memcpy(datagram, topic_buf, types::topic_header_size);
+        std::memcpy(datagram + types::topic_header_size, payload_data, payload_size);
+        gso_used_ += size;
+        ++gso_count_;
+        if (size < gso_segment_ || gso_count_ == gso_limit_) flush_gso();
+    }
+
+    inline void flush_gso() {
+        gso_iov_.iov_len = gso_used_;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))];
+        if (gso_count_ > 1) {
+            gso_msg_.msg_control = control;
+            gso_msg_.msg_controllen = sizeof(control);
+            cmsghdr* cm = CMSG_FIRSTHDR(&gso_msg_);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const auto segment = static_cast<uint16_t>(gso_segment_);
+            std::memcpy(CMSG_DATA(cm), &segment, sizeof(segment));
+        } else {
+            gso_msg_.msg_control = nullptr;
+            gso_msg_.msg_controllen = 0;
+        }
+        // the whole run is one send to the kernel and gets one TX stamp
+        if (tx_stamps_) tx_stamps_->on_send(gso_first_sequence_, gso_count_);
+        ++stats_.syscalls;
+        if (sendmsg(sock_, &gso_msg_, 0) < 0) stats_.errors += gso_count_;
+        gso_count_ = 0;
+        gso_used_ = 0;
+    }
+
+    /*
+    The socket is connected to the group so a plain write sends a datagram there, which lets the send be a
+    WRITE_FIXED: socket as fixed file 0, every send slot inside one registered buffer. A slot is busy from the
+    copy until its completion comes back.
+     */
+    void setup_uring() {
+        if (io_.batch == 0 || io_.ring_entries == 0) throw std::invalid_argument("UDP batch and ring size must be at least 1");
+        if (connect(sock_, reinterpret_cast<const struct sockaddr*>(&dest_addr_), sizeof(dest_addr_)) < 0) {
+            throw std::runtime_error("Failed to connect UDP socket to the multicast group");
+        }
+        ring_ = std::make_unique<IoUring>(IoUring::Options{.entries = io_.ring_entries, .sqpoll = io_.sqpoll});
+        ring_->register_files(&sock_, 1);
+
+        slots_.resize(static_cast<std::size_t>(io_.ring_entries) * datagram_size);
+        const iovec region{slots_.data(), slots_.size()};
+        ring_->register_buffers(&region, 1);
+        free_slots_.reserve(io_.ring_entries);
+        for (unsigned i = io_.ring_entries; i > 0; --i) free_slots_.push_back(i - 1);
+    }
+
+    inline void send_uring(const char* topic_buf, const void* payload_data, size_t payload_size) {
+        reap();
+        while (free_slots_.empty()) {
+            // every slot in flight, push out what is queued and wait for the kernel to finish some
+            ring_->submit(1);
+            reap();
+        }
+        const unsigned slot = free_slots_.back();
+        free_slots_.pop_back();
+
+        std::byte* datagram = slots_.data() + static_cast<std::size_t>(slot) * datagram_size;
+        std::memcpy(datagram, topic_buf, types::topic_header_size);
+        std::memcpy(datagram + types::topic_header_size, payload_data, payload_size);
+
+        io_uring_sqe* sqe = ring_->get_sqe();
+        while (sqe == nullptr) {
+            submit_uring();
+            std::this_thread::yield();
+            sqe = ring_->get_sqe();
+        }
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->flags = IOSQE_FIXED_FILE;
+        sqe->fd = 0;
+        sqe->addr = reinterpret_cast<uint64_t>(datagram);
+        sqe->len = static_cast<uint32_t>(types::topic_header_size + payload_size);
+        sqe->buf_index = 0;
+        sqe->user_data = slot;
+        ++in_flight_;
+        if (++queued_ >= io_.batch) submit_uring();
+    }
+
+    inline void submit_uring() {
+        ring_->submit();
+        queued_ = 0;
+    }
+
+    inline void reap() {
+        ring_->for_each_cqe([this](const io_uring_cqe& cqe) {
+            if (cqe.res < 0) ++stats_.errors;
+            free_slots_.push_back(static_cast<unsigned>(cqe.user_data));
+            --in_flight_;
+        });
+    }
+
     int sock_{-1};
     struct sockaddr_in dest_addr_{};
+    UdpIoOptions io_;
+    UdpIoStats stats_;
+
+    // batched
+    std::vector<std::byte> batch_buffer_;
+    std::vector<iovec> batch_iov_;
+    std::vector<mmsghdr> batch_msgs_;
+    std::size_t batch_count_{0};
+
+    // gso
+    std::vector<std::byte> gso_buffer_;
+    iovec gso_iov_{};
+    msghdr gso_msg_{};
+    std::size_t gso_used_{0};
+    std::size_t gso_segment_{0};
+    unsigned gso_count_{0};
+    unsigned gso_limit_{0};
+    uint64_t gso_first_sequence_{0};
+
+    std::unique_ptr<TxTimestampCollector> tx_stamps_;
+
+    // io_uring, declared after the slots so the ring is closed before they are freed
+    std::vector<std::byte> slots_;
+    std::unique_ptr<IoUring> ring_;
+    std::vector<unsigned> free_slots_;
+    unsigned queued_{0};
+    unsigned in_flight_{0};
 };
 
 
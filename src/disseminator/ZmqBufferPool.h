@@ -0,0 +1,68 @@
+#ifndef ZMQ_BUFFER_POOL_H
+#define ZMQ_BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "../utils/types.h"
+
+/*
+Fixed ring of message buffers for zero-copy zmq sends (zmq_msg_init_data): the publisher fills a slot and hands
+it to zmq, zmq calls release() from its io thread once the bytes are on the wire (or dropped), and the slot is
+free again. No malloc/free per message on either side.
+Slots are taken strictly in ring order, so acquire() is one load. If the next slot is still owned by zmq the
+ring has wrapped onto messages zmq hasn't written yet, the caller falls back to a copying send.
+The pool must outlive every message handed out, i.e. the zmq context.
+ */
+class ZmqBufferPool {
+public:
+    // one message: single-frame header plus the largest payload, rounded up to whole cache lines
+    static constexpr std::size_t slot_size = (types::single_frame_header_size + types::max_wire_payload_size + 63) / 64 * 64;
+
+    explicit ZmqBufferPool(std::size_t slots) : slots_(std::make_unique<Slot[]>(slots)), count_(slots) {}
+
+    ZmqBufferPool(const ZmqBufferPool&) = delete;
+    ZmqBufferPool& operator=(const ZmqBufferPool&) = delete;
+
+    // publisher thread only. Buffer of slot_size bytes and the hint to pass to zmq alongside release, or nullptr
+    inline char* acquire(void*& hint) {
+        Slot& slot = slots_[next_];
+        if (slot.busy.load(std::memory_order_acquire)) {
+            ++exhausted_;
+            return nullptr;
+        }
+        slot.busy.store(true, std::memory_order_relaxed);
+        next_ = next_ + 1 == count_ ? 0 : next_ + 1;
+        hint = &slot;
+        return slot.data;
+    }
+
+    // zmq_free_fn, called by zmq from whichever thread drops the last reference
+    static void release(void* /*data*/, void* hint) {
+        static_cast<Slot*>(hint)->busy.store(false, std::memory_order_release);
+    }
+
+    [[nodiscard]] std::size_t in_flight() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < count_; ++i) n += slots_[i].busy.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    // acquires that found the ring full
+    [[nodiscard]] uint64_t exhausted() const { return exhausted_; }
+    [[nodiscard]] std::size_t size() const { return count_; }
+
+private:
+    struct alignas(64) Slot {
+        char data[slot_size];
+        std::atomic<bool> busy{false};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t count_;
+    std::size_t next_{0};
+    uint64_t exhausted_{0};
+};
+
+#endif // ZMQ_BUFFER_POOL_H
@@ -2,23 +2,64 @@
 #define ZMQ_DISSEMINATOR_H
 
 #include "IDisseminator.h"
+#include "ZmqBufferPool.h"
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <vector>
 #include <zmq.hpp>
 #include <zmq_addon.hpp>
 #include <spdlog/spdlog.h>
 
+/*
+How messages go on the wire.
+    two frames (default)   topic frame, then payload frame. Two zmq messages per market data message.
+    single_frame           one frame, topic padded to types::single_frame_header_size then the payload. zmq prefix
+                           subscriptions still work since the topic is the start of the frame.
+    zero_copy              frames are built in a ZmqBufferPool slot and handed to zmq (zmq_msg_init_data) instead of
+                           zmq allocating and copying. Falls back to a copy when every slot is still in flight.
+The feed handler tells the two framings apart per message, no need to configure it.
+
+Socket settings:
+    context      shared zmq context, required for inproc:// endpoints (subscribers must use the same one).
+                 nullptr -> the disseminator owns a context with io_threads I/O threads.
+    sndhwm       messages queued per subscriber before PUB drops for that subscriber, 0 = unlimited
+    sndbuf       kernel send buffer for tcp/ipc, 0 = OS default
+ */
+struct ZmqPublishOptions {
+    bool single_frame = false;
+    bool zero_copy = false;
+    std::size_t pool_slots = 8192;
+    zmq::context_t* context = nullptr;
+    int io_threads = 1;
+    int sndhwm = 1000;
+    int sndbuf = 0;
+};
+
 template <typename MarketDataQueue>
 class ZmqDisseminator final : public IDisseminator<ZmqDisseminator<MarketDataQueue>, MarketDataQueue> {
 public:
-    ZmqDisseminator(MarketDataQueue& queue, std::string_view multicast_addr)
+    // endpoints: one or more comma separated bind addresses, e.g. "tcp://127.0.0.1:5555,ipc:///tmp/md.ipc".
+    // All of them carry the same stream.
+    ZmqDisseminator(MarketDataQueue& queue, std::string_view endpoints, ZmqPublishOptions options = {})
         : IDisseminator<ZmqDisseminator<MarketDataQueue>, MarketDataQueue>(queue),
-          context_(1),
-          pub_socket_(context_, zmq::socket_type::pub)
+          options_(options),
+          pool_(options.zero_copy ? std::make_unique<ZmqBufferPool>(options.pool_slots) : nullptr),
+          own_context_(options.context ? nullptr : std::make_unique<zmq::context_t>(options.io_threads)),
+          pub_socket_(options.context ? *options.context : *own_context_, zmq::socket_type::pub)
     {
         try {
-            pub_socket_.bind(std::string{multicast_addr});
             pub_socket_.set(zmq::sockopt::linger, 0);
-            spdlog::info("ZmqDisseminator bound to PUB: {}", multicast_addr);
+            pub_socket_.set(zmq::sockopt::sndhwm, options_.sndhwm);
+            if (options_.sndbuf > 0) pub_socket_.set(zmq::sockopt::sndbuf, options_.sndbuf);
+            for (const std::string& endpoint : split_endpoints(endpoints)) {
+                pub_socket_.bind(endpoint);
+                spdlog::info("ZmqDisseminator bound to PUB: {} ({}, {}, {} io threads, sndhwm {})", endpoint,
+                             options_.single_frame ? "single frame" : "two frames", options_.zero_copy ? "zero copy" : "copy",
+                             options_.context ? "shared" : std::to_string(options_.io_threads), options_.sndhwm);
+            }
         } catch (const zmq::error_t& e) {
             spdlog::error("ZMQ Bind Error: {}", e.what());
             throw;
@@ -30,20 +71,79 @@ public:
         if (pub_socket_.handle() != nullptr) {
             pub_socket_.close();
         }
+        // a shared context outlives us and tears the socket down in the background, the pool has to wait for
+        // zmq to give its buffers back. Better leaked than freed under zmq's feet.
+        if (pool_ && options_.context) {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+            while (pool_->in_flight() > 0 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (pool_->in_flight() > 0) {
+                spdlog::warn("ZmqDisseminator: {} pool buffers still held by zmq, leaking the pool", pool_->in_flight());
+                (void)pool_.release();
+            }
+        }
     }
 
     inline void send_impl(const char* topic_buf, const void* payload_data, size_t payload_size) {
-        zmq::message_t topic_msg(topic_buf, 10);
-        zmq::message_t payload_msg(payload_size);
-        std::memcpy(payload_msg.data(), payload_data, payload_size);
+        if (options_.single_frame) {
+            send_single_frame(topic_buf, payload_data, payload_size);
+            return;
+        }
+
+        zmq::message_t topic_msg(topic_buf, types::topic_header_size);
+        zmq::message_t payload_msg;
+        void* hint = nullptr;
+        if (char* buf = pool_ ? pool_->acquire(hint) : nullptr) {
+            std::memcpy(buf, payload_data, payload_size);
+            payload_msg = zmq::message_t(buf, payload_size, &ZmqBufferPool::release, hint);
+        } else {
+            payload_msg = zmq::message_t(payload_data, payload_size);
+        }
 
         pub_socket_.send(topic_msg, zmq::send_flags::sndmore);
         pub_socket_.send(payload_msg, zmq::send_flags::none);
     }
 
+    // sends that wanted a pool slot and had to copy instead
+    [[nodiscard]] uint64_t zero_copy_fallbacks() const { return pool_ ? pool_->exhausted() : 0; }
+
+    static std::vector<std::string> split_endpoints(std::string_view endpoints) {
+        std::vector<std::string> out;
+        while (!endpoints.empty()) {
+            const std::size_t comma = endpoints.find(',');
+            if (const std::string_view e = endpoints.substr(0, comma); !e.empty()) out.emplace_back(e);
+            if (comma == std::string_view::npos) break;
+            endpoints.remove_prefix(comma + 1);
+        }
+        if (out.empty()) throw std::invalid_argument("ZmqDisseminator needs at least one endpoint");
+        return out;
+    }
+
 private:
-    zmq::context_t context_;
+    inline void send_single_frame(const char* topic_buf, const void* payload_data, size_t payload_size) {
+        const std::size_t size = types::single_frame_header_size + payload_size;
+        zmq::message_t msg;
+        void* hint = nullptr;
+        if (char* buf = pool_ ? pool_->acquire(hint) : nullptr) {
+            msg = zmq::message_t(buf, size, &ZmqBufferPool::release, hint);
+        } else {
+            msg.rebuild(size);
+        }
+
+        char* out = static_cast<char*>(msg.data());
+        std::memcpy(out, topic_buf, types::topic_header_size);
+        std::memset(out + types::topic_header_size, 0, types::single_frame_header_size - types::topic_header_size);
+        std::memcpy(out + types::single_frame_header_size, payload_data, payload_size);
+
+        pub_socket_.send(msg, zmq::send_flags::none);
+    }
+
+    ZmqPublishOptions options_;
+    // declared before the context: zmq may still hold pool buffers until the context is gone
+    std::unique_ptr<ZmqBufferPool> pool_;
+    std::unique_ptr<zmq::context_t> own_context_; // unset when the context is shared
     zmq::socket_t pub_socket_;
 };
 
-#endif
\ No newline at end of file
+#endif
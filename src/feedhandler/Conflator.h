@@ -0,0 +1,156 @@
+#ifndef CONFLATOR_H
+#define CONFLATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <variant>
+#include <vector>
+#include "LastValueCache.h"
+#include "../utils/CustomSpscQueue.h"
+#include "../utils/types.h"
+
+/*
+Optional stage between a feed handler and a consumer that cannot keep up. The receive thread push()es every
+message and never waits, the consumer drain()s at its own pace:
+    Quote       conflated, only the latest per symbol id is kept (seqlock slot array) and its id goes on a
+                dirty list the first time it changes after the consumer last took it
+    the rest    passed through untouched in arrival order (trades must never be conflated, nor order messages),
+                dropped and counted only if the consumer is a whole queue behind
+A slow consumer then sees fewer, fresher quotes instead of a growing backlog (TCP) or random loss (UDP).
+The dirty list holds each id at most once, so it never needs more than id_limit entries.
+
+Staleness of a delivered quote is measured from the receipt of the oldest update it stands in for, i.e. how long
+the consumer's view of that symbol was out of date.
+ */
+template <std::size_t PassThroughCapacity = 65536>
+class BasicConflator {
+public:
+    struct Stats {
+        uint64_t quotes_in;
+        uint64_t quotes_out;
+        uint64_t passed_through;
+        uint64_t pass_through_dropped;
+    };
+
+    explicit BasicConflator(uint32_t id_limit)
+        : latest_(id_limit),
+          dirty_since_(std::make_unique<std::atomic<uint64_t>[]>(id_limit)),
+          dirty_ids_(std::make_unique<uint32_t[]>(std::max<uint32_t>(id_limit, 1))),
+          id_limit_(id_limit),
+          taken_version_(id_limit, 0) {}
+
+    // receive thread, same signature as a sink so it can sit behind set_callback or a template sink
+    template <typename T>
+        requires (types::Messages::contains<T>)
+    void push(const T& msg, uint64_t recv_ts) {
+        if constexpr (std::is_same_v<T, types::Quote>) {
+            if (msg.symbol_id != types::no_symbol_id && msg.symbol_id < id_limit_) {
+                quotes_in_.fetch_add(1, std::memory_order_relaxed);
+                latest_.store(msg.symbol_id, Latest{msg, recv_ts});
+                uint64_t clean = 0;
+                if (dirty_since_[msg.symbol_id].compare_exchange_strong(clean, std::max<uint64_t>(recv_ts, 1), std::memory_order_acq_rel)) {
+                    const std::size_t tail = dirty_tail_.load(std::memory_order_relaxed);
+                    dirty_ids_[tail % id_limit_] = msg.symbol_id;
+                    dirty_tail_.store(tail + 1, std::memory_order_release);
+                }
+                return;
+            }
+            // no usable id, nothing to conflate on
+        }
+        if (!pass_through_.push(Entry{msg, recv_ts})) {
+            pass_through_dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+    Consumer thread: hands up to max_messages to consumer(msg, recv_ts), passed-through messages first, then the
+    dirty quotes. For a quote recv_ts is the receipt of that (latest) update. Returns the number delivered.
+     */
+    template <typename Consumer>
+    std::size_t drain(Consumer&& consumer, std::size_t max_messages = std::numeric_limits<std::size_t>::max()) {
+        std::size_t delivered = 0;
+        Entry entry;
+        while (delivered < max_messages && pass_through_.pop(entry)) {
+            std::visit([&](const auto& msg) { consumer(msg, entry.recv_ts); }, entry.msg);
+            ++delivered;
+            passed_through_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::size_t head = dirty_head_.load(std::memory_order_relaxed);
+        const std::size_t tail = dirty_tail_.load(std::memory_order_acquire);
+        Latest latest;
+        for (; delivered < max_messages && head != tail; ++head) {
+            const uint32_t id = dirty_ids_[head % id_limit_];
+            // clear before reading, an update landing after this marks the id dirty again
+            const uint64_t since = dirty_since_[id].exchange(0, std::memory_order_acq_rel);
+            uint64_t version;
+            if (!latest_.read(id, latest, version)) continue;
+            // an update between the clear and the read was already taken here, its dirty mark has nothing new
+            if (version == taken_version_[id]) continue;
+            taken_version_[id] = version;
+
+            consumer(latest.quote, latest.recv_ts);
+            ++delivered;
+            quotes_out_.fetch_add(1, std::memory_order_relaxed);
+            const uint64_t now = now_ns();
+            staleness_ns_.push_back(now - std::min(since, now));
+        }
+        dirty_head_.store(head, std::memory_order_release);
+        return delivered;
+    }
+
+    [[nodiscard]] Stats stats() const {
+        return {quotes_in_.load(std::memory_order_relaxed), quotes_out_.load(std::memory_order_relaxed),
+                passed_through_.load(std::memory_order_relaxed), pass_through_dropped_.load(std::memory_order_relaxed)};
+    }
+
+    // quotes received per quote delivered, 1 means nothing was conflated
+    [[nodiscard]] double conflation_ratio() const {
+        const Stats s = stats();
+        return s.quotes_out == 0 ? 0.0 : static_cast<double>(s.quotes_in) / static_cast<double>(s.quotes_out);
+    }
+
+    // one sample per delivered quote, consumer thread (or after it stopped)
+    [[nodiscard]] const std::vector<uint64_t>& quote_staleness() const { return staleness_ns_; }
+
+private:
+    struct Latest {
+        types::Quote quote;
+        uint64_t recv_ts;
+    };
+
+    struct Entry {
+        types::MarketDataMsg msg;
+        uint64_t recv_ts;
+    };
+
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    LastValueCache<Latest> latest_;
+    std::unique_ptr<std::atomic<uint64_t>[]> dirty_since_;   // receipt of the first update not yet taken, 0 = clean
+    std::unique_ptr<uint32_t[]> dirty_ids_;                  // ring of dirty ids, single producer single consumer
+    alignas(64) std::atomic<std::size_t> dirty_head_{0};
+    alignas(64) std::atomic<std::size_t> dirty_tail_{0};
+    uint32_t id_limit_;
+
+    CustomSpscQueue<Entry, PassThroughCapacity> pass_through_;
+
+    std::atomic<uint64_t> quotes_in_{0};
+    std::atomic<uint64_t> pass_through_dropped_{0};
+    alignas(64) std::atomic<uint64_t> quotes_out_{0};
+    std::atomic<uint64_t> passed_through_{0};
+    std::vector<uint64_t> taken_version_;                    // consumer side, cache version last delivered per id
+    std::vector<uint64_t> staleness_ns_;
+};
+
+using Conflator = BasicConflator<>;
+
+#endif // CONFLATOR_H
@@ -5,13 +5,21 @@
 #ifndef IFEEDHANDLER_H
 #define IFEEDHANDLER_H
 
+#include <span>
+#include <string>
 #include <thread>
 #include <stop_token>
 #include <string_view>
 #include <spdlog/spdlog.h>
+#include "LastValueCache.h"
+#include "MessageSink.h"
+#include "SnapshotSplicer.h"
+#include "SubscriptionFilter.h"
+#include "../shm/StatsSegment.h"
 #include "../utils/types.h"
+#include "../utils/Trace.h"
 
-template <typename Derived>
+template <typename Derived, MessageSink Sink = FunctionSink>
 class IFeedHandler {
 public:
     void start() {
@@ -37,35 +45,182 @@ public:
         static_cast<Derived*>(this)->unsubscribe_impl(symbol);
     }
 
-    void set_quote_callback(std::function<void(const types::Quote&, uint64_t)> cb) { on_quote_ = std::move(cb); }
-    void set_trade_callback(std::function<void(const types::Trade&, uint64_t)> cb) { on_trade_ = std::move(cb); }
+    // bulk versions, the whole list lands in the receive loop as one filter swap. Entries can be patterns, see SubscriptionFilter
+    uint64_t subscribe(std::span<const std::string> patterns, SubscriptionFilter::TypeMask types = SubscriptionFilter::all_types) {
+        return update_subscriptions([&](SubscriptionFilter& filter) {
+            for (const auto& pattern : patterns) filter.add(pattern, types);
+        });
+    }
+
+    uint64_t unsubscribe(std::span<const std::string> patterns, SubscriptionFilter::TypeMask types = SubscriptionFilter::all_types) {
+        return update_subscriptions([&](SubscriptionFilter& filter) {
+            for (const auto& pattern : patterns) filter.remove(pattern, types);
+        });
+    }
+
+    // arbitrary edit of a copy of the current filter, published atomically. Returns the new filter generation
+    template <typename Edit>
+    uint64_t update_subscriptions(Edit&& edit) {
+        return subscriptions_.update(std::forward<Edit>(edit));
+    }
+
+    // lets the receive loop filter on the dense symbol id in the message (bitmap) instead of the symbol
+    uint64_t set_symbol_directory(std::shared_ptr<const SymbolDirectory> directory) {
+        return update_subscriptions([&](SubscriptionFilter& filter) { filter.set_directory(std::move(directory)); });
+    }
+
+    // the receive loop has picked up the latest subscription change
+    [[nodiscard]] bool subscriptions_applied() const {
+        return subscriptions_.acknowledged_generation() >= subscriptions_.published_generation();
+    }
+
+    // runtime callbacks, only with the default FunctionSink
+    template <typename T>
+        requires (types::Messages::contains<T> && std::same_as<Sink, FunctionSink>)
+    void set_callback(types::Messages::callback<T> cb) {
+        sink_.template set<T>(std::move(cb));
+    }
+
+    // registers one generic callable for several message types, e.g. all order messages into a book builder
+    template <typename... Ts, typename F>
+        requires std::same_as<Sink, FunctionSink>
+    void set_callbacks(F&& f) {
+        (set_callback<Ts>(types::Messages::callback<Ts>(f)), ...);
+    }
+
+    void set_quote_callback(types::Messages::callback<types::Quote> cb) requires std::same_as<Sink, FunctionSink> {
+        set_callback<types::Quote>(std::move(cb));
+    }
+    void set_trade_callback(types::Messages::callback<types::Trade> cb) requires std::same_as<Sink, FunctionSink> {
+        set_callback<types::Trade>(std::move(cb));
+    }
+
+    Sink& sink() { return sink_; }
+
+    // latest T per symbol id, kept up to date by the receive thread. Enable before start(), read from any thread.
+    template <typename T>
+        requires (types::Messages::contains<T>)
+    const LastValueCache<T>& enable_last_value_cache(uint32_t id_limit) {
+        auto& cache = std::get<CachePtr<T>>(caches_);
+        cache = std::make_unique<LastValueCache<T>>(id_limit);
+        return *cache;
+    }
+
+    // nullptr unless enabled
+    template <typename T>
+        requires (types::Messages::contains<T>)
+    const LastValueCache<T>* last_value_cache() const { return std::get<CachePtr<T>>(caches_).get(); }
+
+    /*
+    Late join: buffers live packets, fetches a snapshot from a SnapshotServer and has the receive thread splice
+    the two (see SnapshotSplicer). Blocks for the request only, returns the snapshot sequence; the splice happens
+    on the next pass of the receive loop, poll snapshot_spliced(). Throws if the server cannot be reached, the
+    buffered packets are delivered anyway.
+     */
+    uint64_t request_snapshot(const std::string& host, unsigned short port,
+                              SubscriptionFilter::TypeMask types = SubscriptionFilter::all_types) {
+        splicer_.begin();
+        snapshot::Snapshot received;
+        try {
+            received = snapshot::fetch(host, port, types);
+        } catch (...) {
+            splicer_.hand_over({});
+            throw;
+        }
+        const uint64_t sequence = received.sequence;
+        splicer_.hand_over(std::move(received));
+        return sequence;
+    }
+
+    [[nodiscard]] bool snapshot_spliced() const { return splicer_.idle(); }
+
+    // inside a callback: the trace trailer that came with the message being delivered, nullptr if it had none
+    [[nodiscard]] const types::TraceTrailer* current_trace() const { return traced_ ? &trace_ : nullptr; }
+
+    // optional counters in the stats segment, updated from the receive thread. Set before start().
+    void set_stats(shm::FeedHandlerStats* stats) { stats_ = stats; }
+
+    // of the last splice, valid once snapshot_spliced()
+    [[nodiscard]] const SnapshotSplicer::Stats& snapshot_stats() const { return splicer_.stats(); }
 
 
 protected:
-    IFeedHandler() = default;
+    explicit IFeedHandler(Sink sink = Sink{}) : sink_(std::move(sink)) {}
     ~IFeedHandler() = default;
 
-    void deliver_to_client(const types::Quote& quote) {
-        if (on_quote_) {
+    template <typename T>
+    void deliver_to_client(const T& msg) {
+        if (auto* cache = std::get<CachePtr<T>>(caches_).get()) {
+            cache->store(msg.symbol_id, msg);
+        }
+        if constexpr (SinkFor<Sink, T>) {
             uint64_t t3 = std::chrono::duration_cast<std::chrono::nanoseconds>(
                 std::chrono::steady_clock::now().time_since_epoch()).count();
-            on_quote_(quote, t3); // callback should handle msg and receive_timestamp
+            sink_(msg, t3); // sink should handle msg and receive_timestamp
         }
     }
 
-    void deliver_to_client(const types::Trade& trade) {
-        if (on_trade_) {
-            uint64_t t3 = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                std::chrono::steady_clock::now().time_since_epoch()).count();
-            on_trade_(trade, t3);
+    // receive thread only, see FilterPublisher::acquire
+    const SubscriptionFilter& acquire_filter() { return subscriptions_.acquire(); }
+
+    // receive thread, once per loop pass with the filter of that pass. One relaxed load unless a snapshot is pending
+    inline void service_snapshot(const SubscriptionFilter& filter) {
+        if (!splicer_.live()) [[unlikely]] {
+            splicer_.splice(filter, [this](char tag, const void* payload, std::size_t size) {
+                types::Messages::dispatch(tag, payload, size, [this](const auto& msg) { this->deliver_to_client(msg); });
+            });
         }
     }
 
+    // one received packet, tag from the topic and the payload behind it. Delivered in place if aligned.
+    bool deliver_packet(char tag, const void* payload, std::size_t size) {
+        // a traced message ends in the trailer's magic, an untraced one in its disseminate timestamp (whose
+        // high half never looks like the magic)
+        traced_ = false;
+        if (size > sizeof(types::TraceTrailer)) {
+            const auto* bytes = static_cast<const std::byte*>(payload);
+            uint32_t magic;
+            std::memcpy(&magic, bytes + size - sizeof(magic), sizeof(magic));
+            if (magic == types::trace_magic) [[unlikely]] {
+                size -= sizeof(types::TraceTrailer);
+                std::memcpy(&trace_, bytes + size, sizeof(trace_));
+                trace::stamp(trace_, types::TracePoint::Received);
+                traced_ = true;
+            }
+        }
+        if (stats_) count_packet(payload, size);
+        if (!splicer_.live()) [[unlikely]] {
+            splicer_.buffer(tag, payload, size);
+            return true;
+        }
+        return types::Messages::dispatch(tag, payload, size, [this](const auto& msg) { this->deliver_to_client(msg); });
+    }
+
 
 private:
+    template <typename T>
+    using CachePtr = std::unique_ptr<LastValueCache<T>>;
+
+    // a jump in the stream sequence counts the messages in between as gaps
+    void count_packet(const void* payload, std::size_t size) {
+        shm::bump(stats_->received);
+        shm::bump(stats_->bytes, size);
+        if (size < types::sequence_offset + sizeof(uint64_t)) return;
+        uint64_t sequence;
+        std::memcpy(&sequence, static_cast<const std::byte*>(payload) + types::sequence_offset, sizeof(sequence));
+        if (last_sequence_ != 0 && sequence > last_sequence_ + 1) shm::bump(stats_->sequence_gaps, sequence - last_sequence_ - 1);
+        if (sequence > last_sequence_) last_sequence_ = sequence;
+    }
+
     std::jthread receiver_thread_;
-    std::function<void(const types::Quote&, uint64_t)> on_quote_;
-    std::function<void(const types::Trade&, uint64_t)> on_trade_;
+    Sink sink_;
+    FilterPublisher subscriptions_;
+    types::Messages::apply<CachePtr> caches_;
+    SnapshotSplicer splicer_;
+    types::TraceTrailer trace_{};
+    bool traced_{false};
+    shm::FeedHandlerStats* stats_{nullptr};
+    uint64_t last_sequence_{0};
 };
 
-#endif
+#endif
\ No newline at end of file
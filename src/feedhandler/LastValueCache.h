@@ -0,0 +1,95 @@
+#ifndef LAST_VALUE_CACHE_H
+#define LAST_VALUE_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include "../utils/types.h"
+
+/*
+Latest message per symbol, for consumers that only care about the current state and not every update.
+A flat array indexed by the dense symbol id (see SymbolDirectory), one cache line aligned slot per symbol, each
+guarded by a seqlock:
+    writer (the receive thread only): seq -> odd, copy the message in, seq -> even. Never waits on readers.
+    readers (any number of threads): read seq, copy out, read seq again, retry if it moved or was odd.
+The payload is kept as relaxed atomic words rather than plain bytes, so a reader racing the writer is a retry
+and not a data race. Messages without a symbol id are not cached.
+ */
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+class LastValueCache {
+public:
+    explicit LastValueCache(uint32_t id_limit)
+        : slots_(std::make_unique<Slot[]>(id_limit)), id_limit_(id_limit) {}
+
+    // receive thread only
+    inline void store(uint32_t symbol_id, const T& msg) {
+        if (symbol_id == types::no_symbol_id || symbol_id >= id_limit_) return;
+        Slot& slot = slots_[symbol_id];
+
+        uint64_t words[word_count]{};
+        std::memcpy(words, &msg, sizeof(T));
+
+        const uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < word_count; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // consistent copy of the latest message, false if the symbol has not been seen yet. Never blocks the writer.
+    inline bool read(uint32_t symbol_id, T& out) const {
+        uint64_t version;
+        return read(symbol_id, out, version);
+    }
+
+    // same, version is the update count of the copy (see version())
+    inline bool read(uint32_t symbol_id, T& out, uint64_t& version) const {
+        if (symbol_id == types::no_symbol_id || symbol_id >= id_limit_) return false;
+        const Slot& slot = slots_[symbol_id];
+
+        uint64_t words[word_count];
+        while (true) {
+            const uint64_t before = slot.seq.load(std::memory_order_acquire);
+            if (before == 0) return false;
+            if (before & 1) continue; // write in progress
+
+            for (std::size_t i = 0; i < word_count; ++i) {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == before) {
+                version = before / 2;
+                break;
+            }
+        }
+        std::memcpy(&out, words, sizeof(T));
+        return true;
+    }
+
+    // number of updates the symbol has seen
+    [[nodiscard]] uint64_t version(uint32_t symbol_id) const {
+        if (symbol_id >= id_limit_) return 0;
+        return slots_[symbol_id].seq.load(std::memory_order_acquire) / 2;
+    }
+
+    [[nodiscard]] uint32_t id_limit() const { return id_limit_; }
+
+private:
+    static constexpr std::size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> words[word_count]{};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    uint32_t id_limit_;
+};
+
+#endif // LAST_VALUE_CACHE_H
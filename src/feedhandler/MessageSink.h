@@ -0,0 +1,44 @@
+#ifndef MESSAGE_SINK_H
+#define MESSAGE_SINK_H
+
+#include <concepts>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include "../utils/types.h"
+
+/*
+A sink is whatever the feed handler hands decoded messages to, called as sink(msg, receive_timestamp).
+The sink is a template parameter of the feed handler, so with a concrete sink type the call inlines into the
+receive loop, no std::function and no indirect call per message.
+Types the sink can't be called with are dropped at compile time, so a quotes-only consumer costs nothing for
+the rest of the feed.
+
+FunctionSink is the runtime-configurable default behind set_quote_callback() and friends.
+ */
+template <typename S, typename T>
+concept SinkFor = std::invocable<S&, const T&, uint64_t>;
+
+template <typename S>
+concept MessageSink = std::move_constructible<S> && types::Messages::any_invocable<S&>;
+
+class FunctionSink {
+public:
+    template <typename T>
+        requires (types::Messages::contains<T>)
+    void set(types::Messages::callback<T> cb) {
+        std::get<types::Messages::callback<T>>(callbacks_) = std::move(cb);
+    }
+
+    template <typename T>
+    void operator()(const T& msg, uint64_t recv_ts) const {
+        if (const auto& cb = std::get<types::Messages::callback<T>>(callbacks_)) {
+            cb(msg, recv_ts);
+        }
+    }
+
+private:
+    types::Messages::callback_slots callbacks_; // one slot per registered message type
+};
+
+#endif // MESSAGE_SINK_H
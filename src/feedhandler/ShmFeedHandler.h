@@ -0,0 +1,69 @@
+#ifndef SHM_FEED_HANDLER_H
+#define SHM_FEED_HANDLER_H
+
+#include "IFeedHandler.h"
+#include "SubscriptionFilter.h"
+#include "../shm/ShmRing.h"
+#include "../utils/types.h"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <stop_token>
+
+// Polls a ShmDisseminator's ring. Read-only mapping, so any number of these can follow one writer.
+template <MessageSink Sink = FunctionSink>
+class BasicShmFeedHandler final : public IFeedHandler<BasicShmFeedHandler<Sink>, Sink> {
+public:
+    explicit BasicShmFeedHandler(const std::string& name, Sink sink = Sink{})
+        : IFeedHandler<BasicShmFeedHandler<Sink>, Sink>(std::move(sink)),
+          ring_(name) {}
+
+    ~BasicShmFeedHandler() {
+        this->stop();
+    }
+
+    void subscribe_impl(std::string_view symbol) {
+        this->update_subscriptions([symbol](SubscriptionFilter& filter) { filter.add(symbol); });
+    }
+
+    void unsubscribe_impl(std::string_view symbol) {
+        this->update_subscriptions([symbol](SubscriptionFilter& filter) { filter.remove(symbol); });
+    }
+
+    void receive_loop_impl(std::stop_token st) {
+        while (!st.stop_requested()) {
+            const SubscriptionFilter& filter = this->acquire_filter();
+            this->service_snapshot(filter);
+
+            const std::size_t n = ring_.poll([&](char tag, const char* topic, const std::byte* payload, std::size_t size) {
+                uint64_t incoming_symbol;
+                std::memcpy(&incoming_symbol, topic + 2, 8);
+                uint32_t incoming_id = types::no_symbol_id;
+                if (size >= types::symbol_id_offset + sizeof(incoming_id)) {
+                    std::memcpy(&incoming_id, payload + types::symbol_id_offset, sizeof(incoming_id));
+                }
+                if (!filter.matches(tag, incoming_symbol, incoming_id)) return;
+
+                this->deliver_packet(tag, payload, size);
+            });
+            lost_.store(ring_.lost(), std::memory_order_relaxed);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // records the writer overwrote before this handler read them
+    [[nodiscard]] uint64_t lost() const { return lost_.load(std::memory_order_relaxed); }
+
+private:
+    ShmRingReader ring_;
+    std::atomic<uint64_t> lost_{0};
+};
+
+using ShmFeedHandler = BasicShmFeedHandler<>;
+
+#endif // SHM_FEED_HANDLER_H
@@ -0,0 +1,137 @@
+#ifndef SNAPSHOT_SPLICER_H
+#define SNAPSHOT_SPLICER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "../snapshot/SnapshotClient.h"
+#include "../utils/types.h"
+
+/*
+Joins a snapshot with the live stream for a feed handler that starts late:
+    1. client thread: begin(), from now on the receive thread buffers every packet it would have delivered
+    2. client thread: fetch the snapshot (SnapshotClient), hand_over()
+    3. receive thread: splice(), delivers the snapshot records, then the buffered packets the snapshot does not
+       already cover, and goes back to delivering live
+A buffered packet of a snapshot type is stale if its sequence is <= the snapshot sequence, or <= the sequence of the
+snapshot record for the same type and symbol (records can be newer than the snapshot sequence, the server does not
+stop the stream while it reads). Packets of other types (order-by-order) are always replayed, nothing in the
+snapshot stands in for them. The buffer is unbounded, it only has to hold one snapshot round trip worth of packets.
+ */
+class SnapshotSplicer {
+public:
+    struct Stats {
+        uint64_t sequence{0};
+        uint32_t snapshot_records{0};    // delivered from the snapshot, after the subscription filter
+        uint32_t buffered{0};
+        uint32_t replayed{0};            // buffered packets delivered after the snapshot, the rest were stale
+    };
+
+    // client thread, before the request goes out
+    void begin() {
+        State expected = State::Live;
+        if (!state_.compare_exchange_strong(expected, State::Buffering, std::memory_order_acq_rel)) {
+            throw std::logic_error("A snapshot request is already in progress");
+        }
+    }
+
+    // client thread, an empty snapshot just releases the buffered packets (e.g. the request failed)
+    void hand_over(snapshot::Snapshot snapshot) {
+        pending_ = std::move(snapshot);
+        state_.store(State::Ready, std::memory_order_release);
+    }
+
+    // no request in flight, stats() is valid
+    [[nodiscard]] bool idle() const { return state_.load(std::memory_order_acquire) == State::Live; }
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+
+    // receive thread from here on
+
+    [[nodiscard]] inline bool live() const { return state_.load(std::memory_order_relaxed) == State::Live; }
+
+    // keeps a packet the receive loop would have delivered
+    void buffer(char tag, const void* payload, std::size_t size) {
+        const snapshot::RecordHeader rh{static_cast<uint16_t>(size), tag, 0};
+        const std::size_t at = buffered_.size();
+        buffered_.resize(at + sizeof(rh) + size);
+        std::memcpy(buffered_.data() + at, &rh, sizeof(rh));
+        std::memcpy(buffered_.data() + at + sizeof(rh), payload, size);
+        ++buffered_count_;
+    }
+
+    /*
+    Splices if the snapshot has been handed over, otherwise does nothing. The snapshot is run through filter
+    (the live packets already were), deliver(tag, payload, size) gets both.
+     */
+    template <typename Filter, typename Deliver>
+    bool splice(const Filter& filter, Deliver&& deliver) {
+        if (state_.load(std::memory_order_acquire) != State::Ready) return false;
+
+        Stats stats{pending_.sequence, 0, buffered_count_, 0};
+        std::map<std::pair<char, uint64_t>, uint64_t> newer;   // records taken after the snapshot sequence
+
+        pending_.for_each([&](char tag, const std::byte* topic, const std::byte* payload, std::size_t size) {
+            if (size < types::sequence_offset + sizeof(uint64_t)) return;
+            uint64_t symbol;
+            uint32_t id;
+            uint64_t sequence;
+            std::memcpy(&symbol, topic + 2, sizeof(symbol));
+            std::memcpy(&id, payload + types::symbol_id_offset, sizeof(id));
+            std::memcpy(&sequence, payload + types::sequence_offset, sizeof(sequence));
+            if (!filter.matches(tag, symbol, id)) return;
+
+            if (sequence > pending_.sequence) newer[{tag, symbol}] = sequence;
+            deliver(tag, payload, size);
+            ++stats.snapshot_records;
+        });
+
+        std::size_t at = 0;
+        while (at < buffered_.size()) {
+            snapshot::RecordHeader rh;
+            std::memcpy(&rh, buffered_.data() + at, sizeof(rh));
+            const std::byte* payload = buffered_.data() + at + sizeof(rh);
+            at += sizeof(rh) + rh.payload_size;
+            if (rh.payload_size < types::sequence_offset + sizeof(uint64_t)) continue;
+
+            if (snapshot::Types::bit_of_tag(rh.tag) != 0) {
+                uint64_t sequence;
+                std::memcpy(&sequence, payload + types::sequence_offset, sizeof(sequence));
+                if (sequence <= pending_.sequence) continue;
+                if (!newer.empty()) {
+                    uint64_t symbol;
+                    std::memcpy(&symbol, payload, sizeof(symbol));
+                    if (auto it = newer.find({rh.tag, symbol}); it != newer.end() && sequence <= it->second) continue;
+                }
+            }
+            deliver(rh.tag, payload, rh.payload_size);
+            ++stats.replayed;
+        }
+
+        stats_ = stats;
+        pending_ = {};
+        buffered_.clear();
+        buffered_count_ = 0;
+        state_.store(State::Live, std::memory_order_release);
+        return true;
+    }
+
+private:
+    enum class State : uint8_t {
+        Live,
+        Buffering,
+        Ready
+    };
+
+    std::atomic<State> state_{State::Live};
+    snapshot::Snapshot pending_;
+    std::vector<std::byte> buffered_;
+    uint32_t buffered_count_{0};
+    Stats stats_;
+};
+
+#endif // SNAPSHOT_SPLICER_H
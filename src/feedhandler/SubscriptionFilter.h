@@ -0,0 +1,370 @@
+#ifndef SUBSCRIPTION_FILTER_H
+#define SUBSCRIPTION_FILTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "SymbolIndex.h"
+#include "../utils/SymbolDirectory.h"
+#include "../utils/types.h"
+
+// The idea is that we shove the 8 char symbol into this 64bit uint
+//      Should make the set faster too.
+inline uint64_t pack_symbol(std::string_view sym) {
+    // Random walk generator will pad with \0 terminators.
+    uint64_t id = 0;
+    std::memcpy(&id, sym.data(), std::min(sym.size(), size_t{8}));
+    return id;
+}
+
+/*
+What a feed handler lets through: symbol patterns, each with the message types wanted for it.
+    "AAPL"      exact symbol, hash lookup
+    "AA*"       prefix, one mask compare on the packed symbol ("*" alone is everything)
+    "A?P*"      anything else with * or ? is a glob, matched on the symbol string
+Unsubscribing removes the same pattern again, it does not carve a symbol out of a broader pattern.
+
+With a SymbolDirectory attached, sealing also resolves every pattern against every known symbol into a bitmap
+indexed by the symbol id carried in the message, then a packet is one bit test whatever the patterns are.
+Messages without a known id fall back to SymbolIndex and the pattern lists.
+
+A filter is immutable once published (see FilterPublisher), edits happen on a copy.
+ */
+template <typename SymbolIndex = FlatSymbolSet>
+class BasicSubscriptionFilter {
+public:
+    using TypeMask = types::Messages::type_mask;
+    static constexpr TypeMask all_types = types::Messages::all_types;
+
+    // beyond this many topics a ZMQ subscriber takes whole message types and filters locally
+    static constexpr std::size_t zmq_topic_limit = 256;
+
+    void add(std::string_view pattern, TypeMask wanted = all_types) {
+        if (pattern.empty() || wanted == 0) return;
+        switch (classify(pattern)) {
+            case Kind::Exact: {
+                const uint64_t symbol = pack_symbol(pattern);
+                exact_.set(symbol, exact_.find(symbol) | wanted);
+                break;
+            }
+            case Kind::Prefix: {
+                const auto prefix = make_prefix(pattern);
+                if (auto it = std::ranges::find_if(prefixes_, [&](const Prefix& p) { return p.mask == prefix.mask && p.value == prefix.value; });
+                    it != prefixes_.end()) {
+                    it->wanted |= wanted;
+                } else {
+                    prefixes_.push_back({prefix.mask, prefix.value, wanted, std::string(pattern)});
+                }
+                break;
+            }
+            case Kind::Glob:
+                if (auto it = std::ranges::find(globs_, pattern, &Glob::pattern); it != globs_.end()) {
+                    it->wanted |= wanted;
+                } else {
+                    globs_.push_back({std::string(pattern), wanted});
+                }
+                break;
+        }
+    }
+
+    void remove(std::string_view pattern, TypeMask wanted = all_types) {
+        if (pattern.empty()) return;
+        switch (classify(pattern)) {
+            case Kind::Exact: {
+                const uint64_t symbol = pack_symbol(pattern);
+                exact_.set(symbol, exact_.find(symbol) & ~wanted);
+                break;
+            }
+            case Kind::Prefix: {
+                const auto prefix = make_prefix(pattern);
+                for (Prefix& p : prefixes_) {
+                    if (p.mask == prefix.mask && p.value == prefix.value) p.wanted &= ~wanted;
+                }
+                std::erase_if(prefixes_, [](const Prefix& p) { return p.wanted == 0; });
+                break;
+            }
+            case Kind::Glob:
+                for (Glob& g : globs_) {
+                    if (g.pattern == pattern) g.wanted &= ~wanted;
+                }
+                std::erase_if(globs_, [](const Glob& g) { return g.wanted == 0; });
+                break;
+        }
+    }
+
+    void clear() {
+        exact_.clear();
+        prefixes_.clear();
+        globs_.clear();
+    }
+
+    // ids resolve against this directory from the next seal() on, nullptr goes back to symbol lookups
+    void set_directory(std::shared_ptr<const SymbolDirectory> directory) { directory_ = std::move(directory); }
+
+    [[nodiscard]] inline bool matches(char tag, uint64_t symbol, uint32_t symbol_id = types::no_symbol_id) const {
+        const TypeMask bit = types::Messages::bit_of_tag(tag);
+        if ((bit & any_types_) == 0) return false;
+        if (bitmap_.covers(symbol_id)) {
+            return bitmap_.test(std::countr_zero(bit), symbol_id);
+        }
+        return (exact_.find(symbol) & bit) || (pattern_types(symbol) & bit);
+    }
+
+    struct PacketKey {
+        uint64_t symbol;
+        uint32_t symbol_id;
+        char tag;
+    };
+
+    // matches() over a batch of received packets, the symbol lookups are prefetched together
+    void matches_batch(const PacketKey* keys, std::size_t n, bool* out) const {
+        constexpr std::size_t chunk = 64;
+        uint64_t symbols[chunk];
+        TypeMask found[chunk];
+        for (std::size_t base = 0; base < n; base += chunk) {
+            const std::size_t m = std::min(chunk, n - base);
+            std::size_t lookups = 0;
+            for (std::size_t i = 0; i < m; ++i) {
+                if (!bitmap_.covers(keys[base + i].symbol_id)) symbols[lookups++] = keys[base + i].symbol;
+            }
+            exact_.find_batch(symbols, lookups, found);
+
+            std::size_t next = 0;
+            for (std::size_t i = 0; i < m; ++i) {
+                const PacketKey& key = keys[base + i];
+                const TypeMask bit = types::Messages::bit_of_tag(key.tag);
+                if ((bit & any_types_) == 0) {
+                    out[base + i] = false;
+                    next += !bitmap_.covers(key.symbol_id);
+                } else if (bitmap_.covers(key.symbol_id)) {
+                    out[base + i] = bitmap_.test(std::countr_zero(bit), key.symbol_id);
+                } else {
+                    out[base + i] = (found[next++] & bit) || (pattern_types(key.symbol) & bit);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t symbol_count() const { return exact_.size(); }
+    [[nodiscard]] std::size_t pattern_count() const { return prefixes_.size() + globs_.size(); }
+    [[nodiscard]] uint64_t generation() const { return generation_; }
+
+    // sorted topic prefixes a ZMQ SUB socket needs for this filter, computed when the filter is sealed
+    [[nodiscard]] const std::vector<std::string>& zmq_topics() const { return zmq_topics_; }
+
+    // called once by the publisher before the filter becomes visible to the receive thread
+    void seal(uint64_t generation) {
+        generation_ = generation;
+        any_types_ = 0;
+        exact_.for_each([this](uint64_t, TypeMask wanted) { any_types_ |= wanted; });
+        for (const Prefix& p : prefixes_) any_types_ |= p.wanted;
+        for (const Glob& g : globs_) any_types_ |= g.wanted;
+        build_zmq_topics();
+        build_bitmap();
+    }
+
+private:
+    enum class Kind { Exact, Prefix, Glob };
+
+    struct Prefix {
+        uint64_t mask;
+        uint64_t value;
+        TypeMask wanted;
+        std::string pattern;
+    };
+
+    struct Glob {
+        std::string pattern;
+        TypeMask wanted;
+    };
+
+    static Kind classify(std::string_view pattern) {
+        const auto wildcard = pattern.find_first_of("*?");
+        if (wildcard == std::string_view::npos) return Kind::Exact;
+        if (wildcard == pattern.size() - 1 && pattern.back() == '*' && wildcard <= 8) return Kind::Prefix;
+        return Kind::Glob;
+    }
+
+    static Prefix make_prefix(std::string_view pattern) {
+        const std::string_view prefix = pattern.substr(0, pattern.size() - 1);
+        uint64_t mask = 0;
+        std::memset(&mask, 0xff, prefix.size());
+        return {mask, pack_symbol(prefix), 0, {}};
+    }
+
+    // union of the types all prefix and glob patterns want for this symbol
+    [[nodiscard]] TypeMask pattern_types(uint64_t symbol) const {
+        TypeMask wanted = 0;
+        for (const Prefix& p : prefixes_) {
+            if ((symbol & p.mask) == p.value) wanted |= p.wanted;
+        }
+        for (const Glob& g : globs_) {
+            if (glob_match(g.pattern, symbol_view(symbol))) wanted |= g.wanted;
+        }
+        return wanted;
+    }
+
+    void build_bitmap() {
+        bitmap_ = SymbolBitmap{};
+        if (!directory_ || directory_->empty()) return;
+        bitmap_.resize(directory_->id_limit());
+        for (uint32_t id = 1; id < directory_->id_limit(); ++id) {
+            const uint64_t symbol = pack_symbol(directory_->symbol(id));
+            bitmap_.set(id, exact_.find(symbol) | pattern_types(symbol));
+        }
+    }
+
+    static std::string_view symbol_view(const uint64_t& symbol) {
+        const char* chars = reinterpret_cast<const char*>(&symbol);
+        return {chars, strnlen(chars, sizeof(symbol))};
+    }
+
+    // * any run of characters, ? exactly one
+    static bool glob_match(std::string_view pattern, std::string_view text) {
+        std::size_t p = 0, t = 0, star = std::string_view::npos, resume = 0;
+        while (t < text.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+                ++p; ++t;
+            } else if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                resume = t;
+            } else if (star != std::string_view::npos) {
+                p = star + 1;
+                t = ++resume;
+            } else {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '*') ++p;
+        return p == pattern.size();
+    }
+
+    static void append_topics(std::vector<std::string>& out, TypeMask wanted, std::string_view symbol) {
+        types::Messages::for_each_type([&]<typename T>() {
+            if (wanted & types::Messages::mask_of<T>) {
+                std::string topic{types::Messages::tag_of<T>, ':'};
+                topic += symbol;
+                out.push_back(std::move(topic));
+            }
+        });
+    }
+
+    void build_zmq_topics() {
+        zmq_topics_.clear();
+        std::size_t needed = 0;
+        exact_.for_each([&needed](uint64_t, TypeMask wanted) { needed += std::popcount(wanted); });
+        for (const Prefix& p : prefixes_) needed += std::popcount(p.wanted);
+
+        if (!globs_.empty() || needed > zmq_topic_limit) {
+            // "Q:" per wanted type, matches() does the rest on the receive thread
+            append_topics(zmq_topics_, any_types_, {});
+        } else {
+            exact_.for_each([this](uint64_t symbol, TypeMask wanted) { append_topics(zmq_topics_, wanted, symbol_view(symbol)); });
+            for (const Prefix& p : prefixes_) {
+                append_topics(zmq_topics_, p.wanted, std::string_view(p.pattern).substr(0, p.pattern.size() - 1));
+            }
+        }
+        std::ranges::sort(zmq_topics_);
+        zmq_topics_.erase(std::unique(zmq_topics_.begin(), zmq_topics_.end()), zmq_topics_.end());
+    }
+
+    SymbolIndex exact_;
+    std::vector<Prefix> prefixes_;
+    std::vector<Glob> globs_;
+
+    std::shared_ptr<const SymbolDirectory> directory_;
+    SymbolBitmap bitmap_;  // empty without a directory
+
+    TypeMask any_types_{0};
+    uint64_t generation_{0};
+    std::vector<std::string> zmq_topics_;
+};
+
+using SubscriptionFilter = BasicSubscriptionFilter<>;
+
+/*
+Publishes subscription filters to one receive thread.
+Writers (any thread, serialised by a mutex) copy the current filter, apply a whole batch of edits to the copy
+and swap it in with one atomic exchange, so the receive loop never blocks and never sees half an update.
+The receive thread acknowledges the generation it is using, retired filters older than that are freed by the
+next writer. This relies on the single reader letting go of a filter before its next acquire().
+ */
+template <typename Filter>
+class BasicFilterPublisher {
+public:
+    BasicFilterPublisher() {
+        auto initial = std::make_unique<Filter>();
+        initial->seal(0);
+        current_.store(initial.release(), std::memory_order_release);
+    }
+
+    ~BasicFilterPublisher() {
+        delete current_.load(std::memory_order_acquire);
+        for (const Filter* f : retired_) delete f;
+    }
+
+    BasicFilterPublisher(const BasicFilterPublisher&) = delete;
+    BasicFilterPublisher& operator=(const BasicFilterPublisher&) = delete;
+
+    // writer side: edit(Filter&) gets a private copy, returns the published generation
+    template <typename Edit>
+    uint64_t update(Edit&& edit) {
+        std::lock_guard lock(writer_mutex_);
+        auto next = std::make_unique<Filter>(*current_.load(std::memory_order_relaxed));
+        edit(*next);
+        const uint64_t generation = next->generation() + 1;
+        next->seal(generation);
+
+        retired_.push_back(current_.exchange(next.release(), std::memory_order_acq_rel));
+        reclaim();
+        return generation;
+    }
+
+    // reader side, receive thread only. The reference stays valid until the next acquire()
+    [[nodiscard]] inline const Filter& acquire() {
+        const Filter* filter = current_.load(std::memory_order_acquire);
+        if (filter->generation() != seen_) {
+            seen_ = filter->generation();
+            acknowledged_.store(seen_, std::memory_order_release);
+        }
+        return *filter;
+    }
+
+    [[nodiscard]] uint64_t published_generation() const {
+        return current_.load(std::memory_order_acquire)->generation();
+    }
+
+    // generation the receive thread has picked up
+    [[nodiscard]] uint64_t acknowledged_generation() const {
+        return acknowledged_.load(std::memory_order_acquire);
+    }
+
+private:
+    void reclaim() {
+        const uint64_t acknowledged = acknowledged_.load(std::memory_order_acquire);
+        std::erase_if(retired_, [acknowledged](const Filter* f) {
+            if (f->generation() >= acknowledged) return false;
+            delete f;
+            return true;
+        });
+    }
+
+    std::atomic<const Filter*> current_{nullptr};
+    std::atomic<uint64_t> acknowledged_{0};
+    uint64_t seen_{0};  // receive thread only
+
+    std::mutex writer_mutex_;
+    std::vector<const Filter*> retired_;
+};
+
+using FilterPublisher = BasicFilterPublisher<SubscriptionFilter>;
+
+#endif // SUBSCRIPTION_FILTER_H
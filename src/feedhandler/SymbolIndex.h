@@ -0,0 +1,247 @@
+#ifndef SYMBOL_INDEX_H
+#define SYMBOL_INDEX_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../utils/types.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+Exact-symbol lookup structures for the subscription filter, packed 8 char symbol -> message type mask (0 = not
+subscribed). Swappable through the SymbolIndex template parameter of BasicSubscriptionFilter.
+
+    StdSymbolSet    std::unordered_map, node per entry, what the receive loop used to do
+    FlatSymbolSet   open addressing in groups of 4 keys per cache line, a probe is normally one line
+    SymbolBitmap    not keyed by symbol: one bit per (message type, dense symbol id), see SymbolDirectory
+ */
+using SymbolTypeMask = types::Messages::type_mask;
+
+class StdSymbolSet {
+public:
+    [[nodiscard]] SymbolTypeMask find(uint64_t symbol) const {
+        const auto it = map_.find(symbol);
+        return it == map_.end() ? 0 : it->second;
+    }
+
+    void set(uint64_t symbol, SymbolTypeMask mask) {
+        if (mask == 0) map_.erase(symbol);
+        else map_[symbol] = mask;
+    }
+
+    void find_batch(const uint64_t* symbols, std::size_t n, SymbolTypeMask* out) const {
+        for (std::size_t i = 0; i < n; ++i) out[i] = find(symbols[i]);
+    }
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const auto& [symbol, mask] : map_) fn(symbol, mask);
+    }
+
+    [[nodiscard]] std::size_t size() const { return map_.size(); }
+    void clear() { map_.clear(); }
+
+private:
+    std::unordered_map<uint64_t, SymbolTypeMask> map_;
+};
+
+/*
+Groups of 4 slots, one 64 byte line each: the 4 keys side by side so a probe compares them in one go (AVX2 if the
+build has it, otherwise the compiler gets 4 independent compares), the masks behind them.
+Linear probing over groups, kept at most half full so nearly every probe ends in the home group.
+Key 0 is the empty slot (the empty symbol is never subscribed), erased keys leave a tombstone until the next rehash.
+ */
+class FlatSymbolSet {
+public:
+    static constexpr std::size_t group_width = 4;
+
+    FlatSymbolSet() { rehash(16); }
+
+    [[nodiscard]] inline SymbolTypeMask find(uint64_t symbol) const {
+        std::size_t g = home(symbol);
+        while (true) {
+            const Group& group = groups_[g];
+            const int slot = match(group, symbol);
+            if (slot >= 0) return group.masks[slot];
+            if (match(group, empty_key) >= 0) return 0;
+            g = (g + 1) & group_mask_;
+        }
+    }
+
+    /*
+    Probes a batch (e.g. one recvmmsg worth of datagrams): first touches the home line of every key so the
+    misses overlap, then probes. Only pays off once the table falls out of L2, see bench_symbol_filter.
+     */
+    void find_batch(const uint64_t* symbols, std::size_t n, SymbolTypeMask* out) const {
+        for (std::size_t i = 0; i < n; ++i) {
+            __builtin_prefetch(&groups_[home(symbols[i])]);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = find(symbols[i]);
+        }
+    }
+
+    void set(uint64_t symbol, SymbolTypeMask mask) {
+        if (symbol == empty_key || symbol == tombstone_key) return;
+        if (mask == 0) {
+            erase(symbol);
+            return;
+        }
+        if ((size_ + tombstones_ + 1) * 2 > groups_.size() * group_width) {
+            rehash(std::max(groups_.size() * group_width, (size_ + 1) * 4));
+        }
+
+        std::size_t g = home(symbol);
+        Group* reuse = nullptr;
+        int reuse_slot = -1;
+        while (true) {
+            Group& group = groups_[g];
+            if (const int slot = match(group, symbol); slot >= 0) {
+                group.masks[slot] = mask;
+                return;
+            }
+            if (reuse == nullptr) {
+                if (const int slot = match(group, tombstone_key); slot >= 0) {
+                    reuse = &group;
+                    reuse_slot = slot;
+                }
+            }
+            if (const int slot = match(group, empty_key); slot >= 0) {
+                if (reuse == nullptr) {
+                    reuse = &group;
+                    reuse_slot = slot;
+                } else {
+                    --tombstones_;
+                }
+                reuse->keys[reuse_slot] = symbol;
+                reuse->masks[reuse_slot] = mask;
+                ++size_;
+                return;
+            }
+            g = (g + 1) & group_mask_;
+        }
+    }
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const Group& group : groups_) {
+            for (std::size_t i = 0; i < group_width; ++i) {
+                if (group.keys[i] != empty_key && group.keys[i] != tombstone_key) fn(group.keys[i], group.masks[i]);
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const { return size_; }
+
+    void clear() { rehash(16); }
+
+private:
+    static constexpr uint64_t empty_key = 0;
+    static constexpr uint64_t tombstone_key = ~uint64_t{0};
+
+    struct alignas(64) Group {
+        uint64_t keys[group_width];
+        SymbolTypeMask masks[group_width];
+    };
+
+    // the packed symbol is ASCII, fibonacci hashing spreads it over the top bits
+    [[nodiscard]] inline std::size_t home(uint64_t symbol) const {
+        return static_cast<std::size_t>((symbol * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    // slot of key in the group, -1 if not there
+    static inline int match(const Group& group, uint64_t key) {
+#if defined(__AVX2__)
+        const __m256i keys = _mm256_load_si256(reinterpret_cast<const __m256i*>(group.keys));
+        const __m256i eq = _mm256_cmpeq_epi64(keys, _mm256_set1_epi64x(static_cast<long long>(key)));
+        const int bits = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+        return bits ? std::countr_zero(static_cast<unsigned>(bits)) : -1;
+#else
+        unsigned bits = 0;
+        for (std::size_t i = 0; i < group_width; ++i) {
+            bits |= static_cast<unsigned>(group.keys[i] == key) << i;
+        }
+        return bits ? std::countr_zero(bits) : -1;
+#endif
+    }
+
+    void erase(uint64_t symbol) {
+        std::size_t g = home(symbol);
+        while (true) {
+            Group& group = groups_[g];
+            if (const int slot = match(group, symbol); slot >= 0) {
+                group.keys[slot] = tombstone_key;
+                group.masks[slot] = 0;
+                --size_;
+                ++tombstones_;
+                return;
+            }
+            if (match(group, empty_key) >= 0) return;
+            g = (g + 1) & group_mask_;
+        }
+    }
+
+    void rehash(std::size_t min_slots) {
+        std::vector<Group> old = std::move(groups_);
+        const std::size_t group_count = std::bit_ceil(std::max<std::size_t>(min_slots / group_width, 2));
+        groups_.assign(group_count, Group{});
+        group_mask_ = group_count - 1;
+        shift_ = 64 - std::countr_zero(group_count);
+        size_ = 0;
+        tombstones_ = 0;
+        for (const Group& group : old) {
+            for (std::size_t i = 0; i < group_width; ++i) {
+                if (group.keys[i] != empty_key && group.keys[i] != tombstone_key) set(group.keys[i], group.masks[i]);
+            }
+        }
+    }
+
+    std::vector<Group> groups_;
+    std::size_t group_mask_{0};
+    int shift_{64};
+    std::size_t size_{0};
+    std::size_t tombstones_{0};
+};
+
+/*
+One bit per (message type, symbol id), a row of bits per type: 10k symbols are 1.25 KiB per type, all of it
+stays in L1. A lookup is a shift and a test, no hashing and no compare of the symbol.
+ */
+class SymbolBitmap {
+public:
+    // ids in [0, id_limit), see SymbolDirectory::id_limit()
+    void resize(std::size_t id_limit) {
+        words_per_type_ = (id_limit + 63) / 64;
+        id_limit_ = id_limit;
+        bits_.assign(words_per_type_ * types::Messages::count, 0);
+    }
+
+    void set(uint32_t symbol_id, SymbolTypeMask mask) {
+        for (std::size_t type = 0; type < types::Messages::count; ++type) {
+            uint64_t& word = bits_[type * words_per_type_ + symbol_id / 64];
+            const uint64_t bit = uint64_t{1} << (symbol_id % 64);
+            if (mask & (SymbolTypeMask{1} << type)) word |= bit;
+            else word &= ~bit;
+        }
+    }
+
+    [[nodiscard]] inline bool test(std::size_t type_index, uint32_t symbol_id) const {
+        return (bits_[type_index * words_per_type_ + symbol_id / 64] >> (symbol_id % 64)) & 1;
+    }
+
+    [[nodiscard]] bool covers(uint32_t symbol_id) const { return symbol_id != types::no_symbol_id && symbol_id < id_limit_; }
+    [[nodiscard]] bool empty() const { return id_limit_ == 0; }
+
+private:
+    std::vector<uint64_t> bits_;
+    std::size_t words_per_type_{0};
+    std::size_t id_limit_{0};
+};
+
+#endif // SYMBOL_INDEX_H
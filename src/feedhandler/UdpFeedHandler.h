@@ -6,42 +6,45 @@
 #define UDP_FEED_HANDLER_H
 
 #include "IFeedHandler.h"
+#include "SubscriptionFilter.h"
+#include "../utils/IoUring.h"
+#include "../utils/Timestamping.h"
+#include "../utils/UdpIo.h"
 #include "../utils/types.h"
-#include "../utils/CustomSpscQueue.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <cerrno>
+#include <memory>
 #include <string_view>
-#include <unordered_set>
+#include <vector>
 #include <stdexcept>
 #include <thread>
 #include <stop_token>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
 
-// The idea is that we shove the 8 char symbol into this 64bit uint
-//      Should make the set faster too.
-inline uint64_t pack_symbol(std::string_view sym) {
-    // Random walk generator will pad with \0 terminators.
-    uint64_t id = 0;
-    std::memcpy(&id, sym.data(), std::min(sym.size(), size_t{8}));
-    return id;
-}
-
-struct SubCommand {
-    bool is_subscribe;
-    uint64_t symbol_id;
-};
-
-class UdpFeedHandler final : public IFeedHandler<UdpFeedHandler> {
+template <MessageSink Sink = FunctionSink>
+class BasicUdpFeedHandler final : public IFeedHandler<BasicUdpFeedHandler<Sink>, Sink> {
 public:
-    UdpFeedHandler(const std::string& ip, unsigned short port) {
+    // payload offset inside the receive buffer, the 10 byte topic would leave it misaligned at 10
+    static constexpr std::size_t payload_alignment = 16;
+    static_assert(payload_alignment >= types::Messages::max_align);
+
+    // receive buffer per datagram in the batched and io_uring modes, payload_alignment lead included
+    static constexpr std::size_t buffer_stride = 256;
+    static_assert(buffer_stride >= payload_alignment + types::topic_header_size + types::max_wire_payload_size);
+
+    BasicUdpFeedHandler(const std::string& ip, unsigned short port, Sink sink = Sink{}, UdpIoOptions io = {})
+        : IFeedHandler<BasicUdpFeedHandler<Sink>, Sink>(std::move(sink)), io_(io) {
         sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
         if (sock_ < 0) throw std::runtime_error("Failed to create UDP socket");
 
@@ -80,40 +83,99 @@ public:
         if (fcntl(sock_, F_SETFL, flags | O_NONBLOCK) == -1) {
             throw std::runtime_error("Failed to set non-blocking socket");
         }
+
+        if (io_.batch == 0) throw std::invalid_argument("UDP batch size must be at least 1");
+        if (io_.timestamps != KernelTimestamps::Off) {
+            // an io_uring recv hands back no control messages
+            if (io_.mode == UdpIoMode::IoUring) throw std::invalid_argument("Kernel timestamps work with the syscall and batched modes, not io_uring");
+            timestamping::enable(sock_, io_.timestamps, false, true);
+        }
+        if (io_.gro) {
+            setup_gro();
+        } else if (io_.mode == UdpIoMode::Batched) {
+            setup_batched();
+        } else if (io_.mode == UdpIoMode::IoUring) {
+            // io_uring completes reads on a non-blocking socket with EAGAIN instead of waiting for data, the
+            // multishot recv needs it blocking. The receive thread never blocks on it, it only reads the CQ.
+            if (fcntl(sock_, F_SETFL, flags & ~O_NONBLOCK) == -1) {
+                throw std::runtime_error("Failed to set blocking socket");
+            }
+            setup_uring();
+        }
     }
 
-    ~UdpFeedHandler() {
+    ~BasicUdpFeedHandler() {
         this->stop();
+        ring_.reset(); // cancels the armed recv before its buffers are unmapped
+        provided_.reset();
         if (sock_ >= 0) close(sock_);
     }
 
     // the strategy/client of the feedhandler would call these to subscribe and unsubscribe to a symbol
+    // each call publishes a new filter, use the bulk subscribe() for whole universes
     void subscribe_impl(std::string_view symbol) {
-        command_queue_.push({true, pack_symbol(symbol)});
+        this->update_subscriptions([symbol](SubscriptionFilter& filter) { filter.add(symbol); });
     }
 
     void unsubscribe_impl(std::string_view symbol) {
-        command_queue_.push({false, pack_symbol(symbol)});
+        this->update_subscriptions([symbol](SubscriptionFilter& filter) { filter.remove(symbol); });
     }
 
     void receive_loop_impl(std::stop_token st) {
-        std::byte buffer[1024];
+        if (io_.gro) {
+            receive_gro(st);
+            return;
+        }
+        switch (io_.mode) {
+            case UdpIoMode::Batched: receive_batched(st); break;
+            case UdpIoMode::IoUring: receive_uring(st); break;
+            case UdpIoMode::Syscall: receive_syscall(st); break;
+        }
+    }
+
+    // receive thread only, or after stop()
+    [[nodiscard]] UdpIoStats io_stats() const {
+        UdpIoStats s = stats_;
+        if (ring_) s.syscalls = ring_->enter_calls();
+        return s;
+    }
+
+    // inside a callback: steady_clock ns the kernel stamped the datagram being delivered on arrival, 0 with
+    // io.timestamps off or when the packet came without a stamp
+    [[nodiscard]] uint64_t kernel_receive_timestamp() const { return kernel_receive_ns_; }
+
+private:
+    void receive_syscall(const std::stop_token& st) {
+        // receive the topic at an offset such that the payload behind it starts on a payload_alignment boundary,
+        // then the sink gets a view into the buffer instead of a copy
+        constexpr std::size_t lead = payload_alignment - types::topic_header_size % payload_alignment;
+        alignas(64) std::byte storage[lead + 1024];
+        std::byte* const buffer = storage + lead;
+        constexpr std::size_t buffer_size = sizeof(storage) - lead;
 
-        std::unordered_set<uint64_t> local_subscriptions_;
+        // with kernel timestamps the stamp comes as a control message, recvmsg instead of recvfrom
+        const bool stamped = io_.timestamps != KernelTimestamps::Off;
+        alignas(cmsghdr) char control[timestamping::control_size];
+        iovec iov{buffer, buffer_size};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
 
         while (!st.stop_requested()) {
-            // process changes in the subscriptions by the client/ strategy
-            SubCommand cmd;
-            while (command_queue_.pop(cmd)) {
-                if (cmd.is_subscribe) {
-                    local_subscriptions_.insert(cmd.symbol_id);
-                } else {
-                    local_subscriptions_.erase(cmd.symbol_id);
-                }
-            }
+            // picks up subscription changes by the client/ strategy, one atomic load when nothing changed
+            const SubscriptionFilter& filter = this->acquire_filter();
+            this->service_snapshot(filter);
 
             // read from the network, check if packet is valid
-            ssize_t bytes_recvd = recvfrom(sock_, buffer, sizeof(buffer), 0, nullptr, nullptr);
+            ssize_t bytes_recvd;
+            if (stamped) {
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+                bytes_recvd = recvmsg(sock_, &msg, 0);
+            } else {
+                bytes_recvd = recvfrom(sock_, buffer, buffer_size, 0, nullptr, nullptr);
+            }
+            ++stats_.syscalls;
             if (bytes_recvd < 0) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
                     std::this_thread::yield();
@@ -123,38 +185,261 @@ public:
             if (bytes_recvd < types::topic_header_size) {
                 continue;
             }
+            ++stats_.messages;
 
             uint64_t incoming_symbol;
             // skipping the 2-byte prefix, e.g., 'Q:'
             std::memcpy(&incoming_symbol, buffer + 2, 8);
 
-            if (!local_subscriptions_.contains(incoming_symbol)) {
+            // dense id right behind the symbol in every payload, lets the filter use its bitmap
+            uint32_t incoming_id = types::no_symbol_id;
+            if (bytes_recvd >= static_cast<ssize_t>(types::topic_header_size + types::symbol_id_offset + sizeof(incoming_id))) {
+                std::memcpy(&incoming_id, buffer + types::topic_header_size + types::symbol_id_offset, sizeof(incoming_id));
+            }
+
+            char msg_type = static_cast<char>(buffer[0]);
+            if (!filter.matches(msg_type, incoming_symbol, incoming_id)) {
                 continue;
             }
 
             // unpack and deliver
-            char msg_type = static_cast<char>(buffer[0]);
             size_t payload_size = bytes_recvd - types::topic_header_size;
             const std::byte* payload_data = buffer + types::topic_header_size;
 
-            if (msg_type == 'Q' && payload_size == sizeof(types::Quote)) {
-                types::Quote quote;
-                std::memcpy(&quote, payload_data, sizeof(types::Quote));
-                this->deliver_to_client(quote);
+            if (stamped) {
+                kernel_receive_ns_ = timestamping::to_steady_ns(timestamping::realtime_ns(msg, io_.timestamps),
+                                                                timestamping::realtime_offset_ns());
             }
-            else if (msg_type == 'T' && payload_size == sizeof(types::Trade)) {
-                types::Trade trade;
-                std::memcpy(&trade, payload_data, sizeof(types::Trade));
-                this->deliver_to_client(trade);
+            this->deliver_packet(msg_type, payload_data, payload_size);
+        }
+    }
+
+    void setup_batched() {
+        buffers_.resize(io_.batch * buffer_stride);
+        iov_.resize(io_.batch);
+        msgs_.resize(io_.batch);
+        for (std::size_t i = 0; i < io_.batch; ++i) {
+            iov_[i].iov_base = datagram_at(i);
+            iov_[i].iov_len = buffer_stride - lead;
+            msgs_[i].msg_hdr = msghdr{};
+            msgs_[i].msg_hdr.msg_iov = &iov_[i];
+            msgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+        if (io_.timestamps != KernelTimestamps::Off) controls_.resize(io_.batch * timestamping::control_size);
+        packets_.resize(io_.batch);
+    }
+
+    void receive_batched(const std::stop_token& st) {
+        while (!st.stop_requested()) {
+            const SubscriptionFilter& filter = this->acquire_filter();
+            this->service_snapshot(filter);
+
+            if (!controls_.empty()) {
+                // recvmmsg overwrites the lengths with what it filled in
+                for (std::size_t i = 0; i < io_.batch; ++i) {
+                    msgs_[i].msg_hdr.msg_control = controls_.data() + i * timestamping::control_size;
+                    msgs_[i].msg_hdr.msg_controllen = timestamping::control_size;
+                }
             }
+            ++stats_.syscalls;
+            const int n = recvmmsg(sock_, msgs_.data(), static_cast<unsigned>(io_.batch), MSG_DONTWAIT, nullptr);
+            if (n <= 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            const int64_t offset = controls_.empty() ? 0 : timestamping::realtime_offset_ns();
+            for (int i = 0; i < n; ++i) {
+                packets_[i] = {datagram_at(static_cast<std::size_t>(i)), msgs_[i].msg_len};
+                if (!controls_.empty()) {
+                    packets_[i].kernel_ns = timestamping::to_steady_ns(timestamping::realtime_ns(msgs_[i].msg_hdr, io_.timestamps), offset);
+                }
+            }
+            deliver_batch(filter, static_cast<std::size_t>(n));
         }
     }
 
-private:
+    void setup_gro() {
+        if (io_.mode == UdpIoMode::IoUring) throw std::invalid_argument("UDP GRO works with the syscall and batched modes, not io_uring");
+        int on = 1;
+        if (setsockopt(sock_, SOL_UDP, UDP_GRO, &on, sizeof(on)) < 0) {
+            throw std::runtime_error("Failed to enable UDP_GRO on the socket");
+        }
+        // a coalesced run is at most one 64 KiB datagram
+        buffers_.resize(lead + gro_buffer_size);
+        packets_.resize(gro_buffer_size / types::topic_header_size + 1);
+    }
+
+    // one recvmsg takes a whole coalesced run, the segments behind the first lose the payload alignment
+    // (dispatch copies those out). A run carries one kernel RX stamp, that of its first datagram.
+    void receive_gro(const std::stop_token& st) {
+        std::byte* const buffer = buffers_.data() + lead;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int)) + timestamping::control_size];
+        iovec iov{buffer, gro_buffer_size};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        while (!st.stop_requested()) {
+            const SubscriptionFilter& filter = this->acquire_filter();
+            this->service_snapshot(filter);
+
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            ++stats_.syscalls;
+            const ssize_t bytes = recvmsg(sock_, &msg, 0);
+            if (bytes <= 0) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // no UDP_GRO message: a single datagram
+            auto segment = static_cast<std::size_t>(bytes);
+            for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+                if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+                    int size;
+                    std::memcpy(&size, CMSG_DATA(cm), sizeof(size));
+                    if (size > 0) segment = static_cast<std::size_t>(size);
+                }
+            }
+            const uint64_t kernel_ns = io_.timestamps == KernelTimestamps::Off
+                ? 0 : timestamping::to_steady_ns(timestamping::realtime_ns(msg, io_.timestamps), timestamping::realtime_offset_ns());
+            std::size_t n = 0;
+            for (std::size_t offset = 0; offset < static_cast<std::size_t>(bytes); offset += segment) {
+                packets_[n++] = {buffer + offset, std::min(segment, static_cast<std::size_t>(bytes) - offset), kernel_ns};
+            }
+            deliver_batch(filter, n);
+        }
+    }
+
+    /*
+    One multishot recv stays armed on the socket; every datagram lands in one of the provided buffers and posts a
+    CQE naming it. The loop drains up to batch CQEs, filters them together and gives the buffers back. The kernel
+    disarms the recv when it runs out of buffers (ENOBUFS) or on error, then it is armed again.
+     */
+    void setup_uring() {
+        const unsigned count = std::clamp(io_.ring_entries, 1u, 65535u);
+        // CQ (twice the SQ) deep enough for a completion per buffer, a multishot recv ends when the CQ overflows
+        ring_ = std::make_unique<IoUring>(IoUring::Options{.entries = std::bit_ceil(std::max(count / 2, 64u)), .sqpoll = io_.sqpoll});
+        ring_->register_files(&sock_, 1);
+        provided_ = std::make_unique<IoUringProvidedBuffers>(*ring_, buffer_group, count, buffer_stride, lead);
+        packets_.resize(io_.batch);
+        bids_.resize(io_.batch);
+        arm_recv();
+    }
+
+    void arm_recv() {
+        io_uring_sqe* sqe = ring_->get_sqe();
+        if (sqe == nullptr) return; // SQ full, the next pass retries
+        sqe->opcode = IORING_OP_RECV;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+        sqe->fd = 0;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->buf_group = buffer_group;
+        sqe->user_data = recv_tag;
+        ring_->submit();
+        armed_ = true;
+    }
+
+    void receive_uring(const std::stop_token& st) {
+        while (!st.stop_requested()) {
+            const SubscriptionFilter& filter = this->acquire_filter();
+            this->service_snapshot(filter);
+            if (!armed_) arm_recv();
+
+            std::size_t n = 0;
+            ring_->for_each_cqe([&](const io_uring_cqe& cqe) {
+                if (cqe.user_data != recv_tag) {
+                    if (cqe.res < 0) ++stats_.errors; // a buffer hand back failed
+                    return;
+                }
+                if (!(cqe.flags & IORING_CQE_F_MORE)) armed_ = false;
+                if (cqe.res < 0) {
+                    if (cqe.res != -ENOBUFS) ++stats_.errors;
+                    return;
+                }
+                if (!(cqe.flags & IORING_CQE_F_BUFFER)) return;
+                const auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                packets_[n] = {provided_->buffer(bid), static_cast<std::size_t>(cqe.res)};
+                bids_[n] = bid;
+                ++n;
+            }, static_cast<unsigned>(io_.batch));
+
+            if (n == 0) {
+                // nothing to submit while the recv stays armed, completions are read straight off the CQ
+                std::this_thread::yield();
+                continue;
+            }
+            deliver_batch(filter, n);
+            for (std::size_t i = 0; i < n; ++i) provided_->recycle(bids_[i]);
+            provided_->commit();
+        }
+    }
+
+    // filter a batch of received datagrams together (matches_batch prefetches the symbol lookups), deliver the hits
+    void deliver_batch(const SubscriptionFilter& filter, std::size_t n) {
+        SubscriptionFilter::PacketKey keys[max_batch];
+        bool wanted[max_batch];
+        for (std::size_t base = 0; base < n; base += max_batch) {
+            const std::size_t m = std::min(max_batch, n - base);
+            for (std::size_t i = 0; i < m; ++i) {
+                const Packet& p = packets_[base + i];
+                if (p.size < static_cast<std::size_t>(types::topic_header_size)) {
+                    keys[i] = {0, types::no_symbol_id, '\0'}; // no type has tag 0, never matches
+                    continue;
+                }
+                keys[i].tag = static_cast<char>(p.data[0]);
+                std::memcpy(&keys[i].symbol, p.data + 2, 8);
+                keys[i].symbol_id = types::no_symbol_id;
+                if (p.size >= types::topic_header_size + types::symbol_id_offset + sizeof(uint32_t)) {
+                    std::memcpy(&keys[i].symbol_id, p.data + types::topic_header_size + types::symbol_id_offset, sizeof(uint32_t));
+                }
+            }
+            filter.matches_batch(keys, m, wanted);
+            for (std::size_t i = 0; i < m; ++i) {
+                const Packet& p = packets_[base + i];
+                if (p.size >= static_cast<std::size_t>(types::topic_header_size)) ++stats_.messages;
+                if (!wanted[i]) continue;
+                kernel_receive_ns_ = p.kernel_ns;
+                this->deliver_packet(keys[i].tag, p.data + types::topic_header_size, p.size - types::topic_header_size);
+            }
+        }
+    }
+
+    [[nodiscard]] std::byte* datagram_at(std::size_t i) { return buffers_.data() + i * buffer_stride + lead; }
+
+    struct Packet {
+        const std::byte* data;
+        std::size_t size;
+        uint64_t kernel_ns{0}; // kernel RX stamp, steady_clock
+    };
+
+    // payload behind the topic on a payload_alignment boundary, see receive_syscall
+    static constexpr std::size_t lead = payload_alignment - types::topic_header_size % payload_alignment;
+    static constexpr std::size_t max_batch = 64;
+    static constexpr std::size_t gro_buffer_size = 65536;
+    static_assert(__STDCPP_DEFAULT_NEW_ALIGNMENT__ >= payload_alignment && buffer_stride % payload_alignment == 0);
+    static constexpr uint16_t buffer_group = 0;
+    static constexpr uint64_t recv_tag = 1;
+
     int sock_{-1};
+    UdpIoOptions io_;
+    UdpIoStats stats_;
+    std::vector<Packet> packets_;
+    uint64_t kernel_receive_ns_{0};
 
-    // lockfree spscQ such that the client to the feedhandler can subscribe and unsubscribe
-    CustomSpscQueue<SubCommand, 128> command_queue_;
+    // batched and gro, operator new hands out at least 16 byte alignment so the stride keeps every payload aligned
+    std::vector<std::byte> buffers_;
+    std::vector<iovec> iov_;
+    std::vector<mmsghdr> msgs_;
+    std::vector<char> controls_; // batched with kernel timestamps, control_size per datagram
+
+    // io_uring, the ring has to go before the buffers the armed recv writes into (see destructor)
+    std::unique_ptr<IoUringProvidedBuffers> provided_;
+    std::unique_ptr<IoUring> ring_;
+    std::vector<uint16_t> bids_;
+    bool armed_{false};
 };
 
+using UdpFeedHandler = BasicUdpFeedHandler<>;
+
 #endif // UDP_FEED_HANDLER_H
\ No newline at end of file
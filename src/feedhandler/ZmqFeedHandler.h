@@ -2,26 +2,52 @@
 #define ZMQ_FEED_HANDLER_H
 
 #include "IFeedHandler.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <vector>
 #include <zmq.hpp>
 #include <zmq_addon.hpp>
 
-class ZmqFeedHandler final : public IFeedHandler<ZmqFeedHandler> {
+/*
+Receive side socket settings.
+    context      shared zmq context, required for inproc:// (publisher and subscribers must use the same one).
+                 nullptr -> the feed handler owns a context with io_threads I/O threads.
+    rcvhwm       messages queued per connection before zmq drops, 0 = unlimited
+    rcvbuf       kernel receive buffer for tcp/ipc, 0 = OS default
+ */
+struct ZmqSubscribeOptions {
+    zmq::context_t* context = nullptr;
+    int io_threads = 1;
+    int rcvhwm = 1000;
+    int rcvbuf = 0;
+};
+
+template <MessageSink Sink = FunctionSink>
+class BasicZmqFeedHandler final : public IFeedHandler<BasicZmqFeedHandler<Sink>, Sink> {
 public:
-    explicit ZmqFeedHandler(std::string_view multicast_address)
-        : context_(1),
-          multicast_sub_(context_, zmq::socket_type::sub) {
-        multicast_sub_.connect(std::string{multicast_address});
-        multicast_sub_.set(zmq::sockopt::rcvtimeo, 1000);
+    // endpoint is anything zmq connects to: tcp://host:port, ipc://path, inproc://name
+    explicit BasicZmqFeedHandler(std::string_view endpoint, Sink sink = Sink{}, ZmqSubscribeOptions options = {})
+        : IFeedHandler<BasicZmqFeedHandler<Sink>, Sink>(std::move(sink)),
+          own_context_(options.context ? nullptr : std::make_unique<zmq::context_t>(options.io_threads)),
+          multicast_sub_(options.context ? *options.context : *own_context_, zmq::socket_type::sub) {
+        // only picked up by connections made after the option is set
+        multicast_sub_.set(zmq::sockopt::rcvhwm, options.rcvhwm);
+        if (options.rcvbuf > 0) multicast_sub_.set(zmq::sockopt::rcvbuf, options.rcvbuf);
+        multicast_sub_.connect(std::string{endpoint});
+        // also bounds how long an idle receive loop takes to pick up a subscription change
+        multicast_sub_.set(zmq::sockopt::rcvtimeo, 100);
     }
 
-    explicit ZmqFeedHandler(zmq::socket_t &&multicast_sub)
-        : context_(1),
+    explicit BasicZmqFeedHandler(zmq::socket_t &&multicast_sub, Sink sink = Sink{})
+        : IFeedHandler<BasicZmqFeedHandler<Sink>, Sink>(std::move(sink)),
           multicast_sub_(std::move(multicast_sub)) {
         this->multicast_sub_.set(zmq::sockopt::rcvtimeo, 200);
     }
 
-    ~ZmqFeedHandler() {
+    ~BasicZmqFeedHandler() {
         // must stop the base class thread before destroying sockets
         this->stop();
         if (multicast_sub_.handle() != nullptr) {
@@ -30,48 +56,61 @@ public:
         }
     }
 
+    // zmq sockets are not thread safe, the receive thread applies the socket subscriptions when it sees the new filter
     inline void subscribe_impl(std::string_view symbol) {
-        std::string q_topic = "Q:" + std::string(symbol);
-        std::string t_topic = "T:" + std::string(symbol);
-        multicast_sub_.set(zmq::sockopt::subscribe, q_topic);
-        multicast_sub_.set(zmq::sockopt::subscribe, t_topic);
+        this->update_subscriptions([symbol](SubscriptionFilter& filter) { filter.add(symbol); });
     }
 
     inline void unsubscribe_impl(std::string_view symbol) {
-        std::string q_topic = "Q:" + std::string(symbol);
-        std::string t_topic = "T:" + std::string(symbol);
-        multicast_sub_.set(zmq::sockopt::unsubscribe, q_topic);
-        multicast_sub_.set(zmq::sockopt::unsubscribe, t_topic);
+        this->update_subscriptions([symbol](SubscriptionFilter& filter) { filter.remove(symbol); });
     }
 
     inline void receive_loop_impl(std::stop_token st) {
         while (!st.stop_requested()) {
             try {
-                zmq::message_t topic_msg;
-                auto res = multicast_sub_.recv(topic_msg, zmq::recv_flags::none);
+                const SubscriptionFilter& filter = this->acquire_filter();
+                this->service_snapshot(filter);
+                if (filter.generation() != applied_generation_) {
+                    sync_socket_subscriptions(filter);
+                }
+
+                auto res = multicast_sub_.recv(topic_msg_, zmq::recv_flags::none);
                 if (!res) continue; // Timeout
 
-                if (!multicast_sub_.get(zmq::sockopt::rcvmore)) {
-                    spdlog::warn("Received incomplete multipart message.");
-                    continue;
+                // one frame: padded topic then payload, two frames: topic frame then payload frame.
+                // more() reads the flag off the message, no getsockopt(ZMQ_RCVMORE) round trip
+                const char* topic;
+                const char* payload;
+                std::size_t payload_size;
+                if (topic_msg_.more()) {
+                    auto res2 = multicast_sub_.recv(payload_msg_, zmq::recv_flags::none);
+                    if (!res2 || topic_msg_.size() < types::topic_header_size) continue;
+                    topic = static_cast<const char*>(topic_msg_.data());
+                    payload = static_cast<const char*>(payload_msg_.data());
+                    payload_size = payload_msg_.size();
+                } else {
+                    if (topic_msg_.size() < types::single_frame_header_size) {
+                        spdlog::warn("Received a single frame message too short for its header.");
+                        continue;
+                    }
+                    topic = static_cast<const char*>(topic_msg_.data());
+                    payload = topic + types::single_frame_header_size;
+                    payload_size = topic_msg_.size() - types::single_frame_header_size;
                 }
 
-                zmq::message_t payload_msg;
-                auto res2 = multicast_sub_.recv(payload_msg, zmq::recv_flags::none);
-                if (!res2 || topic_msg.size() < 1) continue;
-
-                const char type = static_cast<const char*>(topic_msg.data())[0];
+                const char type = topic[0];
 
-                if (type == 'Q' && payload_msg.size() == sizeof(types::Quote)) {
-                    types::Quote quote;
-                    std::memcpy(&quote, payload_msg.data(), sizeof(types::Quote));
-                    this->deliver_to_client(quote);
-                }
-                else if (type == 'T' && payload_msg.size() == sizeof(types::Trade)) {
-                    types::Trade trade;
-                    std::memcpy(&trade, payload_msg.data(), sizeof(types::Trade));
-                    this->deliver_to_client(trade);
+                // zmq prefix matching is coarse for big universes and patterns, the filter has the final say
+                uint64_t incoming_symbol;
+                std::memcpy(&incoming_symbol, topic + 2, 8);
+                uint32_t incoming_id = types::no_symbol_id;
+                if (payload_size >= types::symbol_id_offset + sizeof(incoming_id)) {
+                    std::memcpy(&incoming_id, payload + types::symbol_id_offset, sizeof(incoming_id));
                 }
+                if (!filter.matches(type, incoming_symbol, incoming_id)) continue;
+
+                // zmq makes no promise about the alignment of frame data, dispatch falls back to a copy if it is off
+                this->deliver_packet(type, payload, payload_size);
 
             } catch (const zmq::error_t& e) {
                 if (e.num() == ETERM || e.num() == ENOTSOCK) break;
@@ -81,8 +120,29 @@ public:
     }
 
 private:
-    zmq::context_t context_;
+    // diff of the sorted topic lists, only the changes hit the socket
+    void sync_socket_subscriptions(const SubscriptionFilter& filter) {
+        const std::vector<std::string>& wanted = filter.zmq_topics();
+        std::vector<std::string> removed, added;
+        std::ranges::set_difference(socket_topics_, wanted, std::back_inserter(removed));
+        std::ranges::set_difference(wanted, socket_topics_, std::back_inserter(added));
+
+        for (const auto& topic : removed) multicast_sub_.set(zmq::sockopt::unsubscribe, topic);
+        for (const auto& topic : added) multicast_sub_.set(zmq::sockopt::subscribe, topic);
+        socket_topics_ = wanted;
+        applied_generation_ = filter.generation();
+    }
+
+    std::unique_ptr<zmq::context_t> own_context_; // unset when the context is shared or came with the socket
     zmq::socket_t multicast_sub_;
+
+    // receive thread only
+    zmq::message_t topic_msg_;
+    zmq::message_t payload_msg_;
+    std::vector<std::string> socket_topics_;
+    uint64_t applied_generation_{0};
 };
 
-#endif
\ No newline at end of file
+using ZmqFeedHandler = BasicZmqFeedHandler<>;
+
+#endif
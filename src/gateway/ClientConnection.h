@@ -0,0 +1,201 @@
+#ifndef CLIENT_CONNECTION_H
+#define CLIENT_CONNECTION_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "GatewayProtocol.h"
+#include "../feedhandler/SubscriptionFilter.h"
+
+/*
+One gateway client, owned by a single event loop thread: its subscription filter, the command line being read
+and the output side.
+Output is a byte ring: frames are appended as packets come in and the whole backlog goes out with one writev per
+loop pass (two iovecs when the ring wraps), so a busy client costs one syscall per batch and not per message.
+When a frame does not fit the client is slow, what happens then is the gateway's SlowClientPolicy. For Conflate
+the frames of gateway::ConflatedTypes go to a side store keyed by type and symbol instead, a newer frame replaces
+the older one in place.
+Everything stays there until the ring has room for it, at the latest when an order event has to go out behind it,
+so a symbol never goes backwards for the client and an order event never overtakes a parked frame.
+ */
+class ClientConnection {
+public:
+    ClientConnection(int fd, std::size_t buffer_bytes, std::shared_ptr<const SymbolDirectory> directory)
+        : fd_(fd), ring_(std::make_unique<std::byte[]>(buffer_bytes)), capacity_(buffer_bytes) {
+        if (directory) filter_.set_directory(std::move(directory));
+        filter_.seal(generation_);
+    }
+
+    ~ClientConnection() {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    ClientConnection(const ClientConnection&) = delete;
+    ClientConnection& operator=(const ClientConnection&) = delete;
+
+    [[nodiscard]] int fd() const { return fd_; }
+    [[nodiscard]] const SubscriptionFilter& filter() const { return filter_; }
+
+    // bytes waiting in the ring, conflated frames not counted
+    [[nodiscard]] std::size_t pending() const { return tail_ - head_; }
+    [[nodiscard]] bool conflating() const { return !conflated_.empty(); }
+    [[nodiscard]] bool has_output() const { return pending() > 0 || conflating(); }
+    [[nodiscard]] uint64_t bad_commands() const { return bad_commands_; }
+
+    /*
+    Reads whatever the client sent and applies complete command lines. False if the peer closed or errored.
+    Malformed lines are counted and skipped.
+     */
+    bool read_commands() {
+        char chunk[512];
+        while (true) {
+            const ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+            if (n == 0) return false;
+            if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            input_.append(chunk, static_cast<std::size_t>(n));
+
+            std::size_t start = 0;
+            for (auto end = input_.find('\n'); end != std::string::npos; end = input_.find('\n', start)) {
+                apply(std::string_view(input_).substr(start, end - start));
+                start = end + 1;
+            }
+            input_.erase(0, start);
+            if (input_.size() > 4096) return false;   // no line is this long, not a client we understand
+        }
+    }
+
+    /*
+    False if the frame does not fit, the caller decides what to do about that.
+    While frames are parked a conflatable frame goes to the store as well, an order event first moves the parked
+    frames into the ring so it does not overtake them, and fails only if they or it do not fit.
+     */
+    bool append(const gateway::FrameHeader& header, const void* topic, const void* payload) {
+        const std::size_t size = sizeof(header) + types::topic_header_size + header.payload_size;
+        if (conflating()) {
+            if (gateway::ConflatedTypes::bit_of_tag(header.tag) != 0) return false;
+            refill_from_conflated();
+            if (conflating()) return false;
+        }
+        if (capacity_ - pending() < size) return false;
+        put(&header, sizeof(header));
+        put(topic, types::topic_header_size);
+        put(payload, header.payload_size);
+        return true;
+    }
+
+    // Conflate policy: parks the frame, replacing an older one for the same type and symbol. True if it replaced one.
+    // Only for gateway::ConflatedTypes, an order event must not replace another
+    bool conflate(const gateway::FrameHeader& header, const void* topic, const void* payload) {
+        uint64_t symbol;
+        std::memcpy(&symbol, static_cast<const char*>(topic) + 2, sizeof(symbol));
+        const auto [it, inserted] = conflated_index_.try_emplace({header.tag, symbol}, conflated_.size());
+        if (inserted) conflated_.emplace_back();
+
+        Parked& parked = conflated_[it->second];
+        parked.header = header;
+        parked.header.flags |= inserted ? 0 : gateway::frame_conflated;
+        std::memcpy(parked.bytes, topic, types::topic_header_size);
+        std::memcpy(parked.bytes + types::topic_header_size, payload, header.payload_size);
+        return !inserted;
+    }
+
+    /*
+    writev of everything in the ring, then refills it from the conflation store once it is empty.
+    False if the connection is broken. Leaves data pending if the socket buffer is full (EAGAIN).
+     */
+    bool flush(uint64_t& writev_calls, uint64_t& bytes_written) {
+        while (true) {
+            while (pending() > 0) {
+                iovec iov[2];
+                const std::size_t start = head_ % capacity_;
+                const std::size_t first = std::min(pending(), capacity_ - start);
+                iov[0] = {ring_.get() + start, first};
+                iov[1] = {ring_.get(), pending() - first};
+
+                const ssize_t n = writev(fd_, iov, iov[1].iov_len > 0 ? 2 : 1);
+                ++writev_calls;
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+                head_ += static_cast<std::size_t>(n);
+                bytes_written += static_cast<std::size_t>(n);
+            }
+            // nothing moved: a parked frame larger than the ring, TcpGateway does not allow such a buffer size
+            if (!conflating() || refill_from_conflated() == 0) return true;
+        }
+    }
+
+private:
+    struct Parked {
+        gateway::FrameHeader header;
+        std::byte bytes[types::topic_header_size + types::max_payload_size];
+    };
+
+    void apply(std::string_view line) {
+        const auto command = gateway::parse_command(line);
+        if (!command) {
+            ++bad_commands_;
+            return;
+        }
+        if (command->subscribe) filter_.add(command->pattern, command->types);
+        else filter_.remove(command->pattern, command->types);
+        filter_.seal(++generation_);
+    }
+
+    void put(const void* data, std::size_t size) {
+        const std::size_t start = tail_ % capacity_;
+        const std::size_t first = std::min(size, capacity_ - start);
+        std::memcpy(ring_.get() + start, data, first);
+        std::memcpy(ring_.get(), static_cast<const std::byte*>(data) + first, size - first);
+        tail_ += size;
+    }
+
+    // moves parked frames into the ring behind what is already there, in arrival order and as many as fit.
+    // Returns how many moved
+    std::size_t refill_from_conflated() {
+        std::size_t moved = 0;
+        for (; moved < conflated_.size(); ++moved) {
+            const Parked& parked = conflated_[moved];
+            const std::size_t size = sizeof(parked.header) + types::topic_header_size + parked.header.payload_size;
+            if (capacity_ - pending() < size) break;
+            put(&parked.header, sizeof(parked.header));
+            put(parked.bytes, types::topic_header_size + parked.header.payload_size);
+        }
+        conflated_.erase(conflated_.begin(), conflated_.begin() + static_cast<std::ptrdiff_t>(moved));
+        conflated_index_.clear();
+        for (std::size_t i = 0; i < conflated_.size(); ++i) {
+            uint64_t symbol;
+            std::memcpy(&symbol, conflated_[i].bytes + 2, sizeof(symbol));
+            conflated_index_[{conflated_[i].header.tag, symbol}] = i;
+        }
+        return moved;
+    }
+
+    int fd_;
+    SubscriptionFilter filter_;
+    uint64_t generation_{0};
+    std::string input_;
+    uint64_t bad_commands_{0};
+
+    std::unique_ptr<std::byte[]> ring_;
+    std::size_t capacity_;
+    std::size_t head_{0};   // monotonic, position mod capacity_
+    std::size_t tail_{0};
+
+    std::vector<Parked> conflated_;
+    std::map<std::pair<char, uint64_t>, std::size_t> conflated_index_;
+};
+
+#endif // CLIENT_CONNECTION_H
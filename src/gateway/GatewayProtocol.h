@@ -0,0 +1,88 @@
+#ifndef GATEWAY_PROTOCOL_H
+#define GATEWAY_PROTOCOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "../utils/types.h"
+
+/*
+TCP protocol between the gateway and its clients.
+
+client -> gateway, text lines:
+    SUB <pattern> [tags]      e.g. "SUB AAPL", "SUB MS* QT" (tags default to every message type)
+    UNSUB <pattern> [tags]
+gateway -> client, binary frames:
+    FrameHeader | topic | payload      topic and payload exactly as on the feed
+ */
+namespace gateway {
+    enum class SlowClientPolicy {
+        Disconnect,     // output buffer full -> drop the connection
+        Conflate,       // keep only the latest message per type and symbol until the client catches up. Only for
+                        // ConflatedTypes, an order event the client has no room for disconnects it as above
+        Block           // stall the event loop (and eventually the feed) until the client drains
+    };
+
+    // last-value types, a newer one makes the older one worthless. Order events build state and never conflate
+    using ConflatedTypes = types::MessageList<types::Quote, types::Trade>;
+
+    inline constexpr uint8_t frame_conflated = 1;   // frame stood in for older ones the client never got
+
+    struct FrameHeader {
+        uint16_t payload_size;
+        char tag;
+        uint8_t flags;
+        uint32_t reserved;
+        uint64_t gateway_ts;     // steady clock ns at which the gateway received the message from the feed
+    };
+    static_assert(sizeof(FrameHeader) == 16);
+
+    inline constexpr std::size_t max_frame_size = sizeof(FrameHeader) + types::topic_header_size + types::max_payload_size;
+
+    struct Command {
+        bool subscribe;
+        std::string pattern;
+        types::Messages::type_mask types;
+    };
+
+    // nullopt for anything malformed
+    inline std::optional<Command> parse_command(std::string_view line) {
+        auto next_word = [&line]() {
+            const auto start = line.find_first_not_of(" \t\r");
+            if (start == std::string_view::npos) {
+                line = {};
+                return std::string_view{};
+            }
+            line.remove_prefix(start);
+            const auto end = std::min(line.find_first_of(" \t\r"), line.size());
+            const std::string_view word = line.substr(0, end);
+            line.remove_prefix(end);
+            return word;
+        };
+
+        const std::string_view verb = next_word();
+        const std::string_view pattern = next_word();
+        const std::string_view tags = next_word();
+        if (pattern.empty() || pattern.size() > 8 || (verb != "SUB" && verb != "UNSUB")) return std::nullopt;
+
+        types::Messages::type_mask mask = tags.empty() ? types::Messages::all_types : 0;
+        for (const char tag : tags) {
+            const auto bit = types::Messages::bit_of_tag(tag);
+            if (bit == 0) return std::nullopt;
+            mask |= bit;
+        }
+        return Command{verb == "SUB", std::string(pattern), mask};
+    }
+
+    inline std::optional<SlowClientPolicy> parse_policy(std::string_view name) {
+        if (name == "disconnect") return SlowClientPolicy::Disconnect;
+        if (name == "conflate") return SlowClientPolicy::Conflate;
+        if (name == "block") return SlowClientPolicy::Block;
+        return std::nullopt;
+    }
+}
+
+#endif // GATEWAY_PROTOCOL_H
@@ -0,0 +1,474 @@
+#ifndef TCP_GATEWAY_H
+#define TCP_GATEWAY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ClientConnection.h"
+#include "GatewayProtocol.h"
+#include "../utils/CustomSpscQueue.h"
+#include "../utils/SymbolDirectory.h"
+#include "../utils/types.h"
+
+struct GatewayConfig {
+    unsigned short port = 0;                                  // 0 picks a free one, see TcpGateway::port()
+    std::size_t loops = 1;                                    // event loop threads, clients are spread round robin
+    std::size_t client_buffer_bytes = 256 * 1024;             // per client output ring
+    int socket_send_buffer = 0;                               // SO_SNDBUF per client, 0 = kernel default (autotuned)
+    gateway::SlowClientPolicy policy = gateway::SlowClientPolicy::Disconnect;
+    std::shared_ptr<const SymbolDirectory> directory;         // optional, lets the client filters use the id bitmap
+};
+
+/*
+Subscriber gateway: takes the feed from one feed handler thread and fans it out to TCP clients
+(see GatewayProtocol.h), each with its own subscription filter.
+
+    feed handler thread --publish()--> one SPSC queue per event loop --> loop thread: filter per client,
+                                                                         append to the client ring, writev per pass
+
+Every loop sees every packet and serves only its own clients, so loops never share a client. Loop 0 also owns
+the listening socket. An idle loop sleeps in epoll_wait and is woken through an eventfd, the feed thread only
+writes it when the loop said it was going to sleep.
+If a loop queue is full the packet is dropped for that loop (counted), except with the Block policy where the
+feed thread waits: back pressure goes all the way to the feed socket.
+ */
+class TcpGateway {
+public:
+    struct Stats {
+        uint64_t clients;
+        uint64_t accepted;
+        uint64_t frames;              // appended to client buffers
+        uint64_t conflated;           // frames replaced by a newer one before they went out
+        uint64_t slow_disconnects;
+        uint64_t writev_calls;
+        uint64_t bytes;
+        uint64_t dropped;             // packets a loop queue had no room for
+        uint64_t blocked_ns;          // loop time spent waiting on slow clients (Block policy)
+    };
+
+    // lets the gateway be the sink of a feed handler, e.g. BasicUdpFeedHandler<TcpGateway::Sink>
+    struct Sink {
+        TcpGateway* gateway;
+
+        template <typename T>
+            requires (types::Messages::contains<T>)
+        void operator()(const T& msg, uint64_t recv_ts) { gateway->publish(msg, recv_ts); }
+    };
+
+    explicit TcpGateway(GatewayConfig config) : config_(std::move(config)) {
+        if (config_.loops == 0) throw std::invalid_argument("Gateway needs at least one event loop");
+        if (config_.client_buffer_bytes < sizeof(gateway::FrameHeader) + types::topic_header_size + types::max_wire_payload_size) {
+            throw std::invalid_argument("Gateway client buffer must hold at least one frame");
+        }
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (listen_fd_ < 0) throw std::runtime_error("Failed to create gateway socket");
+        int opt = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(config_.port);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd_, 1024) < 0) {
+            close(listen_fd_);
+            throw std::runtime_error("Failed to bind gateway to port " + std::to_string(config_.port));
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+
+        for (std::size_t i = 0; i < config_.loops; ++i) {
+            loops_.push_back(std::make_unique<EventLoop>(*this, i == 0 ? listen_fd_ : -1));
+        }
+    }
+
+    ~TcpGateway() {
+        stop();
+        loops_.clear();
+        if (listen_fd_ >= 0) close(listen_fd_);
+    }
+
+    TcpGateway(const TcpGateway&) = delete;
+    TcpGateway& operator=(const TcpGateway&) = delete;
+
+    void start() {
+        for (auto& loop : loops_) loop->start();
+    }
+
+    void stop() {
+        for (auto& loop : loops_) loop->stop();
+    }
+
+    [[nodiscard]] unsigned short port() const { return port_; }
+    Sink sink() { return Sink{this}; }
+
+    // feed thread only
+    template <typename T>
+    void publish(const T& msg, uint64_t recv_ts) {
+        publish(types::Messages::tag_of<T>, &msg, sizeof(T), recv_ts);
+    }
+
+    void publish(char tag, const void* payload, std::size_t size, uint64_t recv_ts) {
+        if (size > types::max_payload_size || size < types::symbol_id_offset) return;
+        Packet packet;
+        packet.recv_ts = recv_ts;
+        packet.size = static_cast<uint16_t>(size);
+        packet.tag = tag;
+        std::memcpy(packet.payload, payload, size);
+        for (auto& loop : loops_) loop->push(packet);
+    }
+
+    [[nodiscard]] Stats stats() const {
+        Stats total{};
+        for (const auto& loop : loops_) {
+            const Counters& c = loop->counters;
+            total.clients += c.clients.load(std::memory_order_relaxed);
+            total.accepted += c.accepted.load(std::memory_order_relaxed);
+            total.frames += c.frames.load(std::memory_order_relaxed);
+            total.conflated += c.conflated.load(std::memory_order_relaxed);
+            total.slow_disconnects += c.slow_disconnects.load(std::memory_order_relaxed);
+            total.writev_calls += c.writev_calls.load(std::memory_order_relaxed);
+            total.bytes += c.bytes.load(std::memory_order_relaxed);
+            total.dropped += c.dropped.load(std::memory_order_relaxed);
+            total.blocked_ns += c.blocked_ns.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    static constexpr std::size_t queue_capacity = 16384;
+    static constexpr std::size_t drain_batch = 1024;
+
+    struct Packet {
+        uint64_t recv_ts;
+        uint16_t size;
+        char tag;
+        alignas(8) std::byte payload[types::max_payload_size];
+    };
+
+    // written by the owning loop (and dropped by the feed thread), read by stats()
+    struct Counters {
+        std::atomic<uint64_t> clients{0};
+        std::atomic<uint64_t> accepted{0};
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> conflated{0};
+        std::atomic<uint64_t> slow_disconnects{0};
+        std::atomic<uint64_t> writev_calls{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> blocked_ns{0};
+    };
+
+    struct Client {
+        std::unique_ptr<ClientConnection> conn;
+        bool dirty{false};
+        bool write_armed{false};
+        bool closed{false};
+    };
+
+    class EventLoop {
+    public:
+        Counters counters;
+
+        EventLoop(TcpGateway& owner, int listen_fd) : owner_(owner), listen_fd_(listen_fd) {
+            epoll_fd_ = epoll_create1(0);
+            wake_fd_ = eventfd(0, EFD_NONBLOCK);
+            if (epoll_fd_ < 0 || wake_fd_ < 0) throw std::runtime_error("Failed to create gateway event loop");
+            add_fd(wake_fd_, nullptr);
+            if (listen_fd_ >= 0) add_fd(listen_fd_, &listen_fd_);
+        }
+
+        ~EventLoop() {
+            stop();
+            clients_.clear();
+            close(wake_fd_);
+            close(epoll_fd_);
+        }
+
+        void start() {
+            if (!worker_.joinable()) {
+                running_.store(true, std::memory_order_release);
+                worker_ = std::jthread([this](std::stop_token st) { run(std::move(st)); });
+            }
+        }
+
+        void stop() {
+            if (worker_.joinable()) {
+                running_.store(false, std::memory_order_release);
+                worker_.request_stop();
+                wake();
+                worker_.join();
+            }
+        }
+
+        // feed thread
+        void push(const Packet& packet) {
+            while (!queue_.push(packet)) {
+                if (owner_.config_.policy != gateway::SlowClientPolicy::Block || !running_.load(std::memory_order_acquire)) {
+                    counters.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            // pairs with the fence in run(): either the loop sees the packet or we see it going to sleep
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false)) wake();
+        }
+
+        // any thread, a freshly accepted connection for this loop
+        void adopt(int fd) {
+            {
+                std::lock_guard lock(incoming_mutex_);
+                incoming_.push_back(fd);
+            }
+            wake();
+        }
+
+    private:
+        void run(std::stop_token st) {
+            epoll_event events[64];
+            while (!st.stop_requested()) {
+                adopt_incoming();
+                const bool busy = drain(st);
+                flush_dirty();
+                reap_closed();
+
+                int timeout_ms = 0;
+                if (!busy) {
+                    sleeping_.store(true, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (queue_.empty()) timeout_ms = 100;
+                    else sleeping_.store(false, std::memory_order_relaxed);
+                }
+                const int n = epoll_wait(epoll_fd_, events, 64, timeout_ms);
+                sleeping_.store(false, std::memory_order_relaxed);
+
+                for (int i = 0; i < n; ++i) {
+                    void* ptr = events[i].data.ptr;
+                    if (ptr == nullptr) {
+                        uint64_t ignored;
+                        [[maybe_unused]] auto r = read(wake_fd_, &ignored, sizeof(ignored));
+                    } else if (ptr == &listen_fd_) {
+                        accept_all();
+                    } else {
+                        service(*static_cast<Client*>(ptr), events[i].events);
+                    }
+                }
+                reap_closed();
+            }
+        }
+
+        // fans out up to drain_batch packets, true if there was anything
+        bool drain(const std::stop_token& st) {
+            Packet packet;
+            std::size_t n = 0;
+            for (; n < drain_batch && queue_.pop(packet); ++n) {
+                char topic[types::topic_header_size];
+                topic[0] = packet.tag;
+                topic[1] = ':';
+                std::memcpy(topic + 2, packet.payload, 8);
+                uint64_t symbol;
+                std::memcpy(&symbol, packet.payload, sizeof(symbol));
+                uint32_t symbol_id;
+                std::memcpy(&symbol_id, packet.payload + types::symbol_id_offset, sizeof(symbol_id));
+                const gateway::FrameHeader header{packet.size, packet.tag, 0, 0, packet.recv_ts};
+
+                for (auto& client : clients_) {
+                    if (client->closed || !client->conn->filter().matches(packet.tag, symbol, symbol_id)) continue;
+                    deliver(*client, header, topic, packet.payload, st);
+                }
+            }
+            return n > 0;
+        }
+
+        void deliver(Client& client, const gateway::FrameHeader& header, const char* topic, const void* payload,
+                     const std::stop_token& st) {
+            ClientConnection& conn = *client.conn;
+            client.dirty = true;
+            if (conn.append(header, topic, payload)) {
+                counters.frames.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            switch (owner_.config_.policy) {
+                case gateway::SlowClientPolicy::Conflate:
+                    if (gateway::ConflatedTypes::bit_of_tag(header.tag) != 0) {
+                        if (conn.conflate(header, topic, payload)) counters.conflated.fetch_add(1, std::memory_order_relaxed);
+                        else counters.frames.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    // dropping or merging an order event would corrupt the client's book
+                    [[fallthrough]];
+                case gateway::SlowClientPolicy::Disconnect:
+                    spdlog::warn("Gateway: client {} fell {} bytes behind, disconnecting", conn.fd(), conn.pending());
+                    counters.slow_disconnects.fetch_add(1, std::memory_order_relaxed);
+                    close_client(client);
+                    return;
+                case gateway::SlowClientPolicy::Block: {
+                    const auto start = std::chrono::steady_clock::now();
+                    while (!conn.append(header, topic, payload)) {
+                        if (!flush(client) || st.stop_requested()) {
+                            close_client(client);
+                            break;
+                        }
+                        pollfd pfd{conn.fd(), POLLOUT, 0};
+                        poll(&pfd, 1, 100);
+                    }
+                    if (!client.closed) counters.frames.fetch_add(1, std::memory_order_relaxed);
+                    counters.blocked_ns.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+
+        bool flush(Client& client) {
+            uint64_t calls = 0, bytes = 0;
+            const bool ok = client.conn->flush(calls, bytes);
+            counters.writev_calls.fetch_add(calls, std::memory_order_relaxed);
+            counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            return ok;
+        }
+
+        void flush_dirty() {
+            for (auto& client : clients_) {
+                if (!client->dirty || client->closed) continue;
+                client->dirty = false;
+                if (!flush(*client)) {
+                    close_client(*client);
+                    continue;
+                }
+                arm_write(*client, client->conn->has_output());
+            }
+        }
+
+        void service(Client& client, uint32_t events) {
+            if (client.closed) return;
+            if (events & (EPOLLHUP | EPOLLERR)) {
+                close_client(client);
+                return;
+            }
+            if ((events & EPOLLIN) && !client.conn->read_commands()) {
+                close_client(client);
+                return;
+            }
+            if (events & EPOLLOUT) {
+                if (!flush(client)) {
+                    close_client(client);
+                    return;
+                }
+                arm_write(client, client.conn->has_output());
+            }
+        }
+
+        // EPOLLOUT only while there is a backlog, otherwise it fires on every pass
+        void arm_write(Client& client, bool want) {
+            if (client.write_armed == want) return;
+            epoll_event ev{};
+            ev.events = want ? uint32_t{EPOLLIN | EPOLLOUT} : uint32_t{EPOLLIN};
+            ev.data.ptr = &client;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.conn->fd(), &ev);
+            client.write_armed = want;
+        }
+
+        void accept_all() {
+            while (true) {
+                const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK);
+                if (fd < 0) return;
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                // a smaller kernel buffer makes a slow client show up in our ring sooner
+                if (owner_.config_.socket_send_buffer > 0) {
+                    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &owner_.config_.socket_send_buffer, sizeof(int));
+                }
+
+                EventLoop& target = *owner_.loops_[owner_.next_loop_++ % owner_.loops_.size()];
+                if (&target == this) add_client(fd);
+                else target.adopt(fd);
+            }
+        }
+
+        void adopt_incoming() {
+            std::vector<int> fds;
+            {
+                std::lock_guard lock(incoming_mutex_);
+                fds.swap(incoming_);
+            }
+            for (const int fd : fds) add_client(fd);
+        }
+
+        void add_client(int fd) {
+            auto client = std::make_unique<Client>();
+            client->conn = std::make_unique<ClientConnection>(fd, owner_.config_.client_buffer_bytes, owner_.config_.directory);
+            add_fd(fd, client.get());
+            clients_.push_back(std::move(client));
+            counters.accepted.fetch_add(1, std::memory_order_relaxed);
+            counters.clients.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // the Client stays alive until reap_closed(), epoll may still hand us its pointer in this pass
+        void close_client(Client& client) {
+            if (client.closed) return;
+            client.closed = true;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client.conn->fd(), nullptr);
+        }
+
+        void reap_closed() {
+            const auto removed = std::erase_if(clients_, [](const auto& client) { return client->closed; });
+            if (removed > 0) counters.clients.fetch_sub(removed, std::memory_order_relaxed);
+        }
+
+        void add_fd(int fd, void* ptr) {
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.ptr = ptr;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        }
+
+        void wake() {
+            const uint64_t one = 1;
+            [[maybe_unused]] auto r = write(wake_fd_, &one, sizeof(one));
+        }
+
+        TcpGateway& owner_;
+        int listen_fd_;
+        int epoll_fd_{-1};
+        int wake_fd_{-1};
+        CustomSpscQueue<Packet, queue_capacity> queue_;
+        std::atomic<bool> sleeping_{false};
+        std::atomic<bool> running_{false};
+        std::vector<std::unique_ptr<Client>> clients_;
+        std::mutex incoming_mutex_;
+        std::vector<int> incoming_;
+        std::jthread worker_;
+    };
+
+    GatewayConfig config_;
+    int listen_fd_{-1};
+    unsigned short port_{0};
+    std::size_t next_loop_{0};     // loop 0 thread only
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+};
+
+#endif // TCP_GATEWAY_H
@@ -0,0 +1,88 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <cxxopts.hpp>
+#include <spdlog/spdlog.h>
+
+#include "./feedhandler/UdpFeedHandler.h"
+#include "./gateway/TcpGateway.h"
+#include "./utils/SymbolDirectory.h"
+
+/*
+Subscriber gateway: joins the UDP multicast feed of main_simulate and serves it to TCP clients, each with its own
+subscriptions (see src/gateway/GatewayProtocol.h). Runs until interrupted, logging fan-out stats as it goes.
+ */
+namespace {
+    std::atomic<bool> interrupted{false};
+}
+
+int main(int argc, char** argv) {
+    cxxopts::Options options("md_gateway", "TCP subscriber gateway for the UDP market data feed");
+
+    options.add_options()
+        ("i,ip", "Multicast group of the feed", cxxopts::value<std::string>()->default_value("239.192.1.1"))
+        ("p,port", "Port of the feed", cxxopts::value<unsigned short>()->default_value("5555"))
+        ("l,listen", "TCP port clients connect to", cxxopts::value<unsigned short>()->default_value("6000"))
+        ("loops", "Event loop threads", cxxopts::value<std::size_t>()->default_value("1"))
+        ("buffer", "Output buffer per client in bytes", cxxopts::value<std::size_t>()->default_value("262144"))
+        ("sndbuf", "SO_SNDBUF per client, 0 = kernel default", cxxopts::value<int>()->default_value("0"))
+        ("policy", "Slow client policy (disconnect/conflate/block)", cxxopts::value<std::string>()->default_value("disconnect"))
+        ("f,symbols", "Symbols file shared with the feed, enables id filtering", cxxopts::value<std::string>()->default_value(""))
+        ("stats", "Stats interval in seconds", cxxopts::value<uint32_t>()->default_value("5"))
+        ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    GatewayConfig config;
+    config.port = result["listen"].as<unsigned short>();
+    config.loops = result["loops"].as<std::size_t>();
+    config.client_buffer_bytes = result["buffer"].as<std::size_t>();
+    config.socket_send_buffer = result["sndbuf"].as<int>();
+    const auto policy = gateway::parse_policy(result["policy"].as<std::string>());
+    if (!policy) throw std::invalid_argument("Invalid policy. Use 'disconnect', 'conflate' or 'block'.");
+    config.policy = *policy;
+    if (const auto symbols_file = result["symbols"].as<std::string>(); !symbols_file.empty()) {
+        config.directory = std::make_shared<const SymbolDirectory>(SymbolDirectory::from_file(symbols_file));
+    }
+
+    std::signal(SIGINT, [](int) { interrupted.store(true); });
+    std::signal(SIGTERM, [](int) { interrupted.store(true); });
+
+    try {
+        TcpGateway gw(config);
+        BasicUdpFeedHandler<TcpGateway::Sink> feed(result["ip"].as<std::string>(), result["port"].as<unsigned short>(), gw.sink());
+        if (config.directory) feed.set_symbol_directory(config.directory);
+        feed.subscribe("*");   // the clients filter, the feed handler passes everything
+
+        gw.start();
+        feed.start();
+        spdlog::info("Gateway listening on port {} with {} event loop(s), feed {}:{}",
+                     gw.port(), config.loops, result["ip"].as<std::string>(), result["port"].as<unsigned short>());
+
+        const auto interval = std::chrono::seconds(result["stats"].as<uint32_t>());
+        auto next = std::chrono::steady_clock::now() + interval;
+        while (!interrupted.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (std::chrono::steady_clock::now() < next) continue;
+            next += interval;
+            const auto s = gw.stats();
+            spdlog::info("clients {} | frames {} | conflated {} | slow disconnects {} | writev {} | {} MiB | dropped {}",
+                         s.clients, s.frames, s.conflated, s.slow_disconnects, s.writev_calls,
+                         s.bytes / (1024 * 1024), s.dropped);
+        }
+
+        feed.stop();
+        gw.stop();
+    } catch (const std::exception& e) {
+        spdlog::error("Gateway failed: {}", e.what());
+        return 1;
+    }
+    return 0;
+}
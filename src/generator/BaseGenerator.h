@@ -1,31 +1,62 @@
 #ifndef BASE_GENERATOR_H
 #define BASE_GENERATOR_H
 
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
 #include <thread>
 #include <chrono>
 #include <stop_token>
 #include <stdexcept>
 #include <variant>
+#include <concepts>
 #include "../utils/types.h"
+#include "../utils/SymbolDirectory.h"
+#include "../utils/Trace.h"
+#include "../shm/StatsSegment.h"
+#include "LoadProfile.h"
 
 // CRTP Base Class
+// Derived must provide generate_msg_impl(). Optionally:
+//   next_delay_impl()  -> std::chrono::nanoseconds, derived paces itself instead of the fixed rate (e.g. replay)
+//   exhausted_impl()   -> bool, ends the generation loop once the source has run dry
+// The rate can change while running, by set_rate() from any thread or by a load profile the generation loop
+// follows. The new interval starts at the next scheduled message, nothing already owed is dropped.
 template <typename Derived, typename MarketDataQueue>
 class BaseGenerator {
 public:
-    explicit BaseGenerator(MarketDataQueue& queue) : queue_(queue), messages_per_sec_(0), interval_(0) {}
+    explicit BaseGenerator(MarketDataQueue& queue) : queue_(queue), messages_per_sec_(0) {}
 
     ~BaseGenerator() { stop(); }
 
+    // any time, also while running: the generation loop picks it up before its next message
     void set_rate(uint32_t messages_per_second) {
         if (messages_per_second < 1) {
             throw std::invalid_argument("Rate must be > 0");
         }
-        messages_per_sec_ = messages_per_second;
-        interval_ = std::chrono::nanoseconds(1'000'000'000 / messages_per_sec_);
+        messages_per_sec_.store(messages_per_second, std::memory_order_relaxed);
     }
 
+    [[nodiscard]] uint32_t rate() const { return messages_per_sec_.load(std::memory_order_relaxed); }
+
+    // optional, the target rate follows the profile from start() on instead of staying at set_rate(). Every
+    // profile_step of the schedule it is looked up again. Set before start(), not for self-paced generators.
+    void set_profile(const LoadProfile* profile) { profile_ = profile; }
+
+    // optional per-stage tracing, the generator stamps the points up to the push. Set before start().
+    void set_trace(TraceLog* trace) { trace_ = trace; }
+
+    // optional counters in the stats segment, updated from the generator thread. Set before start().
+    void set_stats(shm::GeneratorStats* stats) { stats_ = stats; }
+
     void start() {
-        if (messages_per_sec_ == 0) {
+        if (profile_ && self_paced()) {
+            throw std::logic_error("A self-paced generator cannot follow a load profile.");
+        }
+        if (rate() == 0 && !profile_ && !self_paced()) {
             throw std::logic_error("Generator rate has not been configured.");
         }
         if (!generating_thread_.joinable()) {
@@ -42,29 +73,85 @@ public:
     }
 
 protected:
+    // index + 1 in the returned list is the symbol id stamped into the messages
+    static std::vector<std::string> read_symbols_file(std::filesystem::path const &filename) {
+        return SymbolDirectory::read_file(filename);
+    }
+
     MarketDataQueue& queue_;
-    uint32_t messages_per_sec_;
-    std::chrono::nanoseconds interval_;
+    std::atomic<uint32_t> messages_per_sec_;
 
 private:
+    // functions rather than constants so they are only evaluated once Derived is complete
+    static constexpr bool self_paced() {
+        return requires(Derived& d) { { d.next_delay_impl() } -> std::convertible_to<std::chrono::nanoseconds>; };
+    }
+    static constexpr bool finite() {
+        return requires(Derived& d) { { d.exhausted_impl() } -> std::convertible_to<bool>; };
+    }
+
+    static constexpr std::chrono::milliseconds profile_step{1};
+
     void generation_loop(const std::stop_token &stop_tok) {
-        auto next_time = std::chrono::steady_clock::now();
+        const auto start = std::chrono::steady_clock::now();
+        auto next_time = start;
+        auto next_profile_step = start;
+        uint32_t rate = 0;
+        std::chrono::nanoseconds interval{0};
 
         while (!stop_tok.stop_requested()) {
+            if constexpr (finite()) {
+                if (static_cast<Derived*>(this)->exhausted_impl()) break;
+            }
             auto now = std::chrono::steady_clock::now();
 
             if (now >= next_time) {
+                if constexpr (!self_paced()) {
+                    // looked up at the scheduled time, not now: a generator that fell behind still follows the profile in order
+                    if (profile_ && next_time >= next_profile_step) {
+                        messages_per_sec_.store(profile_->rate_at(next_time - start), std::memory_order_relaxed);
+                        next_profile_step = next_time + profile_step;
+                    }
+                    if (const uint32_t r = rate_if_changed(rate)) {
+                        rate = r;
+                        interval = std::chrono::nanoseconds(1'000'000'000 / rate);
+                    }
+                }
+
                 types::MarketDataMsg msg = static_cast<Derived*>(this)->generate_msg_impl();
 
+                // intended is the schedule, not now: a generator that fell behind still owes these messages
+                types::TraceTrailer* trailer = nullptr;
+                if (trace_) {
+                    trailer = &trace_->next_generated();
+                    trace::stamp(*trailer, types::TracePoint::Intended, static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(next_time.time_since_epoch()).count()));
+                    trace::stamp(*trailer, types::TracePoint::Generated);
+                }
+
                 std::visit([](auto&& arg) {
                     arg.enqueue_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
                         std::chrono::steady_clock::now().time_since_epoch()).count();
                 }, msg);
 
-                while (!stop_tok.stop_requested() && !queue_.push(msg)) {
+                // the enqueued stamp is retaken before every attempt, a full queue shows up as generated -> enqueued
+                uint64_t retries = 0;
+                bool pushed = false;
+                while (!stop_tok.stop_requested()) {
+                    if (trailer) trace::stamp(*trailer, types::TracePoint::Enqueued);
+                    if ((pushed = queue_.push(msg))) break;
+                    ++retries;
+                }
+                if (stats_) {
+                    if (pushed) shm::bump(stats_->pushed);
+                    if (retries) shm::bump(stats_->push_retries, retries);
                 }
 
-                next_time += interval_;
+                if constexpr (self_paced()) {
+                    next_time += static_cast<Derived*>(this)->next_delay_impl();
+                } else {
+                    next_time += interval;
+                }
             }
             // else {
             //     if (next_time - now > std::chrono::milliseconds(2)) {
@@ -74,6 +161,17 @@ private:
         }
     }
 
+    // the current rate when it differs from `current`, else 0. Published to the stats for the monitor and md_top.
+    uint32_t rate_if_changed(uint32_t current) {
+        const uint32_t r = messages_per_sec_.load(std::memory_order_relaxed);
+        if (r == current) return 0;
+        if (stats_) stats_->target_rate.store(r, std::memory_order_relaxed);
+        return r;
+    }
+
+    TraceLog* trace_{nullptr};
+    shm::GeneratorStats* stats_{nullptr};
+    const LoadProfile* profile_{nullptr};
     std::jthread generating_thread_;
     std::stop_source stop_source_;
 };
@@ -0,0 +1,180 @@
+#ifndef LOAD_PROFILE_H
+#define LOAD_PROFILE_H
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Load profile (--profile): the generator's target rate as a function of the time since it started, followed by the
+generation loop while it runs. Either one of the built-in shapes, scaled to --rate (the peak) and --duration:
+    ramp    rate/10 up to rate over the whole run
+    step    four equal steps: rate/4, rate/2, 3/4 rate, rate
+    spike   rate/4, then rate for a tenth of the run starting at a third of it, then rate/4 again
+    sine    between rate/10 and rate, four periods
+or segments separated by ';' or newlines (the same in a file), # starts a comment, seconds may have fractions:
+    hold RATE SECONDS
+    ramp FROM TO SECONDS
+    sine LOW HIGH PERIOD SECONDS     starts halfway between LOW and HIGH, going up
+After the last segment its last rate holds until the run ends.
+ */
+class LoadProfile {
+public:
+    enum class Shape { Hold, Ramp, Sine };
+
+    struct Segment {
+        Shape shape;
+        double from;      // hold: the rate, sine: low
+        double to;        // hold: the rate, sine: high
+        double period_s;  // sine only
+        double seconds;
+    };
+
+    static constexpr std::string_view builtin_names[] = {"ramp", "step", "spike", "sine"};
+
+    [[nodiscard]] static bool is_builtin(std::string_view name) {
+        return std::ranges::find(builtin_names, name) != std::end(builtin_names);
+    }
+
+    static LoadProfile builtin(std::string_view name, uint32_t rate, uint32_t duration_sec) {
+        if (rate < 1 || duration_sec < 1) throw std::invalid_argument("Load profile: needs a rate and a duration.");
+        const double peak = rate;
+        const double d = duration_sec;
+        const double low = std::max(peak / 10, 1.0);
+        const double quarter = std::max(peak / 4, 1.0);
+        LoadProfile p;
+        if (name == "ramp") {
+            p.segments_.push_back({Shape::Ramp, low, peak, 0, d});
+        } else if (name == "step") {
+            for (int i = 1; i <= 4; ++i) p.segments_.push_back({Shape::Hold, quarter * i, quarter * i, 0, d / 4});
+        } else if (name == "spike") {
+            p.segments_.push_back({Shape::Hold, quarter, quarter, 0, d / 3});
+            p.segments_.push_back({Shape::Hold, peak, peak, 0, d / 10});
+            p.segments_.push_back({Shape::Hold, quarter, quarter, 0, d - d / 3 - d / 10});
+        } else if (name == "sine") {
+            p.segments_.push_back({Shape::Sine, low, peak, d / 4, d});
+        } else {
+            throw std::invalid_argument("Load profile: no built-in shape '" + std::string(name) + "', use ramp, step, spike or sine.");
+        }
+        return p;
+    }
+
+    static LoadProfile parse(std::string_view spec) {
+        LoadProfile p;
+        while (!spec.empty()) {
+            const std::size_t end = spec.find_first_of(";\n");
+            std::string_view line = spec.substr(0, end);
+            spec = end == std::string_view::npos ? std::string_view{} : spec.substr(end + 1);
+            if (const std::size_t hash = line.find('#'); hash != std::string_view::npos) line = line.substr(0, hash);
+
+            std::vector<double> args;
+            std::string_view kind;
+            while (true) {
+                const std::size_t start = line.find_first_not_of(" \t\r");
+                if (start == std::string_view::npos) break;
+                line.remove_prefix(start);
+                const std::string_view word = line.substr(0, line.find_first_of(" \t\r"));
+                line.remove_prefix(word.size());
+                if (kind.empty()) kind = word;
+                else args.push_back(number(word));
+            }
+            if (kind.empty()) continue;
+
+            const auto expect = [&](std::size_t n, const char* usage) {
+                if (args.size() != n) throw std::invalid_argument("Load profile: expected '" + std::string(usage) + "'");
+            };
+            Segment s{};
+            if (kind == "hold") {
+                expect(2, "hold RATE SECONDS");
+                s = {Shape::Hold, args[0], args[0], 0, args[1]};
+            } else if (kind == "ramp") {
+                expect(3, "ramp FROM TO SECONDS");
+                s = {Shape::Ramp, args[0], args[1], 0, args[2]};
+            } else if (kind == "sine") {
+                expect(4, "sine LOW HIGH PERIOD SECONDS");
+                s = {Shape::Sine, args[0], args[1], args[2], args[3]};
+                if (s.period_s <= 0 || s.to < s.from) throw std::invalid_argument("Load profile: sine needs LOW <= HIGH and a period > 0");
+            } else {
+                throw std::invalid_argument("Load profile: unknown segment '" + std::string(kind) + "', use hold, ramp or sine.");
+            }
+            if (s.from < 1 || s.to < 1) throw std::invalid_argument("Load profile: rates must be at least 1 msg/s");
+            if (s.seconds <= 0) throw std::invalid_argument("Load profile: segment lengths must be > 0");
+            p.segments_.push_back(s);
+        }
+        if (p.segments_.empty()) throw std::invalid_argument("Load profile: no segments");
+        return p;
+    }
+
+    // --profile takes a built-in shape, a file or the segments themselves
+    static LoadProfile load(const std::string& spec, uint32_t rate, uint32_t duration_sec) {
+        if (is_builtin(spec)) return builtin(spec, rate, duration_sec);
+        if (spec.find_first_of(" \t;\n") == std::string::npos && std::filesystem::is_regular_file(spec)) {
+            std::ifstream in(spec);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            return parse(ss.str());
+        }
+        return parse(spec);
+    }
+
+    // whole msgs/s, at least 1
+    [[nodiscard]] uint32_t rate_at(std::chrono::nanoseconds elapsed) const {
+        double t = std::chrono::duration<double>(elapsed).count();
+        for (const Segment& s : segments_) {
+            if (t < s.seconds) return whole(value(s, t));
+            t -= s.seconds;
+        }
+        return whole(value(segments_.back(), segments_.back().seconds));
+    }
+
+    [[nodiscard]] uint32_t peak() const {
+        double peak = 0;
+        for (const Segment& s : segments_) peak = std::max({peak, s.from, s.to});
+        return whole(peak);
+    }
+
+    [[nodiscard]] double seconds() const {
+        double total = 0;
+        for (const Segment& s : segments_) total += s.seconds;
+        return total;
+    }
+
+    [[nodiscard]] const std::vector<Segment>& segments() const { return segments_; }
+
+private:
+    static double number(std::string_view word) {
+        double v{};
+        const auto [end, ec] = std::from_chars(word.data(), word.data() + word.size(), v);
+        if (ec != std::errc{} || end != word.data() + word.size()) {
+            throw std::invalid_argument("Load profile: '" + std::string(word) + "' is not a number");
+        }
+        return v;
+    }
+
+    static double value(const Segment& s, double t) {
+        switch (s.shape) {
+            case Shape::Hold: return s.from;
+            case Shape::Ramp: return s.from + (s.to - s.from) * std::min(t / s.seconds, 1.0);
+            case Shape::Sine: return (s.from + s.to) / 2 + (s.to - s.from) / 2 * std::sin(2 * std::numbers::pi * t / s.period_s);
+        }
+        return s.from;
+    }
+
+    static uint32_t whole(double rate) {
+        return static_cast<uint32_t>(std::clamp(std::lround(rate), 1L, static_cast<long>(UINT32_MAX)));
+    }
+
+    std::vector<Segment> segments_;
+};
+
+#endif // LOAD_PROFILE_H
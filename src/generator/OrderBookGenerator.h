@@ -0,0 +1,227 @@
+#ifndef ORDER_BOOK_GENERATOR_H
+#define ORDER_BOOK_GENERATOR_H
+
+#include "BaseGenerator.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+/*
+Order-by-order generator. Keeps a small internal book per symbol and emits the add/modify/cancel/execute
+stream that a consumer needs to rebuild that book.
+Adds rest passively around a random-walk mid and never cross the opposite side, executes always hit the best
+order of one side, so a correct book builder never sees a crossed book.
+Order ids are recycled through a free list, which keeps them dense and lets both sides index orders by id.
+ */
+template <typename MarketDataQueue>
+class OrderBookGenerator final : public BaseGenerator<OrderBookGenerator<MarketDataQueue>, MarketDataQueue> {
+public:
+    static constexpr std::size_t max_orders_per_symbol = 64;
+    static constexpr std::size_t target_orders_per_symbol = 32;
+    static constexpr int64_t initial_mid_ticks = 10'000; // 100.00
+
+    explicit OrderBookGenerator(MarketDataQueue& queue)
+        : BaseGenerator<OrderBookGenerator<MarketDataQueue>, MarketDataQueue>(queue),
+          rng_(std::random_device{}()) {}
+
+    void configure(uint32_t messages_per_second, const std::filesystem::path &symbols_file) {
+        this->set_rate(messages_per_second);
+        symbols_ = this->read_symbols_file(symbols_file);
+
+        if (symbols_.empty()) throw std::logic_error("Symbols file empty or invalid.");
+
+        books_.assign(symbols_.size(), SymbolBook{});
+        for (auto& book : books_) {
+            book.mid = initial_mid_ticks;
+            book.order_ids.reserve(max_orders_per_symbol);
+        }
+        spdlog::info("OrderBookGenerator configured: {} msgs/sec, {} symbols", messages_per_second, symbols_.size());
+    }
+
+    types::MarketDataMsg generate_msg_impl() {
+        std::uniform_int_distribution<size_t> symbol_distr(0, symbols_.size() - 1);
+        std::uniform_int_distribution<int> action_distr(0, 99);
+
+        const std::size_t idx = symbol_distr(rng_);
+        SymbolBook& book = books_[idx];
+
+        // slow random walk of the mid, adds follow it
+        if (const int step = action_distr(rng_); step < 5) {
+            book.mid = std::max<int64_t>(book.mid - 1, 100);
+        } else if (step >= 95) {
+            book.mid += 1;
+        }
+
+        const std::size_t depth = book.order_ids.size();
+        const int add_threshold = depth < target_orders_per_symbol ? 60 : 40;
+        const int roll = action_distr(rng_);
+
+        if (depth == 0 || (roll < add_threshold && depth < max_orders_per_symbol)) {
+            return add_order(idx, book);
+        }
+        if (roll < 80 || depth >= max_orders_per_symbol) {
+            return cancel_order(idx, book);
+        }
+        if (roll < 90) {
+            return modify_order(idx, book);
+        }
+        return execute_order(idx, book);
+    }
+
+    [[nodiscard]] std::size_t live_orders() const { return orders_.size() - free_ids_.size(); }
+
+private:
+    struct LiveOrder {
+        int64_t price;      // ticks
+        uint32_t size;
+        types::Side side;
+        uint32_t position;  // index in SymbolBook::order_ids
+    };
+
+    struct SymbolBook {
+        int64_t mid{0};
+        std::vector<uint64_t> order_ids;
+    };
+
+    template <typename Msg>
+    Msg make_msg(std::size_t idx, uint64_t order_id) {
+        Msg msg{};
+        std::strncpy(msg.symbol, symbols_[idx].c_str(), sizeof(msg.symbol) - 1);
+        msg.symbol_id = static_cast<uint32_t>(idx + 1);
+        msg.order_id = order_id;
+        msg.enqueue_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        return msg;
+    }
+
+    static double to_price(int64_t ticks) { return static_cast<double>(ticks) * types::price_tick; }
+
+    // best price on one side, or the sentinel if that side is empty
+    int64_t best(const SymbolBook& book, types::Side side) const {
+        int64_t best = side == types::Side::Buy ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+        for (const uint64_t id : book.order_ids) {
+            const LiveOrder& o = orders_[id];
+            if (o.side != side) continue;
+            best = side == types::Side::Buy ? std::max(best, o.price) : std::min(best, o.price);
+        }
+        return best;
+    }
+
+    uint64_t pick_order(const SymbolBook& book) {
+        std::uniform_int_distribution<size_t> distr(0, book.order_ids.size() - 1);
+        return book.order_ids[distr(rng_)];
+    }
+
+    void remove_order(SymbolBook& book, uint64_t order_id) {
+        const uint32_t pos = orders_[order_id].position;
+        const uint64_t last = book.order_ids.back();
+        book.order_ids[pos] = last;
+        orders_[last].position = pos;
+        book.order_ids.pop_back();
+        free_ids_.push_back(order_id);
+    }
+
+    types::OrderAdd add_order(std::size_t idx, SymbolBook& book) {
+        std::bernoulli_distribution side_distr(0.5);
+        std::geometric_distribution<int> offset_distr(0.3);
+        std::uniform_int_distribution<uint32_t> lots_distr(1, 10);
+
+        const types::Side side = side_distr(rng_) ? types::Side::Buy : types::Side::Sell;
+        const int64_t offset = 1 + std::min(offset_distr(rng_), 50);
+        int64_t price;
+        if (side == types::Side::Buy) {
+            price = std::min(book.mid - offset, best(book, types::Side::Sell) - 1);
+        } else {
+            price = std::max(book.mid + offset, best(book, types::Side::Buy) + 1);
+        }
+
+        uint64_t order_id;
+        if (!free_ids_.empty()) {
+            order_id = free_ids_.back();
+            free_ids_.pop_back();
+        } else {
+            order_id = orders_.size();
+            orders_.emplace_back();
+        }
+        const uint32_t size = 100 * lots_distr(rng_);
+        orders_[order_id] = {price, size, side, static_cast<uint32_t>(book.order_ids.size())};
+        book.order_ids.push_back(order_id);
+
+        auto msg = make_msg<types::OrderAdd>(idx, order_id);
+        msg.price = to_price(price);
+        msg.size = size;
+        msg.side = side;
+        return msg;
+    }
+
+    types::OrderCancel cancel_order(std::size_t idx, SymbolBook& book) {
+        const uint64_t order_id = pick_order(book);
+        remove_order(book, order_id);
+        return make_msg<types::OrderCancel>(idx, order_id);
+    }
+
+    types::OrderModify modify_order(std::size_t idx, SymbolBook& book) {
+        std::uniform_int_distribution<uint32_t> lots_distr(1, 10);
+        std::bernoulli_distribution move_distr(0.3);
+
+        const uint64_t order_id = pick_order(book);
+        LiveOrder& order = orders_[order_id];
+        order.size = 100 * lots_distr(rng_);
+        // only ever move away from the touch, that can't cross the book
+        if (move_distr(rng_)) {
+            if (order.side == types::Side::Sell) {
+                order.price += 1;
+            } else if (order.price > 1) {
+                order.price -= 1;
+            }
+        }
+
+        auto msg = make_msg<types::OrderModify>(idx, order_id);
+        msg.price = to_price(order.price);
+        msg.size = order.size;
+        return msg;
+    }
+
+    types::MarketDataMsg execute_order(std::size_t idx, SymbolBook& book) {
+        std::bernoulli_distribution side_distr(0.5);
+        types::Side side = side_distr(rng_) ? types::Side::Buy : types::Side::Sell;
+        int64_t best_price = best(book, side);
+        if (best_price == std::numeric_limits<int64_t>::min() || best_price == std::numeric_limits<int64_t>::max()) {
+            side = side == types::Side::Buy ? types::Side::Sell : types::Side::Buy;
+            best_price = best(book, side);
+        }
+
+        uint64_t order_id = book.order_ids.front();
+        for (const uint64_t id : book.order_ids) {
+            if (orders_[id].side == side && orders_[id].price == best_price) {
+                order_id = id;
+                break;
+            }
+        }
+
+        LiveOrder& order = orders_[order_id];
+        std::uniform_int_distribution<uint32_t> fill_distr(1, order.size);
+        const uint32_t executed = fill_distr(rng_);
+        order.size -= executed;
+        if (order.size == 0) {
+            remove_order(book, order_id);
+        }
+
+        auto msg = make_msg<types::OrderExecute>(idx, order_id);
+        msg.executed_size = executed;
+        return msg;
+    }
+
+    std::vector<std::string> symbols_;
+    std::vector<SymbolBook> books_;
+    std::vector<LiveOrder> orders_;   // indexed by order id
+    std::vector<uint64_t> free_ids_;
+    std::mt19937 rng_;
+};
+
+#endif // ORDER_BOOK_GENERATOR_H
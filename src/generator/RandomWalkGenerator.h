@@ -18,7 +18,7 @@ public:
 
     void configure(uint32_t messages_per_second, const std::filesystem::path &symbols_file) {
         this->set_rate(messages_per_second);
-        symbols_ = read_symbols_file(symbols_file);
+        symbols_ = this->read_symbols_file(symbols_file);
         
         if (symbols_.empty()) throw std::logic_error("Symbols file empty or invalid.");
         
@@ -51,6 +51,7 @@ private:
 
         types::Quote next_quote{};
         std::strncpy(next_quote.symbol, symbol.c_str(), sizeof(next_quote.symbol) - 1);
+        next_quote.symbol_id = static_cast<uint32_t>(idx + 1);
         next_quote.bid_price = price - bid_ask_spread / 2;
         next_quote.ask_price = price + bid_ask_spread / 2;
         next_quote.bid_size = quote_size(rng_);
@@ -70,6 +71,7 @@ private:
 
         types::Trade next_trade{};
         std::strncpy(next_trade.symbol, symbol.c_str(), sizeof(next_trade.symbol) - 1);
+        next_trade.symbol_id = static_cast<uint32_t>(idx + 1);
         next_trade.price = price;
         next_trade.size = trade_size(rng_);
         next_trade.enqueue_timestamp= std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -78,25 +80,6 @@ private:
         return next_trade;
     }
 
-    std::vector<std::string> read_symbols_file(std::filesystem::path const &filename) {
-        std::vector<std::string> tickers;
-        std::ifstream file(filename);
-        std::string str;
-
-        // had some problems with linux/windows CRLF vs R so now strip all
-        while (std::getline(file, str)) {
-            str.erase(std::remove(str.begin(), str.end(), '\r'), str.end());
-            str.erase(std::remove(str.begin(), str.end(), '\n'), str.end());
-
-            str.erase(std::remove_if(str.begin(), str.end(), ::isspace), str.end());
-
-            if (!str.empty() && str.length() < 9) {
-                tickers.push_back(str);
-            }
-        }
-        return tickers;
-    }
-
     std::vector<std::string> symbols_;
     std::mt19937 rng_;
     std::vector<double> current_prices_;
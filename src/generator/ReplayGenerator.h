@@ -0,0 +1,98 @@
+#ifndef REPLAY_GENERATOR_H
+#define REPLAY_GENERATOR_H
+
+#include "BaseGenerator.h"
+#include "../recorder/CaptureReader.h"
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+/*
+Replays a capture written by CaptureRecorder into the queue.
+    speed == 1.0 -> original inter-message timing
+    speed == 4.0 -> four times faster than recorded
+    speed <= 0   -> as fast as the queue accepts, no pacing at all
+The capture stays memory-mapped, each call decodes one record straight out of the mapping into the variant,
+so there is no per-message allocation and the RNG cost of RandomWalkGenerator is out of the picture.
+ */
+template <typename MarketDataQueue>
+class ReplayGenerator final : public BaseGenerator<ReplayGenerator<MarketDataQueue>, MarketDataQueue> {
+public:
+    explicit ReplayGenerator(MarketDataQueue& queue)
+        : BaseGenerator<ReplayGenerator<MarketDataQueue>, MarketDataQueue>(queue) {}
+
+    void configure(const std::filesystem::path& capture_file, double speed = 1.0, bool loop = true) {
+        reader_ = std::make_unique<CaptureReader>(capture_file);
+        speed_ = speed;
+        loop_ = loop;
+        if (!load_next()) {
+            throw std::logic_error("Capture file contains no replayable records.");
+        }
+        spdlog::info("ReplayGenerator configured: {} records from {}, speed {}{}",
+                     reader_->header().record_count, capture_file.string(),
+                     speed_ > 0 ? std::to_string(speed_) + "x" : "max", loop_ ? ", looping" : "");
+    }
+
+    types::MarketDataMsg generate_msg_impl() {
+        types::MarketDataMsg msg = pending_;
+        const uint64_t ts = pending_ts_;
+        has_pending_ = load_next();
+
+        // gap to the next record scaled by speed, the wrap around from the last record to the first is not delayed
+        if (speed_ > 0 && has_pending_ && pending_ts_ >= ts) {
+            delay_ = std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(pending_ts_ - ts) / speed_));
+        } else {
+            delay_ = std::chrono::nanoseconds(0);
+        }
+        ++replayed_;
+        return msg;
+    }
+
+    [[nodiscard]] std::chrono::nanoseconds next_delay_impl() const { return delay_; }
+    [[nodiscard]] bool exhausted_impl() const { return !has_pending_; }
+
+    [[nodiscard]] uint64_t replayed() const { return replayed_; }
+
+private:
+    // decodes the next known message into pending_, skips anything we don't know
+    bool load_next() {
+        capture::RecordView rec{};
+        bool wrapped = false;
+        while (true) {
+            if (!reader_->next(rec)) {
+                // a second wrap in one call means there is nothing we can replay in the whole file
+                if (!loop_ || wrapped) {
+                    return false;
+                }
+                wrapped = true;
+                reader_->rewind();
+                if (!reader_->next(rec)) {
+                    return false;
+                }
+            }
+
+            const auto* rh = rec.header;
+            const bool known = types::Messages::dispatch(rh->tag, rec.payload, rh->payload_size,
+                [this](const auto& msg) { pending_ = msg; });
+            if (!known) {
+                continue;
+            }
+            pending_ts_ = rh->timestamp_ns;
+            has_pending_ = true;
+            return true;
+        }
+    }
+
+    std::unique_ptr<CaptureReader> reader_;
+    double speed_{1.0};
+    bool loop_{true};
+
+    types::MarketDataMsg pending_;
+    uint64_t pending_ts_{0};
+    bool has_pending_{false};
+    std::chrono::nanoseconds delay_{0};
+    uint64_t replayed_{0};
+};
+
+#endif // REPLAY_GENERATOR_H
@@ -1,42 +1,243 @@
+#include <csignal>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <cxxopts.hpp>
 #include <spdlog/spdlog.h>
 #include <boost/lockfree/spsc_queue.hpp>
 
 #include "./utils/config.h"
+#include "./utils/Sweep.h"
+#include "./utils/ThroughputSearch.h"
 #include "./utils/CustomSpscQueue.h"
 #include "./utils/SpinSpscQueue.h"
 #include "./utils/WaitableSpscQueue.h"
 #include "./disseminator/UdpDisseminator.h"
 #include "./disseminator/ZmqDisseminator.h"
+#include "./disseminator/ShmDisseminator.h"
 #include "./generator/RandomWalkGenerator.h"
+#include "./generator/ReplayGenerator.h"
+#include "./generator/OrderBookGenerator.h"
+#include "./generator/LoadProfile.h"
+#include "./book/BookBuilder.h"
 #include "./monitor/LatencyMonitor.h"
+#include "./monitor/LiveLatency.h"
+#include "./monitor/RunAnalysis.h"
+#include "./recorder/CaptureRecorder.h"
+#include "./shm/StatsSegment.h"
+#include "./snapshot/SnapshotServer.h"
 #include "./feedhandler/UdpFeedHandler.h"
 #include "./feedhandler/ZmqFeedHandler.h"
+#include "./feedhandler/ShmFeedHandler.h"
+#include "./feedhandler/Conflator.h"
+
+// Ctrl-C ends the run early but still drains and writes the results, a second one kills it
+volatile std::sig_atomic_t interrupted = 0;
+
+extern "C" void on_interrupt(int) {
+    interrupted = 1;
+    std::signal(SIGINT, SIG_DFL);
+}
+
+template <typename GeneratorType>
+void drive_generator(const BenchmarkConfig& config, GeneratorType& generator, TraceLog* trace, shm::GeneratorStats* stats,
+                     const LoadProfile* profile) {
+    generator.set_trace(trace);
+    generator.set_stats(stats);
+    generator.set_profile(profile);
+    generator.start();
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::seconds(config.duration_sec);
+    for (auto now = start; now < end && !interrupted; now = std::chrono::steady_clock::now()) {
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(std::chrono::milliseconds(100), end - now));
+    }
+
+    if (interrupted) {
+        spdlog::warn("Interrupted after {:.1f}s. Stopping generator...",
+                     std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    } else {
+        spdlog::info("Benchmark duration met. Stopping generator...");
+    }
+    generator.stop();
+}
+
+// slow consumer behind the conflation stage, rate 0 takes everything as soon as it is there
+void consume_conflated(const std::stop_token& st, Conflator& conflator, LatencyMonitor& monitor, uint32_t rate,
+                       LatencyRecorder* live) {
+    auto consume = [&monitor, live](const auto& msg, uint64_t recv_ts) {
+        using T = std::decay_t<decltype(msg)>;
+        // no sequence, the quotes conflation leaves out are not drops
+        if (live) live->record(recv_ts - msg.enqueue_timestamp);
+        if constexpr (std::is_same_v<T, types::Quote>) monitor.on_quote(msg, recv_ts);
+        else if constexpr (std::is_same_v<T, types::Trade>) monitor.on_trade(msg, recv_ts);
+    };
+
+    constexpr auto tick = std::chrono::milliseconds(1);
+    const double per_tick = rate / 1000.0;
+    double budget = 0.0;
+    auto next = std::chrono::steady_clock::now();
+    while (!st.stop_requested()) {
+        if (rate == 0) {
+            if (conflator.drain(consume) == 0) std::this_thread::yield();
+            continue;
+        }
+        // unused budget does not pile up, an idle consumer is not allowed to burst later
+        budget = std::min(budget + per_tick, std::max(per_tick, 1.0));
+        budget -= static_cast<double>(conflator.drain(consume, static_cast<std::size_t>(budget)));
+        next += tick;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void report_conflation(const Conflator& conflator) {
+    std::vector<uint64_t> staleness = conflator.quote_staleness();
+    std::ranges::sort(staleness);
+    auto pct = [&staleness](double p) {
+        return staleness.empty() ? 0.0 : staleness[static_cast<std::size_t>(p * static_cast<double>(staleness.size() - 1))] / 1000.0;
+    };
+    const auto stats = conflator.stats();
+    spdlog::info("Conflation: {} quotes in, {} delivered (ratio {:.2f}), {} passed through, {} dropped.",
+                 stats.quotes_in, stats.quotes_out, conflator.conflation_ratio(), stats.passed_through, stats.pass_through_dropped);
+    spdlog::info("Quote staleness: p50 {:.1f} us, p90 {:.1f} us, p99 {:.1f} us, p99.9 {:.1f} us.",
+                 pct(0.5), pct(0.9), pct(0.99), pct(0.999));
+}
+
+// kernel RX stamp of the message being delivered, for feed handlers that take them (UDP with --udp-timestamping)
+template <typename FeedHandlerType>
+uint64_t kernel_receive_timestamp(const FeedHandlerType& feedhandler) {
+    if constexpr (requires { feedhandler.kernel_receive_timestamp(); }) return feedhandler.kernel_receive_timestamp();
+    else return 0;
+}
+
+// the disseminator's kernel TX stamps, collected off its error queue while it ran, complete the latency records
+template <typename DisseminatorType>
+void resolve_tx_timestamps(DisseminatorType& disseminator, LatencyMonitor& monitor) {
+    if constexpr (requires { disseminator.tx_timestamps(); }) {
+        TxTimestampCollector* tx = disseminator.tx_timestamps();
+        if (tx == nullptr) return;
+        tx->stop();
+        const std::size_t resolved = monitor.resolve_tx_timestamps([tx](uint64_t sequence) { return tx->tx_ns(sequence); });
+        spdlog::info("Kernel timestamps: {} TX stamps collected ({} unmatched), {} records split into tx stack / wire / rx stack.",
+                     tx->collected(), tx->unmatched(), resolved);
+    }
+}
 
 template <typename MarketDataQueue, typename DisseminatorType, typename FeedHandlerType>
-void run_benchmark_pipeline(const BenchmarkConfig& config,
+shm::Drain run_benchmark_pipeline(const BenchmarkConfig& config,
                             MarketDataQueue& queue,
                             DisseminatorType& disseminator,
                             FeedHandlerType& feedhandler) {
 
     spdlog::info("Starting benchmark: Transport={}, QueueStrategy={}, Size={}, Rate={}, Duration={}s",
-                 (config.transport == TransportProtocol::UdpMulticast ? "UDP" : "ZMQ"),
+                 transport_name(config.transport),
                  (config.queue_strategy == QueueWaitStrategy::Spin ? "Spin" : "Waitable"),
                  config.queue_size, config.message_rate, config.duration_sec);
 
-    LatencyMonitor monitor(config.message_rate * config.duration_sec, config.out_dir);
+    // with a profile --rate only scales the built-in shapes, the records are reserved for its peak
+    std::optional<LoadProfile> profile;
+    if (!config.profile.empty()) {
+        profile = LoadProfile::load(config.profile, config.message_rate, config.duration_sec);
+        spdlog::info("Load profile {}: {} segment(s) over {:.1f} s, peak {} msg/s.", config.profile, profile->segments().size(),
+                     profile->seconds(), profile->peak());
+        if (profile->seconds() < config.duration_sec) {
+            spdlog::info("The profile ends before the run, its last rate holds for the remaining {:.1f} s.",
+                         config.duration_sec - profile->seconds());
+        }
+    }
+    const uint32_t peak_rate = profile ? profile->peak() : config.message_rate;
+
+    // streamed records need no room in memory
+    LatencyMonitor monitor(config.binary_latencies ? 0 : std::size_t{peak_rate} * config.duration_sec, config.out_dir);
+    if (config.binary_latencies) {
+        monitor.stream_binary(config.out_dir + "/latencies.mdlat", LatencyColumnWriter::default_block_records,
+                              config.conflate ? latency_columns::conflated_sequences : 0);
+        if (config.udp_timestamping != KernelTimestamps::Off) {
+            spdlog::warn("--latency-format binary does not record the kernel timestamp stages, use csv for those.");
+        }
+    }
+
+    // the generators number the symbols the same way, so the feed handler can filter on the symbol id in the
+    // messages. Not for replays, the ids in a capture come from whatever file it was recorded with.
+    auto directory = std::make_shared<const SymbolDirectory>(SymbolDirectory::from_file(config.symbols_file));
+    const std::vector<std::string>& symbols = directory->symbols();
+
+    // counters for an outside viewer (md_top), see shm/StatsSegment.h
+    std::unique_ptr<StatsSegment> stats;
+    if (!config.stats_shm.empty()) {
+        stats = std::make_unique<StatsSegment>(config.stats_shm, transport_name(config.transport),
+                                               queue_strategy_name(config.queue_strategy),
+                                               config.queue_size, config.message_rate);
+        spdlog::info("Publishing stats to shared memory {}, watch with md_top --name {}", config.stats_shm, config.stats_shm);
+    }
+    // the stages always count, in the segment if there is one: the end of the run waits on them to drain
+    shm::GeneratorStats own_generator{};
+    shm::DisseminatorStats own_disseminator{};
+    shm::FeedHandlerStats own_feed_handler{};
+    shm::GeneratorStats& generated = stats ? stats->generator() : own_generator;
+    shm::DisseminatorStats& sent = stats ? stats->disseminator() : own_disseminator;
+    shm::FeedHandlerStats& received = stats ? stats->feed_handler() : own_feed_handler;
+    disseminator.set_stats(&sent);
+    feedhandler.set_stats(&received);
+
+    // live p50/p99/p99.9 of the consumer while running, from whichever thread feeds the monitor. Also what
+    // the stats segment shows as latency. A profile run always gets it, each window next to its target rate.
+    std::unique_ptr<LiveAggregator> live;
+    LatencyRecorder* live_recorder = nullptr;
+    const bool live_csv = config.live || profile;
+    if (live_csv || stats) {
+        live = std::make_unique<LiveAggregator>(std::chrono::milliseconds(config.live_interval_ms),
+                                                live_csv ? config.out_dir + "/live_latency.csv" : std::string{});
+        live->set_logging(live_csv);
+        live->set_target_rate(&generated.target_rate);
+        if (stats) {
+            live->set_observer([&latency = stats->latency()](const LatencyHistogram& total, uint64_t drops,
+                                                              const LiveAggregator::Report* report) {
+                shm::publish_latency(latency, total, drops, report);
+            });
+        }
+        live_recorder = &live->add_recorder("consumer");
+        live->start();
+    }
 
-    feedhandler.set_quote_callback([&monitor](const types::Quote& q, uint64_t recv_ts) {
-        monitor.on_quote(q, recv_ts);
-    });
-    feedhandler.set_trade_callback([&monitor](const types::Trade& t, uint64_t recv_ts) {
-        monitor.on_trade(t, recv_ts);
-    });
+    std::unique_ptr<Conflator> conflator;
+    std::jthread consumer;
+    if (config.conflate) {
+        // quotes and trades go through the conflation stage, a consumer thread takes them out at consumer_rate
+        conflator = std::make_unique<Conflator>(directory->id_limit());
+        feedhandler.set_quote_callback([c = conflator.get()](const types::Quote& q, uint64_t recv_ts) { c->push(q, recv_ts); });
+        feedhandler.set_trade_callback([c = conflator.get()](const types::Trade& t, uint64_t recv_ts) { c->push(t, recv_ts); });
+        consumer = std::jthread([&config, &monitor, c = conflator.get(), live_recorder](std::stop_token st) {
+            consume_conflated(st, *c, monitor, config.consumer_rate, live_recorder);
+        });
+    } else {
+        feedhandler.set_quote_callback([&monitor, &feedhandler, live_recorder](const types::Quote& q, uint64_t recv_ts) {
+            if (live_recorder) live_recorder->record(recv_ts - q.enqueue_timestamp, q.sequence);
+            if (const types::TraceTrailer* trailer = feedhandler.current_trace()) monitor.on_trace(q, *trailer, trace::now_ns());
+            monitor.on_quote(q, recv_ts, kernel_receive_timestamp(feedhandler));
+        });
+        feedhandler.set_trade_callback([&monitor, &feedhandler, live_recorder](const types::Trade& t, uint64_t recv_ts) {
+            if (live_recorder) live_recorder->record(recv_ts - t.enqueue_timestamp, t.sequence);
+            if (const types::TraceTrailer* trailer = feedhandler.current_trace()) monitor.on_trace(t, *trailer, trace::now_ns());
+            monitor.on_trade(t, recv_ts, kernel_receive_timestamp(feedhandler));
+        });
+    }
 
-    RandomWalkGenerator<MarketDataQueue> generator(queue);
-    generator.configure(config.message_rate, config.symbols_file);
+    // order-by-order feed: rebuild the books on the receive thread, that work is part of the measured path
+    // symbol ids outside the directory (a capture from another source) go through the symbol hash
+    BookBuilder book_builder(symbols.size(), 0, directory->id_limit());
+    auto apply_order = [&monitor, &book_builder, &feedhandler, live_recorder](const auto& msg, uint64_t recv_ts) {
+        if (live_recorder) live_recorder->record(recv_ts - msg.enqueue_timestamp, msg.sequence);
+        if (const types::TraceTrailer* trailer = feedhandler.current_trace()) monitor.on_trace(msg, *trailer, trace::now_ns());
+        book_builder.apply(msg);
+        const uint64_t applied_ts = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        monitor.on_order(msg, recv_ts, applied_ts, kernel_receive_timestamp(feedhandler));
+    };
+    feedhandler.template set_callbacks<types::OrderAdd, types::OrderModify,
+                                       types::OrderCancel, types::OrderExecute>(apply_order);
 
     // start everything in reverse order (Consumer -> Publisher -> Generator)
     feedhandler.start();
@@ -45,70 +246,210 @@ void run_benchmark_pipeline(const BenchmarkConfig& config,
     // feedhandler.subscribe("AAPL");
     // feedhandler.subscribe("MSFT");
 
-    std::ifstream sym_file(config.symbols_file);
-    std::string sym;
-    int sub_count = 0;
-    while (std::getline(sym_file, sym)) {
-        sym.erase(std::remove(sym.begin(), sym.end(), '\r'), sym.end());
-        sym.erase(std::remove(sym.begin(), sym.end(), '\n'), sym.end());
-        sym.erase(std::remove_if(sym.begin(), sym.end(), ::isspace), sym.end());
-
-        if (!sym.empty() && sym.length() < 9) {
-            feedhandler.subscribe(sym);
-            sub_count++;
-        }
+    if (config.generator != GeneratorKind::Replay) {
+        feedhandler.set_symbol_directory(directory);
     }
-    spdlog::info("Feedhandler subscribed to {} symbols.", sub_count);
 
-    disseminator.start();
-    std::this_thread::sleep_for(std::chrono::milliseconds(200));  // for the handshake if zmq tcp
-    generator.start();
+    // whole universe in one filter swap, then wait for the receive thread to pick it up
+    const auto sub_start = std::chrono::steady_clock::now();
+    feedhandler.subscribe(symbols);
+    const auto sub_published = std::chrono::steady_clock::now();
+    while (!feedhandler.subscriptions_applied() && std::chrono::steady_clock::now() - sub_start < std::chrono::seconds(2)) {
+        std::this_thread::yield();
+    }
+    const auto sub_applied = std::chrono::steady_clock::now();
+    spdlog::info("Feedhandler subscribed to {} symbols: filter published after {} us, live in the receive loop after {} us.",
+                 symbols.size(),
+                 std::chrono::duration_cast<std::chrono::microseconds>(sub_published - sub_start).count(),
+                 std::chrono::duration_cast<std::chrono::microseconds>(sub_applied - sub_start).count());
+
+    std::unique_ptr<CaptureRecorder> recorder;
+    if (!config.record_file.empty()) {
+        recorder = std::make_unique<CaptureRecorder>(config.record_file);
+        disseminator.set_recorder(recorder.get());
+        recorder->start();
+        spdlog::info("Recording disseminated stream to {}", config.record_file);
+    }
 
-    std::this_thread::sleep_for(std::chrono::seconds(config.duration_sec));
+    // last values per symbol for feed handlers that join after the start, see IFeedHandler::request_snapshot
+    std::unique_ptr<SnapshotServer> snapshot_server;
+    if (config.snapshot_port != 0) {
+        snapshot_server = std::make_unique<SnapshotServer>(config.snapshot_port, directory->id_limit());
+        disseminator.set_snapshot_server(snapshot_server.get());
+        snapshot_server->start();
+        spdlog::info("Snapshot server listening on 127.0.0.1:{}", snapshot_server->port());
+    }
 
-    spdlog::info("Benchmark duration met. Stopping generator...");
-    generator.stop();
+    // per-stage tracing, generator -> disseminator -> feed handler -> monitor, see utils/Trace.h
+    std::unique_ptr<TraceLog> trace_log;
+    if (config.trace_points != 0) {
+        trace_log = std::make_unique<TraceLog>(config.trace_points, config.queue_size,
+                                           static_cast<std::size_t>(peak_rate) * config.duration_sec);
+        disseminator.set_trace(trace_log.get());
+    }
+
+    disseminator.start();
+    if (config.transport == TransportProtocol::Zmq) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));  // for the handshake, zmq subscribers join late
+    }
+
+    if (config.generator == GeneratorKind::Replay) {
+        ReplayGenerator<MarketDataQueue> generator(queue);
+        generator.configure(config.replay_file, config.replay_speed);
+        drive_generator(config, generator, trace_log.get(), &generated, nullptr);
+    } else if (config.generator == GeneratorKind::OrderBook) {
+        OrderBookGenerator<MarketDataQueue> generator(queue);
+        generator.configure(config.message_rate, config.symbols_file);
+        drive_generator(config, generator, trace_log.get(), &generated, profile ? &*profile : nullptr);
+    } else {
+        RandomWalkGenerator<MarketDataQueue> generator(queue);
+        generator.configure(config.message_rate, config.symbols_file);
+        drive_generator(config, generator, trace_log.get(), &generated, profile ? &*profile : nullptr);
+    }
 
-    spdlog::info("Draining queues and network buffers (1 second)...");
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    const shm::Drain drain = shm::wait_drained(generated, sent, received);
+    if (drain.complete) {
+        spdlog::info("Drained after {} ms: {} messages sent, {} received.", drain.waited.count(), drain.sent, drain.received);
+    } else {
+        spdlog::warn("Not drained after {} ms: {} pushed, {} sent, {} received ({} in sequence gaps). Stopping anyway.",
+                     drain.waited.count(), drain.pushed, drain.sent, drain.received, drain.gaps);
+    }
 
     disseminator.stop();
     feedhandler.stop();
+    if (live) {
+        live->stop();
+    }
+    resolve_tx_timestamps(disseminator, monitor);
+    if (trace_log) {
+        monitor.resolve_post_send([&trace_log](uint64_t sequence) { return trace_log->post_send(sequence); });
+        const LatencyMonitor::TraceSummary s = monitor.trace_summary();
+        spdlog::info("Traced {} messages. From the intended send time (corrected): p50 {:.1f} us, p99 {:.1f} us, p99.9 {:.1f} us.",
+                     s.count, s.corrected_us[0], s.corrected_us[1], s.corrected_us[2]);
+        spdlog::info("From the enqueue timestamp (uncorrected): p50 {:.1f} us, p99 {:.1f} us, p99.9 {:.1f} us.",
+                     s.uncorrected_us[0], s.uncorrected_us[1], s.uncorrected_us[2]);
+    }
+    if (conflator) {
+        consumer.request_stop();
+        consumer.join();
+        report_conflation(*conflator);
+        monitor.set_quote_staleness(conflator->quote_staleness());
+    }
+    if (recorder) {
+        recorder->stop();
+    }
+    if (snapshot_server) {
+        snapshot_server->stop();
+        spdlog::info("Snapshot server served {} snapshots, last sequence {}.", snapshot_server->served(), snapshot_server->sequence());
+    }
+    if (config.generator == GeneratorKind::OrderBook) {
+        spdlog::info("Book builder applied {} order messages across {} books, {} referenced unknown orders, "
+                     "{} dropped for an order id past the limit or an unusable price.",
+                     book_builder.applied(), book_builder.book_count(), book_builder.unknown_orders(), book_builder.dropped());
+    }
 
     spdlog::info("Benchmark completed.");
+    return drain;
+}
+
+/*
+One PUB, possibly bound to several endpoints, and zmq_subscribers feed handlers spread round robin over them.
+The first one feeds the latency monitor, the others subscribe to the same universe and only count, they are
+there to load the publisher. inproc needs publisher and subscribers on one context, so then everything shares one.
+ */
+template <typename QueueType>
+shm::Drain run_zmq_pipeline(const BenchmarkConfig& config, QueueType& queue) {
+    const std::string endpoints = config.zmq_endpoints.empty() ? "tcp://127.0.0.1:" + std::to_string(config.port)
+                                                               : config.zmq_endpoints;
+    const std::vector<std::string> connect_to = ZmqDisseminator<QueueType>::split_endpoints(endpoints);
+
+    std::unique_ptr<zmq::context_t> shared_context;
+    if (endpoints.find("inproc://") != std::string::npos) {
+        shared_context = std::make_unique<zmq::context_t>(config.zmq_io_threads);
+    }
+    const ZmqPublishOptions publish{.single_frame = config.zmq_single_frame, .zero_copy = config.zmq_zero_copy,
+                                    .context = shared_context.get(), .io_threads = config.zmq_io_threads,
+                                    .sndhwm = config.zmq_sndhwm, .sndbuf = config.zmq_sndbuf};
+    const ZmqSubscribeOptions subscribe{.context = shared_context.get(), .io_threads = config.zmq_io_threads,
+                                        .rcvhwm = config.zmq_rcvhwm};
+
+    // inproc connects need the bind to exist first
+    ZmqDisseminator<QueueType> disseminator(queue, endpoints, publish);
+    ZmqFeedHandler feedhandler(connect_to[0], FunctionSink{}, subscribe);
+
+    std::vector<std::unique_ptr<ZmqFeedHandler>> extra;
+    std::vector<std::unique_ptr<std::atomic<uint64_t>>> extra_counts;
+    if (config.zmq_subscribers > 1) {
+        const std::vector<std::string> symbols = SymbolDirectory::read_file(config.symbols_file);
+        for (int i = 1; i < config.zmq_subscribers; ++i) {
+            auto& count = extra_counts.emplace_back(std::make_unique<std::atomic<uint64_t>>(0));
+            auto& fh = extra.emplace_back(std::make_unique<ZmqFeedHandler>(connect_to[i % connect_to.size()], FunctionSink{}, subscribe));
+            auto counter = [c = count.get()](const auto&, uint64_t) { c->fetch_add(1, std::memory_order_relaxed); };
+            fh->set_quote_callback(counter);
+            fh->set_trade_callback(counter);
+            fh->subscribe(symbols);
+            fh->start();
+        }
+        spdlog::info("{} additional ZMQ subscribers on {} endpoint(s).", extra.size(), connect_to.size());
+    }
+
+    const shm::Drain drain = run_benchmark_pipeline(config, queue, disseminator, feedhandler);
+
+    for (std::size_t i = 0; i < extra.size(); ++i) {
+        extra[i]->stop();
+        spdlog::info("ZMQ subscriber {} ({}) received {} messages.", i + 1, connect_to[(i + 1) % connect_to.size()], extra_counts[i]->load());
+    }
+    if (config.zmq_zero_copy) {
+        spdlog::info("ZMQ zero copy: {} sends fell back to a copy.", disseminator.zero_copy_fallbacks());
+    }
+    return drain;
+}
+
+// the shared memory ring lives in /dev/shm, the feed handler maps it read-only like an external process would
+template <typename QueueType>
+shm::Drain run_transport(const BenchmarkConfig& config, QueueType& queue) {
+    switch (config.transport) {
+        case TransportProtocol::UdpMulticast: {
+            const UdpIoOptions io{.mode = config.udp_io, .batch = config.udp_batch, .sqpoll = config.udp_sqpoll,
+                                  .gso = config.udp_gso, .gro = config.udp_gro, .timestamps = config.udp_timestamping};
+            UdpDisseminator<QueueType> disseminator(queue, config.ip_address, config.port, io);
+            UdpFeedHandler feedhandler(config.ip_address, config.port, {}, io);
+            const shm::Drain drain = run_benchmark_pipeline(config, queue, disseminator, feedhandler);
+
+            const UdpIoStats tx = disseminator.io_stats();
+            const UdpIoStats rx = feedhandler.io_stats();
+            spdlog::info("UDP {} I/O: sent {} in {} syscalls ({} errors), received {} in {} syscalls.",
+                         udp_io_mode_name(config.udp_io), tx.messages, tx.syscalls, tx.errors, rx.messages, rx.syscalls);
+            return drain;
+        }
+        case TransportProtocol::Zmq:
+            return run_zmq_pipeline(config, queue);
+        case TransportProtocol::SharedMemory: {
+            ShmDisseminator<QueueType> disseminator(queue, config.shm_name, config.shm_slots);
+            ShmFeedHandler feedhandler(config.shm_name);
+            const shm::Drain drain = run_benchmark_pipeline(config, queue, disseminator, feedhandler);
+            if (feedhandler.lost() > 0) {
+                spdlog::warn("Shared memory feed handler was lapped by the writer, {} messages lost.", feedhandler.lost());
+            }
+            return drain;
+        }
+    }
+    throw std::logic_error("Unknown transport");
 }
 
 template <std::size_t Size>
-void dispatch_types(const BenchmarkConfig& config) {
+shm::Drain dispatch_types(const BenchmarkConfig& config) {
     if (config.underlying_queue == UnderlyingQueue::Custom) {
         using BaseQueue = CustomSpscQueue<types::MarketDataMsg, Size>;
 
         if (config.queue_strategy == QueueWaitStrategy::Spin) {
             using QueueType = SpinSpscQueue<types::MarketDataMsg, BaseQueue>;
             QueueType queue;
-            if (config.transport == TransportProtocol::UdpMulticast) {
-                UdpDisseminator<QueueType> disseminator(queue, config.ip_address, config.port);
-                UdpFeedHandler feedhandler(config.ip_address, config.port);
-                run_benchmark_pipeline(config, queue, disseminator, feedhandler);
-            } else {
-                std::string zmq_bind = "tcp://127.0.0.1:" + std::to_string(config.port);
-                ZmqDisseminator<QueueType> disseminator(queue, zmq_bind);
-                ZmqFeedHandler feedhandler(zmq_bind);
-                run_benchmark_pipeline(config, queue, disseminator, feedhandler);
-            }
+            return run_transport(config, queue);
         } else {
             using QueueType = WaitableSpscQueue<types::MarketDataMsg, BaseQueue>;
             QueueType queue;
-            if (config.transport == TransportProtocol::UdpMulticast) {
-                UdpDisseminator<QueueType> disseminator(queue, config.ip_address, config.port);
-                UdpFeedHandler feedhandler(config.ip_address, config.port);
-                run_benchmark_pipeline(config, queue, disseminator, feedhandler);
-            } else {
-                std::string zmq_bind = "tcp://127.0.0.1:" + std::to_string(config.port);
-                ZmqDisseminator<QueueType> disseminator(queue, zmq_bind);
-                ZmqFeedHandler feedhandler(zmq_bind);
-                run_benchmark_pipeline(config, queue, disseminator, feedhandler);
-            }
+            return run_transport(config, queue);
         }
     } else {
         using BaseQueue = boost::lockfree::spsc_queue<types::MarketDataMsg, boost::lockfree::capacity<Size>>;
@@ -116,59 +457,242 @@ void dispatch_types(const BenchmarkConfig& config) {
         if (config.queue_strategy == QueueWaitStrategy::Spin) {
             using QueueType = SpinSpscQueue<types::MarketDataMsg, BaseQueue>;
             QueueType queue;
-            if (config.transport == TransportProtocol::UdpMulticast) {
-                UdpDisseminator<QueueType> disseminator(queue, config.ip_address, config.port);
-                UdpFeedHandler feedhandler(config.ip_address, config.port);
-                run_benchmark_pipeline(config, queue, disseminator, feedhandler);
-            } else {
-                std::string zmq_bind = "tcp://127.0.0.1:" + std::to_string(config.port);
-                ZmqDisseminator<QueueType> disseminator(queue, zmq_bind);
-                ZmqFeedHandler feedhandler(zmq_bind);
-                run_benchmark_pipeline(config, queue, disseminator, feedhandler);
-            }
+            return run_transport(config, queue);
         } else {
             using QueueType = WaitableSpscQueue<types::MarketDataMsg, BaseQueue>;
             QueueType queue;
-            if (config.transport == TransportProtocol::UdpMulticast) {
-                UdpDisseminator<QueueType> disseminator(queue, config.ip_address, config.port);
-                UdpFeedHandler feedhandler(config.ip_address, config.port);
-                run_benchmark_pipeline(config, queue, disseminator, feedhandler);
-            } else {
-                std::string zmq_bind = "tcp://127.0.0.1:" + std::to_string(config.port);
-                ZmqDisseminator<QueueType> disseminator(queue, zmq_bind);
-                ZmqFeedHandler feedhandler(zmq_bind);
-                run_benchmark_pipeline(config, queue, disseminator, feedhandler);
-            }
+            return run_transport(config, queue);
         }
     }
 }
 
-void dispatch_size(const BenchmarkConfig& config) {
+shm::Drain dispatch_size(const BenchmarkConfig& config) {
     switch (config.queue_size) {
-        case 128:     dispatch_types<128>(config); break;
-        case 512:     dispatch_types<512>(config); break;
-        case 1024:    dispatch_types<1024>(config); break;
-        case 4096:    dispatch_types<4096>(config); break;
-        case 16384:   dispatch_types<16384>(config); break;
-        case 65536:   dispatch_types<65536>(config); break;
+        case 128:     return dispatch_types<128>(config);
+        case 512:     return dispatch_types<512>(config);
+        case 1024:    return dispatch_types<1024>(config);
+        case 4096:    return dispatch_types<4096>(config);
+        case 16384:   return dispatch_types<16384>(config);
+        case 65536:   return dispatch_types<65536>(config);
         default:
             throw std::invalid_argument("Unsupported queue size. Allowed: 128, 512, 1024, 4096, 16384, 65536");
     }
 }
 
+/*
+--sweep: every combination of the grid one after another in this process, each run with its own queue,
+disseminator and feed handler and its own output directory under --out. One row per run goes to
+<out>/sweep_results.csv as soon as the run is done, so an interrupted sweep keeps what it has.
+ */
+void run_sweep(const BenchmarkConfig& base) {
+    const std::vector<sweep::Axis> axes = sweep::load(base.sweep);
+    const std::vector<sweep::Point> points = sweep::expand(axes);
+
+    std::filesystem::create_directories(base.out_dir);
+    const std::string results_path = base.out_dir + "/sweep_results.csv";
+    std::ofstream results(results_path);
+    if (!results) throw std::runtime_error("Could not open " + results_path);
+    results << "run,transport,queue,underlying,size,rate,duration,profile,generator,udp_io,conflate,latency_format,"
+               "pushed,sent,received,sequence_gaps,drained,drain_ms,messages,p50_us,p99_us,p999_us,max_us,mean_us,"
+               "jitter_us,rate_mean,loss_pct,error\n";
+    spdlog::info("Sweep: {} runs over {} parameters -> {}", points.size(), axes.size(), results_path);
+
+    std::size_t done = 0;
+    for (std::size_t i = 0; i < points.size() && !interrupted; ++i) {
+        BenchmarkConfig config = base;
+        for (const auto& [key, value] : points[i]) sweep::apply(config, key, value);
+        const std::string label = sweep::label(i, points[i]);
+        config.out_dir = base.out_dir + "/" + label;
+        std::filesystem::create_directories(config.out_dir);
+        spdlog::info("Sweep run {}/{}: {}", i + 1, points.size(), label);
+
+        shm::Drain drain{};
+        analysis::RunSummary summary;
+        std::string error;
+        try {
+            drain = dispatch_size(config);
+            analysis::RunData data = analysis::load_run(config.out_dir);
+            summary = analysis::summarize(data);
+        } catch (const std::exception& e) {
+            error = e.what();
+            std::ranges::replace(error, ',', ';');
+            spdlog::error("Sweep run {} failed: {}", label, error);
+        }
+
+        results << label << "," << transport_name(config.transport) << "," << queue_strategy_name(config.queue_strategy) << ","
+                << underlying_queue_name(config.underlying_queue) << "," << config.queue_size << "," << config.message_rate << ","
+                << config.duration_sec << "," << config.profile << "," << generator_kind_name(config.generator) << "," << udp_io_mode_name(config.udp_io) << ","
+                << config.conflate << "," << (config.binary_latencies ? "binary" : "csv") << "," << drain.pushed << ","
+                << drain.sent << "," << drain.received << "," << drain.gaps << "," << drain.complete << "," << drain.waited.count()
+                << "," << summary.messages << "," << summary.p50_ns / 1000.0 << "," << summary.p99_ns / 1000.0 << ","
+                << summary.p999_ns / 1000.0 << "," << summary.max_ns / 1000.0 << "," << summary.mean_ns / 1000.0 << ","
+                << summary.jitter_ns / 1000.0 << "," << summary.rate_mean << "," << summary.loss_pct << "," << error << "\n";
+        results.flush();
+        ++done;
+    }
+    if (done < points.size()) spdlog::warn("Sweep interrupted after {} of {} runs.", done, points.size());
+    spdlog::info("Sweep done, results in {}", results_path);
+}
+
+// one run at the config's rate, its numbers after the warm-up. Loss and delivery from the stage counters.
+search::Trial run_trial(const BenchmarkConfig& config, const analysis::Options& opts) {
+    std::filesystem::remove_all(config.out_dir);
+    const shm::Drain drain = dispatch_size(config);
+    analysis::RunData data = analysis::load_run(config.out_dir, opts);
+    const analysis::RunSummary s = analysis::summarize(data);
+    const double expected = static_cast<double>(config.message_rate) * config.duration_sec;
+    return {config.message_rate, s.p50_ns / 1000.0, s.p99_ns / 1000.0, s.p999_ns / 1000.0,
+            drain.sent > 0 ? 100.0 * static_cast<double>(drain.sent - std::min(drain.received, drain.sent)) / static_cast<double>(drain.sent) : 0.0,
+            expected > 0 ? static_cast<double>(drain.received) / expected : 0.0};
+}
+
+/*
+--search: the highest rate each combination of the --sweep grid (or just the command line) holds within the
+SLOs, see utils/ThroughputSearch.h. --rate is where the ramp starts, --duration the length of one trial. Trials
+stream binary latencies into <out>/trial, each overwriting the last. Every trial is a row in
+<out>/search_trials.csv (the latency and loss curves), every combination one in <out>/search_results.csv.
+ */
+void run_search(const BenchmarkConfig& base) {
+    std::vector<sweep::Point> points{{}};
+    if (!base.sweep.empty()) {
+        const std::vector<sweep::Axis> axes = sweep::load(base.sweep);
+        for (const sweep::Axis& axis : axes) {
+            if (axis.key == "rate" || axis.key == "duration" || axis.key == "profile") {
+                throw std::invalid_argument("--search sets " + axis.key + " itself, leave it out of the --sweep grid.");
+            }
+        }
+        points = sweep::expand(axes);
+    }
+    if (uint64_t{base.duration_sec} * 1000 <= base.warmup_ms) {
+        throw std::invalid_argument("--duration (the length of one trial) must be longer than --warmup.");
+    }
+    const search::Slo slo{base.slo_p99_us, base.slo_loss_pct};
+    analysis::Options after_warmup;
+    after_warmup.skip_ns = uint64_t{base.warmup_ms} * 1'000'000;
+
+    std::filesystem::create_directories(base.out_dir);
+    std::ofstream trials_csv(base.out_dir + "/search_trials.csv");
+    std::ofstream results_csv(base.out_dir + "/search_results.csv");
+    if (!trials_csv || !results_csv) throw std::runtime_error("Could not open the search CSVs in " + base.out_dir);
+    trials_csv << "combination,rate,trial,p50_us,p99_us,p999_us,loss_pct,delivered,verdict\n";
+    results_csv << "combination,transport,queue,underlying,size,max_rate,capped,first_failed_rate,p50_us,p99_us,"
+                   "p999_us,loss_pct,delivered,trials,slo_p99_us,slo_loss_pct,error\n";
+    spdlog::info("Search: {} combination(s), SLO p99 <= {} us and loss <= {}%, {} trials of {} s per rate ({} ms warm-up).",
+                 points.size(), slo.p99_us, slo.loss_pct, base.search_trials, base.duration_sec, base.warmup_ms);
+
+    for (std::size_t i = 0; i < points.size() && !interrupted; ++i) {
+        BenchmarkConfig config = base;
+        for (const auto& [key, value] : points[i]) sweep::apply(config, key, value);
+        config.binary_latencies = true;
+        config.out_dir = base.out_dir + "/trial";
+        const std::string label = sweep::label(i, points[i]);
+
+        search::RateSearch rates(base.message_rate, base.search_max_rate);
+        std::vector<search::Trial> at_best;
+        std::size_t trial_count = 0;
+        std::string error;
+        try {
+            while (const std::optional<uint32_t> rate = rates.next()) {
+                config.message_rate = *rate;
+                std::vector<search::Trial> trials;
+                search::Verdict verdict = search::Verdict::Unsure;
+                while (trials.size() < 2 * std::size_t{base.search_trials} && !interrupted) {
+                    trials.push_back(run_trial(config, after_warmup));
+                    ++trial_count;
+                    if (trials.size() >= base.search_trials) verdict = search::judge(trials, slo);
+                    const search::Trial& t = trials.back();
+                    trials_csv << label << "," << *rate << "," << trials.size() << "," << t.p50_us << "," << t.p99_us << ","
+                               << t.p999_us << "," << t.loss_pct << "," << t.delivered << "," << search::verdict_name(verdict) << "\n";
+                    trials_csv.flush();
+                    if (verdict != search::Verdict::Unsure) break;
+                }
+                if (interrupted) break;
+
+                const bool pass = verdict == search::Verdict::Pass ||
+                                  (verdict == search::Verdict::Unsure && search::passes_on_means(trials, slo));
+                const search::Interval p99 = search::interval(trials, &search::Trial::p99_us);
+                spdlog::info("Search {}: {} msg/s {}{}, p99 {:.1f} +- {:.1f} us, loss {:.4f}%, delivered {:.1f}% over {} trials.",
+                             label, *rate, pass ? "holds" : "fails", verdict == search::Verdict::Unsure ? " (on the means)" : "",
+                             p99.mean, p99.half_width, search::interval(trials, &search::Trial::loss_pct).mean,
+                             100.0 * search::interval(trials, &search::Trial::delivered).mean, trials.size());
+                if (pass && *rate > (at_best.empty() ? 0 : at_best.front().rate)) at_best = trials;
+                rates.report(*rate, pass);
+            }
+        } catch (const std::exception& e) {
+            error = e.what();
+            std::ranges::replace(error, ',', ';');
+            spdlog::error("Search {} failed: {}", label, error);
+        }
+
+        auto mean = [&at_best](double search::Trial::*field) {
+            return at_best.empty() ? 0.0 : search::interval(at_best, field).mean;
+        };
+        results_csv << label << "," << transport_name(config.transport) << "," << queue_strategy_name(config.queue_strategy) << ","
+                    << underlying_queue_name(config.underlying_queue) << "," << config.queue_size << "," << rates.best() << ","
+                    << rates.capped() << "," << rates.first_failed() << "," << mean(&search::Trial::p50_us) << ","
+                    << mean(&search::Trial::p99_us) << "," << mean(&search::Trial::p999_us) << "," << mean(&search::Trial::loss_pct)
+                    << "," << mean(&search::Trial::delivered) << "," << trial_count << "," << slo.p99_us << "," << slo.loss_pct
+                    << "," << error << "\n";
+        results_csv.flush();
+        if (rates.capped()) {
+            spdlog::info("Search {}: holds the SLOs up to --search-max-rate {} msg/s, the limit is above it.", label, rates.best());
+        } else {
+            spdlog::info("Search {}: max sustainable rate {} msg/s (fails at {}).", label, rates.best(), rates.first_failed());
+        }
+    }
+    std::filesystem::remove_all(base.out_dir + "/trial");
+    spdlog::info("Search done, results in {}/search_results.csv", base.out_dir);
+}
+
 int main(int argc, char** argv) {
     cxxopts::Options options("MarketBench", "Low latency market data disseminator benchmark");
 
     options.add_options()
         ("q,queue", "Queue type (spin/waitable)", cxxopts::value<std::string>()->default_value("spin"))
         ("s,size", "Queue size (128, 512, 1024, 4096, 16384, 65536)", cxxopts::value<std::size_t>()->default_value("1024"))
-        ("t,transport", "Transport (udp/zmq)", cxxopts::value<std::string>()->default_value("udp"))
+        ("t,transport", "Transport (udp/zmq/shm)", cxxopts::value<std::string>()->default_value("udp"))
         ("r,rate", "Message rate (msgs/sec)", cxxopts::value<uint32_t>()->default_value("10000"))
         ("d,duration", "Benchmark duration in seconds", cxxopts::value<uint32_t>()->default_value("10"))
+        ("profile", "Target rate over time: ramp, step, spike or sine scaled to --rate and --duration, a file, or segments like \"hold 100000 5; ramp 100000 800000 10\"", cxxopts::value<std::string>()->default_value(""))
         ("h,help", "Print usage")
         ("f,symbols", "Path to symbols.txt", cxxopts::value<std::string>()->default_value("../data/symbols.txt"))
         ("o,out", "Output directory for CSVs", cxxopts::value<std::string>()->default_value("../data"))
-        ("u,underlying", "Underlying queue (custom/boost)", cxxopts::value<std::string>()->default_value("custom"));
+        ("u,underlying", "Underlying queue (custom/boost)", cxxopts::value<std::string>()->default_value("custom"))
+        ("record", "Record the disseminated stream to this capture file", cxxopts::value<std::string>()->default_value(""))
+        ("g,generator", "Message source (randomwalk/replay/orderbook)", cxxopts::value<std::string>()->default_value("randomwalk"))
+        ("replay", "Capture file to replay, implies --generator replay", cxxopts::value<std::string>()->default_value(""))
+        ("replay-speed", "Replay speed multiple, 0 = as fast as possible", cxxopts::value<double>()->default_value("1.0"))
+        ("snapshot-port", "Serve last-value snapshots on this local TCP port, 0 = off", cxxopts::value<unsigned short>()->default_value("0"))
+        ("conflate", "Put a per-symbol quote conflation stage between feed handler and consumer")
+        ("consumer-rate", "Messages/sec the consumer behind the conflation stage takes, 0 = unthrottled", cxxopts::value<uint32_t>()->default_value("0"))
+        ("zmq-single-frame", "ZMQ: send topic and payload as one frame instead of two")
+        ("zmq-zero-copy", "ZMQ: hand pooled buffers to zmq instead of letting it allocate and copy")
+        ("zmq-endpoint", "ZMQ: comma separated PUB endpoints (tcp://, ipc://, inproc://), default tcp on --port", cxxopts::value<std::string>()->default_value(""))
+        ("zmq-io-threads", "ZMQ: I/O threads per context", cxxopts::value<int>()->default_value("1"))
+        ("zmq-subscribers", "ZMQ: feed handlers subscribed to the one PUB", cxxopts::value<int>()->default_value("1"))
+        ("zmq-sndhwm", "ZMQ: PUB send high water mark, 0 = unlimited", cxxopts::value<int>()->default_value("1000"))
+        ("zmq-rcvhwm", "ZMQ: SUB receive high water mark, 0 = unlimited", cxxopts::value<int>()->default_value("1000"))
+        ("zmq-sndbuf", "ZMQ: PUB kernel send buffer in bytes, 0 = OS default", cxxopts::value<int>()->default_value("0"))
+        ("udp-io", "UDP: kernel I/O path (syscall/batched/uring)", cxxopts::value<std::string>()->default_value("syscall"))
+        ("udp-batch", "UDP: datagrams per sendmmsg/recvmmsg or io_uring submission", cxxopts::value<unsigned>()->default_value("64"))
+        ("udp-sqpoll", "UDP: io_uring with a kernel thread polling the submission queue")
+        ("udp-gso", "UDP: send runs of datagrams as one UDP_SEGMENT (GSO) buffer, syscall/batched only")
+        ("udp-gro", "UDP: receive coalesced runs with UDP_GRO and split them, syscall/batched only")
+        ("live", "Log p50/p99/p99.9, message rate and drops every second while running, also to live_latency.csv")
+        ("live-interval", "Live: how often (ms) the aggregator collects the recording threads", cxxopts::value<uint32_t>()->default_value("100"))
+        ("latency-format", "Latency records as csv at the end of the run, or binary columns streamed to latencies.mdlat while it runs", cxxopts::value<std::string>()->default_value("csv"))
+        ("sweep", "Run every combination of a parameter grid, e.g. \"transport=udp,shm;size=1024,65536;rate=100000,500000\", or a file with one key=values per line", cxxopts::value<std::string>()->default_value(""))
+        ("search", "Find the highest rate that holds the SLOs, ramping up from --rate with trials of --duration seconds, for every combination of --sweep")
+        ("slo-p99", "Search: p99 latency limit in us", cxxopts::value<double>()->default_value("100"))
+        ("slo-loss", "Search: loss limit in percent", cxxopts::value<double>()->default_value("0.01"))
+        ("search-max-rate", "Search: highest rate to try", cxxopts::value<uint32_t>()->default_value("5000000"))
+        ("trials", "Search: trials per rate before judging it, up to twice as many while the result is unclear", cxxopts::value<uint32_t>()->default_value("3"))
+        ("warmup", "Search: ms at the start of each trial left out of its numbers", cxxopts::value<uint32_t>()->default_value("500"))
+        ("stats-shm", "Publish live counters and latency to this shared memory segment for md_top, e.g. /mdds_stats", cxxopts::value<std::string>()->default_value(""))
+        ("trace", "Per-stage tracing: all, off or a comma list of intended,generated,enqueued,dequeued,pre_send,post_send,received,delivered", cxxopts::value<std::string>()->default_value("off"))
+        ("udp-timestamping", "UDP: kernel packet timestamps (off/software/hardware), syscall/batched only", cxxopts::value<std::string>()->default_value("off"))
+        ("shm-name", "Shared memory: segment name (shm_open)", cxxopts::value<std::string>()->default_value("/mdds_feed"))
+        ("shm-slots", "Shared memory: ring size in messages, power of two", cxxopts::value<uint64_t>()->default_value("65536"));
 
     auto result = options.parse(argc, argv);
 
@@ -176,34 +700,75 @@ int main(int argc, char** argv) {
         std::cout << options.help() << std::endl;
         return 0;
     }
+    std::signal(SIGINT, on_interrupt);
 
     BenchmarkConfig config;
     config.queue_size = result["size"].as<std::size_t>();
     config.message_rate = result["rate"].as<uint32_t>();
     config.duration_sec = result["duration"].as<uint32_t>();
+    config.profile = result["profile"].as<std::string>();
     config.symbols_file = result["symbols"].as<std::string>();
     config.out_dir = result["out"].as<std::string>();
+    config.record_file = result["record"].as<std::string>();
+    config.replay_file = result["replay"].as<std::string>();
+    config.replay_speed = result["replay-speed"].as<double>();
+    config.snapshot_port = result["snapshot-port"].as<unsigned short>();
+    config.conflate = result.count("conflate") > 0;
+    config.consumer_rate = result["consumer-rate"].as<uint32_t>();
+    config.zmq_single_frame = result.count("zmq-single-frame") > 0;
+    config.zmq_zero_copy = result.count("zmq-zero-copy") > 0;
+    config.zmq_endpoints = result["zmq-endpoint"].as<std::string>();
+    config.zmq_io_threads = result["zmq-io-threads"].as<int>();
+    config.zmq_subscribers = result["zmq-subscribers"].as<int>();
+    config.zmq_sndhwm = result["zmq-sndhwm"].as<int>();
+    config.zmq_rcvhwm = result["zmq-rcvhwm"].as<int>();
+    config.zmq_sndbuf = result["zmq-sndbuf"].as<int>();
+    config.udp_io = parse_udp_io_mode(result["udp-io"].as<std::string>());
+    config.udp_batch = result["udp-batch"].as<unsigned>();
+    config.udp_sqpoll = result.count("udp-sqpoll") > 0;
+    config.udp_gso = result.count("udp-gso") > 0;
+    config.udp_gro = result.count("udp-gro") > 0;
+    config.live = result.count("live") > 0;
+    config.live_interval_ms = result["live-interval"].as<uint32_t>();
+    config.stats_shm = result["stats-shm"].as<std::string>();
+    config.sweep = result["sweep"].as<std::string>();
+    config.search = result.count("search") > 0;
+    config.slo_p99_us = result["slo-p99"].as<double>();
+    config.slo_loss_pct = result["slo-loss"].as<double>();
+    config.search_max_rate = result["search-max-rate"].as<uint32_t>();
+    config.search_trials = result["trials"].as<uint32_t>();
+    config.warmup_ms = result["warmup"].as<uint32_t>();
+    if (config.search_trials < 1) throw std::invalid_argument("--trials must be at least 1.");
+    if (const std::string format = result["latency-format"].as<std::string>(); format == "binary") config.binary_latencies = true;
+    else if (format != "csv") throw std::invalid_argument("Invalid latency format. Use 'csv' or 'binary'.");
+    config.trace_points = trace::parse_points(result["trace"].as<std::string>());
+    config.udp_timestamping = parse_kernel_timestamps(result["udp-timestamping"].as<std::string>());
+    config.shm_name = result["shm-name"].as<std::string>();
+    config.shm_slots = result["shm-slots"].as<uint64_t>();
+    if (config.zmq_io_threads < 1 || config.zmq_subscribers < 1) {
+        throw std::invalid_argument("--zmq-io-threads and --zmq-subscribers must be at least 1.");
+    }
 
-    std::string q_type = result["queue"].as<std::string>();
-    if (q_type == "spin") config.queue_strategy = QueueWaitStrategy::Spin;
-    else if (q_type == "waitable") config.queue_strategy = QueueWaitStrategy::Waitable;
-    else throw std::invalid_argument("Invalid queue type. Use 'spin' or 'waitable'.");
-
-
-    std::string u_type = result["underlying"].as<std::string>();
-    if (u_type == "custom") config.underlying_queue = UnderlyingQueue::Custom;
-    else if (u_type == "boost") config.underlying_queue = UnderlyingQueue::Boost;
-    else throw std::invalid_argument("Invalid underlying queue. Use 'custom' or 'boost'.");
+    config.generator = parse_generator_kind(result["generator"].as<std::string>());
+    if (!config.replay_file.empty()) config.generator = GeneratorKind::Replay;
+    if (config.generator == GeneratorKind::Replay && config.replay_file.empty()) {
+        throw std::invalid_argument("--generator replay needs a capture file via --replay.");
+    }
 
-    std::string t_type = result["transport"].as<std::string>();
-    if (t_type == "udp") {
-        config.transport = TransportProtocol::UdpMulticast;
+    if (!config.profile.empty()) {
+        if (config.generator == GeneratorKind::Replay) throw std::invalid_argument("--profile does not apply to a replay, it keeps the capture's pace.");
+        if (config.search) throw std::invalid_argument("--search sets the rate itself, it cannot follow a --profile.");
+        LoadProfile::load(config.profile, config.message_rate, config.duration_sec); // a typo fails before the run
     }
-    else if (t_type == "zmq") config.transport = TransportProtocol::Zmq;
-    else throw std::invalid_argument("Invalid transport type. Use 'udp' or 'zmq'.");
+
+    config.queue_strategy = parse_queue_strategy(result["queue"].as<std::string>());
+    config.underlying_queue = parse_underlying_queue(result["underlying"].as<std::string>());
+    config.transport = parse_transport(result["transport"].as<std::string>());
 
     try {
-        dispatch_size(config);
+        if (config.search) run_search(config);
+        else if (!config.sweep.empty()) run_sweep(config);
+        else dispatch_size(config);
     } catch (const std::exception& e) {
         spdlog::error("Benchmark failed: {}", e.what());
         return 1;
@@ -0,0 +1,282 @@
+#ifndef LATENCY_COLUMNS_H
+#define LATENCY_COLUMNS_H
+
+#include "../utils/CustomSpscQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+Binary columnar latency file (.mdlat, --latency-format binary), streamed while the run goes instead of
+formatted as CSV at the end:
+
+    [FileHeader, one 4 KiB page]     schema: name, numpy dtype, width and offset of every column in a block
+    [Block] * block_count            block_records records, column by column, each column a plain array
+
+Block and header sizes are multiples of 4 KiB, every write is one whole aligned block. The last block is
+written padded, record_count says how many records are real. While the run is going the header is rewritten
+after every block, so a file of a run that died is readable up to its last full block.
+python/latency_columns.py maps it with numpy.memmap.
+ */
+namespace latency_columns {
+    inline constexpr std::array<char, 8> file_magic{'M', 'D', 'L', 'A', 'T', 'C', 'O', 'L'};
+    inline constexpr uint32_t format_version = 1;   // of the header, readers find the columns by name
+    inline constexpr std::size_t header_page_size = 4096;
+    inline constexpr std::size_t max_columns = 16;
+
+    // FileHeader::flags
+    inline constexpr uint64_t conflated_sequences = 1;  // records went through the conflator, sequence holes are not loss
+
+    struct Column {
+        char name[16];
+        char dtype[8];       // numpy type string, "<u8", "<u4", "|S1"
+        uint32_t width;
+        uint32_t offset;     // of the column's array within a block
+    };
+
+    struct FileHeader {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t header_size;      // data starts here, header_page_size
+        uint32_t block_records;
+        uint32_t column_count;
+        uint64_t block_bytes;
+        uint64_t record_count;
+        uint64_t block_count;
+        uint64_t dropped;          // records the writer had no room for
+        Column columns[max_columns];
+        uint64_t flags;            // behind the columns so version 1 readers are unaffected, 0 in older files
+    };
+    static_assert(sizeof(FileHeader) <= header_page_size);
+
+    // what one record holds, in the order of the schema
+    enum ColumnId : std::size_t { Sequence, ReceiveNs, QueueNs, NetworkNs, TotalNs, ApplyNs, SymbolId, Type, column_count };
+
+    inline constexpr Column schema[column_count] = {
+        {"sequence", "<u8", 8, 0},
+        {"recv_ns", "<u8", 8, 0},    // receive timestamp, steady clock
+        {"queue_ns", "<u8", 8, 0},
+        {"network_ns", "<u8", 8, 0},
+        {"total_ns", "<u8", 8, 0},
+        {"apply_ns", "<u8", 8, 0},   // order messages, 0 for the others
+        {"symbol_id", "<u4", 4, 0},
+        {"type", "|S1", 1, 0},       // the message tag, 'Q', 'T', 'A' ...
+    };
+
+    // the schema has the widest columns first, so with block_records a multiple of 4096 every array starts
+    // page aligned
+    inline uint64_t layout(uint32_t block_records, Column (&columns)[column_count]) {
+        uint64_t offset = 0;
+        for (std::size_t i = 0; i < column_count; ++i) {
+            columns[i] = schema[i];
+            columns[i].offset = static_cast<uint32_t>(offset);
+            offset += static_cast<uint64_t>(block_records) * schema[i].width;
+        }
+        return offset;
+    }
+}
+
+/*
+The consumer thread fills a block in memory (append()), a full block goes over a hand-off queue to a writer
+thread that pwrite()s it and gives it back. If the writer falls behind and no free block is left, records are
+dropped and counted, the consumer never waits on disk.
+ */
+class LatencyColumnWriter {
+public:
+    static constexpr uint32_t default_block_records = 8192;
+    static constexpr std::size_t block_pool = 8;
+
+    explicit LatencyColumnWriter(const std::filesystem::path& path, uint32_t block_records = default_block_records,
+                                 uint64_t flags = 0)
+        : path_(path), block_records_(block_records), flags_(flags) {
+        if (block_records_ == 0 || block_records_ % latency_columns::header_page_size != 0) {
+            throw std::invalid_argument("Latency column blocks must hold a multiple of 4096 records.");
+        }
+        block_bytes_ = latency_columns::layout(block_records_, columns_);
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) throw std::runtime_error("Failed to open latency file: " + path_.string());
+
+        for (std::size_t i = 0; i < block_pool; ++i) {
+            auto* data = static_cast<std::byte*>(std::aligned_alloc(latency_columns::header_page_size, block_bytes_));
+            if (data == nullptr) throw std::bad_alloc();
+            blocks_.emplace_back(data);
+        }
+        current_ = blocks_[0].get();
+        for (std::size_t i = 1; i < block_pool; ++i) free_.push(blocks_[i].get());
+        bind(current_);
+
+        write_header();
+        writer_ = std::jthread([this](std::stop_token st) { writer_loop(std::move(st)); });
+    }
+
+    ~LatencyColumnWriter() { close(); }
+
+    LatencyColumnWriter(const LatencyColumnWriter&) = delete;
+    LatencyColumnWriter& operator=(const LatencyColumnWriter&) = delete;
+
+    // hot path, one thread only
+    inline void append(char type, uint32_t symbol_id, uint64_t sequence, uint64_t receive_ns, uint64_t queue_ns,
+                       uint64_t network_ns, uint64_t total_ns, uint64_t apply_ns = 0) {
+        if (current_ == nullptr && !free_.pop(current_)) [[unlikely]] {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        if (fill_ == 0) bind(current_);
+        sequence_[fill_] = sequence;
+        receive_ns_[fill_] = receive_ns;
+        queue_ns_[fill_] = queue_ns;
+        network_ns_[fill_] = network_ns;
+        total_ns_[fill_] = total_ns;
+        apply_ns_[fill_] = apply_ns;
+        symbol_id_[fill_] = symbol_id;
+        type_[fill_] = type;
+        if (++fill_ == block_records_) {
+            full_.push(current_); // never full, there are no more blocks than it holds
+            current_ = nullptr;
+            fill_ = 0;
+            free_.pop(current_);
+        }
+    }
+
+    // after the last append: writes the partial block, the final header and closes the file. Idempotent.
+    void close() {
+        if (fd_ < 0) return;
+        const uint32_t last_fill = fill_;
+        if (last_fill > 0) {
+            for (const latency_columns::Column& c : columns_) {
+                std::memset(current_ + c.offset + std::size_t{last_fill} * c.width, 0, std::size_t{block_records_ - last_fill} * c.width);
+            }
+            full_.push(current_);
+            current_ = nullptr;
+        }
+        writer_.request_stop();
+        writer_.join();
+        record_count_ = (block_count_ - (last_fill > 0 ? 1 : 0)) * block_records_ + last_fill;
+        write_header();
+        if (::close(fd_) != 0) spdlog::warn("Closing latency file {} failed", path_.string());
+        fd_ = -1;
+        if (dropped() > 0) spdlog::warn("Latency file writer fell behind, {} records dropped.", dropped());
+        spdlog::info("Latencies: {} records in {} blocks -> {}", record_count_, block_count_, path_.string());
+    }
+
+    [[nodiscard]] uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t block_bytes() const { return block_bytes_; }
+    // after close()
+    [[nodiscard]] uint64_t record_count() const { return record_count_; }
+
+private:
+    struct FreeDeleter {
+        void operator()(std::byte* p) const { std::free(p); }
+    };
+
+    void bind(std::byte* block) {
+        auto at = [&](latency_columns::ColumnId id) { return block + columns_[id].offset; };
+        sequence_ = reinterpret_cast<uint64_t*>(at(latency_columns::Sequence));
+        receive_ns_ = reinterpret_cast<uint64_t*>(at(latency_columns::ReceiveNs));
+        queue_ns_ = reinterpret_cast<uint64_t*>(at(latency_columns::QueueNs));
+        network_ns_ = reinterpret_cast<uint64_t*>(at(latency_columns::NetworkNs));
+        total_ns_ = reinterpret_cast<uint64_t*>(at(latency_columns::TotalNs));
+        apply_ns_ = reinterpret_cast<uint64_t*>(at(latency_columns::ApplyNs));
+        symbol_id_ = reinterpret_cast<uint32_t*>(at(latency_columns::SymbolId));
+        type_ = reinterpret_cast<char*>(at(latency_columns::Type));
+    }
+
+    // writer thread, then close()
+    void write_header() {
+        alignas(64) std::byte page[latency_columns::header_page_size]{};
+        auto* hdr = reinterpret_cast<latency_columns::FileHeader*>(page);
+        hdr->magic = latency_columns::file_magic;
+        hdr->version = latency_columns::format_version;
+        hdr->header_size = latency_columns::header_page_size;
+        hdr->block_records = block_records_;
+        hdr->column_count = latency_columns::column_count;
+        hdr->block_bytes = block_bytes_;
+        hdr->record_count = record_count_;
+        hdr->block_count = block_count_;
+        hdr->dropped = dropped();
+        std::copy(std::begin(columns_), std::end(columns_), hdr->columns);
+        hdr->flags = flags_;
+        write_at(page, sizeof(page), 0);
+    }
+
+    void write_at(const std::byte* data, std::size_t size, uint64_t offset) {
+        while (size > 0) {
+            const ssize_t n = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+            if (n <= 0) {
+                spdlog::error("Writing latency file {} failed", path_.string());
+                return;
+            }
+            data += n;
+            size -= static_cast<std::size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+    }
+
+    void writer_loop(std::stop_token st) {
+        std::byte* block = nullptr;
+        while (true) {
+            bool wrote = false;
+            while (full_.pop(block)) {
+                write_at(block, block_bytes_, latency_columns::header_page_size + block_count_ * block_bytes_);
+                ++block_count_;
+                free_.push(block);
+                wrote = true;
+            }
+            if (wrote) {
+                record_count_ = block_count_ * block_records_; // full blocks only, close() writes the real count
+                write_header();
+            } else if (st.stop_requested()) {
+                break;
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    std::filesystem::path path_;
+    int fd_{-1};
+    uint32_t block_records_;
+    uint64_t flags_;
+    uint64_t block_bytes_{0};
+    latency_columns::Column columns_[latency_columns::column_count]{};
+    std::vector<std::unique_ptr<std::byte, FreeDeleter>> blocks_;
+
+    // appending thread
+    std::byte* current_{nullptr};
+    uint32_t fill_{0};
+    std::atomic<uint64_t> dropped_{0}; // read by the writer thread for the header
+    uint64_t* sequence_{nullptr};
+    uint64_t* receive_ns_{nullptr};
+    uint64_t* queue_ns_{nullptr};
+    uint64_t* network_ns_{nullptr};
+    uint64_t* total_ns_{nullptr};
+    uint64_t* apply_ns_{nullptr};
+    uint32_t* symbol_id_{nullptr};
+    char* type_{nullptr};
+
+    // writer thread, then close()
+    uint64_t block_count_{0};
+    uint64_t record_count_{0};
+
+    CustomSpscQueue<std::byte*, block_pool> full_;
+    CustomSpscQueue<std::byte*, block_pool> free_;
+    std::jthread writer_;
+};
+
+#endif // LATENCY_COLUMNS_H
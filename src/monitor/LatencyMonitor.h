@@ -2,18 +2,34 @@
 #define LATENCY_MONITOR_H
 
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <fstream>
 #include <filesystem>
+#include <memory>
 #include <spdlog/spdlog.h>
+#include "LatencyColumns.h"
 #include "../utils/types.h"
+#include "../utils/Trace.h"
 
 
 struct LatencyRecord {
     uint64_t queue_ns;
     uint64_t network_ns;
     uint64_t total_ns;
+    // network_ns split up by kernel timestamps (UDP with timestamps on), 0 where a stamp is missing.
+    // Signed: the stamps come from different places in the kernel, and a multicast loop copy can be
+    // received before the original has been stamped on its way out.
+    int64_t tx_stack_ns{0}; // disseminate -> kernel TX stamp
+    int64_t wire_ns{0};     // kernel TX stamp -> kernel RX stamp
+    int64_t rx_stack_ns{0}; // kernel RX stamp -> receive callback
+};
+
+// order-by-order messages additionally carry the time the book builder took to apply them
+struct OrderLatencyRecord {
+    LatencyRecord latency;
+    uint64_t apply_ns;
 };
 
 class LatencyMonitor {
@@ -30,42 +46,260 @@ public:
 
     ~LatencyMonitor() { save_to_csv(); }
 
-    inline void on_quote(const types::Quote& quote, uint64_t receive_timestamp) {
-        quote_latencies_.push_back({
-            quote.disseminate_timestamp - quote.enqueue_timestamp,
-            receive_timestamp - quote.disseminate_timestamp,
-            receive_timestamp - quote.enqueue_timestamp
-        });
+    /*
+    Streams the quote, trade and order records to a binary columnar file (see LatencyColumns.h) as they come
+    instead of keeping them for CSVs at the end. Their kernel stage split, which needs the TX stamps resolved
+    at the end, is not recorded then. Call before the first record.
+     */
+    void stream_binary(const std::filesystem::path& path, uint32_t block_records = LatencyColumnWriter::default_block_records,
+                       uint64_t flags = 0) {
+        columns_ = std::make_unique<LatencyColumnWriter>(path, block_records, flags);
+        std::vector<LatencyRecord>().swap(quote_latencies_);
+        std::vector<LatencyRecord>().swap(trade_latencies_);
     }
 
-    inline void on_trade(const types::Trade& trade, uint64_t receive_timestamp) {
-        trade_latencies_.push_back({
-            trade.disseminate_timestamp - trade.enqueue_timestamp,
-            receive_timestamp - trade.disseminate_timestamp,
-            receive_timestamp - trade.enqueue_timestamp
-        });
+    // kernel_receive_timestamp: the kernel's RX stamp of the datagram, steady_clock, 0 if there is none
+    inline void on_quote(const types::Quote& quote, uint64_t receive_timestamp, uint64_t kernel_receive_timestamp = 0) {
+        if (columns_) {
+            stream(quote, receive_timestamp);
+            return;
+        }
+        quote_latencies_.push_back(make_record(quote, receive_timestamp, kernel_receive_timestamp));
+        if (kernel_receive_timestamp != 0) {
+            quote_pending_.push_back({quote_latencies_.size() - 1, quote.sequence, quote.disseminate_timestamp, kernel_receive_timestamp});
+        }
     }
 
+    inline void on_trade(const types::Trade& trade, uint64_t receive_timestamp, uint64_t kernel_receive_timestamp = 0) {
+        if (columns_) {
+            stream(trade, receive_timestamp);
+            return;
+        }
+        trade_latencies_.push_back(make_record(trade, receive_timestamp, kernel_receive_timestamp));
+        if (kernel_receive_timestamp != 0) {
+            trade_pending_.push_back({trade_latencies_.size() - 1, trade.sequence, trade.disseminate_timestamp, kernel_receive_timestamp});
+        }
+    }
+
+    template <typename OrderMsg>
+    inline void on_order(const OrderMsg& msg, uint64_t receive_timestamp, uint64_t applied_timestamp,
+                         uint64_t kernel_receive_timestamp = 0) {
+        if (columns_) {
+            stream(msg, receive_timestamp, applied_timestamp - receive_timestamp);
+            return;
+        }
+        order_latencies_.push_back({make_record(msg, receive_timestamp, kernel_receive_timestamp),
+                                    applied_timestamp - receive_timestamp});
+        if (kernel_receive_timestamp != 0) {
+            order_pending_.push_back({order_latencies_.size() - 1, msg.sequence, msg.disseminate_timestamp, kernel_receive_timestamp});
+        }
+    }
+
+    /*
+    TX stamps come back on the sender's error queue some time after the send, so the tx stack and wire stages
+    are filled in at the end: tx_ns(sequence) gives the steady_clock ns the message went out, 0 if unknown.
+    Only messages that were recorded with a kernel RX stamp take part. Returns how many records got both.
+     */
+    template <typename TxStamps>
+    std::size_t resolve_tx_timestamps(const TxStamps& tx_ns) {
+        std::size_t resolved = 0;
+        auto resolve = [&](const std::vector<PendingStages>& pending, auto& records, auto&& record_of) {
+            for (const PendingStages& p : pending) {
+                const uint64_t tx = tx_ns(p.sequence);
+                if (tx == 0) continue;
+                LatencyRecord& rec = record_of(records[p.index]);
+                rec.tx_stack_ns = static_cast<int64_t>(tx - p.disseminate_ns);
+                rec.wire_ns = static_cast<int64_t>(p.kernel_receive_ns - tx);
+                ++resolved;
+            }
+        };
+        auto self = [](LatencyRecord& rec) -> LatencyRecord& { return rec; };
+        resolve(quote_pending_, quote_latencies_, self);
+        resolve(trade_pending_, trade_latencies_, self);
+        resolve(order_pending_, order_latencies_, [](OrderLatencyRecord& rec) -> LatencyRecord& { return rec.latency; });
+        return resolved;
+    }
+
+    // a traced message as the consumer gets it, stamps delivered. See utils/Trace.h
+    template <typename Msg>
+    inline void on_trace(const Msg& msg, const types::TraceTrailer& trailer, uint64_t delivered_timestamp) {
+        TraceRecord rec{msg.sequence, msg.enqueue_timestamp, trailer};
+        trace::stamp(rec.trailer, types::TracePoint::Delivered, delivered_timestamp);
+        traces_.push_back(rec);
+    }
+
+    // post-send stamps stay with the sender, post_send_ns(sequence) gives them (0 if unknown) once it stopped
+    template <typename PostSend>
+    void resolve_post_send(const PostSend& post_send_ns) {
+        for (TraceRecord& rec : traces_) {
+            trace::stamp(rec.trailer, types::TracePoint::PostSend, post_send_ns(rec.sequence));
+        }
+    }
+
+    /*
+    End to end latency of the traced messages, to the delivered stamp (received if delivered is not traced):
+    corrected from the intended send time, uncorrected from the enqueue timestamp the message carries.
+    The gap between the two is what coordinated omission hides.
+     */
+    struct TraceSummary {
+        std::size_t count{0};
+        double corrected_us[3]{};   // p50, p99, p99.9
+        double uncorrected_us[3]{};
+    };
+
+    [[nodiscard]] TraceSummary trace_summary() const {
+        std::vector<int64_t> corrected;
+        std::vector<int64_t> uncorrected;
+        for (const TraceRecord& rec : traces_) {
+            const uint64_t end = trace_end(rec);
+            if (end == 0) continue;
+            uncorrected.push_back(static_cast<int64_t>(end - rec.enqueue_ns));
+            if (const uint64_t intended = trace::at(rec.trailer, types::TracePoint::Intended); intended != 0) {
+                corrected.push_back(static_cast<int64_t>(end - intended));
+            }
+        }
+        TraceSummary s;
+        s.count = uncorrected.size();
+        const double ps[3] = {0.5, 0.99, 0.999};
+        auto fill = [&ps](std::vector<int64_t>& v, double* out) {
+            if (v.empty()) return;
+            std::ranges::sort(v);
+            for (int i = 0; i < 3; ++i) out[i] = static_cast<double>(v[static_cast<std::size_t>(ps[i] * static_cast<double>(v.size() - 1))]) / 1000.0;
+        };
+        fill(corrected, s.corrected_us);
+        fill(uncorrected, s.uncorrected_us);
+        return s;
+    }
+
+    // with a conflation stage in front of the consumer: how out of date each delivered quote was, see Conflator
+    void set_quote_staleness(std::vector<uint64_t> staleness_ns) { quote_staleness_ = std::move(staleness_ns); }
+
+    [[nodiscard]] const std::vector<LatencyRecord>& quote_latencies() const { return quote_latencies_; }
+    [[nodiscard]] const std::vector<LatencyRecord>& trade_latencies() const { return trade_latencies_; }
+
     void save_to_csv() const {
         spdlog::info("Saving latency data to disk...");
 
+        if (columns_) {
+            columns_->close();
+        } else {
+            save_latencies();
+        }
+
+        if (!traces_.empty()) {
+            save_traces(out_dir_ + "/trace_latencies.csv");
+        }
+
+        if (!quote_staleness_.empty()) {
+            std::ofstream s_file(out_dir_ + "/quote_staleness.csv");
+            s_file << "staleness_ns\n";
+            for (const uint64_t ns : quote_staleness_) {
+                s_file << ns << "\n";
+            }
+        }
+    }
+
+private:
+    static constexpr const char* columns = "queue_ns,network_ns,total_ns,tx_stack_ns,wire_ns,rx_stack_ns";
+
+    void save_latencies() const {
         std::ofstream q_file(out_dir_ + "/quote_latencies.csv");
-        q_file << "queue_ns,network_ns,total_ns\n";
+        q_file << columns << "\n";
         for (const auto& lat : quote_latencies_) {
-            q_file << lat.queue_ns << "," << lat.network_ns << "," << lat.total_ns << "\n";
+            write_record(q_file, lat) << "\n";
         }
 
         std::ofstream t_file(out_dir_ + "/trade_latencies.csv");
-        t_file << "queue_ns,network_ns,total_ns\n";
+        t_file << columns << "\n";
         for (const auto& lat : trade_latencies_) {
-            t_file << lat.queue_ns << "," << lat.network_ns << "," << lat.total_ns << "\n";
+            write_record(t_file, lat) << "\n";
+        }
+
+        if (!order_latencies_.empty()) {
+            std::ofstream o_file(out_dir_ + "/order_latencies.csv");
+            o_file << columns << ",apply_ns\n";
+            for (const auto& rec : order_latencies_) {
+                write_record(o_file, rec.latency) << "," << rec.apply_ns << "\n";
+            }
         }
     }
 
-private:
+    template <typename Msg>
+    inline void stream(const Msg& msg, uint64_t receive_timestamp, uint64_t apply_ns = 0) {
+        columns_->append(types::MessageTraits<Msg>::tag, msg.symbol_id, msg.sequence, receive_timestamp,
+                         msg.disseminate_timestamp - msg.enqueue_timestamp, receive_timestamp - msg.disseminate_timestamp,
+                         receive_timestamp - msg.enqueue_timestamp, apply_ns);
+    }
+
+    // a record still waiting for the TX stamp of its message
+    struct PendingStages {
+        std::size_t index;
+        uint64_t sequence;
+        uint64_t disseminate_ns;
+        uint64_t kernel_receive_ns;
+    };
+
+    template <typename Msg>
+    static LatencyRecord make_record(const Msg& msg, uint64_t receive_timestamp, uint64_t kernel_receive_timestamp) {
+        return {
+            msg.disseminate_timestamp - msg.enqueue_timestamp,
+            receive_timestamp - msg.disseminate_timestamp,
+            receive_timestamp - msg.enqueue_timestamp,
+            0, 0,
+            kernel_receive_timestamp != 0 ? static_cast<int64_t>(receive_timestamp - kernel_receive_timestamp) : 0
+        };
+    }
+
+    struct TraceRecord {
+        uint64_t sequence;
+        uint64_t enqueue_ns;
+        types::TraceTrailer trailer;
+    };
+
+    static uint64_t trace_end(const TraceRecord& rec) {
+        const uint64_t delivered = trace::at(rec.trailer, types::TracePoint::Delivered);
+        return delivered != 0 ? delivered : trace::at(rec.trailer, types::TracePoint::Received);
+    }
+
+    // every point as ns after the intended time (after the enqueue timestamp if intended is not traced), empty
+    // where not traced. corrected_ns / uncorrected_ns as in trace_summary()
+    void save_traces(const std::string& path) const {
+        std::ofstream file(path);
+        file << "sequence";
+        for (const char* name : trace::point_names) file << "," << name << "_ns";
+        file << ",corrected_ns,uncorrected_ns\n";
+        for (const TraceRecord& rec : traces_) {
+            const uint64_t intended = trace::at(rec.trailer, types::TracePoint::Intended);
+            const uint64_t reference = intended != 0 ? intended : rec.enqueue_ns;
+            file << rec.sequence;
+            for (const uint64_t ns : rec.trailer.stamps) {
+                file << ",";
+                if (ns != 0) file << static_cast<int64_t>(ns - reference);
+            }
+            const uint64_t end = trace_end(rec);
+            file << ",";
+            if (end != 0 && intended != 0) file << static_cast<int64_t>(end - intended);
+            file << ",";
+            if (end != 0) file << static_cast<int64_t>(end - rec.enqueue_ns);
+            file << "\n";
+        }
+    }
+
+    static std::ostream& write_record(std::ostream& out, const LatencyRecord& lat) {
+        return out << lat.queue_ns << "," << lat.network_ns << "," << lat.total_ns << ","
+                   << lat.tx_stack_ns << "," << lat.wire_ns << "," << lat.rx_stack_ns;
+    }
+
     std::string out_dir_;
     std::vector<LatencyRecord> quote_latencies_;
     std::vector<LatencyRecord> trade_latencies_;
+    std::vector<OrderLatencyRecord> order_latencies_;
+    std::vector<uint64_t> quote_staleness_;
+    std::vector<PendingStages> quote_pending_;
+    std::vector<PendingStages> trade_pending_;
+    std::vector<PendingStages> order_pending_;
+    std::vector<TraceRecord> traces_;
+    std::unique_ptr<LatencyColumnWriter> columns_;
 };
 
 #endif // LATENCY_MONITOR_H
\ No newline at end of file
@@ -0,0 +1,315 @@
+#ifndef LIVE_LATENCY_H
+#define LIVE_LATENCY_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+/*
+Live latency numbers while a run is going, next to the full per-message records LatencyMonitor writes at the end.
+    LatencyRecorder   one per recording thread, wait-free: a sample is a couple of relaxed loads and stores into
+                      buckets only that thread writes
+    LiveAggregator    background thread, every interval it reads the recorders' counters, the difference to
+                      its previous read is what was recorded in between, and merges that into the current window.
+                      Once per report period (1 s) it logs p50/p99/p99.9, message rate and drops for the window
+                      and appends them to a time-series CSV, with the generator's mean target rate over the
+                      window when it has one (a load profile changes it while running).
+Reading cumulative counters instead of swapping buffers means the writer never has to notice the aggregator.
+The price is that one read may catch a bucket and the total a sample apart, which a live view can live with.
+ */
+
+// log-linear buckets: exact below 64 ns, then 32 per power of two (about 3% wide) up to ~18 minutes
+class LatencyHistogram {
+public:
+    static constexpr unsigned sub_bits = 5;
+    static constexpr uint64_t linear_limit = uint64_t{2} << sub_bits; // 64
+    static constexpr unsigned max_bits = 40;
+    static constexpr std::size_t bucket_count = linear_limit + (max_bits - sub_bits) * (std::size_t{1} << sub_bits);
+
+    static constexpr std::size_t bucket_of(uint64_t ns) {
+        if (ns < linear_limit) return static_cast<std::size_t>(ns);
+        const unsigned shift = std::min<unsigned>(std::bit_width(ns) - sub_bits - 1, max_bits - sub_bits);
+        const uint64_t sub = std::min<uint64_t>(ns >> shift, linear_limit - 1) - (linear_limit / 2);
+        return static_cast<std::size_t>(linear_limit + (shift - 1) * (linear_limit / 2) + sub);
+    }
+
+    // highest value that lands in the bucket
+    static constexpr uint64_t upper_bound(std::size_t bucket) {
+        if (bucket < linear_limit) return bucket;
+        const std::size_t shift = (bucket - linear_limit) / (linear_limit / 2) + 1;
+        const uint64_t sub = (bucket - linear_limit) % (linear_limit / 2) + linear_limit / 2;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void add(std::size_t bucket, uint64_t n) {
+        counts_[bucket] += n;
+        total_ += n;
+    }
+
+    void record(uint64_t ns) { add(bucket_of(ns), 1); }
+
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < bucket_count; ++i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+    }
+
+    void reset() {
+        counts_.fill(0);
+        total_ = 0;
+    }
+
+    [[nodiscard]] uint64_t count() const { return total_; }
+    [[nodiscard]] uint64_t bucket(std::size_t i) const { return counts_[i]; }
+
+    // upper bound of the bucket holding the p-th sample, 0 when empty
+    [[nodiscard]] uint64_t percentile(double p) const {
+        if (total_ == 0) return 0;
+        const auto rank = static_cast<uint64_t>(p * static_cast<double>(total_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) return upper_bound(i);
+        }
+        return upper_bound(bucket_count - 1);
+    }
+
+    [[nodiscard]] uint64_t max() const {
+        for (std::size_t i = bucket_count; i > 0; --i) {
+            if (counts_[i - 1] != 0) return upper_bound(i - 1);
+        }
+        return 0;
+    }
+
+private:
+    std::array<uint64_t, bucket_count> counts_{};
+    uint64_t total_{0};
+};
+
+// single writer, any number of readers. Counters only ever grow.
+class LatencyRecorder {
+public:
+    explicit LatencyRecorder(std::string name) : name_(std::move(name)) {}
+
+    // owning thread only. sequence numbers the stream (types::sequence_offset), a jump forward counts the
+    // messages in between as dropped. 0 = not numbered.
+    inline void record(uint64_t latency_ns, uint64_t sequence = 0) {
+        bump(buckets_[LatencyHistogram::bucket_of(latency_ns)]);
+        bump(count_);
+        if (sequence != 0) {
+            if (last_sequence_ != 0 && sequence > last_sequence_ + 1) {
+                drops_.store(drops_.load(std::memory_order_relaxed) + (sequence - last_sequence_ - 1), std::memory_order_relaxed);
+            }
+            if (sequence > last_sequence_) last_sequence_ = sequence;
+        }
+    }
+
+    // owning thread only, losses the recorder cannot see in the sequence
+    inline void add_drops(uint64_t n) {
+        drops_.store(drops_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] const std::string& name() const { return name_; }
+    [[nodiscard]] uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t drops() const { return drops_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t bucket(std::size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+
+private:
+    // no read-modify-write needed, nobody else writes
+    static inline void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::string name_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_{std::make_unique<std::atomic<uint64_t>[]>(LatencyHistogram::bucket_count)};
+    alignas(64) std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> drops_{0};
+    uint64_t last_sequence_{0};
+};
+
+class LiveAggregator {
+public:
+    // one report row per window
+    struct Report {
+        double elapsed_s;
+        uint64_t messages;
+        double rate;
+        uint64_t p50_ns;
+        uint64_t p99_ns;
+        uint64_t p999_ns;
+        uint64_t max_ns;
+        uint64_t drops;
+        double target_rate; // mean over the window, 0 without set_target_rate()
+    };
+
+    // csv_path empty: log only
+    explicit LiveAggregator(std::chrono::milliseconds interval, std::string csv_path = {},
+                            std::chrono::milliseconds report_period = std::chrono::seconds(1))
+        : interval_(interval), report_period_(report_period), csv_path_(std::move(csv_path)) {
+        if (interval_.count() <= 0 || report_period_ < interval_) {
+            throw std::invalid_argument("Live aggregation interval must be > 0 and not longer than the report period.");
+        }
+    }
+
+    ~LiveAggregator() { stop(); }
+
+    LiveAggregator(const LiveAggregator&) = delete;
+    LiveAggregator& operator=(const LiveAggregator&) = delete;
+
+    // a recorder for one recording thread, stays valid as long as the aggregator. Any time, also while running.
+    LatencyRecorder& add_recorder(std::string name) {
+        std::lock_guard lock(mutex_);
+        sources_.push_back({std::make_unique<LatencyRecorder>(std::move(name)), {}, 0, 0});
+        sources_.back().seen.resize(LatencyHistogram::bucket_count, 0);
+        return *sources_.back().recorder;
+    }
+
+    void start() {
+        if (thread_.joinable()) return;
+        if (!csv_path_.empty()) {
+            csv_.open(csv_path_);
+            if (!csv_) throw std::runtime_error("Could not open " + csv_path_);
+            csv_ << "elapsed_s,messages,rate,p50_ns,p99_ns,p999_ns,max_ns,drops,target_rate\n";
+        }
+        start_ = std::chrono::steady_clock::now();
+        thread_ = std::jthread([this](std::stop_token st) { run(st); });
+    }
+
+    // takes the last partial window too
+    void stop() {
+        if (!thread_.joinable()) return;
+        thread_.request_stop();
+        thread_.join();
+        collect();
+        const Report* report = nullptr;
+        if (window_.count() > 0 || window_drops_ > 0) report = &emit(std::chrono::steady_clock::now());
+        if (observer_) observer_(total_, total_drops_, report);
+        csv_.close();
+    }
+
+    // all windows so far, after stop() or from the aggregator's own callbacks
+    [[nodiscard]] const std::vector<Report>& reports() const { return reports_; }
+
+    /*
+    Called on the aggregator thread after every pass with everything recorded so far and the drops, plus the
+    window when the pass closed one (nullptr otherwise), e.g. shm::publish_latency. Set before start().
+     */
+    using Observer = std::function<void(const LatencyHistogram& total, uint64_t drops, const Report* report)>;
+    void set_observer(Observer observer) { observer_ = std::move(observer); }
+
+    // the generator's current target rate (shm::GeneratorStats::target_rate), read every pass. Set before start().
+    void set_target_rate(const std::atomic<uint64_t>* rate) { target_ = rate; }
+
+    // the log line per window, on by default
+    void set_logging(bool on) { logging_ = on; }
+
+private:
+    struct Source {
+        std::unique_ptr<LatencyRecorder> recorder;
+        std::vector<uint64_t> seen; // bucket counts at the last read
+        uint64_t seen_count;
+        uint64_t seen_drops;
+    };
+
+    void run(const std::stop_token& st) {
+        auto next_report = start_ + report_period_;
+        while (!st.stop_requested()) {
+            std::this_thread::sleep_for(interval_);
+            collect();
+            const Report* report = nullptr;
+            if (const auto now = std::chrono::steady_clock::now(); now >= next_report) {
+                report = &emit(now);
+                next_report += report_period_;
+            }
+            if (observer_) observer_(total_, total_drops_, report);
+        }
+    }
+
+    // what every recorder added since the last read, into the window
+    void collect() {
+        std::lock_guard lock(mutex_);
+        for (Source& s : sources_) {
+            const uint64_t count = s.recorder->count();
+            if (count != s.seen_count) {
+                for (std::size_t i = 0; i < LatencyHistogram::bucket_count; ++i) {
+                    const uint64_t now = s.recorder->bucket(i);
+                    if (now != s.seen[i]) {
+                        window_.add(i, now - s.seen[i]);
+                        total_.add(i, now - s.seen[i]);
+                        s.seen[i] = now;
+                    }
+                }
+                s.seen_count = count;
+            }
+            const uint64_t drops = s.recorder->drops();
+            window_drops_ += drops - s.seen_drops;
+            total_drops_ += drops - s.seen_drops;
+            s.seen_drops = drops;
+        }
+        if (target_) {
+            target_sum_ += static_cast<double>(target_->load(std::memory_order_relaxed));
+            ++target_samples_;
+        }
+    }
+
+    const Report& emit(std::chrono::steady_clock::time_point now) {
+        const double window_s = std::chrono::duration<double>(now - window_start_.value_or(start_)).count();
+        Report r{std::chrono::duration<double>(now - start_).count(), window_.count(),
+                 window_s > 0 ? static_cast<double>(window_.count()) / window_s : 0.0,
+                 window_.percentile(0.5), window_.percentile(0.99), window_.percentile(0.999), window_.max(),
+                 window_drops_, target_samples_ > 0 ? target_sum_ / static_cast<double>(target_samples_) : 0.0};
+        reports_.push_back(r);
+        if (logging_) spdlog::info("live {:.0f}s: {:.0f} msgs/s{}, p50 {:.1f} us, p99 {:.1f} us, p99.9 {:.1f} us, max {:.1f} us, {} dropped",
+                     r.elapsed_s, r.rate, target_ ? fmt::format(" (target {:.0f})", r.target_rate) : std::string{},
+                     r.p50_ns / 1000.0, r.p99_ns / 1000.0, r.p999_ns / 1000.0, r.max_ns / 1000.0, r.drops);
+        if (csv_.is_open()) {
+            csv_ << r.elapsed_s << "," << r.messages << "," << r.rate << "," << r.p50_ns << "," << r.p99_ns << ","
+                 << r.p999_ns << "," << r.max_ns << "," << r.drops << "," << r.target_rate << "\n";
+            csv_.flush(); // so a tail -f or a killed run still has it
+        }
+        window_.reset();
+        window_drops_ = 0;
+        target_sum_ = 0;
+        target_samples_ = 0;
+        window_start_ = now;
+        return reports_.back();
+    }
+
+    std::chrono::milliseconds interval_;
+    std::chrono::milliseconds report_period_;
+    std::string csv_path_;
+    std::ofstream csv_;
+
+    std::mutex mutex_; // sources_ only, the recorders themselves are never locked
+    std::vector<Source> sources_;
+
+    // aggregator thread, then stop()
+    Observer observer_;
+    const std::atomic<uint64_t>* target_{nullptr};
+    bool logging_{true};
+    LatencyHistogram window_;
+    LatencyHistogram total_;
+    uint64_t window_drops_{0};
+    uint64_t total_drops_{0};
+    double target_sum_{0};
+    uint64_t target_samples_{0};
+    std::chrono::steady_clock::time_point start_;
+    std::optional<std::chrono::steady_clock::time_point> window_start_;
+    std::vector<Report> reports_;
+    std::jthread thread_;
+};
+
+#endif // LIVE_LATENCY_H
@@ -0,0 +1,481 @@
+#ifndef RUN_ANALYSIS_H
+#define RUN_ANALYSIS_H
+
+#include "LatencyColumns.h"
+#include "LiveLatency.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+Offline summary of finished runs (md_analyze): reads what main_simulate left in an output directory, the
+binary column file (latencies.mdlat) or the *_latencies.csv files, and reduces each run to one row.
+    latency      exact percentiles (sorted samples) next to the log-linear histogram ones the live view shows,
+                 mean, jitter (standard deviation), mean queue and network part
+    throughput   messages per window from the receive timestamps (binary), or the rates in live_latency.csv
+    loss         holes in the sequence numbers (binary), or the drops in live_latency.csv
+Runs are independent, analyze() spreads them over worker threads, each loads, reduces and frees one run at a
+time, so memory is a few runs' worth of total_ns, not the whole sweep.
+ */
+namespace analysis {
+    struct Options {
+        uint64_t window_ns{1'000'000'000};
+        char type{0};        // only this message tag ('Q', 'T', 'A' ...), 0 = all
+        uint64_t skip_ns{0}; // warm-up, leaves out what was received this long after the first record (binary only)
+    };
+
+    // the samples of one run, what the statistics are taken from
+    struct RunData {
+        std::string source;               // "binary" or "csv"
+        std::vector<uint64_t> total_ns;
+        double queue_sum_ns{0};
+        double network_sum_ns{0};
+        std::vector<double> window_rates; // msg/s per full window
+        bool loss_known{false};
+        uint64_t lost{0};
+        uint64_t expected{0};             // messages the sequence numbers (or live windows) account for
+    };
+
+    struct RunSummary {
+        std::string run;
+        std::string source;
+        std::string error;   // loading failed, nothing else is set
+        uint64_t messages{0};
+        double mean_ns{0};
+        double jitter_ns{0};
+        uint64_t p50_ns{0}, p90_ns{0}, p99_ns{0}, p999_ns{0}, max_ns{0};
+        uint64_t hist_p50_ns{0}, hist_p99_ns{0}, hist_p999_ns{0};
+        double mean_queue_ns{0};
+        double mean_network_ns{0};
+        std::size_t windows{0};
+        double rate_mean{0}, rate_min{0}, rate_max{0};
+        bool loss_known{false};
+        uint64_t lost{0};
+        double loss_pct{0};
+    };
+
+    inline constexpr const char* binary_file = "latencies.mdlat";
+    inline constexpr const char* live_file = "live_latency.csv";
+
+    // the file a message type was written to with --latency-format csv, nullptr for all of them
+    inline const char* csv_file_of(char type) {
+        switch (type) {
+            case 0: return nullptr;
+            case 'Q': return "quote_latencies.csv";
+            case 'T': return "trade_latencies.csv";
+            default: return "order_latencies.csv";
+        }
+    }
+
+    namespace detail {
+        inline std::string read_file(const std::filesystem::path& path) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) throw std::runtime_error("Cannot open " + path.string());
+            std::string data;
+            data.resize(std::filesystem::file_size(path));
+            in.read(data.data(), static_cast<std::streamsize>(data.size()));
+            return data;
+        }
+
+        inline std::vector<std::string_view> split(std::string_view line) {
+            std::vector<std::string_view> fields;
+            std::size_t start = 0;
+            while (true) {
+                const std::size_t comma = line.find(',', start);
+                fields.push_back(line.substr(start, comma - start));
+                if (comma == std::string_view::npos) break;
+                start = comma + 1;
+            }
+            return fields;
+        }
+
+        template <typename T>
+        T parse(std::string_view field) {
+            T v{};
+            const auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), v);
+            if (ec != std::errc{}) throw std::runtime_error("Bad number '" + std::string(field) + "'");
+            (void)end;
+            return v;
+        }
+
+        // read-only mapping of a whole file
+        class Mapping {
+        public:
+            explicit Mapping(const std::filesystem::path& path) {
+                const int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) throw std::runtime_error("Cannot open " + path.string());
+                struct stat st{};
+                if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                    ::close(fd);
+                    throw std::runtime_error("Empty or unreadable " + path.string());
+                }
+                size_ = static_cast<std::size_t>(st.st_size);
+                void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                ::close(fd);
+                if (addr == MAP_FAILED) throw std::runtime_error("Failed to mmap " + path.string());
+                madvise(addr, size_, MADV_SEQUENTIAL);
+                data_ = static_cast<const std::byte*>(addr);
+            }
+            ~Mapping() { munmap(const_cast<std::byte*>(data_), size_); }
+            Mapping(const Mapping&) = delete;
+            Mapping& operator=(const Mapping&) = delete;
+
+            [[nodiscard]] const std::byte* data() const { return data_; }
+            [[nodiscard]] std::size_t size() const { return size_; }
+
+        private:
+            const std::byte* data_{nullptr};
+            std::size_t size_{0};
+        };
+
+        inline void count_windows(RunData& run, const std::vector<uint64_t>& per_window, uint64_t window_ns) {
+            // the last window is cut off by the end of the run, unless it is the only one
+            const std::size_t full = per_window.size() > 1 ? per_window.size() - 1 : per_window.size();
+            for (std::size_t i = 0; i < full; ++i) {
+                run.window_rates.push_back(static_cast<double>(per_window[i]) * 1e9 / static_cast<double>(window_ns));
+            }
+        }
+    }
+
+    inline RunData load_binary(const std::filesystem::path& path, const Options& opts) {
+        using namespace latency_columns;
+        detail::Mapping file(path);
+        FileHeader h{};
+        if (file.size() < sizeof(h)) throw std::runtime_error(path.string() + " is too short for a latency column file");
+        std::memcpy(&h, file.data(), sizeof(h));
+        if (h.magic != file_magic) throw std::runtime_error(path.string() + " is not a latency column file");
+        if (h.version != format_version) {
+            throw std::runtime_error(path.string() + " has format version " + std::to_string(h.version));
+        }
+        if (h.column_count > max_columns || file.size() < h.header_size + h.block_count * h.block_bytes ||
+            h.record_count > h.block_count * h.block_records) {
+            throw std::runtime_error(path.string() + " is truncated or has a broken header");
+        }
+
+        auto find = [&](const char* name, uint32_t width) -> const Column* {
+            for (uint32_t i = 0; i < h.column_count; ++i) {
+                if (std::strncmp(h.columns[i].name, name, sizeof(h.columns[i].name)) == 0) {
+                    if (h.columns[i].width != width) throw std::runtime_error(std::string("Unexpected width of column ") + name);
+                    return &h.columns[i];
+                }
+            }
+            return nullptr;
+        };
+        const Column* total = find("total_ns", 8);
+        if (total == nullptr) throw std::runtime_error(path.string() + " has no total_ns column");
+        const Column* queue = find("queue_ns", 8);
+        const Column* network = find("network_ns", 8);
+        const Column* sequence = find("sequence", 8);
+        const Column* receive = find("recv_ns", 8);
+        const Column* type = find("type", 1);
+        if (opts.type != 0 && type == nullptr) throw std::runtime_error(path.string() + " has no type column");
+        if (opts.skip_ns != 0 && receive == nullptr) throw std::runtime_error(path.string() + " has no recv_ns column to skip a warm-up by");
+
+        RunData run;
+        run.source = "binary";
+        run.total_ns.reserve(h.record_count);
+        std::vector<uint64_t> per_window;
+        uint64_t start = 0, first_sequence = 0, last_sequence = 0, numbered = 0;
+        bool started = false;
+
+        auto value = [&](const Column* c, const std::byte* block, uint64_t i) {
+            uint64_t v;
+            std::memcpy(&v, block + c->offset + i * 8, sizeof(v));
+            return v;
+        };
+        for (uint64_t b = 0, left = h.record_count; left > 0; ++b) {
+            const std::byte* block = file.data() + h.header_size + b * h.block_bytes;
+            const uint64_t n = std::min<uint64_t>(left, h.block_records);
+            for (uint64_t i = 0; i < n; ++i) {
+                if (opts.type != 0 && static_cast<char>(block[type->offset + i]) != opts.type) continue;
+                if (receive) {
+                    // windows count from the end of the warm-up
+                    const uint64_t at = value(receive, block, i);
+                    if (!started) {
+                        start = at + opts.skip_ns;
+                        started = true;
+                    }
+                    if (at < start) continue;
+                    const auto w = static_cast<std::size_t>((at - start) / opts.window_ns);
+                    if (w >= per_window.size()) per_window.resize(w + 1, 0);
+                    ++per_window[w];
+                }
+                run.total_ns.push_back(value(total, block, i));
+                if (queue) run.queue_sum_ns += static_cast<double>(value(queue, block, i));
+                if (network) run.network_sum_ns += static_cast<double>(value(network, block, i));
+                if (sequence) {
+                    // conflated records carry the sequence of the last message they replaced, 0 = not numbered
+                    const uint64_t s = value(sequence, block, i);
+                    if (s != 0) {
+                        first_sequence = numbered == 0 ? s : std::min(first_sequence, s);
+                        last_sequence = std::max(last_sequence, s);
+                        ++numbered;
+                    }
+                }
+            }
+            left -= n;
+        }
+        detail::count_windows(run, per_window, opts.window_ns);
+        // with a type filter the other types fill the sequence holes, after the conflator the quotes it merged
+        // do, neither are lost
+        if (numbered > 0 && opts.type == 0 && (h.flags & latency_columns::conflated_sequences) == 0) {
+            run.loss_known = true;
+            run.expected = last_sequence - first_sequence + 1;
+            run.lost = run.expected > numbered ? run.expected - numbered : 0;
+        }
+        return run;
+    }
+
+    // one *_latencies.csv, appended to run
+    inline void load_csv(const std::filesystem::path& path, RunData& run) {
+        const std::string data = detail::read_file(path);
+        std::string_view rest(data);
+        auto next_line = [&rest]() {
+            const std::size_t nl = rest.find('\n');
+            std::string_view line = rest.substr(0, nl);
+            rest = nl == std::string_view::npos ? std::string_view{} : rest.substr(nl + 1);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            return line;
+        };
+
+        const std::vector<std::string_view> header = detail::split(next_line());
+        auto column = [&header](std::string_view name) {
+            const auto it = std::find(header.begin(), header.end(), name);
+            return it == header.end() ? std::string_view::npos : static_cast<std::size_t>(it - header.begin());
+        };
+        const std::size_t total = column("total_ns"), queue = column("queue_ns"), network = column("network_ns");
+        if (total == std::string_view::npos) throw std::runtime_error(path.string() + " has no total_ns column");
+
+        run.source = "csv";
+        while (!rest.empty()) {
+            const std::string_view line = next_line();
+            if (line.empty()) continue;
+            // the columns written before total_ns are all that is needed, stop splitting there
+            std::size_t start = 0;
+            for (std::size_t col = 0; col <= total; ++col) {
+                const std::size_t comma = line.find(',', start);
+                const std::string_view field = line.substr(start, comma - start);
+                if (col == total) run.total_ns.push_back(detail::parse<uint64_t>(field));
+                else if (col == queue) run.queue_sum_ns += static_cast<double>(detail::parse<uint64_t>(field));
+                else if (col == network) run.network_sum_ns += static_cast<double>(detail::parse<uint64_t>(field));
+                if (comma == std::string_view::npos && col < total) {
+                    throw std::runtime_error(path.string() + ": short line '" + std::string(line) + "'");
+                }
+                start = comma + 1;
+            }
+        }
+    }
+
+    // rates and drops of the --live windows, what a CSV run has instead of receive timestamps and sequences
+    inline void load_live(const std::filesystem::path& path, RunData& run) {
+        const std::string data = detail::read_file(path);
+        std::string_view rest(data);
+        std::size_t rate = std::string_view::npos, drops = std::string_view::npos, messages = std::string_view::npos;
+        bool first = true;
+        uint64_t total_drops = 0, total_messages = 0;
+        while (!rest.empty()) {
+            const std::size_t nl = rest.find('\n');
+            const std::string_view line = rest.substr(0, nl);
+            rest = nl == std::string_view::npos ? std::string_view{} : rest.substr(nl + 1);
+            if (line.empty()) continue;
+            const std::vector<std::string_view> fields = detail::split(line);
+            if (first) {
+                for (std::size_t i = 0; i < fields.size(); ++i) {
+                    if (fields[i] == "rate") rate = i;
+                    else if (fields[i] == "drops") drops = i;
+                    else if (fields[i] == "messages") messages = i;
+                }
+                if (rate == std::string_view::npos) throw std::runtime_error(path.string() + " has no rate column");
+                first = false;
+                continue;
+            }
+            if (rate >= fields.size()) continue;
+            run.window_rates.push_back(detail::parse<double>(fields[rate]));
+            if (drops < fields.size()) total_drops += detail::parse<uint64_t>(fields[drops]);
+            if (messages < fields.size()) total_messages += detail::parse<uint64_t>(fields[messages]);
+        }
+        if (drops != std::string_view::npos) {
+            run.loss_known = true;
+            run.lost = total_drops;
+            run.expected = total_messages + total_drops;
+        }
+    }
+
+    // a run directory (the newer of latencies.mdlat and the CSVs) or one file of either kind
+    inline RunData load_run(const std::filesystem::path& path, const Options& opts = {}) {
+        namespace fs = std::filesystem;
+        if (!fs::is_directory(path)) {
+            if (path.extension() == ".mdlat") return load_binary(path, opts);
+            RunData run;
+            load_csv(path, run);
+            return run;
+        }
+
+        const fs::path binary = path / binary_file;
+        const fs::path quotes = path / csv_file_of('Q');
+        if (fs::exists(binary) && (!fs::exists(quotes) || fs::last_write_time(binary) >= fs::last_write_time(quotes))) {
+            return load_binary(binary, opts);
+        }
+
+        RunData run;
+        std::vector<const char*> files;
+        if (const char* one = csv_file_of(opts.type)) files.push_back(one);
+        else files = {csv_file_of('Q'), csv_file_of('T'), csv_file_of('A')};
+        bool any = false;
+        for (const char* f : files) {
+            if (!fs::exists(path / f)) continue;
+            load_csv(path / f, run);
+            any = true;
+        }
+        if (!any) throw std::runtime_error("No latency output in " + path.string());
+        if (fs::exists(path / live_file)) load_live(path / live_file, run);
+        return run;
+    }
+
+    // a directory with latency output is a run, one without it a sweep whose subdirectories are the runs
+    inline std::vector<std::filesystem::path> find_runs(const std::vector<std::string>& paths) {
+        namespace fs = std::filesystem;
+        auto is_run = [](const fs::path& dir) {
+            return fs::exists(dir / binary_file) || fs::exists(dir / csv_file_of('Q')) || fs::exists(dir / csv_file_of('T')) ||
+                   fs::exists(dir / csv_file_of('A'));
+        };
+        std::vector<fs::path> runs;
+        for (const std::string& p : paths) {
+            const fs::path path(p);
+            if (!fs::exists(path)) throw std::runtime_error("No such file or directory: " + p);
+            if (!fs::is_directory(path) || is_run(path)) {
+                runs.push_back(path);
+                continue;
+            }
+            std::vector<fs::path> sub;
+            for (const auto& e : fs::directory_iterator(path)) {
+                if (e.is_directory() && is_run(e.path())) sub.push_back(e.path());
+            }
+            if (sub.empty()) throw std::runtime_error("No runs in " + p);
+            std::sort(sub.begin(), sub.end());
+            runs.insert(runs.end(), sub.begin(), sub.end());
+        }
+        return runs;
+    }
+
+    inline RunSummary summarize(RunData& run) {
+        RunSummary s;
+        s.source = run.source;
+        std::vector<uint64_t>& v = run.total_ns;
+        s.messages = v.size();
+        if (!v.empty()) {
+            LatencyHistogram hist;
+            double mean = 0, m2 = 0, n = 0;
+            for (const uint64_t ns : v) {
+                hist.record(ns);
+                n += 1;
+                const double d = static_cast<double>(ns) - mean;
+                mean += d / n;
+                m2 += d * (static_cast<double>(ns) - mean);
+            }
+            s.mean_ns = mean;
+            s.jitter_ns = std::sqrt(m2 / n);
+            s.mean_queue_ns = run.queue_sum_ns / n;
+            s.mean_network_ns = run.network_sum_ns / n;
+            s.hist_p50_ns = hist.percentile(0.5);
+            s.hist_p99_ns = hist.percentile(0.99);
+            s.hist_p999_ns = hist.percentile(0.999);
+
+            // same rank as LatencyHistogram::percentile. Ascending, so each selection only looks at what is
+            // above the previous one
+            auto begin = v.begin();
+            auto exact = [&](double p) {
+                const auto at = v.begin() + static_cast<std::ptrdiff_t>(p * static_cast<double>(v.size() - 1));
+                std::nth_element(begin, at, v.end());
+                begin = at;
+                return *at;
+            };
+            s.p50_ns = exact(0.5);
+            s.p90_ns = exact(0.9);
+            s.p99_ns = exact(0.99);
+            s.p999_ns = exact(0.999);
+            s.max_ns = *std::max_element(begin, v.end());
+        }
+
+        s.windows = run.window_rates.size();
+        if (s.windows > 0) {
+            const auto [lo, hi] = std::minmax_element(run.window_rates.begin(), run.window_rates.end());
+            double sum = 0;
+            for (const double r : run.window_rates) sum += r;
+            s.rate_mean = sum / static_cast<double>(s.windows);
+            s.rate_min = *lo;
+            s.rate_max = *hi;
+        }
+        s.loss_known = run.loss_known;
+        s.lost = run.lost;
+        s.loss_pct = run.expected > 0 ? 100.0 * static_cast<double>(run.lost) / static_cast<double>(run.expected) : 0.0;
+        return s;
+    }
+
+    // the rows in the order of runs, a run that failed to load has error set. jobs 0 = one per core
+    inline std::vector<RunSummary> analyze(const std::vector<std::filesystem::path>& runs, const Options& opts,
+                                           unsigned jobs = 0) {
+        std::vector<RunSummary> out(runs.size());
+        if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+        jobs = static_cast<unsigned>(std::min<std::size_t>(jobs, std::max<std::size_t>(runs.size(), 1)));
+
+        std::atomic<std::size_t> next{0};
+        auto work = [&]() {
+            for (std::size_t i = next.fetch_add(1); i < runs.size(); i = next.fetch_add(1)) {
+                try {
+                    RunData data = load_run(runs[i], opts);
+                    out[i] = summarize(data);
+                } catch (const std::exception& e) {
+                    out[i].error = e.what();
+                }
+                out[i].run = runs[i].lexically_normal().string();
+                if (out[i].run.size() > 1 && out[i].run.back() == '/') out[i].run.pop_back();
+            }
+        };
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned j = 1; j < jobs; ++j) workers.emplace_back(work);
+            work();
+        }
+        return out;
+    }
+
+    // the summary table, one row per run that loaded. Latencies in us, rates in msg/s, loss empty when unknown
+    inline void write_csv(std::ostream& out, const std::vector<RunSummary>& rows) {
+        out << "run,source,messages,p50_us,p90_us,p99_us,p999_us,max_us,mean_us,jitter_us,tail_ratio,"
+               "hist_p50_us,hist_p99_us,hist_p999_us,queue_us,network_us,windows,rate_mean,rate_min,rate_max,lost,loss_pct\n";
+        auto us = [](double ns) { return ns / 1000.0; };
+        for (const RunSummary& r : rows) {
+            if (!r.error.empty()) continue;
+            out << r.run << "," << r.source << "," << r.messages << "," << us(r.p50_ns) << "," << us(r.p90_ns) << ","
+                << us(r.p99_ns) << "," << us(r.p999_ns) << "," << us(r.max_ns) << "," << us(r.mean_ns) << ","
+                << us(r.jitter_ns) << "," << (r.p50_ns > 0 ? static_cast<double>(r.p99_ns) / static_cast<double>(r.p50_ns) : 0.0)
+                << "," << us(r.hist_p50_ns) << "," << us(r.hist_p99_ns) << "," << us(r.hist_p999_ns) << ","
+                << us(r.mean_queue_ns) << "," << us(r.mean_network_ns) << "," << r.windows << "," << r.rate_mean << ","
+                << r.rate_min << "," << r.rate_max << ",";
+            if (r.loss_known) out << r.lost << "," << r.loss_pct;
+            else out << ",";
+            out << "\n";
+        }
+    }
+}
+
+#endif // RUN_ANALYSIS_H
@@ -0,0 +1,116 @@
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "../utils/types.h"
+
+/*
+On-disk layout of a capture (.mdcap) file:
+
+    [FileHeader, one 4 KiB page]
+    [RecordHeader | topic | payload | pad to 8] * record_count
+    [IndexEntry] * index_count            <- written when the capture is closed
+
+The header carries a schema table (tag, payload size, name) of every message type that can appear in
+the file, so a reader can walk the records without knowing our structs. The index is sparse: one entry
+per index_interval_ns of capture time, which is enough to binary search into a multi-GB file and then
+scan forward a few records.
+While the capture is still being written index_offset stays 0 and data_end is bumped after every batch,
+so a crashed run is still readable by scanning.
+ */
+namespace capture {
+    inline constexpr std::array<char, 8> file_magic{'M', 'D', 'C', 'A', 'P', '\0', '\r', '\n'};
+    inline constexpr uint32_t format_version = 3;   // 2: messages carry symbol_id, 3: and their stream sequence
+    inline constexpr std::size_t header_page_size = 4096;
+    inline constexpr std::size_t max_schema_entries = 32;
+    inline constexpr std::size_t record_alignment = 8;
+
+    struct MessageSchema {
+        char tag;
+        uint8_t reserved[3];
+        uint32_t payload_size;
+        char name[24];
+    };
+
+    struct FileHeader {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t header_size;
+        uint32_t record_header_size;
+        uint32_t topic_size;
+        uint64_t data_offset;
+        uint64_t data_end;           // one past the last complete record
+        uint64_t record_count;
+        uint64_t index_offset;       // 0 until the capture is closed
+        uint64_t index_count;
+        uint64_t index_interval_ns;
+        uint64_t first_timestamp_ns;
+        uint64_t last_timestamp_ns;
+        uint32_t schema_count;
+        uint32_t reserved;
+        MessageSchema schema[max_schema_entries];
+    };
+    static_assert(sizeof(FileHeader) <= header_page_size);
+
+    struct RecordHeader {
+        uint64_t timestamp_ns;       // disseminate timestamp of the message
+        uint64_t sequence;           // position in the disseminated stream
+        uint32_t record_size;        // header + topic + payload + padding
+        uint16_t payload_size;
+        char tag;
+        uint8_t topic_size;
+    };
+    static_assert(sizeof(RecordHeader) == 24);
+
+    struct IndexEntry {
+        uint64_t timestamp_ns;
+        uint64_t offset;
+        uint64_t sequence;
+    };
+
+    constexpr std::size_t padded_record_size(std::size_t topic_size, std::size_t payload_size) {
+        const std::size_t raw = sizeof(RecordHeader) + topic_size + payload_size;
+        return (raw + record_alignment - 1) & ~(record_alignment - 1);
+    }
+
+    inline MessageSchema make_schema(char tag, uint32_t payload_size, const char* name) {
+        MessageSchema s{};
+        s.tag = tag;
+        s.payload_size = payload_size;
+        std::strncpy(s.name, name, sizeof(s.name) - 1);
+        return s;
+    }
+
+    // one schema entry per type in types::Messages
+    inline void write_default_schema(FileHeader& header) {
+        static_assert(types::Messages::count <= max_schema_entries);
+        header.schema_count = 0;
+        types::Messages::for_each_type([&]<typename T>() {
+            header.schema[header.schema_count++] =
+                make_schema(types::MessageTraits<T>::tag, sizeof(T), types::MessageTraits<T>::name);
+        });
+    }
+
+    inline bool is_valid_header(const FileHeader& header) {
+        return header.magic == file_magic && header.version == format_version &&
+               header.record_header_size == sizeof(RecordHeader) && header.data_offset >= sizeof(FileHeader);
+    }
+
+    // returns the offset of the last indexed record at or before timestamp_ns, scanning forward from
+    // there reaches the first record >= timestamp_ns.
+    inline uint64_t seek_offset(const FileHeader& header, const IndexEntry* index, uint64_t timestamp_ns) {
+        if (index == nullptr || header.index_count == 0) {
+            return header.data_offset;
+        }
+        const IndexEntry* end = index + header.index_count;
+        const IndexEntry* it = std::upper_bound(index, end, timestamp_ns,
+            [](uint64_t ts, const IndexEntry& e) { return ts < e.timestamp_ns; });
+        return it == index ? header.data_offset : (it - 1)->offset;
+    }
+}
+
+#endif // CAPTURE_FORMAT_H
@@ -0,0 +1,154 @@
+#ifndef CAPTURE_READER_H
+#define CAPTURE_READER_H
+
+#include "CaptureFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace capture {
+    struct RecordView {
+        const RecordHeader* header;
+        const std::byte* topic;
+        const std::byte* payload;
+    };
+}
+
+// Read-only, sequential cursor over a memory-mapped capture file. Records are handed out as views into the
+// mapping, nothing is copied or allocated per record.
+class CaptureReader {
+public:
+    // how far ahead of the cursor we ask the kernel to fault pages in
+    static constexpr std::size_t readahead_window = std::size_t{4} << 20;
+
+    explicit CaptureReader(const std::filesystem::path& path) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open capture file: " + path.string());
+        }
+        struct stat st{};
+        if (fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(capture::FileHeader)) {
+            ::close(fd_);
+            throw std::runtime_error("Capture file too small: " + path.string());
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to mmap capture file: " + path.string());
+        }
+        map_ = static_cast<const std::byte*>(addr);
+        madvise(const_cast<std::byte*>(map_), size_, MADV_SEQUENTIAL);
+
+        if (!capture::is_valid_header(header())) {
+            munmap(const_cast<std::byte*>(map_), size_);
+            ::close(fd_);
+            throw std::runtime_error("Not a capture file or unsupported version: " + path.string());
+        }
+
+        // a capture that was never closed has no index, but data_end is still valid
+        end_ = std::min<uint64_t>(header().data_end, size_);
+        if (header().index_offset != 0 &&
+            header().index_offset + header().index_count * sizeof(capture::IndexEntry) <= size_) {
+            index_ = reinterpret_cast<const capture::IndexEntry*>(map_ + header().index_offset);
+        }
+        rewind();
+    }
+
+    ~CaptureReader() {
+        if (map_ != nullptr) munmap(const_cast<std::byte*>(map_), size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    [[nodiscard]] const capture::FileHeader& header() const {
+        return *reinterpret_cast<const capture::FileHeader*>(map_);
+    }
+
+    [[nodiscard]] bool at_end() const { return cursor_ + sizeof(capture::RecordHeader) > end_; }
+
+    // timestamp of the record next() would return, only valid if !at_end()
+    [[nodiscard]] uint64_t peek_timestamp() const {
+        return reinterpret_cast<const capture::RecordHeader*>(map_ + cursor_)->timestamp_ns;
+    }
+
+    inline bool next(capture::RecordView& out) {
+        if (at_end()) {
+            return false;
+        }
+        const auto* rh = reinterpret_cast<const capture::RecordHeader*>(map_ + cursor_);
+        if (!complete(*rh)) {
+            cursor_ = end_; // torn tail of a crashed capture
+            return false;
+        }
+        out.header = rh;
+        out.topic = map_ + cursor_ + sizeof(capture::RecordHeader);
+        out.payload = out.topic + rh->topic_size;
+        cursor_ += rh->record_size;
+
+        __builtin_prefetch(map_ + std::min<uint64_t>(cursor_ + 256, end_ - 1));
+        if (cursor_ >= advised_until_) {
+            advise_ahead();
+        }
+        return true;
+    }
+
+    void rewind() {
+        cursor_ = header().data_offset;
+        advised_until_ = cursor_;
+        advise_ahead();
+    }
+
+    // positions the cursor on the first record with timestamp >= timestamp_ns
+    void seek(uint64_t timestamp_ns) {
+        cursor_ = capture::seek_offset(header(), index_, timestamp_ns);
+        while (!at_end()) {
+            const auto* rh = reinterpret_cast<const capture::RecordHeader*>(map_ + cursor_);
+            if (!complete(*rh)) {
+                cursor_ = end_;
+                break;
+            }
+            if (rh->timestamp_ns >= timestamp_ns) break;
+            cursor_ += rh->record_size;
+        }
+        advised_until_ = cursor_;
+        advise_ahead();
+    }
+
+private:
+    // false for a zero-filled or truncated record, the header at the cursor is in the mapping
+    [[nodiscard]] bool complete(const capture::RecordHeader& rh) const {
+        return rh.record_size >= sizeof(capture::RecordHeader) && cursor_ + rh.record_size <= end_;
+    }
+
+    void advise_ahead() {
+        const uint64_t page_mask = ~uint64_t{4095};
+        const uint64_t from = advised_until_ & page_mask;
+        const uint64_t to = std::min<uint64_t>(advised_until_ + readahead_window, end_);
+        if (to > from) {
+            madvise(const_cast<std::byte*>(map_ + from), to - from, MADV_WILLNEED);
+        }
+        // re-advise once we are half way through the window
+        advised_until_ = from + readahead_window / 2;
+    }
+
+    int fd_{-1};
+    const std::byte* map_{nullptr};
+    std::size_t size_{0};
+    uint64_t end_{0};
+    uint64_t cursor_{0};
+    uint64_t advised_until_{0};
+    const capture::IndexEntry* index_{nullptr};
+};
+
+#endif // CAPTURE_READER_H
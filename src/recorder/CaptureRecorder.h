@@ -0,0 +1,247 @@
+#ifndef CAPTURE_RECORDER_H
+#define CAPTURE_RECORDER_H
+
+#include "CaptureFormat.h"
+#include "../utils/CustomSpscQueue.h"
+#include "../utils/types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+Taps the disseminated stream and journals it to a memory-mapped capture file.
+The disseminator thread only copies the message into its frame in the hand-off queue (record()), a separate
+writer thread appends the frames into the preallocated mapping and keeps the time index.
+If the writer falls behind and the hand-off queue is full the frame is dropped and counted, the send path never blocks
+on disk.
+ */
+class CaptureRecorder {
+public:
+    static constexpr std::size_t max_body_size = types::topic_header_size + types::max_payload_size;
+    static constexpr std::size_t handoff_capacity = 1 << 16;
+
+    struct Frame {
+        capture::RecordHeader header;
+        std::byte body[max_body_size];
+    };
+
+    explicit CaptureRecorder(const std::filesystem::path& path,
+                             uint64_t preallocate_bytes = uint64_t{256} << 20,
+                             uint64_t index_interval_ns = 1'000'000)
+        : path_(path), grow_bytes_(std::max<uint64_t>(preallocate_bytes, capture::header_page_size * 16)),
+          index_interval_ns_(index_interval_ns) {
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open capture file: " + path_.string());
+        }
+        map_file(grow_bytes_);
+
+        auto* hdr = header();
+        std::memset(hdr, 0, capture::header_page_size);
+        hdr->magic = capture::file_magic;
+        hdr->version = capture::format_version;
+        hdr->header_size = sizeof(capture::FileHeader);
+        hdr->record_header_size = sizeof(capture::RecordHeader);
+        hdr->topic_size = types::topic_header_size;
+        hdr->data_offset = capture::header_page_size;
+        hdr->data_end = capture::header_page_size;
+        hdr->index_interval_ns = index_interval_ns_;
+        capture::write_default_schema(*hdr);
+        write_offset_ = capture::header_page_size;
+    }
+
+    ~CaptureRecorder() {
+        stop();
+        close_file();
+    }
+
+    CaptureRecorder(const CaptureRecorder&) = delete;
+    CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+    void start() {
+        if (fd_ < 0) {
+            throw std::logic_error("Capture file has already been closed.");
+        }
+        if (!writer_.joinable()) {
+            writer_ = std::jthread([this](std::stop_token st) { writer_loop(std::move(st)); });
+        }
+    }
+
+    // drains everything still in the hand-off queue and closes the file, a recorder is one-shot
+    void stop() {
+        if (writer_.joinable()) {
+            writer_.request_stop();
+            writer_.join();
+            close_file();
+        }
+    }
+
+    // hot path, called from the disseminator thread
+    inline bool record(const char* topic_buf, const void* payload_data, std::size_t payload_size, uint64_t timestamp_ns) {
+        const uint64_t seq = next_sequence_++;
+        if (payload_size + types::topic_header_size > max_body_size) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // written straight into the queue slot, the message is copied once on this thread
+        const bool queued = handoff_.push_with([&](Frame& frame) {
+            frame.header.timestamp_ns = timestamp_ns;
+            frame.header.sequence = seq;
+            frame.header.record_size = static_cast<uint32_t>(capture::padded_record_size(types::topic_header_size, payload_size));
+            frame.header.payload_size = static_cast<uint16_t>(payload_size);
+            frame.header.tag = topic_buf[0];
+            frame.header.topic_size = types::topic_header_size;
+            std::memcpy(frame.body, topic_buf, types::topic_header_size);
+            std::memcpy(frame.body + types::topic_header_size, payload_data, payload_size);
+        });
+        if (!queued) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] uint64_t recorded() const { return recorded_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    [[nodiscard]] const std::filesystem::path& path() const { return path_; }
+
+private:
+    capture::FileHeader* header() { return reinterpret_cast<capture::FileHeader*>(map_); }
+
+    void map_file(uint64_t size) {
+        // reserve the blocks up front so page faults in the writer don't also have to allocate on disk
+        if (posix_fallocate(fd_, 0, static_cast<off_t>(size)) != 0 && ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            throw std::runtime_error("Failed to preallocate capture file: " + path_.string());
+        }
+        if (map_ != nullptr) {
+            munmap(map_, mapped_size_);
+        }
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) {
+            map_ = nullptr;
+            throw std::runtime_error("Failed to mmap capture file: " + path_.string());
+        }
+        map_ = static_cast<std::byte*>(addr);
+        mapped_size_ = size;
+    }
+
+    void ensure_capacity(uint64_t bytes) {
+        if (write_offset_ + bytes > mapped_size_) {
+            map_file(std::max(mapped_size_ + grow_bytes_, write_offset_ + bytes));
+        }
+    }
+
+    void append(const Frame& frame) {
+        const auto& rh = frame.header;
+        ensure_capacity(rh.record_size);
+
+        std::byte* dst = map_ + write_offset_;
+        std::memcpy(dst, &rh, sizeof(rh));
+        std::memcpy(dst + sizeof(rh), frame.body, rh.topic_size + rh.payload_size);
+
+        if (rh.timestamp_ns >= next_index_ts_ || index_.empty()) {
+            index_.push_back({rh.timestamp_ns, write_offset_, rh.sequence});
+            next_index_ts_ = rh.timestamp_ns + index_interval_ns_;
+        }
+        if (record_count_ == 0) {
+            header()->first_timestamp_ns = rh.timestamp_ns;
+        }
+        last_ts_ = rh.timestamp_ns;
+        write_offset_ += rh.record_size;
+        ++record_count_;
+    }
+
+    void publish_progress() {
+        auto* hdr = header();
+        hdr->record_count = record_count_;
+        hdr->last_timestamp_ns = last_ts_;
+        hdr->data_end = write_offset_;
+        recorded_.store(record_count_, std::memory_order_relaxed);
+    }
+
+    void writer_loop(std::stop_token st) {
+        Frame frame;
+        while (true) {
+            bool wrote = false;
+            while (handoff_.pop(frame)) {
+                append(frame);
+                wrote = true;
+            }
+            if (wrote) {
+                publish_progress();
+            } else if (st.stop_requested()) {
+                break;
+            } else {
+                // writer is not latency sensitive, don't burn a core when the stream is quiet
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    void close_file() {
+        if (fd_ < 0) {
+            return;
+        }
+        if (map_ != nullptr) {
+            const uint64_t index_bytes = index_.size() * sizeof(capture::IndexEntry);
+            ensure_capacity(index_bytes);
+            std::memcpy(map_ + write_offset_, index_.data(), index_bytes);
+
+            publish_progress();
+            auto* hdr = header();
+            hdr->index_offset = write_offset_;
+            hdr->index_count = index_.size();
+
+            const uint64_t final_size = write_offset_ + index_bytes;
+            msync(map_, mapped_size_, MS_SYNC);
+            munmap(map_, mapped_size_);
+            map_ = nullptr;
+            if (ftruncate(fd_, static_cast<off_t>(final_size)) != 0) {
+                spdlog::warn("Failed to truncate capture file {}", path_.string());
+            }
+            spdlog::info("Capture closed: {} records, {} dropped, {} index entries -> {}",
+                         record_count_, dropped(), index_.size(), path_.string());
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    std::filesystem::path path_;
+    int fd_{-1};
+    std::byte* map_{nullptr};
+    uint64_t mapped_size_{0};
+    uint64_t grow_bytes_;
+    uint64_t index_interval_ns_;
+
+    // disseminator thread only
+    uint64_t next_sequence_{0};
+
+    // writer thread only
+    uint64_t write_offset_{0};
+    uint64_t record_count_{0};
+    uint64_t last_ts_{0};
+    uint64_t next_index_ts_{0};
+    std::vector<capture::IndexEntry> index_;
+
+    CustomSpscQueue<Frame, handoff_capacity> handoff_;
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::jthread writer_;
+};
+
+#endif // CAPTURE_RECORDER_H
@@ -0,0 +1,269 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include "../utils/types.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+Same-host market data log in POSIX shared memory (/dev/shm/<name>): one writer, any number of reader processes.
+
+    [RingHeader, one 4 KiB page]
+    [Slot] * slot_count             slot_count a power of two, record n lives in slot n % slot_count
+
+Each slot is a seqlock keyed by the record number, the writer stores 2n+1 before and 2n+2 after writing record n.
+The writer never waits for anybody. A reader keeps its own cursor (nothing is written to the segment, it is
+mapped read-only) and, for its next record c, finds in the slot:
+    < 2c+2   not written yet, nothing new
+    = 2c+2   the record, valid if the seq is still the same after copying it out
+    > 2c+2   the writer has lapped the reader, records were overwritten. The reader counts them as lost and
+             resyncs half a ring behind the writer, which is what a UDP socket buffer overflow looks like too.
+Payload words are relaxed atomics, like LastValueCache, so a torn read is a retry and not a data race.
+ */
+namespace shm {
+    inline constexpr std::array<char, 8> magic{'M', 'D', 'S', 'H', 'R', 'I', 'N', 'G'};
+    inline constexpr uint32_t format_version = 2; // 2: slots hold a trace trailer
+    inline constexpr std::size_t header_page_size = 4096;
+
+    // meta word (payload size, tag), topic padded to 16 so the payload stays aligned, payload
+    inline constexpr std::size_t record_words = 1 + (types::single_frame_header_size + types::max_wire_payload_size + 7) / 8;
+    inline constexpr std::size_t topic_offset = sizeof(uint64_t);
+    inline constexpr std::size_t payload_offset = topic_offset + types::single_frame_header_size;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> words[record_words];
+    };
+
+    struct RingHeader {
+        std::array<char, 8> magic;   // written last, a reader that sees it sees the rest
+        uint32_t version;
+        uint32_t slot_size;
+        uint64_t slot_count;
+        uint64_t created_ns;
+        alignas(64) std::atomic<uint64_t> write_seq; // records published so far
+    };
+    static_assert(sizeof(RingHeader) <= header_page_size);
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "slots are shared between processes");
+
+    inline std::size_t segment_size(uint64_t slot_count) { return header_page_size + slot_count * sizeof(Slot); }
+}
+
+class ShmRingWriter {
+public:
+    // name as for shm_open, e.g. "/mdds_feed". Replaces a segment left behind by an earlier writer.
+    ShmRingWriter(std::string name, uint64_t slot_count) : name_(std::move(name)) {
+        if (slot_count < 2 || !std::has_single_bit(slot_count)) {
+            throw std::invalid_argument("Shared memory ring needs a power of two number of slots");
+        }
+        shm_unlink(name_.c_str()); // readers still on an old segment keep their mapping of it
+        fd_ = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd_ < 0) throw std::runtime_error("Failed to create shared memory segment: " + name_);
+
+        size_ = shm::segment_size(slot_count);
+        if (ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+            cleanup();
+            throw std::runtime_error("Failed to size shared memory segment: " + name_);
+        }
+        void* addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) {
+            cleanup();
+            throw std::runtime_error("Failed to mmap shared memory segment: " + name_);
+        }
+        map_ = static_cast<std::byte*>(addr);
+
+        // fresh pages are zero, which is a valid atomic 0 in every slot
+        header_ = new (map_) shm::RingHeader{};
+        header_->version = shm::format_version;
+        header_->slot_size = sizeof(shm::Slot);
+        header_->slot_count = slot_count;
+        header_->created_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        slots_ = reinterpret_cast<shm::Slot*>(map_ + shm::header_page_size);
+        mask_ = slot_count - 1;
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->magic = shm::magic;
+    }
+
+    ~ShmRingWriter() { cleanup(); }
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    // writer thread only. topic is types::topic_header_size bytes
+    inline void publish(const char* topic, const void* payload, std::size_t payload_size) {
+        uint64_t words[shm::record_words]{};
+        auto* bytes = reinterpret_cast<std::byte*>(words);
+        words[0] = payload_size | (static_cast<uint64_t>(static_cast<uint8_t>(topic[0])) << 16);
+        std::memcpy(bytes + shm::topic_offset, topic, types::topic_header_size);
+        std::memcpy(bytes + shm::payload_offset, payload, payload_size);
+        const std::size_t used = (shm::payload_offset + payload_size + 7) / 8;
+
+        const uint64_t n = next_++;
+        shm::Slot& slot = slots_[n & mask_];
+        slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < used; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(2 * n + 2, std::memory_order_release);
+        header_->write_seq.store(n + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] uint64_t published() const { return next_; }
+    [[nodiscard]] const std::string& name() const { return name_; }
+
+private:
+    void cleanup() {
+        if (map_ != nullptr) munmap(map_, size_);
+        if (fd_ >= 0) {
+            ::close(fd_);
+            shm_unlink(name_.c_str());
+        }
+        map_ = nullptr;
+        fd_ = -1;
+    }
+
+    std::string name_;
+    int fd_{-1};
+    std::size_t size_{0};
+    std::byte* map_{nullptr};
+    shm::RingHeader* header_{nullptr};
+    shm::Slot* slots_{nullptr};
+    uint64_t mask_{0};
+    uint64_t next_{0};
+};
+
+class ShmRingReader {
+public:
+    // maps the writer's segment read-only and starts at its current end, like joining a multicast group
+    explicit ShmRingReader(const std::string& name) {
+        fd_ = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd_ < 0) throw std::runtime_error("No shared memory segment (is the disseminator running?): " + name);
+        struct stat st{};
+        if (fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) < shm::header_page_size) {
+            ::close(fd_);
+            throw std::runtime_error("Shared memory segment too small: " + name);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to mmap shared memory segment: " + name);
+        }
+        map_ = static_cast<const std::byte*>(addr);
+        header_ = reinterpret_cast<const shm::RingHeader*>(map_);
+
+        // the magic is written last, read it first and fence so the rest of the header is not read before it
+        const std::array<char, 8> magic = header_->magic;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (magic != shm::magic || header_->version != shm::format_version ||
+            header_->slot_size != sizeof(shm::Slot) || shm::segment_size(header_->slot_count) > size_) {
+            munmap(const_cast<std::byte*>(map_), size_);
+            ::close(fd_);
+            throw std::runtime_error("Not a market data ring or unsupported version: " + name);
+        }
+        slots_ = reinterpret_cast<const shm::Slot*>(map_ + shm::header_page_size);
+        slot_count_ = header_->slot_count;
+        mask_ = slot_count_ - 1;
+        cursor_ = header_->write_seq.load(std::memory_order_acquire);
+    }
+
+    ~ShmRingReader() {
+        if (map_ != nullptr) munmap(const_cast<std::byte*>(map_), size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    /*
+    Hands up to max new records to fn(tag, topic, payload, payload_size), returns how many. The pointers are into
+    a local copy (payload 8 byte aligned) and valid for the call only.
+     */
+    template <typename Fn>
+    std::size_t poll(Fn&& fn, std::size_t max = 64) {
+        alignas(16) uint64_t words[shm::record_words];
+        const auto* bytes = reinterpret_cast<const std::byte*>(words);
+        std::size_t n = 0;
+        while (n < max) {
+            const shm::Slot& slot = slots_[cursor_ & mask_];
+            const uint64_t expected = 2 * cursor_ + 2;
+            const uint64_t before = slot.seq.load(std::memory_order_acquire);
+            if (before < expected) break;
+            if (before > expected) {
+                resync();
+                continue;
+            }
+
+            words[0] = slot.words[0].load(std::memory_order_relaxed);
+            const std::size_t payload_size = std::min<std::size_t>(words[0] & 0xFFFF, types::max_wire_payload_size);
+            const std::size_t used = (shm::payload_offset + payload_size + 7) / 8;
+            for (std::size_t i = 1; i < used; ++i) {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != before) {
+                resync(); // overwritten while we copied
+                continue;
+            }
+
+            ++cursor_;
+            ++n;
+            fn(static_cast<char>((words[0] >> 16) & 0xFF), reinterpret_cast<const char*>(bytes + shm::topic_offset),
+               bytes + shm::payload_offset, payload_size);
+        }
+        received_ += n;
+        return n;
+    }
+
+    // records still to read, 0 when caught up
+    [[nodiscard]] uint64_t backlog() const { return header_->write_seq.load(std::memory_order_acquire) - cursor_; }
+    [[nodiscard]] uint64_t received() const { return received_; }
+    // records overwritten before this reader got to them
+    [[nodiscard]] uint64_t lost() const { return lost_; }
+    [[nodiscard]] uint64_t overruns() const { return overruns_; }
+    [[nodiscard]] uint64_t slot_count() const { return slot_count_; }
+
+private:
+    void resync() {
+        const uint64_t head = header_->write_seq.load(std::memory_order_acquire);
+        const uint64_t restart = head > slot_count_ / 2 ? head - slot_count_ / 2 : 0;
+        if (restart > cursor_) {
+            lost_ += restart - cursor_;
+            cursor_ = restart;
+        } else {
+            // only with a writer that went backwards (restarted on the same name), step over the record
+            ++lost_;
+            ++cursor_;
+        }
+        ++overruns_;
+    }
+
+    int fd_{-1};
+    std::size_t size_{0};
+    const std::byte* map_{nullptr};
+    const shm::RingHeader* header_{nullptr};
+    const shm::Slot* slots_{nullptr};
+    uint64_t slot_count_{0};
+    uint64_t mask_{0};
+    uint64_t cursor_{0};
+    uint64_t received_{0};
+    uint64_t lost_{0};
+    uint64_t overruns_{0};
+};
+
+#endif // SHM_RING_H
@@ -0,0 +1,325 @@
+#ifndef STATS_SEGMENT_H
+#define STATS_SEGMENT_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../monitor/LiveLatency.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+Run statistics in POSIX shared memory (/dev/shm/<name>, --stats-shm) for an outside viewer (md_top) to map
+read-only while the benchmark runs. Fixed layout, one block per writing thread:
+    header         written once at creation
+    generator      generator thread    messages pushed, failed pushes (queue full), the current target rate
+    disseminator   disseminator thread messages and bytes sent
+    feed handler   receive thread      messages and bytes past the filter, sequence gaps
+    latency        LiveAggregator      cumulative latency histogram of the consumer, the last 1 s window
+Every block starts on its own cache line and only its thread writes it, with relaxed stores and no
+read-modify-write, so the hot threads share no line with each other or with the viewer's reads beyond their own.
+Queue depth is not counted by the queue, the viewer takes it as pushed - sent.
+ */
+namespace shm {
+    inline constexpr std::array<char, 8> stats_magic{'M', 'D', 'S', 'T', 'A', 'T', 'S', '1'};
+    inline constexpr uint32_t stats_version = 2;
+
+    // owning thread only
+    inline void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    struct alignas(64) GeneratorStats {
+        std::atomic<uint64_t> pushed;
+        std::atomic<uint64_t> push_retries;
+        std::atomic<uint64_t> target_rate;   // msgs/s, changes while running with a load profile
+    };
+
+    struct alignas(64) DisseminatorStats {
+        std::atomic<uint64_t> sent;
+        std::atomic<uint64_t> bytes;
+    };
+
+    struct alignas(64) FeedHandlerStats {
+        std::atomic<uint64_t> received;
+        std::atomic<uint64_t> bytes;
+        std::atomic<uint64_t> sequence_gaps; // subscribed to a subset, the filtered out messages count too
+    };
+
+    struct alignas(64) LatencyStats {
+        std::atomic<uint64_t> updated_ns;    // steady_clock, each aggregator pass, a heartbeat for the viewer
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> drops;
+        std::atomic<uint64_t> window_p50_ns;
+        std::atomic<uint64_t> window_p99_ns;
+        std::atomic<uint64_t> window_p999_ns;
+        std::atomic<uint64_t> window_max_ns;
+        std::atomic<uint64_t> window_target_rate;   // msgs/s, mean target over the window, 0 without a generator
+        alignas(64) std::atomic<uint64_t> buckets[LatencyHistogram::bucket_count];
+    };
+
+    struct StatsHeader {
+        std::array<char, 8> magic;   // written last
+        uint32_t version;
+        uint32_t layout_size;
+        uint32_t histogram_buckets;
+        int32_t pid;
+        uint64_t created_ns;         // steady_clock, tells a restarted run from the old one
+        uint64_t queue_capacity;
+        uint32_t target_rate;        // configured, the generator block has the current one
+        char transport[12];
+        char queue[12];
+    };
+
+    struct StatsLayout {
+        alignas(64) StatsHeader header;
+        GeneratorStats generator;
+        DisseminatorStats disseminator;
+        FeedHandlerStats feed_handler;
+        LatencyStats latency;
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "counters are shared between processes");
+    static_assert(offsetof(StatsLayout, generator) % 64 == 0 && offsetof(StatsLayout, disseminator) % 64 == 0 &&
+                  offsetof(StatsLayout, feed_handler) % 64 == 0 && offsetof(StatsLayout, latency) % 64 == 0);
+
+    // LiveAggregator::set_observer target: the cumulative histogram every pass, the window once a second
+    inline void publish_latency(LatencyStats& stats, const LatencyHistogram& total, uint64_t drops,
+                                const LiveAggregator::Report* report) {
+        for (std::size_t i = 0; i < LatencyHistogram::bucket_count; ++i) {
+            if (const uint64_t n = total.bucket(i); n != stats.buckets[i].load(std::memory_order_relaxed)) {
+                stats.buckets[i].store(n, std::memory_order_relaxed);
+            }
+        }
+        stats.count.store(total.count(), std::memory_order_relaxed);
+        stats.drops.store(drops, std::memory_order_relaxed);
+        if (report) {
+            stats.window_p50_ns.store(report->p50_ns, std::memory_order_relaxed);
+            stats.window_p99_ns.store(report->p99_ns, std::memory_order_relaxed);
+            stats.window_p999_ns.store(report->p999_ns, std::memory_order_relaxed);
+            stats.window_max_ns.store(report->max_ns, std::memory_order_relaxed);
+            stats.window_target_rate.store(static_cast<uint64_t>(std::llround(report->target_rate)), std::memory_order_relaxed);
+        }
+        stats.updated_ns.store(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()), std::memory_order_release);
+    }
+
+    struct Drain {
+        bool complete;   // all that was pushed got sent and the receiver got to the last sequence
+        uint64_t pushed;
+        uint64_t sent;
+        uint64_t received;
+        uint64_t gaps;
+        std::chrono::milliseconds waited;
+    };
+
+    // after the generator stopped: until the disseminator has sent all that was pushed and the receiver has the
+    // last sequence sent, received or counted as a gap (sequences start at 1, so then received + gaps == sent).
+    // A transport that lost the tail never gets there, so it also stops once nothing moved for `quiet`.
+    inline Drain wait_drained(const GeneratorStats& generator, const DisseminatorStats& disseminator,
+                              const FeedHandlerStats& feed_handler,
+                              std::chrono::milliseconds quiet = std::chrono::milliseconds(250),
+                              std::chrono::milliseconds limit = std::chrono::seconds(10)) {
+        const auto start = std::chrono::steady_clock::now();
+        auto moved = start;
+        uint64_t progress = 0;
+        while (true) {
+            const uint64_t pushed = generator.pushed.load(std::memory_order_relaxed);
+            const uint64_t sent = disseminator.sent.load(std::memory_order_relaxed);
+            const uint64_t received = feed_handler.received.load(std::memory_order_relaxed);
+            const uint64_t gaps = feed_handler.sequence_gaps.load(std::memory_order_relaxed);
+            const auto now = std::chrono::steady_clock::now();
+            if (sent + received != progress) {
+                progress = sent + received;
+                moved = now;
+            }
+            const bool complete = sent == pushed && received + gaps >= sent;
+            if (complete || now - moved >= quiet || now - start >= limit) {
+                return {complete, pushed, sent, received, gaps,
+                        std::chrono::duration_cast<std::chrono::milliseconds>(now - start)};
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+class StatsSegment {
+public:
+    // name as for shm_open, e.g. "/mdds_stats". Replaces a segment left behind by an earlier run.
+    StatsSegment(std::string name, const char* transport, const char* queue, uint64_t queue_capacity, uint32_t target_rate)
+        : name_(std::move(name)) {
+        shm_unlink(name_.c_str());
+        fd_ = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd_ < 0) throw std::runtime_error("Failed to create stats segment: " + name_);
+        if (ftruncate(fd_, static_cast<off_t>(sizeof(shm::StatsLayout))) != 0) {
+            cleanup();
+            throw std::runtime_error("Failed to size stats segment: " + name_);
+        }
+        void* addr = mmap(nullptr, sizeof(shm::StatsLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) {
+            cleanup();
+            throw std::runtime_error("Failed to mmap stats segment: " + name_);
+        }
+
+        // fresh pages are zero, a valid atomic 0 in every counter
+        stats_ = new (addr) shm::StatsLayout{};
+        shm::StatsHeader& h = stats_->header;
+        h.version = shm::stats_version;
+        h.layout_size = sizeof(shm::StatsLayout);
+        h.histogram_buckets = LatencyHistogram::bucket_count;
+        h.pid = static_cast<int32_t>(getpid());
+        h.created_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        h.queue_capacity = queue_capacity;
+        h.target_rate = target_rate;
+        std::strncpy(h.transport, transport, sizeof(h.transport) - 1);
+        std::strncpy(h.queue, queue, sizeof(h.queue) - 1);
+        std::atomic_thread_fence(std::memory_order_release);
+        h.magic = shm::stats_magic;
+    }
+
+    ~StatsSegment() { cleanup(); }
+
+    StatsSegment(const StatsSegment&) = delete;
+    StatsSegment& operator=(const StatsSegment&) = delete;
+
+    [[nodiscard]] shm::GeneratorStats& generator() { return stats_->generator; }
+    [[nodiscard]] shm::DisseminatorStats& disseminator() { return stats_->disseminator; }
+    [[nodiscard]] shm::FeedHandlerStats& feed_handler() { return stats_->feed_handler; }
+    [[nodiscard]] shm::LatencyStats& latency() { return stats_->latency; }
+    [[nodiscard]] const std::string& name() const { return name_; }
+
+private:
+    void cleanup() {
+        if (stats_ != nullptr) munmap(stats_, sizeof(shm::StatsLayout));
+        if (fd_ >= 0) {
+            ::close(fd_);
+            shm_unlink(name_.c_str());
+        }
+        stats_ = nullptr;
+        fd_ = -1;
+    }
+
+    std::string name_;
+    int fd_{-1};
+    shm::StatsLayout* stats_{nullptr};
+};
+
+// the viewer's side, read-only
+class StatsReader {
+public:
+    // a consistent-enough copy of everything, for computing rates between two of them
+    struct Snapshot {
+        uint64_t taken_ns;
+        uint64_t pushed;
+        uint64_t push_retries;
+        uint64_t target_rate;
+        uint64_t sent;
+        uint64_t sent_bytes;
+        uint64_t received;
+        uint64_t received_bytes;
+        uint64_t sequence_gaps;
+        uint64_t latency_updated_ns;
+        uint64_t latency_drops;
+        uint64_t window_p50_ns;
+        uint64_t window_p99_ns;
+        uint64_t window_p999_ns;
+        uint64_t window_max_ns;
+        uint64_t window_target_rate;
+        LatencyHistogram latency;
+
+        // in the queue between generator and disseminator
+        [[nodiscard]] uint64_t queue_depth() const { return pushed > sent ? pushed - sent : 0; }
+    };
+
+    explicit StatsReader(const std::string& name) {
+        fd_ = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd_ < 0) throw std::runtime_error("No stats segment (is main_simulate running with --stats-shm?): " + name);
+        struct stat st{};
+        if (fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(shm::StatsLayout)) {
+            ::close(fd_);
+            throw std::runtime_error("Stats segment too small or of another version: " + name);
+        }
+        void* addr = mmap(nullptr, sizeof(shm::StatsLayout), PROT_READ, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to mmap stats segment: " + name);
+        }
+        stats_ = static_cast<const shm::StatsLayout*>(addr);
+
+        // magic first, then the fence, then the fields written before it
+        const std::array<char, 8> magic = stats_->header.magic;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const shm::StatsHeader& h = stats_->header;
+        if (magic != shm::stats_magic || h.version != shm::stats_version || h.layout_size != sizeof(shm::StatsLayout) ||
+            h.histogram_buckets != LatencyHistogram::bucket_count) {
+            munmap(const_cast<shm::StatsLayout*>(stats_), sizeof(shm::StatsLayout));
+            ::close(fd_);
+            throw std::runtime_error("Not a stats segment or unsupported version: " + name);
+        }
+    }
+
+    ~StatsReader() {
+        if (stats_ != nullptr) munmap(const_cast<shm::StatsLayout*>(stats_), sizeof(shm::StatsLayout));
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    StatsReader(const StatsReader&) = delete;
+    StatsReader& operator=(const StatsReader&) = delete;
+
+    [[nodiscard]] const shm::StatsHeader& header() const { return stats_->header; }
+
+    // the writer unlinked its segment (run over) or a new run replaced it, this mapping is of a dead one
+    [[nodiscard]] bool replaced(const std::string& name) const {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return true;
+        struct stat now{}, ours{};
+        const bool same = fstat(fd, &now) == 0 && fstat(fd_, &ours) == 0 && now.st_ino == ours.st_ino;
+        ::close(fd);
+        return !same;
+    }
+
+    [[nodiscard]] Snapshot snapshot() const {
+        Snapshot s{};
+        s.taken_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        const shm::LatencyStats& lat = stats_->latency;
+        s.latency_updated_ns = lat.updated_ns.load(std::memory_order_acquire);
+        s.latency_drops = lat.drops.load(std::memory_order_relaxed);
+        s.window_p50_ns = lat.window_p50_ns.load(std::memory_order_relaxed);
+        s.window_p99_ns = lat.window_p99_ns.load(std::memory_order_relaxed);
+        s.window_p999_ns = lat.window_p999_ns.load(std::memory_order_relaxed);
+        s.window_max_ns = lat.window_max_ns.load(std::memory_order_relaxed);
+        s.window_target_rate = lat.window_target_rate.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < LatencyHistogram::bucket_count; ++i) {
+            if (const uint64_t n = lat.buckets[i].load(std::memory_order_relaxed)) s.latency.add(i, n);
+        }
+        // downstream first, what was pushed is read last and comes out >= sent, the depth stays sane
+        s.received = stats_->feed_handler.received.load(std::memory_order_relaxed);
+        s.received_bytes = stats_->feed_handler.bytes.load(std::memory_order_relaxed);
+        s.sequence_gaps = stats_->feed_handler.sequence_gaps.load(std::memory_order_relaxed);
+        s.sent = stats_->disseminator.sent.load(std::memory_order_relaxed);
+        s.sent_bytes = stats_->disseminator.bytes.load(std::memory_order_relaxed);
+        s.pushed = stats_->generator.pushed.load(std::memory_order_relaxed);
+        s.push_retries = stats_->generator.push_retries.load(std::memory_order_relaxed);
+        s.target_rate = stats_->generator.target_rate.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    int fd_{-1};
+    const shm::StatsLayout* stats_{nullptr};
+};
+
+#endif // STATS_SEGMENT_H
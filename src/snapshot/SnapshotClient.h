@@ -0,0 +1,78 @@
+#ifndef SNAPSHOT_CLIENT_H
+#define SNAPSHOT_CLIENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "SnapshotProtocol.h"
+#include "../utils/types.h"
+
+namespace snapshot {
+    // a received snapshot, records still in wire format
+    struct Snapshot {
+        uint64_t sequence{0};
+        uint32_t record_count{0};
+        std::vector<std::byte> records;
+
+        // fn(tag, topic, payload, payload_size) per record
+        template <typename Fn>
+        void for_each(Fn&& fn) const {
+            std::size_t at = 0;
+            while (at + sizeof(RecordHeader) + types::topic_header_size <= records.size()) {
+                RecordHeader rh;
+                std::memcpy(&rh, records.data() + at, sizeof(rh));
+                const std::byte* topic = records.data() + at + sizeof(rh);
+                const std::size_t next = at + sizeof(rh) + types::topic_header_size + rh.payload_size;
+                if (next > records.size()) break;
+                fn(rh.tag, topic, topic + types::topic_header_size, static_cast<std::size_t>(rh.payload_size));
+                at = next;
+            }
+        }
+    };
+
+    // blocking request to a SnapshotServer, throws if it cannot be reached or the answer is malformed
+    inline Snapshot fetch(const std::string& host, unsigned short port,
+                          types::Messages::type_mask wanted = types::Messages::all_types, int timeout_ms = 2000) {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) throw std::runtime_error("Failed to create snapshot client socket");
+
+        timeval timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+
+        Snapshot result;
+        ResponseHeader header{};
+        const Request request{magic, wanted};
+        bool ok = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                  send_all(fd, &request, sizeof(request)) &&
+                  recv_all(fd, &header, sizeof(header)) &&
+                  plausible(header);
+        if (ok) {
+            result.sequence = header.sequence;
+            result.record_count = header.record_count;
+            result.records.resize(header.payload_bytes);
+            ok = recv_all(fd, result.records.data(), result.records.size());
+        }
+        close(fd);
+        if (!ok) {
+            throw std::runtime_error("Snapshot request to " + host + ":" + std::to_string(port) + " failed");
+        }
+        return result;
+    }
+}
+
+#endif // SNAPSHOT_CLIENT_H
@@ -0,0 +1,81 @@
+#ifndef SNAPSHOT_PROTOCOL_H
+#define SNAPSHOT_PROTOCOL_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sys/socket.h>
+#include "../utils/types.h"
+
+/*
+Request/response on the local TCP snapshot channel, one snapshot per connection:
+
+    client -> server    Request
+    server -> client    ResponseHeader | (RecordHeader | topic | payload) * record_count
+
+Records are the same topic + payload as on the live feed, so the receive side decodes them with the same
+dispatch. ResponseHeader::sequence is the last sequence disseminated before the snapshot was taken: every
+message up to it is reflected in the snapshot, later ones may or may not be (each record carries its own).
+Only last-value types are served, order-by-order messages would need a book snapshot.
+ */
+namespace snapshot {
+    inline constexpr uint32_t magic = 0x4e534453; // "SDSN"
+
+    using Types = types::MessageList<types::Quote, types::Trade>;
+
+    struct Request {
+        uint32_t magic;
+        types::Messages::type_mask types;    // of types::Messages, anything outside Types is ignored
+    };
+
+    struct ResponseHeader {
+        uint32_t magic;
+        uint32_t record_count;
+        uint64_t sequence;
+        uint64_t payload_bytes;              // everything behind this header
+    };
+
+    struct RecordHeader {
+        uint16_t payload_size;
+        char tag;
+        uint8_t reserved;
+    };
+
+    inline constexpr std::size_t min_record_size = sizeof(RecordHeader) + types::topic_header_size + Types::min_size;
+    inline constexpr std::size_t max_record_size = sizeof(RecordHeader) + types::topic_header_size + Types::max_size;
+    inline constexpr uint64_t max_payload_bytes = 256ull << 20;   // far above any symbol universe we simulate
+
+    // the client checks a header off the wire with this before it allocates payload_bytes
+    inline bool plausible(const ResponseHeader& header) {
+        return header.magic == magic && header.payload_bytes <= max_payload_bytes &&
+               header.payload_bytes >= header.record_count * min_record_size &&
+               header.payload_bytes <= header.record_count * max_record_size;
+    }
+
+    // blocking full-buffer send/receive, false on error or if the peer went away
+    inline bool send_all(int fd, const void* data, std::size_t size) {
+        auto* p = static_cast<const std::byte*>(data);
+        while (size > 0) {
+            const ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    inline bool recv_all(int fd, void* data, std::size_t size) {
+        auto* p = static_cast<std::byte*>(data);
+        while (size > 0) {
+            const ssize_t n = ::recv(fd, p, size, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+}
+
+#endif // SNAPSHOT_PROTOCOL_H
@@ -0,0 +1,176 @@
+#ifndef SNAPSHOT_SERVER_H
+#define SNAPSHOT_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "SnapshotProtocol.h"
+#include "../feedhandler/LastValueCache.h"
+#include "../utils/types.h"
+
+/*
+Disseminator side state for late joiners: the last message of every snapshot type per symbol id, served over a
+local TCP request channel (see SnapshotProtocol.h).
+The disseminator thread calls record() for every message before sending it, the server thread builds snapshots
+from the seqlock caches without ever stopping the disseminator. Clients are served one at a time.
+ */
+class SnapshotServer {
+public:
+    // port 0 picks a free one, see port()
+    SnapshotServer(unsigned short port, uint32_t id_limit) {
+        std::apply([id_limit](auto&... cache) {
+            ((cache = std::make_unique<typename std::decay_t<decltype(cache)>::element_type>(id_limit)), ...);
+        }, caches_);
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) throw std::runtime_error("Failed to create snapshot socket");
+
+        int opt = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd_, 16) < 0) {
+            close(listen_fd_);
+            throw std::runtime_error("Failed to bind snapshot server to port " + std::to_string(port));
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+    }
+
+    ~SnapshotServer() {
+        stop();
+        if (listen_fd_ >= 0) close(listen_fd_);
+    }
+
+    SnapshotServer(const SnapshotServer&) = delete;
+    SnapshotServer& operator=(const SnapshotServer&) = delete;
+
+    void start() {
+        if (!worker_.joinable()) {
+            worker_ = std::jthread([this](std::stop_token st) { serve_loop(std::move(st)); });
+        }
+    }
+
+    void stop() {
+        if (worker_.joinable()) {
+            worker_.request_stop();
+            worker_.join();
+        }
+    }
+
+    // disseminator thread only, msg.sequence already stamped
+    template <typename T>
+    inline void record(const T& msg) {
+        if constexpr (Types::contains<T>) {
+            std::get<CachePtr<T>>(caches_)->store(msg.symbol_id, msg);
+        }
+        sequence_.store(msg.sequence, std::memory_order_release);
+    }
+
+    /*
+    Appends the records of a snapshot to out and returns its header. The sequence is read before the caches, so
+    everything up to it is in there. Any thread, does not block record().
+     */
+    snapshot::ResponseHeader build(std::vector<std::byte>& out, types::Messages::type_mask wanted = types::Messages::all_types) const {
+        snapshot::ResponseHeader header{snapshot::magic, 0, sequence_.load(std::memory_order_acquire), 0};
+        const std::size_t start = out.size();
+
+        std::apply([&](const auto&... cache) { (append(*cache, wanted, out, header), ...); }, caches_);
+
+        header.payload_bytes = out.size() - start;
+        return header;
+    }
+
+    [[nodiscard]] unsigned short port() const { return port_; }
+    [[nodiscard]] uint64_t sequence() const { return sequence_.load(std::memory_order_acquire); }
+    [[nodiscard]] uint64_t served() const { return served_.load(std::memory_order_relaxed); }
+
+private:
+    using Types = snapshot::Types;
+
+    template <typename T>
+    using CachePtr = std::unique_ptr<LastValueCache<T>>;
+
+    template <typename T>
+    static void append(const LastValueCache<T>& cache, types::Messages::type_mask wanted,
+                       std::vector<std::byte>& out, snapshot::ResponseHeader& header) {
+        if (!(wanted & types::Messages::mask_of<T>)) return;
+
+        constexpr std::size_t record_size = sizeof(snapshot::RecordHeader) + types::topic_header_size + sizeof(T);
+        const snapshot::RecordHeader rh{static_cast<uint16_t>(sizeof(T)), types::Messages::tag_of<T>, 0};
+        out.reserve(out.size() + cache.id_limit() * record_size);
+
+        T msg;
+        for (uint32_t id = 1; id < cache.id_limit(); ++id) {
+            if (!cache.read(id, msg)) continue;
+            const std::size_t at = out.size();
+            out.resize(at + record_size);
+            std::byte* p = out.data() + at;
+            std::memcpy(p, &rh, sizeof(rh));
+            types::Messages::encode_topic(msg, reinterpret_cast<char*>(p + sizeof(rh)));
+            std::memcpy(p + sizeof(rh) + types::topic_header_size, &msg, sizeof(T));
+            ++header.record_count;
+        }
+    }
+
+    void serve_loop(std::stop_token st) {
+        std::vector<std::byte> buffer;
+        while (!st.stop_requested()) {
+            // poll with a timeout so stop() does not have to wait for a client
+            pollfd pfd{listen_fd_, POLLIN, 0};
+            if (poll(&pfd, 1, 100) <= 0) continue;
+
+            const int client = accept(listen_fd_, nullptr, nullptr);
+            if (client < 0) continue;
+
+            // a client that stops reading must not hold up the next one, or stop()
+            timeval timeout{1, 0};
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            snapshot::Request request{};
+            if (snapshot::recv_all(client, &request, sizeof(request)) && request.magic == snapshot::magic) {
+                buffer.clear();
+                const snapshot::ResponseHeader header = build(buffer, request.types);
+                if (snapshot::send_all(client, &header, sizeof(header)) &&
+                    snapshot::send_all(client, buffer.data(), buffer.size())) {
+                    served_.fetch_add(1, std::memory_order_relaxed);
+                    spdlog::debug("Served snapshot at sequence {}: {} records, {} bytes",
+                                  header.sequence, header.record_count, header.payload_bytes);
+                }
+            } else {
+                spdlog::warn("Snapshot server: dropped a client with a bad request");
+            }
+            close(client);
+        }
+    }
+
+    Types::apply<CachePtr> caches_;
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<uint64_t> served_{0};
+    int listen_fd_{-1};
+    unsigned short port_{0};
+    std::jthread worker_;
+};
+
+#endif // SNAPSHOT_SERVER_H
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <cxxopts.hpp>
+#include <spdlog/spdlog.h>
+
+#include "./shm/StatsSegment.h"
+
+/*
+top for a running main_simulate --stats-shm: maps the stats segment read-only and redraws rates, queue depth,
+drops and consumer latency percentiles every interval. The percentiles are over the interval, taken from the
+difference of the cumulative histogram between two refreshes. Waits for the segment to appear, follows a new
+run that replaces it.
+ */
+namespace {
+    std::atomic<bool> interrupted{false};
+
+    double per_sec(uint64_t now, uint64_t before, double seconds) {
+        return seconds > 0 && now >= before ? static_cast<double>(now - before) / seconds : 0.0;
+    }
+
+    double us(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+    void render(const std::string& name, const shm::StatsHeader& h, const StatsReader::Snapshot& prev,
+                const StatsReader::Snapshot& cur, bool clear) {
+        const double dt = static_cast<double>(cur.taken_ns - prev.taken_ns) / 1e9;
+        LatencyHistogram window;
+        for (std::size_t i = 0; i < LatencyHistogram::bucket_count; ++i) {
+            if (cur.latency.bucket(i) > prev.latency.bucket(i)) window.add(i, cur.latency.bucket(i) - prev.latency.bucket(i));
+        }
+        const uint64_t depth = cur.queue_depth();
+        const bool stale = cur.latency_updated_ns != 0 && cur.taken_ns > cur.latency_updated_ns + 2'000'000'000;
+
+        if (clear) std::printf("\x1b[H\x1b[2J");
+        std::printf("md_top %s   pid %d   %s, %s queue of %lu, target %lu msg/s   up %.1f s%s\n\n", name.c_str(), h.pid,
+                    h.transport, h.queue, static_cast<unsigned long>(h.queue_capacity),
+                    static_cast<unsigned long>(cur.target_rate ? cur.target_rate : h.target_rate),
+                    static_cast<double>(cur.taken_ns - h.created_ns) / 1e9, stale ? "   (no updates, stopped?)" : "");
+        std::printf("%-14s %12s %14s %12s\n", "", "msg/s", "total", "MB/s");
+        std::printf("%-14s %12.0f %14lu %12s   push retries/s %.0f\n", "generator", per_sec(cur.pushed, prev.pushed, dt),
+                    static_cast<unsigned long>(cur.pushed), "", per_sec(cur.push_retries, prev.push_retries, dt));
+        std::printf("%-14s %12lu / %lu (%.1f%%)\n", "queue depth", static_cast<unsigned long>(depth),
+                    static_cast<unsigned long>(h.queue_capacity),
+                    h.queue_capacity ? 100.0 * static_cast<double>(depth) / static_cast<double>(h.queue_capacity) : 0.0);
+        std::printf("%-14s %12.0f %14lu %12.2f\n", "disseminator", per_sec(cur.sent, prev.sent, dt),
+                    static_cast<unsigned long>(cur.sent), per_sec(cur.sent_bytes, prev.sent_bytes, dt) / 1e6);
+        std::printf("%-14s %12.0f %14lu %12.2f   sequence gaps %lu (+%lu)\n", "feed handler",
+                    per_sec(cur.received, prev.received, dt), static_cast<unsigned long>(cur.received),
+                    per_sec(cur.received_bytes, prev.received_bytes, dt) / 1e6, static_cast<unsigned long>(cur.sequence_gaps),
+                    static_cast<unsigned long>(cur.sequence_gaps - prev.sequence_gaps));
+        std::printf("\nconsumer latency over %.1f s, %lu msgs, %lu dropped\n", dt, static_cast<unsigned long>(window.count()),
+                    static_cast<unsigned long>(cur.latency_drops - prev.latency_drops));
+        std::printf("  p50 %9.1f us   p99 %9.1f us   p99.9 %9.1f us   max %9.1f us\n", us(window.percentile(0.5)),
+                    us(window.percentile(0.99)), us(window.percentile(0.999)), us(window.max()));
+        std::printf("whole run, %lu msgs\n", static_cast<unsigned long>(cur.latency.count()));
+        std::printf("  p50 %9.1f us   p99 %9.1f us   p99.9 %9.1f us   max %9.1f us\n", us(cur.latency.percentile(0.5)),
+                    us(cur.latency.percentile(0.99)), us(cur.latency.percentile(0.999)), us(cur.latency.max()));
+        std::fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv) {
+    cxxopts::Options options("md_top", "Live view of a main_simulate run started with --stats-shm");
+
+    options.add_options()
+        ("n,name", "Stats segment name", cxxopts::value<std::string>()->default_value("/mdds_stats"))
+        ("i,interval", "Refresh interval in ms", cxxopts::value<uint32_t>()->default_value("1000"))
+        ("once", "Print one refresh and exit, no screen clearing")
+        ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+    const std::string name = result["name"].as<std::string>();
+    const auto interval = std::chrono::milliseconds(std::max<uint32_t>(result["interval"].as<uint32_t>(), 50));
+    const bool once = result.count("once") > 0;
+
+    std::signal(SIGINT, [](int) { interrupted.store(true); });
+    std::signal(SIGTERM, [](int) { interrupted.store(true); });
+
+    std::unique_ptr<StatsReader> reader;
+    StatsReader::Snapshot prev{};
+    bool waiting_logged = false;
+    while (!interrupted.load()) {
+        if (!reader) {
+            try {
+                reader = std::make_unique<StatsReader>(name);
+                prev = reader->snapshot();
+                waiting_logged = false;
+            } catch (const std::exception& e) {
+                if (once) {
+                    spdlog::error("{}", e.what());
+                    return 1;
+                }
+                if (!waiting_logged) spdlog::info("Waiting for {} ({})", name, e.what());
+                waiting_logged = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                continue;
+            }
+        }
+
+        std::this_thread::sleep_for(interval);
+        const StatsReader::Snapshot cur = reader->snapshot();
+        render(name, reader->header(), prev, cur, !once);
+        prev = cur;
+        if (once) break;
+
+        // the run ended (segment unlinked) or another one took the name: keep showing the last numbers until
+        // a new segment is there
+        if (reader->replaced(name)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            try {
+                auto next = std::make_unique<StatsReader>(name);
+                reader = std::move(next);
+                prev = reader->snapshot();
+            } catch (const std::exception&) {
+            }
+        }
+    }
+    return 0;
+}
@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include <memory>
+#include <new>
 
 /*
 since i know that there is only 1 producer and one consumer, and the read_ pointer is only modified from this thread,
@@ -45,6 +46,22 @@ public:
         return true;
     }
 
+    // builds the item in its slot instead of copying a finished one in, fill(T&) gets a default-initialized T
+    template <typename Fill>
+    bool push_with(Fill&& fill) {
+        const std::size_t w = write_.load(std::memory_order_relaxed);
+        const std::size_t r = read_.load(std::memory_order_acquire);
+
+        if (w - r == RealCapacity) {
+            return false;
+        }
+
+        T* slot = ::new (static_cast<void*>(data_ + (w % RealCapacity))) T;
+        fill(*slot);
+        write_.store(w + 1, std::memory_order_release);
+        return true;
+    }
+
     bool pop(T& item) {
         const std::size_t r = read_.load(std::memory_order_relaxed);
         const std::size_t w = write_.load(std::memory_order_acquire);
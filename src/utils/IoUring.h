@@ -0,0 +1,278 @@
+#ifndef IO_URING_H
+#define IO_URING_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/*
+The bits of io_uring the UDP paths need, straight on the kernel interface from <linux/io_uring.h> so there is no
+liburing to install. One thread per ring: SQEs are queued with get_sqe() and published with submit(), completions
+are read out of the mapped CQ ring with for_each_cqe(), which never makes a syscall.
+With sqpoll a kernel thread picks up submissions by itself, submit() only enters the kernel to wake that thread
+after it went idle (sq_thread_idle_ms), so a busy ring makes no syscalls at all. enter_calls() counts the ones made.
+ */
+class IoUring {
+public:
+    struct Options {
+        unsigned entries = 256;         // SQ size, the CQ gets twice that
+        bool sqpoll = false;
+        unsigned sq_thread_idle_ms = 1000;
+    };
+
+    explicit IoUring(Options options) {
+        io_uring_params p{};
+        if (options.sqpoll) {
+            p.flags |= IORING_SETUP_SQPOLL;
+            p.sq_thread_idle = options.sq_thread_idle_ms;
+        }
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, options.entries, &p));
+        if (fd_ < 0) throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+        sqpoll_ = options.sqpoll;
+
+        sq_ring_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        single_mmap_ = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap_) sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        try {
+            sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+            cq_ring_ = single_mmap_ ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+            sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        } catch (...) {
+            release();
+            throw;
+        }
+
+        auto* sq = static_cast<std::byte*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_flags_ = reinterpret_cast<unsigned*>(sq + p.sq_off.flags);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_entries_ = p.sq_entries;
+        // SQEs are always used in ring order, so the indirection array is the identity
+        auto* array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        for (unsigned i = 0; i < p.sq_entries; ++i) array[i] = i;
+
+        auto* cq = static_cast<std::byte*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+        sqe_tail_ = *sq_tail_;
+    }
+
+    ~IoUring() { release(); }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // zeroed SQE to fill in, nullptr if the SQ is full (submit() and reap first)
+    inline io_uring_sqe* get_sqe() {
+        const unsigned head = std::atomic_ref(*sq_head_).load(std::memory_order_acquire);
+        if (sqe_tail_ - head >= sq_entries_) return nullptr;
+        io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+        ++sqe_tail_;
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // publishes the queued SQEs, wait_nr > 0 also blocks until that many completions are there
+    inline void submit(unsigned wait_nr = 0) {
+        const unsigned to_submit = sqe_tail_ - std::atomic_ref(*sq_tail_).load(std::memory_order_relaxed);
+        std::atomic_ref(*sq_tail_).store(sqe_tail_, std::memory_order_release);
+
+        unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+        if (sqpoll_) {
+            // the tail store has to be visible before we look at whether the SQ thread is asleep
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (std::atomic_ref(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_NEED_WAKEUP) {
+                flags |= IORING_ENTER_SQ_WAKEUP;
+            }
+            if (flags == 0) return;
+            enter(0, wait_nr, flags);
+        } else if (to_submit > 0 || wait_nr > 0) {
+            enter(to_submit, wait_nr, flags);
+        }
+    }
+
+    /*
+    Hands up to max completions to fn(const io_uring_cqe&) and retires them. No syscall, except when the CQ ran
+    over: the kernel then parks completions on a list (the last one of a multishot request among them) and only
+    moves them into the CQ on an enter with GETEVENTS.
+     */
+    template <typename Fn>
+    inline unsigned for_each_cqe(Fn&& fn, unsigned max = ~0u) {
+        unsigned head = *cq_head_;
+        unsigned tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+        if (head == tail && (std::atomic_ref(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_CQ_OVERFLOW)) {
+            enter(0, 0, IORING_ENTER_GETEVENTS);
+            tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+        }
+        unsigned n = 0;
+        for (; head != tail && n < max; ++head, ++n) {
+            fn(cqes_[head & cq_mask_]);
+        }
+        if (n > 0) std::atomic_ref(*cq_head_).store(head, std::memory_order_release);
+        return n;
+    }
+
+    // fixed files: SQEs then name the fd by its index here, with IOSQE_FIXED_FILE
+    void register_files(const int* fds, unsigned count) {
+        if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_FILES, fds, count) < 0) {
+            throw std::runtime_error(std::string("io_uring register files failed: ") + std::strerror(errno));
+        }
+    }
+
+    // registered buffers for the *_FIXED opcodes, pinned once instead of mapped per operation
+    void register_buffers(const iovec* buffers, unsigned count) {
+        if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers, count) < 0) {
+            throw std::runtime_error(std::string("io_uring register buffers failed: ") + std::strerror(errno));
+        }
+    }
+
+    [[nodiscard]] uint64_t enter_calls() const { return enter_calls_; }
+    [[nodiscard]] bool sqpoll() const { return sqpoll_; }
+
+private:
+    void* map(std::size_t size, off_t offset) {
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        if (addr == MAP_FAILED) throw std::runtime_error(std::string("io_uring mmap failed: ") + std::strerror(errno));
+        return addr;
+    }
+
+    void release() {
+        if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+        if (cq_ring_ != nullptr && !single_mmap_) munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+        if (fd_ >= 0) ::close(fd_);
+        sqes_ = nullptr;
+        cq_ring_ = sq_ring_ = nullptr;
+        fd_ = -1;
+    }
+
+    inline void enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        ++enter_calls_;
+        while (syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, flags, nullptr, 0) < 0 && errno == EINTR) {}
+    }
+
+    int fd_{-1};
+    bool sqpoll_{false};
+    bool single_mmap_{false};
+    std::size_t sq_ring_size_{0}, cq_ring_size_{0}, sqes_size_{0};
+    void* sq_ring_{nullptr};
+    void* cq_ring_{nullptr};
+    io_uring_sqe* sqes_{nullptr};
+
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_flags_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned sq_entries_{0};
+    unsigned sqe_tail_{0};
+
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe* cqes_{nullptr};
+
+    uint64_t enter_calls_{0};
+};
+
+/*
+Provided buffers: a pool of equally sized receive buffers the kernel picks from per completion, the CQE says which
+one (buffer id), so a multishot recv needs no buffer of its own. Buffers are handed back with recycle(); commit()
+queues one IORING_OP_PROVIDE_BUFFERS per run of consecutive ids and submits them, which normally is one SQE per
+batch since the kernel hands the ids out in order.
+Classic provided buffers rather than a mapped ring (IORING_REGISTER_PBUF_RING): on the 6.18 test kernel every recv
+against a registered ring completed with ENOBUFS, the classic kind works on anything since 5.7.
+lead offsets every buffer's start, same trick as the plain UDP receive loop to get the payload behind the 10 byte
+topic aligned. A failed hand back posts a completion with provide_tag.
+ */
+class IoUringProvidedBuffers {
+public:
+    static constexpr uint64_t provide_tag = ~uint64_t{0};
+
+    IoUringProvidedBuffers(IoUring& ring, uint16_t group, unsigned count, std::size_t stride, std::size_t lead)
+        : ring_(ring), group_(group), count_(count), stride_(stride), lead_(lead) {
+        if (count == 0 || count > 65535 || lead >= stride) {
+            throw std::invalid_argument("io_uring provided buffers need 1..65535 buffers and lead < stride");
+        }
+        // the buffers sit back to back, shifted by lead as a whole
+        data_size_ = count * stride + lead;
+        void* d = mmap(nullptr, data_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (d == MAP_FAILED) throw std::runtime_error("Failed to map io_uring receive buffers");
+        data_ = static_cast<std::byte*>(d);
+
+        provide(0, count);
+        ring_.submit();
+    }
+
+    // must outlive the requests using it, i.e. be destroyed after the IoUring has been closed
+    ~IoUringProvidedBuffers() { munmap(data_, data_size_); }
+
+    IoUringProvidedBuffers(const IoUringProvidedBuffers&) = delete;
+    IoUringProvidedBuffers& operator=(const IoUringProvidedBuffers&) = delete;
+
+    [[nodiscard]] inline const std::byte* buffer(uint16_t bid) const { return data_ + lead_ + bid * stride_; }
+    [[nodiscard]] std::size_t buffer_size() const { return stride_; }
+    [[nodiscard]] unsigned count() const { return count_; }
+
+    inline void recycle(uint16_t bid) {
+        if (run_length_ > 0 && bid == run_start_ + run_length_) {
+            ++run_length_;
+            return;
+        }
+        if (run_length_ > 0) provide(run_start_, run_length_);
+        run_start_ = bid;
+        run_length_ = 1;
+    }
+
+    inline void commit() {
+        if (run_length_ == 0) return;
+        provide(run_start_, run_length_);
+        run_length_ = 0;
+        ring_.submit();
+    }
+
+private:
+    inline void provide(unsigned first, unsigned n) {
+        io_uring_sqe* sqe = ring_.get_sqe();
+        while (sqe == nullptr) {
+            ring_.submit();
+            sqe = ring_.get_sqe();
+        }
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = static_cast<int>(n);
+        sqe->addr = reinterpret_cast<uint64_t>(data_ + lead_ + first * stride_);
+        sqe->len = static_cast<uint32_t>(stride_);
+        sqe->off = first;
+        sqe->buf_group = group_;
+        sqe->flags = IOSQE_CQE_SKIP_SUCCESS; // only failures take a CQ slot
+        sqe->user_data = provide_tag;
+    }
+
+    IoUring& ring_;
+    std::byte* data_{nullptr};
+    std::size_t data_size_{0};
+    uint16_t group_;
+    unsigned count_;
+    std::size_t stride_;
+    std::size_t lead_;
+    unsigned run_start_{0};
+    unsigned run_length_{0};
+};
+
+#endif // IO_URING_H
@@ -0,0 +1,182 @@
+#ifndef MESSAGE_REGISTRY_H
+#define MESSAGE_REGISTRY_H
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+
+/*
+Compile-time registry of the message types on the wire.
+Every message type specialises MessageTraits<T> with its one-char tag and a name, and is listed once in
+types::Messages. Everything else is generated from that list:
+    - the MarketDataMsg variant and the max payload size
+    - topic encoding on the disseminator side
+    - a 256-entry jump table from tag to decoder, one per visitor type, so receive loops do a single
+      indirect call instead of walking an if/else chain
+    - one callback slot per type in IFeedHandler
+Adding a message is: define the struct, specialise MessageTraits, append it to the list. No transport changes.
+ */
+namespace types {
+    template <typename T>
+    struct MessageTraits;
+
+    template <typename T>
+    concept WireMessage = std::is_trivially_copyable_v<T> && requires(const T& msg) {
+        { MessageTraits<T>::tag } -> std::convertible_to<char>;
+        { MessageTraits<T>::name } -> std::convertible_to<const char*>;
+        msg.symbol;
+        msg.symbol_id;
+        msg.sequence;
+    };
+
+    template <WireMessage... Ms>
+    struct MessageList {
+        using variant = std::variant<Ms...>;
+
+        template <typename T>
+        using callback = std::function<void(const T&, uint64_t)>;
+        using callback_slots = std::tuple<callback<Ms>...>;
+
+        // std::tuple<W<Ms>...>, one W per message type
+        template <template <typename> class W>
+        using apply = std::tuple<W<Ms>...>;
+
+        static constexpr std::size_t count = sizeof...(Ms);
+        static constexpr std::size_t max_size = std::max({sizeof(Ms)...});
+        static constexpr std::size_t min_size = std::min({sizeof(Ms)...});
+        static constexpr std::size_t max_align = std::max({alignof(Ms)...});
+        static constexpr std::array<char, count> tags{MessageTraits<Ms>::tag...};
+
+        template <typename T>
+        static constexpr bool contains = (std::is_same_v<T, Ms> || ...);
+
+        // F can be called as f(msg, timestamp) with at least one of the types
+        template <typename F>
+        static constexpr bool any_invocable = (std::is_invocable_v<F, const Ms&, uint64_t> || ...);
+
+        template <typename T>
+        static constexpr char tag_of = MessageTraits<T>::tag;
+
+        // position of T in the list
+        template <typename T>
+            requires (contains<T>)
+        static constexpr std::size_t index_of = [] {
+            std::size_t i = 0;
+            (void)((std::is_same_v<T, Ms> ? true : (++i, false)) || ...);
+            return i;
+        }();
+
+        // one bit per type, used by subscriptions to filter on message type
+        using type_mask = uint32_t;
+        static_assert(count <= 32, "type_mask has one bit per message type");
+
+        template <typename... Ts>
+        static constexpr type_mask mask_of = ((type_mask{1} << index_of<Ts>) | ... | type_mask{0});
+        static constexpr type_mask all_types = mask_of<Ms...>;
+
+        // 0 for tags that are not registered
+        static constexpr type_mask bit_of_tag(char tag) {
+            return tag_bits[static_cast<unsigned char>(tag)];
+        }
+
+        static constexpr bool unique_tags() {
+            for (std::size_t i = 0; i < count; ++i)
+                for (std::size_t j = i + 1; j < count; ++j)
+                    if (tags[i] == tags[j]) return false;
+            return true;
+        }
+
+        static constexpr bool symbol_id_at(std::size_t offset) {
+            return ((offsetof(Ms, symbol_id) == offset) && ...);
+        }
+
+        static constexpr bool sequence_at(std::size_t offset) {
+            return ((offsetof(Ms, sequence) == offset) && ...);
+        }
+
+        // "Q:SYMBOL" style topic, the prefix ZMQ subscriptions and the UDP filter match on
+        template <typename T>
+        static inline void encode_topic(const T& msg, char* topic_buf) {
+            topic_buf[0] = MessageTraits<T>::tag;
+            topic_buf[1] = ':';
+            std::memcpy(&topic_buf[2], msg.symbol, 8);
+        }
+
+        template <typename T>
+        static inline bool decode(const void* payload, std::size_t size, T& out) {
+            if (size != sizeof(T)) return false;
+            std::memcpy(&out, payload, sizeof(T));
+            return true;
+        }
+
+        // true if payload can be read as a T where it lies, receive buffers are laid out so that it can
+        template <typename T>
+        static inline bool is_aligned(const void* payload) {
+            return reinterpret_cast<std::uintptr_t>(payload) % alignof(T) == 0;
+        }
+
+        // calls fn.template operator()<T>() for every registered type, in list order
+        template <typename Fn>
+        static constexpr void for_each_type(Fn&& fn) {
+            (fn.template operator()<Ms>(), ...);
+        }
+
+        /*
+        decodes payload by tag and hands the message to visitor, false for unknown tags or size mismatch.
+        If the payload is suitably aligned the visitor gets a view straight into the buffer, otherwise a copy.
+        Either way the reference is only valid for the duration of the call.
+         */
+        template <typename Visitor>
+        static inline bool dispatch(char tag, const void* payload, std::size_t size, Visitor&& visitor) {
+            using V = std::remove_reference_t<Visitor>;
+            return DispatchTable<V>::table[static_cast<unsigned char>(tag)](payload, size, visitor);
+        }
+
+    private:
+        static constexpr std::array<type_mask, 256> tag_bits = [] {
+            std::array<type_mask, 256> t{};
+            ((t[static_cast<unsigned char>(MessageTraits<Ms>::tag)] = mask_of<Ms>), ...);
+            return t;
+        }();
+
+        template <typename V>
+        struct DispatchTable {
+            using Fn = bool (*)(const void*, std::size_t, V&);
+
+            template <typename T>
+            static bool decode_and_visit(const void* payload, std::size_t size, V& visitor) {
+                if (size != sizeof(T)) return false;
+                if (is_aligned<T>(payload)) {
+                    // the bytes came off the wire from the same struct, T is trivially copyable
+                    visitor(*std::launder(reinterpret_cast<const T*>(payload)));
+                } else {
+                    T msg;
+                    std::memcpy(&msg, payload, sizeof(T));
+                    visitor(msg);
+                }
+                return true;
+            }
+
+            static bool reject(const void*, std::size_t, V&) { return false; }
+
+            static constexpr std::array<Fn, 256> make() {
+                std::array<Fn, 256> t{};
+                t.fill(&reject);
+                ((t[static_cast<unsigned char>(MessageTraits<Ms>::tag)] = &decode_and_visit<Ms>), ...);
+                return t;
+            }
+
+            static constexpr std::array<Fn, 256> table = make();
+        };
+    };
+}
+
+#endif // MESSAGE_REGISTRY_H
@@ -23,7 +23,8 @@ public:
         return false;
     }
     
-    [[nodiscard]] bool empty() const { return queue_.empty(); }
+    // not const, boost::lockfree::spsc_queue::empty() isn't
+    [[nodiscard]] bool empty() { return queue_.empty(); }
 
 private:
     UnderlyingQueue_T queue_;
@@ -0,0 +1,166 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "../generator/LoadProfile.h"
+
+/*
+Parameter sweep (--sweep): a grid of main_simulate options, every combination is one run in the same process.
+    --sweep "transport=udp,shm; size=1024,65536; rate=100000,500000"
+or the name of a file with one axis per line, `key = v1, v2`, # starts a comment. Keys are the long option
+names (without --), the last axis changes fastest. Everything the grid does not set comes from the rest of the
+command line.
+ */
+namespace sweep {
+    struct Axis {
+        std::string key;
+        std::vector<std::string> values;
+    };
+
+    // one value per axis, in the order of the axes
+    using Point = std::vector<std::pair<std::string, std::string>>;
+
+    namespace detail {
+        inline std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+            return s;
+        }
+
+        template <typename T>
+        T number(const std::string& key, const std::string& value) {
+            T v{};
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), v);
+            if (ec != std::errc{} || end != value.data() + value.size()) {
+                throw std::invalid_argument("Sweep: '" + value + "' is not a valid " + key);
+            }
+            return v;
+        }
+
+        inline bool flag(const std::string& key, const std::string& value) {
+            if (value == "on" || value == "true" || value == "1") return true;
+            if (value == "off" || value == "false" || value == "0") return false;
+            throw std::invalid_argument("Sweep: " + key + " takes on or off, not '" + value + "'");
+        }
+    }
+
+    // the options a grid can vary, parsed like on the command line
+    inline void apply(BenchmarkConfig& config, const std::string& key, const std::string& value) {
+        if (key == "queue") config.queue_strategy = parse_queue_strategy(value);
+        else if (key == "size") config.queue_size = detail::number<std::size_t>(key, value);
+        else if (key == "underlying") config.underlying_queue = parse_underlying_queue(value);
+        else if (key == "transport") config.transport = parse_transport(value);
+        else if (key == "rate") config.message_rate = detail::number<uint32_t>(key, value);
+        else if (key == "duration") config.duration_sec = detail::number<uint32_t>(key, value);
+        else if (key == "profile") {
+            // a value is also part of the run's directory name, so only the built-in shapes
+            if (!LoadProfile::is_builtin(value)) throw std::invalid_argument("Sweep: profile is ramp, step, spike or sine");
+            config.profile = value;
+        }
+        else if (key == "generator") config.generator = parse_generator_kind(value);
+        else if (key == "udp-io") config.udp_io = parse_udp_io_mode(value);
+        else if (key == "udp-batch") config.udp_batch = detail::number<unsigned>(key, value);
+        else if (key == "udp-gso") config.udp_gso = detail::flag(key, value);
+        else if (key == "udp-gro") config.udp_gro = detail::flag(key, value);
+        else if (key == "conflate") config.conflate = detail::flag(key, value);
+        else if (key == "consumer-rate") config.consumer_rate = detail::number<uint32_t>(key, value);
+        else if (key == "shm-slots") config.shm_slots = detail::number<uint64_t>(key, value);
+        else if (key == "zmq-sndhwm") config.zmq_sndhwm = detail::number<int>(key, value);
+        else if (key == "zmq-rcvhwm") config.zmq_rcvhwm = detail::number<int>(key, value);
+        else if (key == "latency-format") {
+            if (value != "csv" && value != "binary") throw std::invalid_argument("Sweep: latency-format is csv or binary");
+            config.binary_latencies = value == "binary";
+        } else {
+            throw std::invalid_argument("Sweep: '" + key + "' cannot be swept. Use queue, size, underlying, transport, rate, "
+                                        "duration, profile, generator, udp-io, udp-batch, udp-gso, udp-gro, conflate, consumer-rate, "
+                                        "shm-slots, zmq-sndhwm, zmq-rcvhwm or latency-format.");
+        }
+    }
+
+    // axes separated by ';' or newlines. Every value is tried on a scratch config, so a typo fails here and
+    // not hours into the sweep
+    inline std::vector<Axis> parse(std::string_view spec) {
+        std::vector<Axis> axes;
+        while (!spec.empty()) {
+            const std::size_t end = spec.find_first_of(";\n");
+            std::string_view line = spec.substr(0, end);
+            spec = end == std::string_view::npos ? std::string_view{} : spec.substr(end + 1);
+            if (const std::size_t hash = line.find('#'); hash != std::string_view::npos) line = line.substr(0, hash);
+            line = detail::trim(line);
+            if (line.empty()) continue;
+
+            const std::size_t eq = line.find('=');
+            if (eq == std::string_view::npos) throw std::invalid_argument("Sweep: expected key=values, got '" + std::string(line) + "'");
+            Axis axis{std::string(detail::trim(line.substr(0, eq))), {}};
+            if (axis.key.starts_with("--")) axis.key.erase(0, 2);
+            std::string_view values = line.substr(eq + 1);
+            while (true) {
+                const std::size_t comma = values.find(',');
+                const std::string_view v = detail::trim(values.substr(0, comma));
+                if (!v.empty()) axis.values.emplace_back(v);
+                if (comma == std::string_view::npos) break;
+                values.remove_prefix(comma + 1);
+            }
+            if (axis.values.empty()) throw std::invalid_argument("Sweep: no values for " + axis.key);
+            if (std::any_of(axes.begin(), axes.end(), [&](const Axis& a) { return a.key == axis.key; })) {
+                throw std::invalid_argument("Sweep: " + axis.key + " given twice");
+            }
+            BenchmarkConfig scratch;
+            for (const std::string& v : axis.values) apply(scratch, axis.key, v);
+            axes.push_back(std::move(axis));
+        }
+        if (axes.empty()) throw std::invalid_argument("Sweep: empty grid");
+        return axes;
+    }
+
+    // --sweep takes the grid itself or a file holding it
+    inline std::vector<Axis> load(const std::string& spec_or_file) {
+        if (spec_or_file.find('=') == std::string::npos && std::filesystem::is_regular_file(spec_or_file)) {
+            std::ifstream in(spec_or_file);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            return parse(ss.str());
+        }
+        return parse(spec_or_file);
+    }
+
+    inline std::vector<Point> expand(const std::vector<Axis>& axes) {
+        std::vector<Point> points{{}};
+        for (const Axis& axis : axes) {
+            std::vector<Point> next;
+            next.reserve(points.size() * axis.values.size());
+            for (const Point& p : points) {
+                for (const std::string& v : axis.values) {
+                    next.push_back(p);
+                    next.back().emplace_back(axis.key, v);
+                }
+            }
+            points = std::move(next);
+        }
+        return points;
+    }
+
+    // directory name of a run, "003_transport-shm_rate-500000"
+    inline std::string label(std::size_t index, const Point& point) {
+        std::string s = std::to_string(index + 1);
+        s.insert(0, s.size() < 3 ? 3 - s.size() : 0, '0');
+        for (const auto& [key, value] : point) {
+            s += "_" + key + "-" + value;
+        }
+        return s;
+    }
+}
+
+#endif // SWEEP_H
@@ -0,0 +1,81 @@
+#ifndef SYMBOL_DIRECTORY_H
+#define SYMBOL_DIRECTORY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+
+/*
+Dense symbol ids shared by both ends of the pipeline: the id of a symbol is its position among the symbols kept by
+read_file(), counting from 1 so that a zeroed message reads as types::no_symbol_id. Empty lines and names longer
+than 8 chars are skipped without taking an id, so this is not the line number once the file has any of those.
+Generators stamp it into every message (symbol_id), the feed handler uses it to index flat per-symbol arrays
+(subscription bitmap, last value cache) instead of hashing the 8 char symbol.
+Both sides only agree if they load the same file. Arrays indexed by id need id_limit() slots, slot 0 unused.
+ */
+class SymbolDirectory {
+public:
+    SymbolDirectory() = default;
+
+    explicit SymbolDirectory(std::vector<std::string> symbols) : symbols_(std::move(symbols)) {
+        ids_.reserve(symbols_.size());
+        for (std::size_t i = 0; i < symbols_.size(); ++i) {
+            ids_.try_emplace(pack(symbols_[i]), static_cast<uint32_t>(i + 1));
+        }
+    }
+
+    static SymbolDirectory from_file(const std::filesystem::path& filename) {
+        return SymbolDirectory(read_file(filename));
+    }
+
+    // one symbol per line, whitespace stripped, anything longer than 8 chars is skipped
+    static std::vector<std::string> read_file(const std::filesystem::path& filename) {
+        std::vector<std::string> tickers;
+        std::ifstream file(filename);
+        std::string str;
+
+        // had some problems with linux/windows CRLF vs R so now strip all
+        while (std::getline(file, str)) {
+            str.erase(std::remove(str.begin(), str.end(), '\r'), str.end());
+            str.erase(std::remove(str.begin(), str.end(), '\n'), str.end());
+
+            str.erase(std::remove_if(str.begin(), str.end(), ::isspace), str.end());
+
+            if (!str.empty() && str.length() < 9) {
+                tickers.push_back(str);
+            }
+        }
+        return tickers;
+    }
+
+    [[nodiscard]] uint32_t id_of(std::string_view symbol) const {
+        const auto it = ids_.find(pack(symbol));
+        return it == ids_.end() ? types::no_symbol_id : it->second;
+    }
+
+    // id must be in [1, id_limit())
+    [[nodiscard]] const std::string& symbol(uint32_t id) const { return symbols_[id - 1]; }
+    [[nodiscard]] uint32_t id_limit() const { return static_cast<uint32_t>(symbols_.size() + 1); }
+    [[nodiscard]] const std::vector<std::string>& symbols() const { return symbols_; }
+    [[nodiscard]] std::size_t size() const { return symbols_.size(); }
+    [[nodiscard]] bool empty() const { return symbols_.empty(); }
+
+private:
+    static uint64_t pack(std::string_view sym) {
+        uint64_t id = 0;
+        std::memcpy(&id, sym.data(), std::min(sym.size(), std::size_t{8}));
+        return id;
+    }
+
+    std::vector<std::string> symbols_;
+    std::unordered_map<uint64_t, uint32_t> ids_;
+};
+
+#endif // SYMBOL_DIRECTORY_H
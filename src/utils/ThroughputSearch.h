@@ -0,0 +1,161 @@
+#ifndef THROUGHPUT_SEARCH_H
+#define THROUGHPUT_SEARCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+/*
+Maximum sustainable rate under latency and loss SLOs (--search). A rate is tried with a few short trials,
+each a whole pipeline run whose first warm-up part is left out of the numbers:
+    judge()       pass or fail once the 95% confidence interval of the trial means is clear of the limit on
+                  every SLO, unsure while it still straddles one (then the caller runs another trial)
+    RateSearch    doubles the rate from the start rate until one fails, then bisects between the last pass and
+                  the first fail until they are within the resolution
+ */
+namespace search {
+    struct Slo {
+        double p99_us;
+        double loss_pct;
+        double min_delivered = 0.98; // received / (rate * duration), below it the pipeline did not keep up
+    };
+
+    // what one trial measured, after the warm-up
+    struct Trial {
+        uint32_t rate;
+        double p50_us;
+        double p99_us;
+        double p999_us;
+        double loss_pct;
+        double delivered;            // fraction of rate * duration that reached the receiver
+    };
+
+    enum class Verdict { Pass, Fail, Unsure };
+
+    inline const char* verdict_name(Verdict v) {
+        switch (v) {
+            case Verdict::Pass: return "pass";
+            case Verdict::Fail: return "fail";
+            case Verdict::Unsure: return "unsure";
+        }
+        return "?";
+    }
+
+    // two-sided 95% Student t for n - 1 degrees of freedom
+    inline double t95(std::size_t n) {
+        static constexpr double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228};
+        if (n < 2) return std::numeric_limits<double>::infinity();
+        return n - 1 <= std::size(table) ? table[n - 2] : 1.96;
+    }
+
+    struct Interval {
+        double mean;
+        double half_width;
+    };
+
+    template <typename Field>
+    Interval interval(const std::vector<Trial>& trials, Field field) {
+        const double n = static_cast<double>(trials.size());
+        double mean = 0;
+        for (const Trial& t : trials) mean += t.*field;
+        mean /= n;
+        double ss = 0;
+        for (const Trial& t : trials) ss += (t.*field - mean) * (t.*field - mean);
+        const double sd = trials.size() > 1 ? std::sqrt(ss / (n - 1)) : 0.0;
+        // zero width for identical trials, and for a single one: the caller decides how many make a sample
+        const double half = sd == 0.0 ? 0.0 : t95(trials.size()) * sd / std::sqrt(n);
+        return {mean, half};
+    }
+
+    // confident: pass needs every SLO met with the interval, fail needs one missed with it
+    inline Verdict judge(const std::vector<Trial>& trials, const Slo& slo) {
+        if (trials.empty()) return Verdict::Unsure;
+        const Interval p99 = interval(trials, &Trial::p99_us);
+        const Interval loss = interval(trials, &Trial::loss_pct);
+        const Interval delivered = interval(trials, &Trial::delivered);
+
+        if (p99.mean - p99.half_width > slo.p99_us || loss.mean - loss.half_width > slo.loss_pct ||
+            delivered.mean + delivered.half_width < slo.min_delivered) {
+            return Verdict::Fail;
+        }
+        if (p99.mean + p99.half_width <= slo.p99_us && loss.mean + loss.half_width <= slo.loss_pct &&
+            delivered.mean - delivered.half_width >= slo.min_delivered) {
+            return Verdict::Pass;
+        }
+        return Verdict::Unsure;
+    }
+
+    // out of trials and still unsure: the means decide
+    inline bool passes_on_means(const std::vector<Trial>& trials, const Slo& slo) {
+        return !trials.empty() && interval(trials, &Trial::p99_us).mean <= slo.p99_us &&
+               interval(trials, &Trial::loss_pct).mean <= slo.loss_pct &&
+               interval(trials, &Trial::delivered).mean >= slo.min_delivered;
+    }
+
+    class RateSearch {
+    public:
+        RateSearch(uint32_t start_rate, uint32_t max_rate, double resolution = 0.05)
+            : next_(start_rate), max_(max_rate), resolution_(resolution) {
+            if (start_rate == 0 || max_rate < start_rate) {
+                throw std::invalid_argument("Search: needs 0 < start rate <= max rate.");
+            }
+        }
+
+        // the rate to try next, none once the search is done
+        [[nodiscard]] std::optional<uint32_t> next() const {
+            if (done_) return std::nullopt;
+            return next_;
+        }
+
+        void report(uint32_t rate, bool pass) {
+            if (pass) {
+                best_ = std::max(best_, rate);
+                if (failed_ == 0) {
+                    // still ramping
+                    if (rate >= max_) {
+                        capped_ = true;
+                        done_ = true;
+                        return;
+                    }
+                    next_ = static_cast<uint32_t>(std::min<uint64_t>(uint64_t{rate} * 2, max_));
+                    return;
+                }
+            } else {
+                failed_ = failed_ == 0 ? rate : std::min(failed_, rate);
+                if (best_ == 0) {
+                    // not even the start rate holds
+                    done_ = true;
+                    return;
+                }
+            }
+            if (failed_ - best_ <= std::max<uint32_t>(static_cast<uint32_t>(resolution_ * best_), 1)) {
+                done_ = true;
+                return;
+            }
+            next_ = best_ + (failed_ - best_) / 2;
+        }
+
+        // highest rate that passed, 0 if none did
+        [[nodiscard]] uint32_t best() const { return best_; }
+        // lowest that failed, 0 if none did
+        [[nodiscard]] uint32_t first_failed() const { return failed_; }
+        // the max rate passed, the knee is somewhere above it
+        [[nodiscard]] bool capped() const { return capped_; }
+
+    private:
+        uint32_t next_;
+        uint32_t max_;
+        double resolution_;
+        uint32_t best_{0};
+        uint32_t failed_{0};
+        bool capped_{false};
+        bool done_{false};
+    };
+}
+
+#endif // THROUGHPUT_SEARCH_H
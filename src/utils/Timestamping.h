@@ -0,0 +1,215 @@
+#ifndef TIMESTAMPING_H
+#define TIMESTAMPING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+
+/*
+Kernel packet timestamps (SO_TIMESTAMPING), to split the user space send -> receive time of a datagram into
+    tx stack   our send call up to the driver handing the packet to the device (TX software stamp)
+    wire       device to device, TX stamp -> RX stamp
+    rx stack   the receiving stack picking the packet up -> our receive loop delivering it (RX software stamp)
+Hardware asks the NIC for both stamps (SOF_TIMESTAMPING_RAW_HARDWARE) and falls back to the software ones per
+packet. The NIC has to have timestamping switched on (hwstamp_ctl / SIOCSHWTSTAMP) and its clock has to follow
+CLOCK_REALTIME (phc2sys), otherwise its stamps are in a different time base.
+Kernel stamps are CLOCK_REALTIME, everything else here is steady_clock (CLOCK_MONOTONIC): to_steady_ns() moves
+them over with the offset between the two clocks at the time of conversion.
+ */
+enum class KernelTimestamps {
+    Off,
+    Software,
+    Hardware
+};
+
+inline KernelTimestamps parse_kernel_timestamps(std::string_view s) {
+    if (s == "off") return KernelTimestamps::Off;
+    if (s == "software" || s == "sw") return KernelTimestamps::Software;
+    if (s == "hardware" || s == "hw") return KernelTimestamps::Hardware;
+    throw std::invalid_argument("Invalid kernel timestamps. Use 'off', 'software' or 'hardware'.");
+}
+
+inline const char* kernel_timestamps_name(KernelTimestamps mode) {
+    switch (mode) {
+        case KernelTimestamps::Off: return "off";
+        case KernelTimestamps::Software: return "software";
+        case KernelTimestamps::Hardware: return "hardware";
+    }
+    return "?";
+}
+
+namespace timestamping {
+    inline int64_t ns_of(const timespec& ts) {
+        return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+    }
+
+    // CLOCK_REALTIME - CLOCK_MONOTONIC right now, the realtime read taken between two monotonic ones
+    inline int64_t realtime_offset_ns() {
+        timespec mono_before{}, real{}, mono_after{};
+        clock_gettime(CLOCK_MONOTONIC, &mono_before);
+        clock_gettime(CLOCK_REALTIME, &real);
+        clock_gettime(CLOCK_MONOTONIC, &mono_after);
+        return ns_of(real) - (ns_of(mono_before) + ns_of(mono_after)) / 2;
+    }
+
+    // a kernel stamp on the steady_clock time line, 0 stays 0 (no stamp)
+    inline uint64_t to_steady_ns(int64_t realtime_ns, int64_t offset_ns) {
+        return realtime_ns == 0 ? 0 : static_cast<uint64_t>(realtime_ns - offset_ns);
+    }
+
+    // control buffer room for one SCM_TIMESTAMPING message
+    inline constexpr std::size_t control_size = CMSG_SPACE(sizeof(scm_timestamping));
+
+    inline void enable(int fd, KernelTimestamps mode, bool tx, bool rx) {
+        if (mode == KernelTimestamps::Off) return;
+        unsigned flags = SOF_TIMESTAMPING_SOFTWARE;
+        if (tx) flags |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+        if (rx) flags |= SOF_TIMESTAMPING_RX_SOFTWARE;
+        if (mode == KernelTimestamps::Hardware) {
+            flags |= SOF_TIMESTAMPING_RAW_HARDWARE;
+            if (tx) flags |= SOF_TIMESTAMPING_TX_HARDWARE;
+            if (rx) flags |= SOF_TIMESTAMPING_RX_HARDWARE;
+        }
+        if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) {
+            throw std::runtime_error(std::string("Failed to enable SO_TIMESTAMPING: ") + std::strerror(errno));
+        }
+    }
+
+    // CLOCK_REALTIME ns out of the SCM_TIMESTAMPING message, the hardware stamp when there is one and it was
+    // asked for, 0 if the message has none
+    inline int64_t realtime_ns(const msghdr& msg, KernelTimestamps mode) {
+        for (const cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(const_cast<msghdr*>(&msg), const_cast<cmsghdr*>(cm))) {
+            if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_TIMESTAMPING) continue;
+            scm_timestamping stamps;
+            std::memcpy(&stamps, CMSG_DATA(cm), sizeof(stamps));
+            if (mode == KernelTimestamps::Hardware && ns_of(stamps.ts[2]) != 0) return ns_of(stamps.ts[2]);
+            return ns_of(stamps.ts[0]);
+        }
+        return 0;
+    }
+}
+
+/*
+Collects the TX stamps of a socket off its error queue on a thread of its own, so the send path pays nothing
+but a note per send. With SOF_TIMESTAMPING_OPT_ID the kernel numbers the sends of the socket 0, 1, 2 ...
+(a GSO buffer is one send, a sendmmsg one per datagram) and hands that number back with the stamp;
+on_send() records which message sequences the next number covers.
+The numbering relies on every noted send reaching the kernel: after a failed send the stamps of later
+messages are attributed one send off.
+ */
+class TxTimestampCollector {
+public:
+    TxTimestampCollector(int fd, KernelTimestamps mode, std::size_t expected_messages = 0)
+        : fd_(fd), mode_(mode), pending_(std::make_unique<Pending[]>(pending_size)) {
+        timestamping::enable(fd, mode, true, false);
+        stamps_.reserve(expected_messages + 1);
+        thread_ = std::jthread([this](std::stop_token st) { run(st); });
+    }
+
+    ~TxTimestampCollector() { stop(); }
+
+    TxTimestampCollector(const TxTimestampCollector&) = delete;
+    TxTimestampCollector& operator=(const TxTimestampCollector&) = delete;
+
+    // sender thread, before the send: the next send carries the messages with sequences [first, first + count)
+    inline void on_send(uint64_t first_sequence, uint32_t count) {
+        Pending& p = pending_[next_id_ & (pending_size - 1)];
+        p.first_sequence.store(first_sequence, std::memory_order_relaxed);
+        p.count.store(count, std::memory_order_relaxed);
+        p.id.store(next_id_, std::memory_order_release);
+        ++next_id_;
+    }
+
+    // waits a moment for the last stamps, then stops the collector thread
+    void stop() {
+        if (!thread_.joinable()) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        thread_.request_stop();
+        thread_.join();
+    }
+
+    // after stop(): steady_clock ns the message with this sequence went out, 0 if no stamp came back for it
+    [[nodiscard]] uint64_t tx_ns(uint64_t sequence) const {
+        return sequence < stamps_.size() ? stamps_[sequence] : 0;
+    }
+
+    [[nodiscard]] uint64_t collected() const { return collected_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t unmatched() const { return unmatched_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t pending_size = 65536; // sends the collector may fall behind by
+
+    struct Pending {
+        std::atomic<uint64_t> id{~uint64_t{0}};
+        std::atomic<uint64_t> first_sequence{0};
+        std::atomic<uint32_t> count{0};
+    };
+
+    void run(const std::stop_token& st) {
+        alignas(cmsghdr) char control[timestamping::control_size + CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in))];
+        while (!st.stop_requested()) {
+            // the error queue filling up raises POLLERR, nothing needs to be asked for
+            pollfd pfd{fd_, 0, 0};
+            if (poll(&pfd, 1, 10) <= 0) continue;
+
+            while (true) {
+                msghdr msg{};
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+                if (recvmsg(fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+                take(msg, timestamping::realtime_offset_ns());
+            }
+        }
+    }
+
+    void take(const msghdr& msg, int64_t offset) {
+        const int64_t realtime = timestamping::realtime_ns(msg, mode_);
+        for (const cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(const_cast<msghdr*>(&msg), const_cast<cmsghdr*>(cm))) {
+            if (cm->cmsg_level != SOL_IP || cm->cmsg_type != IP_RECVERR) continue;
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+            if (err.ee_origin != SO_EE_ORIGIN_TIMESTAMPING || realtime == 0) continue;
+
+            // ee_data is the low 32 bits of the send number
+            const Pending& p = pending_[err.ee_data & (pending_size - 1)];
+            const uint64_t id = p.id.load(std::memory_order_acquire);
+            if (static_cast<uint32_t>(id) != err.ee_data) {
+                unmatched_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            const uint64_t first = p.first_sequence.load(std::memory_order_relaxed);
+            const uint32_t count = p.count.load(std::memory_order_relaxed);
+            if (stamps_.size() < first + count) stamps_.resize(std::max(first + count, stamps_.size() * 2), 0);
+            const uint64_t steady = timestamping::to_steady_ns(realtime, offset);
+            for (uint64_t s = first; s < first + count; ++s) stamps_[s] = steady;
+            collected_.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+
+    int fd_;
+    KernelTimestamps mode_;
+    std::unique_ptr<Pending[]> pending_;
+    uint64_t next_id_{0};               // sender thread
+    std::vector<uint64_t> stamps_;      // by sequence, collector thread until stop()
+    std::atomic<uint64_t> collected_{0};
+    std::atomic<uint64_t> unmatched_{0};
+    std::jthread thread_;
+};
+
+#endif // TIMESTAMPING_H
@@ -0,0 +1,124 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.h"
+
+/*
+Per-stage tracing of messages through the pipeline (--trace). Each enabled types::TracePoint is a steady_clock
+stamp in a types::TraceTrailer that travels with the message:
+    generator      intended (the pacing schedule), generated, enqueued -> into the TraceLog slot of the message
+    disseminator   dequeued, pre-send from its slot, then sends the trailer behind the payload; post-send is
+                   only known after the send and stays in the TraceLog
+    feed handler   strips the trailer off the packet, stamps received; the consumer stamps delivered
+Latencies measured from the intended time instead of the enqueue time include the time a stalled generator
+(full queue, late wakeup) held the message back. Measuring from the enqueue time hides exactly those delays,
+coordinated omission: the generator stops sending while the system is slow, so the slow period is sampled less.
+ */
+namespace trace {
+    using PointMask = uint32_t;
+
+    inline constexpr PointMask bit(types::TracePoint point) { return PointMask{1} << static_cast<unsigned>(point); }
+    inline constexpr PointMask all_points = (PointMask{1} << types::trace_point_count) - 1;
+
+    inline constexpr const char* point_names[types::trace_point_count] = {
+        "intended", "generated", "enqueued", "dequeued", "pre_send", "post_send", "received", "delivered"
+    };
+
+    // "all", "off" or a comma separated list of point names
+    inline PointMask parse_points(std::string_view s) {
+        if (s == "all") return all_points;
+        if (s == "off" || s.empty()) return 0;
+        PointMask mask = 0;
+        while (!s.empty()) {
+            const std::size_t comma = s.find(',');
+            const std::string_view name = s.substr(0, comma);
+            bool found = false;
+            for (std::size_t i = 0; i < types::trace_point_count; ++i) {
+                if (name == point_names[i]) {
+                    mask |= PointMask{1} << i;
+                    found = true;
+                }
+            }
+            if (!found) throw std::invalid_argument("Unknown trace point '" + std::string(name) + "'.");
+            if (comma == std::string_view::npos) break;
+            s.remove_prefix(comma + 1);
+        }
+        return mask;
+    }
+
+    inline uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // stamps the point if the trailer asks for it
+    inline void stamp(types::TraceTrailer& trailer, types::TracePoint point, uint64_t ns) {
+        if (trailer.points & bit(point)) trailer.stamps[static_cast<std::size_t>(point)] = ns;
+    }
+
+    inline void stamp(types::TraceTrailer& trailer, types::TracePoint point) {
+        if (trailer.points & bit(point)) trailer.stamps[static_cast<std::size_t>(point)] = now_ns();
+    }
+
+    inline uint64_t at(const types::TraceTrailer& trailer, types::TracePoint point) {
+        return trailer.stamps[static_cast<std::size_t>(point)];
+    }
+}
+
+/*
+Hand over of the trailers between the generator and the disseminator of one pipeline. The queue is FIFO and
+nothing else pushes into it, so the k-th message the generator pushes is the one the disseminator numbers
+sequence k; the generator fills slot k before the push and the queue's own push/pop ordering publishes it.
+The ring only has to cover what can sit in the queue. Post-send stamps are kept by sequence for the whole run.
+ */
+class TraceLog {
+public:
+    TraceLog(trace::PointMask points, std::size_t queue_capacity, std::size_t expected_messages = 0)
+        : points_(points), slots_(std::bit_ceil(2 * queue_capacity + 2)), mask_(slots_.size() - 1) {
+        if (points_ & trace::bit(types::TracePoint::PostSend)) post_send_.reserve(expected_messages + 1);
+    }
+
+    [[nodiscard]] trace::PointMask points() const { return points_; }
+
+    // generator thread: a fresh trailer for the next message it pushes
+    types::TraceTrailer& next_generated() {
+        types::TraceTrailer& t = slots_[++generated_ & mask_];
+        t = types::TraceTrailer{};
+        t.points = points_;
+        return t;
+    }
+
+    // disseminator thread, sequence as it numbers the messages
+    types::TraceTrailer& slot(uint64_t sequence) { return slots_[sequence & mask_]; }
+
+    // disseminator thread
+    inline void record_post_send(uint64_t sequence, uint64_t ns) {
+        if (!(points_ & trace::bit(types::TracePoint::PostSend))) return;
+        if (post_send_.size() <= sequence) post_send_.resize(std::max<std::size_t>(sequence + 1, post_send_.size() * 2), 0);
+        post_send_[sequence] = ns;
+    }
+
+    // after the disseminator has stopped, 0 if not recorded
+    [[nodiscard]] uint64_t post_send(uint64_t sequence) const {
+        return sequence < post_send_.size() ? post_send_[sequence] : 0;
+    }
+
+private:
+    trace::PointMask points_;
+    std::vector<types::TraceTrailer> slots_;
+    std::size_t mask_;
+    uint64_t generated_{0};
+    std::vector<uint64_t> post_send_;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,68 @@
+#ifndef UDP_IO_H
+#define UDP_IO_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include "Timestamping.h"
+
+/*
+How the UDP disseminator and feed handler talk to the kernel, to compare the three on one machine.
+    Syscall    sendto/recvfrom, one syscall per datagram (the original paths)
+    Batched    sendmmsg/recvmmsg, up to batch datagrams per syscall. The disseminator flushes when its queue
+               runs dry, so a batch never waits for traffic that isn't there.
+    IoUring    io_uring with a fixed file: sends are WRITE_FIXED from registered buffers, submitted batch at a
+               time; the receive side is one multishot recv picking from provided buffers. With sqpoll the
+               kernel polls the submission queue and the hot threads make no syscalls at all.
+On top of syscall or batched:
+    gso        the disseminator packs runs of equal sized datagrams into one buffer and sends it with UDP_SEGMENT,
+               the stack is walked once per run and the kernel (or the NIC) cuts it into datagrams
+    gro        the feed handler enables UDP_GRO and takes coalesced runs with recvmsg, splitting them at the
+               segment size the kernel reports. Replaces recvfrom/recvmmsg, the kernel already did the batching.
+    timestamps SO_TIMESTAMPING on both sockets (see Timestamping.h): TX stamps off the disseminator's error queue,
+               RX stamps with every receive. Splits the send -> receive time into tx stack, wire and rx stack.
+ */
+enum class UdpIoMode {
+    Syscall,
+    Batched,
+    IoUring
+};
+
+struct UdpIoOptions {
+    UdpIoMode mode = UdpIoMode::Syscall;
+    unsigned batch = 64;           // datagrams per sendmmsg/recvmmsg or io_uring submission
+    bool sqpoll = false;           // io_uring only
+    unsigned ring_entries = 1024;  // io_uring SQ size, also the number of send slots / receive buffers
+    bool gso = false;              // send side, not with io_uring
+    bool gro = false;              // receive side, not with io_uring
+    KernelTimestamps timestamps = KernelTimestamps::Off; // not with io_uring
+};
+
+// datagrams per UDP_SEGMENT send, the kernel's UDP_MAX_SEGMENTS on older kernels
+inline constexpr unsigned udp_gso_max_segments = 64;
+
+// what one UDP path did, syscalls next to messages is the number the modes are compared on
+struct UdpIoStats {
+    uint64_t messages{0};
+    uint64_t syscalls{0};
+    uint64_t errors{0};
+};
+
+inline UdpIoMode parse_udp_io_mode(std::string_view s) {
+    if (s == "syscall") return UdpIoMode::Syscall;
+    if (s == "batched" || s == "mmsg") return UdpIoMode::Batched;
+    if (s == "uring" || s == "io_uring") return UdpIoMode::IoUring;
+    throw std::invalid_argument("Invalid UDP I/O mode. Use 'syscall', 'batched' or 'uring'.");
+}
+
+inline const char* udp_io_mode_name(UdpIoMode mode) {
+    switch (mode) {
+        case UdpIoMode::Syscall: return "syscall";
+        case UdpIoMode::Batched: return "batched";
+        case UdpIoMode::IoUring: return "io_uring";
+    }
+    return "?";
+}
+
+#endif // UDP_IO_H
@@ -2,7 +2,11 @@
 #define CONFIG_H
 
 #include <string>
+#include <string_view>
+#include <stdexcept>
 #include <cstdint>
+#include "UdpIo.h"
+#include "Trace.h"
 
 enum class QueueWaitStrategy {
     Spin,
@@ -11,25 +15,120 @@ enum class QueueWaitStrategy {
 
 enum class TransportProtocol {
     UdpMulticast,
-    Zmq
+    Zmq,
+    SharedMemory
 };
+
+inline const char* transport_name(TransportProtocol t) {
+    switch (t) {
+        case TransportProtocol::UdpMulticast: return "UDP";
+        case TransportProtocol::Zmq: return "ZMQ";
+        case TransportProtocol::SharedMemory: return "SHM";
+    }
+    return "?";
+}
 enum class UnderlyingQueue {
     Custom,
     Boost
 };
+enum class GeneratorKind {
+    RandomWalk,
+    Replay,
+    OrderBook
+};
+
+// the command line spellings, also what a sweep grid (--sweep) uses
+inline QueueWaitStrategy parse_queue_strategy(std::string_view s) {
+    if (s == "spin") return QueueWaitStrategy::Spin;
+    if (s == "waitable") return QueueWaitStrategy::Waitable;
+    throw std::invalid_argument("Invalid queue type. Use 'spin' or 'waitable'.");
+}
+
+inline const char* queue_strategy_name(QueueWaitStrategy q) {
+    return q == QueueWaitStrategy::Spin ? "spin" : "waitable";
+}
+
+inline UnderlyingQueue parse_underlying_queue(std::string_view s) {
+    if (s == "custom") return UnderlyingQueue::Custom;
+    if (s == "boost") return UnderlyingQueue::Boost;
+    throw std::invalid_argument("Invalid underlying queue. Use 'custom' or 'boost'.");
+}
+
+inline const char* underlying_queue_name(UnderlyingQueue u) {
+    return u == UnderlyingQueue::Custom ? "custom" : "boost";
+}
+
+inline TransportProtocol parse_transport(std::string_view s) {
+    if (s == "udp") return TransportProtocol::UdpMulticast;
+    if (s == "zmq") return TransportProtocol::Zmq;
+    if (s == "shm") return TransportProtocol::SharedMemory;
+    throw std::invalid_argument("Invalid transport type. Use 'udp', 'zmq' or 'shm'.");
+}
+
+inline GeneratorKind parse_generator_kind(std::string_view s) {
+    if (s == "randomwalk") return GeneratorKind::RandomWalk;
+    if (s == "replay") return GeneratorKind::Replay;
+    if (s == "orderbook") return GeneratorKind::OrderBook;
+    throw std::invalid_argument("Invalid generator. Use 'randomwalk', 'replay' or 'orderbook'.");
+}
+
+inline const char* generator_kind_name(GeneratorKind g) {
+    switch (g) {
+        case GeneratorKind::RandomWalk: return "randomwalk";
+        case GeneratorKind::Replay: return "replay";
+        case GeneratorKind::OrderBook: return "orderbook";
+    }
+    return "?";
+}
 struct BenchmarkConfig {
     QueueWaitStrategy queue_strategy = QueueWaitStrategy::Spin;
     TransportProtocol transport = TransportProtocol::UdpMulticast;
     UnderlyingQueue underlying_queue = UnderlyingQueue::Custom;
+    GeneratorKind generator = GeneratorKind::RandomWalk;
     std::size_t queue_size = 1024;
     uint32_t message_rate = 10000;
     uint32_t duration_sec = 10;
+    std::string profile;              // target rate over time instead of the fixed rate, see generator/LoadProfile.h
     
     std::string ip_address = "239.192.1.1";
     unsigned short port = 5555;
 
     std::string symbols_file = "tickers.txt";
     std::string out_dir = "../data";
+    std::string record_file;   // empty -> no capture
+    std::string replay_file;
+    double replay_speed = 1.0; // <= 0 -> as fast as possible
+    unsigned short snapshot_port = 0; // 0 -> no snapshot server
+    bool conflate = false;            // quote conflation stage in front of the consumer
+    uint32_t consumer_rate = 0;       // msgs/sec the consumer takes out of it, 0 -> unthrottled
+    bool zmq_single_frame = false;    // topic and payload in one zmq frame
+    bool zmq_zero_copy = false;       // zmq sends from a pooled buffer ring
+    std::string zmq_endpoints;        // comma separated PUB binds (tcp/ipc/inproc), empty -> tcp://127.0.0.1:<port>
+    int zmq_io_threads = 1;           // per zmq context
+    int zmq_subscribers = 1;          // feed handlers on the one PUB, only the first feeds the latency monitor
+    int zmq_sndhwm = 1000;            // 0 -> unlimited
+    int zmq_rcvhwm = 1000;
+    int zmq_sndbuf = 0;               // 0 -> OS default
+    UdpIoMode udp_io = UdpIoMode::Syscall;
+    unsigned udp_batch = 64;          // datagrams per sendmmsg/recvmmsg or io_uring submission
+    bool udp_sqpoll = false;          // io_uring submission queue polled by a kernel thread
+    bool udp_gso = false;             // disseminator coalesces runs of datagrams into UDP_SEGMENT sends
+    bool udp_gro = false;             // feed handler takes coalesced runs (UDP_GRO) and splits them
+    KernelTimestamps udp_timestamping = KernelTimestamps::Off; // SO_TIMESTAMPING on both UDP sockets
+    trace::PointMask trace_points = 0; // per-stage tracing, 0 -> off
+    bool live = false;                // live percentiles every second, see monitor/LiveLatency.h
+    uint32_t live_interval_ms = 100;  // how often the aggregator collects the recorders
+    std::string stats_shm;            // shared memory stats segment for md_top, empty -> off
+    bool binary_latencies = false;    // stream latencies.mdlat instead of the per-type CSVs at the end
+    std::string sweep;                // grid or grid file, one run per combination, see utils/Sweep.h
+    bool search = false;              // max sustainable rate under the SLOs, see utils/ThroughputSearch.h
+    double slo_p99_us = 100.0;
+    double slo_loss_pct = 0.01;
+    uint32_t search_max_rate = 5'000'000;
+    uint32_t search_trials = 3;       // per rate before judging, up to twice as many while unsure
+    uint32_t warmup_ms = 500;         // left out of each trial's numbers
+    std::string shm_name = "/mdds_feed";
+    uint64_t shm_slots = 65536;       // power of two
 };
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -6,13 +6,27 @@
 #define TYPES_H
 
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <variant>
+#include "MessageRegistry.h"
 
 namespace types {
+    // dense id of the symbol, its line in the shared symbols file counting from 1 (see SymbolDirectory), 0 if
+    // unknown. Same offset in every message so the receive side can read it without decoding the type first.
+    inline constexpr uint32_t no_symbol_id = 0;
+    inline constexpr std::size_t symbol_id_offset = 8;
+
+    // position in the disseminated stream, stamped by the disseminator counting from 1 (0 = never sent).
+    // Lets a late joiner splice a snapshot with the live stream, see SnapshotServer and SnapshotSplicer.
+    inline constexpr std::size_t sequence_offset = 16;
+
     struct Quote {
         char symbol[8];
+        uint32_t symbol_id{no_symbol_id};
+        uint64_t sequence{0};
         double bid_price;
         double ask_price;
         uint32_t bid_size;
@@ -24,14 +38,111 @@ namespace types {
 
     struct Trade {
         char symbol[8];
+        uint32_t symbol_id{no_symbol_id};
+        uint64_t sequence{0};
+        double price;
+        uint32_t size;
+        uint64_t enqueue_timestamp;
+        uint64_t disseminate_timestamp{0};
+    };
+
+    // Order-by-order (level 2) messages, the consumer rebuilds the book per symbol from these.
+    // Prices stay on the price_tick grid so the book builder can index levels by tick.
+    inline constexpr double price_tick = 0.01;
+
+    enum class Side : uint8_t {
+        Buy,
+        Sell
+    };
+
+    struct OrderAdd {
+        char symbol[8];
+        uint32_t symbol_id{no_symbol_id};
+        uint64_t sequence{0};
+        uint64_t order_id;
+        double price;
+        uint32_t size;
+        Side side;
+        uint64_t enqueue_timestamp;
+        uint64_t disseminate_timestamp{0};
+    };
+
+    // replaces price and size of a resting order, side stays the same
+    struct OrderModify {
+        char symbol[8];
+        uint32_t symbol_id{no_symbol_id};
+        uint64_t sequence{0};
+        uint64_t order_id;
         double price;
         uint32_t size;
         uint64_t enqueue_timestamp;
         uint64_t disseminate_timestamp{0};
     };
 
-    using MarketDataMsg = std::variant<Quote, Trade>;
+    struct OrderCancel {
+        char symbol[8];
+        uint32_t symbol_id{no_symbol_id};
+        uint64_t sequence{0};
+        uint64_t order_id;
+        uint64_t enqueue_timestamp;
+        uint64_t disseminate_timestamp{0};
+    };
+
+    struct OrderExecute {
+        char symbol[8];
+        uint32_t symbol_id{no_symbol_id};
+        uint64_t sequence{0};
+        uint64_t order_id;
+        uint32_t executed_size;
+        uint64_t enqueue_timestamp;
+        uint64_t disseminate_timestamp{0};
+    };
+
+    template <> struct MessageTraits<Quote>        { static constexpr char tag = 'Q'; static constexpr const char* name = "Quote"; };
+    template <> struct MessageTraits<Trade>        { static constexpr char tag = 'T'; static constexpr const char* name = "Trade"; };
+    template <> struct MessageTraits<OrderAdd>     { static constexpr char tag = 'A'; static constexpr const char* name = "OrderAdd"; };
+    template <> struct MessageTraits<OrderModify>  { static constexpr char tag = 'M'; static constexpr const char* name = "OrderModify"; };
+    template <> struct MessageTraits<OrderCancel>  { static constexpr char tag = 'X'; static constexpr const char* name = "OrderCancel"; };
+    template <> struct MessageTraits<OrderExecute> { static constexpr char tag = 'E'; static constexpr const char* name = "OrderExecute"; };
+
+    // the one place a new message type has to be registered
+    using Messages = MessageList<Quote, Trade, OrderAdd, OrderModify, OrderCancel, OrderExecute>;
+    static_assert(Messages::unique_tags(), "two message types share a tag");
+    static_assert(Messages::symbol_id_at(symbol_id_offset), "symbol_id must directly follow the symbol");
+    static_assert(Messages::sequence_at(sequence_offset), "sequence must directly follow the symbol_id");
+
+    using MarketDataMsg = Messages::variant;
     inline constexpr int topic_header_size = 10; // e.g., Q:APPL ...
+    // single-frame zmq messages: topic padded to 16 so the payload behind it stays 8 byte aligned
+    inline constexpr std::size_t single_frame_header_size = 16;
+
+    inline constexpr std::size_t max_payload_size = Messages::max_size;
+
+    // stages a traced message is stamped at on its way through, see utils/Trace.h
+    enum class TracePoint : uint8_t {
+        Intended,   // when the generator's pacing schedule meant to send it
+        Generated,
+        Enqueued,   // the push that made it into the queue
+        Dequeued,
+        PreSend,
+        PostSend,   // send call returned, kept on the sender side (after the trailer went out)
+        Received,   // receive loop handing the packet to dispatch
+        Delivered   // consumer callback
+    };
+    inline constexpr std::size_t trace_point_count = 8;
+    inline constexpr uint32_t trace_magic = 0x54524331; // "TRC1"
+
+    // optional telemetry behind the payload of a traced message. The receive side recognises it by the magic,
+    // which sits last so it is at the end of the packet, and strips it before decoding the payload.
+    struct TraceTrailer {
+        uint64_t stamps[trace_point_count]{}; // steady_clock ns by TracePoint, 0 = not taken
+        uint32_t points{0};                   // TracePoint bits that are being stamped
+        uint32_t magic{trace_magic};
+    };
+    static_assert(sizeof(TraceTrailer) == trace_point_count * 8 + 8);
+
+    // what transports have to make room for, payload plus trailer
+    inline constexpr std::size_t max_wire_payload_size = max_payload_size + sizeof(TraceTrailer);
 }
 
 
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "../src/recorder/CaptureRecorder.h"
+#include "../src/utils/types.h"
+
+class CaptureRecorderTest : public ::testing::Test {
+protected:
+    std::filesystem::path path_ = "test_capture.mdcap";
+
+    void TearDown() override {
+        if (std::filesystem::exists(path_)) std::filesystem::remove(path_);
+    }
+
+    std::vector<char> read_file() {
+        std::ifstream f(path_, std::ios::binary);
+        return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+    }
+
+    static void make_topic(char* topic, char tag, const char* symbol) {
+        std::memset(topic, 0, types::topic_header_size);
+        topic[0] = tag;
+        topic[1] = ':';
+        std::memcpy(topic + 2, symbol, std::strlen(symbol));
+    }
+};
+
+TEST_F(CaptureRecorderTest, WritesHeaderRecordsAndIndex) {
+    constexpr int N = 1000;
+    {
+        CaptureRecorder recorder(path_, 1 << 16, 100);
+        recorder.start();
+
+        char topic[types::topic_header_size];
+        for (int i = 0; i < N; ++i) {
+            types::Quote q{};
+            std::strncpy(q.symbol, "AAPL", sizeof(q.symbol) - 1);
+            q.bid_price = i;
+            make_topic(topic, 'Q', "AAPL");
+            ASSERT_TRUE(recorder.record(topic, &q, sizeof(q), 1000 + i * 10));
+        }
+        recorder.stop();
+        EXPECT_EQ(recorder.recorded(), N);
+        EXPECT_EQ(recorder.dropped(), 0);
+    }
+
+    const auto bytes = read_file();
+    ASSERT_GE(bytes.size(), sizeof(capture::FileHeader));
+    capture::FileHeader hdr;
+    std::memcpy(&hdr, bytes.data(), sizeof(hdr));
+
+    ASSERT_TRUE(capture::is_valid_header(hdr));
+    EXPECT_EQ(hdr.record_count, N);
+    EXPECT_EQ(hdr.first_timestamp_ns, 1000);
+    EXPECT_EQ(hdr.last_timestamp_ns, 1000 + (N - 1) * 10);
+    EXPECT_EQ(hdr.schema_count, 6);
+    EXPECT_EQ(hdr.schema[0].payload_size, sizeof(types::Quote));
+    EXPECT_EQ(hdr.index_count, 100);  // one entry every 10 records at a 100ns interval
+    EXPECT_EQ(bytes.size(), hdr.index_offset + hdr.index_count * sizeof(capture::IndexEntry));
+
+    // walk the records and check the payloads came through in order
+    uint64_t offset = hdr.data_offset;
+    for (int i = 0; i < N; ++i) {
+        capture::RecordHeader rh;
+        std::memcpy(&rh, bytes.data() + offset, sizeof(rh));
+        ASSERT_EQ(rh.sequence, static_cast<uint64_t>(i));
+        ASSERT_EQ(rh.tag, 'Q');
+        types::Quote q;
+        std::memcpy(&q, bytes.data() + offset + sizeof(rh) + rh.topic_size, sizeof(q));
+        ASSERT_DOUBLE_EQ(q.bid_price, i);
+        offset += rh.record_size;
+    }
+    EXPECT_EQ(offset, hdr.data_end);
+}
+
+TEST_F(CaptureRecorderTest, IndexSeeksCloseToTimestamp) {
+    {
+        CaptureRecorder recorder(path_, 1 << 16, 1000);
+        recorder.start();
+        char topic[types::topic_header_size];
+        make_topic(topic, 'T', "MSFT");
+        types::Trade t{};
+        for (int i = 0; i < 10'000; ++i) {
+            recorder.record(topic, &t, sizeof(t), i * 100);
+        }
+    }
+
+    const auto bytes = read_file();
+    capture::FileHeader hdr;
+    std::memcpy(&hdr, bytes.data(), sizeof(hdr));
+    const auto* index = reinterpret_cast<const capture::IndexEntry*>(bytes.data() + hdr.index_offset);
+
+    const uint64_t offset = capture::seek_offset(hdr, index, 500'050);
+    capture::RecordHeader rh;
+    std::memcpy(&rh, bytes.data() + offset, sizeof(rh));
+    EXPECT_LE(rh.timestamp_ns, 500'050);
+    EXPECT_GT(rh.timestamp_ns + hdr.index_interval_ns, 500'050);
+
+    EXPECT_EQ(capture::seek_offset(hdr, index, 0), hdr.data_offset);
+}
+
+TEST_F(CaptureRecorderTest, GrowsPastPreallocation) {
+    constexpr int N = 5000;
+    {
+        // 64KiB preallocation is far smaller than 5000 records
+        CaptureRecorder recorder(path_, 1 << 16);
+        recorder.start();
+        char topic[types::topic_header_size];
+        make_topic(topic, 'Q', "NVDA");
+        types::Quote q{};
+        for (int i = 0; i < N; ++i) {
+            recorder.record(topic, &q, sizeof(q), i);
+        }
+    }
+
+    const auto bytes = read_file();
+    capture::FileHeader hdr;
+    std::memcpy(&hdr, bytes.data(), sizeof(hdr));
+    EXPECT_EQ(hdr.record_count, N);
+    EXPECT_GT(hdr.data_end, uint64_t{1} << 16);
+}
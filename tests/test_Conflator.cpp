@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../src/feedhandler/Conflator.h"
+
+namespace {
+    types::Quote conflator_quote(const char* symbol, uint32_t id, double bid) {
+        types::Quote q{};
+        std::strncpy(q.symbol, symbol, sizeof(q.symbol) - 1);
+        q.symbol_id = id;
+        q.bid_price = bid;
+        return q;
+    }
+
+    struct Collected {
+        std::vector<types::Quote> quotes;
+        std::vector<types::Trade> trades;
+
+        void operator()(const types::Quote& q, uint64_t) { quotes.push_back(q); }
+        void operator()(const types::Trade& t, uint64_t) { trades.push_back(t); }
+        template <typename T>
+        void operator()(const T&, uint64_t) {}
+    };
+}
+
+TEST(ConflatorTest, KeepsLatestQuotePerSymbolAndPassesTradesThrough) {
+    Conflator conflator(8);
+    conflator.push(conflator_quote("AAPL", 1, 1.0), 10);
+    conflator.push(conflator_quote("MSFT", 2, 5.0), 11);
+    conflator.push(conflator_quote("AAPL", 1, 2.0), 12);
+    types::Trade t1{};
+    t1.symbol_id = 1;
+    t1.price = 1.5;
+    conflator.push(t1, 13);
+    conflator.push(conflator_quote("AAPL", 1, 3.0), 14);
+    types::Trade t2 = t1;
+    t2.price = 2.5;
+    conflator.push(t2, 15);
+
+    Collected got;
+    EXPECT_EQ(conflator.drain(got), 4);
+    ASSERT_EQ(got.trades.size(), 2);
+    EXPECT_DOUBLE_EQ(got.trades[0].price, 1.5);
+    EXPECT_DOUBLE_EQ(got.trades[1].price, 2.5);
+    ASSERT_EQ(got.quotes.size(), 2);
+    EXPECT_STREQ(got.quotes[0].symbol, "AAPL");
+    EXPECT_DOUBLE_EQ(got.quotes[0].bid_price, 3.0);
+    EXPECT_DOUBLE_EQ(got.quotes[1].bid_price, 5.0);
+
+    const auto stats = conflator.stats();
+    EXPECT_EQ(stats.quotes_in, 4);
+    EXPECT_EQ(stats.quotes_out, 2);
+    EXPECT_EQ(stats.passed_through, 2);
+    EXPECT_DOUBLE_EQ(conflator.conflation_ratio(), 2.0);
+    EXPECT_EQ(conflator.quote_staleness().size(), 2);
+
+    // nothing changed since, nothing to deliver; a quote without an id cannot be conflated and passes through
+    EXPECT_EQ(conflator.drain(got), 0);
+    conflator.push(conflator_quote("IBM", types::no_symbol_id, 7.0), 16);
+    EXPECT_EQ(conflator.drain(got), 1);
+    EXPECT_EQ(conflator.stats().quotes_in, 4);
+}
+
+TEST(ConflatorTest, DrainBudgetLeavesTheRestDirty) {
+    Conflator conflator(16);
+    for (uint32_t id = 1; id < 16; ++id) conflator.push(conflator_quote("S", id, id), id);
+
+    Collected got;
+    EXPECT_EQ(conflator.drain(got, 5), 5);
+    EXPECT_EQ(conflator.drain(got), 10);
+    EXPECT_EQ(got.quotes.size(), 15);
+}
+
+TEST(ConflatorTest, SlowConsumerSeesEveryLastValueAndNeverGoesBack) {
+    constexpr uint32_t symbols = 16;
+    constexpr int updates = 200'000;
+    Conflator conflator(symbols + 1);
+    std::atomic<bool> done{false};
+
+    std::thread producer([&] {
+        for (int i = 1; i <= updates; ++i) {
+            const auto id = static_cast<uint32_t>(1 + i % symbols);
+            conflator.push(conflator_quote("S", id, i), static_cast<uint64_t>(i));
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    std::vector<double> last(symbols + 1, 0.0);
+    int regressions = 0;
+    auto check = [&](const types::Quote& q, uint64_t) {
+        if (q.bid_price <= last[q.symbol_id]) ++regressions;
+        last[q.symbol_id] = q.bid_price;
+    };
+    auto consume = [&](const auto& msg, uint64_t ts) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(msg)>, types::Quote>) check(msg, ts);
+    };
+    while (!done.load(std::memory_order_acquire)) {
+        conflator.drain(consume, 8);
+        std::this_thread::yield();
+    }
+    producer.join();
+    conflator.drain(consume);
+
+    EXPECT_EQ(regressions, 0);
+    for (uint32_t id = 1; id <= symbols; ++id) {
+        // the last update for id is the largest i with 1 + i % symbols == id
+        int expected = updates;
+        while (static_cast<uint32_t>(1 + expected % symbols) != id) --expected;
+        EXPECT_DOUBLE_EQ(last[id], expected) << "symbol id " << id;
+    }
+    EXPECT_EQ(conflator.stats().quotes_in, static_cast<uint64_t>(updates));
+    EXPECT_GE(conflator.conflation_ratio(), 1.0);
+}
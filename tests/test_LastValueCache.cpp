@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../src/feedhandler/LastValueCache.h"
+
+TEST(LastValueCacheTest, StoresLatestPerSymbol) {
+    LastValueCache<types::Quote> cache(16);
+    types::Quote out{};
+    EXPECT_FALSE(cache.read(3, out));
+
+    types::Quote q{};
+    std::strncpy(q.symbol, "AAPL", sizeof(q.symbol) - 1);
+    q.symbol_id = 3;
+    q.bid_price = 1.0;
+    cache.store(q.symbol_id, q);
+    q.bid_price = 2.0;
+    cache.store(q.symbol_id, q);
+
+    ASSERT_TRUE(cache.read(3, out));
+    EXPECT_DOUBLE_EQ(out.bid_price, 2.0);
+    EXPECT_STREQ(out.symbol, "AAPL");
+    EXPECT_EQ(cache.version(3), 2);
+    EXPECT_EQ(cache.version(4), 0);
+
+    // no id or out of range is ignored rather than written somewhere
+    cache.store(types::no_symbol_id, q);
+    cache.store(99, q);
+    EXPECT_FALSE(cache.read(types::no_symbol_id, out));
+    EXPECT_FALSE(cache.read(99, out));
+}
+
+TEST(LastValueCacheTest, ReadersNeverSeeTornQuotes) {
+    constexpr uint32_t symbols = 8;
+    LastValueCache<types::Quote> cache(symbols);
+    std::atomic<bool> done{false};
+
+    // every field of a written quote carries the same counter, a torn read mixes two of them
+    std::thread writer([&] {
+        for (uint32_t i = 1; i <= 200'000; ++i) {
+            types::Quote q{};
+            q.symbol_id = 1 + i % (symbols - 1);
+            q.bid_price = i;
+            q.ask_price = i;
+            q.bid_size = i;
+            q.ask_size = i;
+            q.enqueue_timestamp = i;
+            cache.store(q.symbol_id, q);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    std::vector<std::thread> readers;
+    std::atomic<int> torn{0};
+    std::atomic<uint64_t> reads{0};
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&] {
+            types::Quote q{};
+            // at least one pass, on a single core the writer may be done before a reader runs
+            bool last_pass = false;
+            while (!last_pass) {
+                last_pass = done.load(std::memory_order_acquire);
+                for (uint32_t id = 1; id < symbols; ++id) {
+                    if (!cache.read(id, q)) continue;
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                    const auto v = static_cast<uint64_t>(q.bid_price);
+                    if (q.ask_price != q.bid_price || q.bid_size != v || q.ask_size != v || q.enqueue_timestamp != v) {
+                        torn.fetch_add(1);
+                    }
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    writer.join();
+    for (auto& t : readers) t.join();
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_GT(reads.load(), 0);
+}
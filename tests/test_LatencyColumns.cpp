@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../src/monitor/LatencyColumns.h"
+#include "../src/monitor/LatencyMonitor.h"
+
+namespace {
+    std::vector<char> read_file(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    latency_columns::FileHeader header_of(const std::vector<char>& file) {
+        latency_columns::FileHeader h{};
+        std::memcpy(&h, file.data(), sizeof(h));
+        return h;
+    }
+
+    // record i of column c, as the schema describes it
+    template <typename T>
+    T value(const std::vector<char>& file, const latency_columns::FileHeader& h, std::size_t column, uint64_t i) {
+        const latency_columns::Column& c = h.columns[column];
+        const uint64_t at = h.header_size + (i / h.block_records) * h.block_bytes + c.offset + (i % h.block_records) * c.width;
+        T v;
+        std::memcpy(&v, file.data() + at, sizeof(v));
+        return v;
+    }
+}
+
+TEST(LatencyColumnsTest, StreamsBlocksWithSchema) {
+    const std::string path = ::testing::TempDir() + "columns.mdlat";
+    constexpr uint64_t count = 10'000;
+    {
+        LatencyColumnWriter writer(path, 4096);
+        for (uint64_t i = 0; i < count; ++i) {
+            writer.append(i % 3 ? 'Q' : 'T', static_cast<uint32_t>(i % 7), i + 1, i * 100, i * 10, i * 20, i * 30, i % 5);
+        }
+        writer.close();
+        EXPECT_EQ(writer.record_count(), count);
+        EXPECT_EQ(writer.dropped(), 0u);
+    }
+
+    const std::vector<char> file = read_file(path);
+    const latency_columns::FileHeader h = header_of(file);
+    EXPECT_EQ(h.magic, latency_columns::file_magic);
+    EXPECT_EQ(h.version, latency_columns::format_version);
+    EXPECT_EQ(h.record_count, count);
+    EXPECT_EQ(h.block_count, 3u);
+    EXPECT_EQ(h.block_bytes % 4096, 0u);
+    EXPECT_EQ(file.size(), h.header_size + h.block_count * h.block_bytes);
+    ASSERT_EQ(h.column_count, latency_columns::column_count);
+    EXPECT_STREQ(h.columns[latency_columns::TotalNs].name, "total_ns");
+    EXPECT_STREQ(h.columns[latency_columns::SymbolId].dtype, "<u4");
+    for (const latency_columns::Column& c : h.columns) {
+        if (c.width != 0) {
+            EXPECT_EQ(c.offset % 4096, 0u) << c.name;
+        }
+    }
+
+    for (uint64_t i : {uint64_t{0}, uint64_t{4095}, uint64_t{4096}, uint64_t{8191}, count - 1}) {
+        EXPECT_EQ(value<uint64_t>(file, h, latency_columns::Sequence, i), i + 1);
+        EXPECT_EQ(value<uint64_t>(file, h, latency_columns::ReceiveNs, i), i * 100);
+        EXPECT_EQ(value<uint64_t>(file, h, latency_columns::QueueNs, i), i * 10);
+        EXPECT_EQ(value<uint64_t>(file, h, latency_columns::NetworkNs, i), i * 20);
+        EXPECT_EQ(value<uint64_t>(file, h, latency_columns::TotalNs, i), i * 30);
+        EXPECT_EQ(value<uint64_t>(file, h, latency_columns::ApplyNs, i), i % 5);
+        EXPECT_EQ(value<uint32_t>(file, h, latency_columns::SymbolId, i), i % 7);
+        EXPECT_EQ(value<char>(file, h, latency_columns::Type, i), i % 3 ? 'Q' : 'T');
+    }
+    // the padding behind the last record is zeroed
+    EXPECT_EQ(value<uint64_t>(file, h, latency_columns::Sequence, count), 0u);
+}
+
+TEST(LatencyColumnsTest, RejectsUnalignedBlocks) {
+    EXPECT_THROW(LatencyColumnWriter(::testing::TempDir() + "bad.mdlat", 1000), std::invalid_argument);
+}
+
+TEST(LatencyColumnsTest, MonitorStreamsInsteadOfCsv) {
+    const std::string dir = ::testing::TempDir() + "binary_monitor";
+    std::filesystem::remove_all(dir);
+    {
+        LatencyMonitor monitor(16, dir);
+        monitor.stream_binary(dir + "/latencies.mdlat", 4096);
+        types::Quote q{};
+        q.symbol_id = 3;
+        q.enqueue_timestamp = 1'000;
+        q.disseminate_timestamp = 1'500;
+        for (uint64_t s = 1; s <= 5; ++s) {
+            q.sequence = s;
+            monitor.on_quote(q, 4'000);
+        }
+        types::OrderAdd a{};
+        a.sequence = 6;
+        a.enqueue_timestamp = 1'000;
+        a.disseminate_timestamp = 1'200;
+        monitor.on_order(a, 2'000, 2'250);
+        EXPECT_TRUE(monitor.quote_latencies().empty());
+    }
+
+    EXPECT_FALSE(std::filesystem::exists(dir + "/quote_latencies.csv"));
+    const std::vector<char> file = read_file(dir + "/latencies.mdlat");
+    const latency_columns::FileHeader h = header_of(file);
+    ASSERT_EQ(h.record_count, 6u);
+    EXPECT_EQ(value<uint64_t>(file, h, latency_columns::ReceiveNs, 0), 4'000u);
+    EXPECT_EQ(value<uint64_t>(file, h, latency_columns::QueueNs, 0), 500u);
+    EXPECT_EQ(value<uint64_t>(file, h, latency_columns::NetworkNs, 0), 2'500u);
+    EXPECT_EQ(value<uint64_t>(file, h, latency_columns::TotalNs, 0), 3'000u);
+    EXPECT_EQ(value<uint32_t>(file, h, latency_columns::SymbolId, 0), 3u);
+    EXPECT_EQ(value<char>(file, h, latency_columns::Type, 5), 'A');
+    EXPECT_EQ(value<uint64_t>(file, h, latency_columns::ApplyNs, 5), 250u);
+    EXPECT_EQ(value<uint64_t>(file, h, latency_columns::Sequence, 5), 6u);
+}
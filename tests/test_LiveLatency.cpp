@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/monitor/LiveLatency.h"
+
+TEST(LatencyHistogramTest, BucketsCoverTheirValues) {
+    EXPECT_EQ(LatencyHistogram::bucket_of(0), 0u);
+    EXPECT_EQ(LatencyHistogram::bucket_of(63), 63u);
+    EXPECT_EQ(LatencyHistogram::bucket_of(64), 64u);
+    std::size_t previous = 0;
+    for (uint64_t ns = 1; ns < (uint64_t{1} << 36); ns += ns / 7 + 1) {
+        const std::size_t b = LatencyHistogram::bucket_of(ns);
+        ASSERT_LT(b, LatencyHistogram::bucket_count);
+        EXPECT_GE(b, previous);
+        EXPECT_GE(LatencyHistogram::upper_bound(b), ns);
+        if (b > 0) {
+            EXPECT_LT(LatencyHistogram::upper_bound(b - 1), ns) << ns;
+        }
+        // never more than one bucket width (1/32) above the value
+        EXPECT_LE(LatencyHistogram::upper_bound(b) - ns, ns / 32 + 1) << ns;
+        previous = b;
+    }
+    // past the top everything lands in the last bucket
+    EXPECT_EQ(LatencyHistogram::bucket_of(~uint64_t{0}), LatencyHistogram::bucket_count - 1);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinABucket) {
+    std::mt19937_64 rng(7);
+    std::lognormal_distribution<double> dist(9.0, 1.0); // median ~8 us
+    std::vector<uint64_t> values(100'000);
+    LatencyHistogram h;
+    for (uint64_t& v : values) {
+        v = static_cast<uint64_t>(dist(rng));
+        h.record(v);
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(h.count(), values.size());
+    for (double p : {0.5, 0.99, 0.999}) {
+        const auto exact = static_cast<double>(values[static_cast<std::size_t>(p * (values.size() - 1))]);
+        EXPECT_NEAR(static_cast<double>(h.percentile(p)), exact, exact * 0.035) << p;
+    }
+    EXPECT_GE(h.max(), values.back());
+    h.reset();
+    EXPECT_EQ(h.percentile(0.5), 0u);
+}
+
+TEST(LatencyRecorderTest, CountsSequenceGapsAsDrops) {
+    LatencyRecorder r("test");
+    for (uint64_t s : {1, 2, 3, 7, 8, 8, 5, 10}) r.record(1'000, s);
+    r.record(1'000); // unnumbered
+    EXPECT_EQ(r.count(), 9u);
+    // 4..6 and 9 missing, the duplicate and the late 5 are not gaps
+    EXPECT_EQ(r.drops(), 4u);
+    r.add_drops(2);
+    EXPECT_EQ(r.drops(), 6u);
+    EXPECT_EQ(r.bucket(LatencyHistogram::bucket_of(1'000)), 9u);
+}
+
+// a writer thread recording while the aggregator reads, every sample ends up in exactly one window
+TEST(LiveAggregatorTest, ReportsEverySampleOnce) {
+    const std::string csv = ::testing::TempDir() + "live_latency.csv";
+    LiveAggregator live(std::chrono::milliseconds(5), csv, std::chrono::milliseconds(40));
+    LatencyRecorder& recorder = live.add_recorder("writer");
+    live.start();
+
+    constexpr uint64_t count = 200'000;
+    std::thread writer([&recorder] {
+        for (uint64_t s = 1; s <= count; ++s) {
+            if (s % 10'000 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(8)); // ~160 ms in all
+            if (s % 1000 == 0) continue; // one dropped per thousand
+            recorder.record(500 + s % 1000, s);
+        }
+    });
+    writer.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    live.stop();
+
+    const auto& reports = live.reports();
+    ASSERT_GE(reports.size(), 3u);
+    uint64_t messages = 0, drops = 0;
+    for (const auto& r : reports) {
+        messages += r.messages;
+        drops += r.drops;
+        if (r.messages > 0) {
+            EXPECT_GE(r.p50_ns, 500u);
+            EXPECT_LE(r.p50_ns, r.p99_ns);
+            EXPECT_LE(r.p99_ns, r.p999_ns);
+            EXPECT_LE(r.p999_ns, r.max_ns);
+            EXPECT_LE(r.max_ns, 1'600u);
+        }
+    }
+    EXPECT_EQ(messages, count - count / 1000);
+    // the last one is never followed by anything, so it is not seen as a gap
+    EXPECT_EQ(drops, count / 1000 - 1);
+
+    std::ifstream in(csv);
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line, "elapsed_s,messages,rate,p50_ns,p99_ns,p999_ns,max_ns,drops,target_rate");
+    std::size_t rows = 0;
+    while (std::getline(in, line)) ++rows;
+    EXPECT_EQ(rows, reports.size());
+}
+
+// every window carries the mean of the target rate it saw, a change mid-run shows in the windows after it
+TEST(LiveAggregatorTest, WindowsCarryTheTargetRate) {
+    std::atomic<uint64_t> target{1'000};
+    LiveAggregator live(std::chrono::milliseconds(5), {}, std::chrono::milliseconds(40));
+    live.set_logging(false);
+    live.set_target_rate(&target);
+    live.add_recorder("writer");
+    live.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    target.store(3'000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    live.stop();
+
+    const auto& reports = live.reports();
+    ASSERT_GE(reports.size(), 3u);
+    EXPECT_DOUBLE_EQ(reports.front().target_rate, 1'000.0);
+    EXPECT_DOUBLE_EQ(reports.back().target_rate, 3'000.0);
+    for (const auto& r : reports) {
+        EXPECT_GE(r.target_rate, 1'000.0);
+        EXPECT_LE(r.target_rate, 3'000.0);
+    }
+}
+
+TEST(LiveAggregatorTest, RejectsAnIntervalLongerThanTheReportPeriod) {
+    EXPECT_THROW(LiveAggregator(std::chrono::milliseconds(0)), std::invalid_argument);
+    EXPECT_THROW(LiveAggregator(std::chrono::milliseconds(2000)), std::invalid_argument);
+}
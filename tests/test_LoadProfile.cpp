@@ -0,0 +1,120 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "../src/generator/LoadProfile.h"
+#include "../src/generator/RandomWalkGenerator.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    // counts from the generator thread, read from the test
+    struct CountingQueue {
+        std::atomic<uint64_t> pushed{0};
+        bool push(const types::MarketDataMsg&) {
+            pushed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    };
+
+    std::chrono::nanoseconds at(double seconds) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(seconds));
+    }
+}
+
+TEST(LoadProfileTest, BuiltinShapesScaleToRateAndDuration) {
+    const LoadProfile ramp = LoadProfile::builtin("ramp", 100'000, 10);
+    EXPECT_EQ(ramp.rate_at(at(0)), 10'000u);
+    EXPECT_EQ(ramp.rate_at(at(5)), 55'000u);
+    EXPECT_EQ(ramp.rate_at(at(30)), 100'000u); // the last rate holds
+    EXPECT_DOUBLE_EQ(ramp.seconds(), 10.0);
+
+    const LoadProfile step = LoadProfile::builtin("step", 100'000, 8);
+    EXPECT_EQ(step.rate_at(at(1)), 25'000u);
+    EXPECT_EQ(step.rate_at(at(3)), 50'000u);
+    EXPECT_EQ(step.rate_at(at(7.9)), 100'000u);
+
+    const LoadProfile spike = LoadProfile::builtin("spike", 100'000, 30);
+    EXPECT_EQ(spike.rate_at(at(9.9)), 25'000u);
+    EXPECT_EQ(spike.rate_at(at(10.5)), 100'000u);
+    EXPECT_EQ(spike.rate_at(at(13.1)), 25'000u);
+    EXPECT_EQ(spike.peak(), 100'000u);
+
+    const LoadProfile sine = LoadProfile::builtin("sine", 100'000, 20);
+    EXPECT_EQ(sine.rate_at(at(0)), 55'000u);
+    EXPECT_EQ(sine.rate_at(at(1.25)), 100'000u);
+    EXPECT_EQ(sine.rate_at(at(3.75)), 10'000u);
+
+    EXPECT_THROW(LoadProfile::builtin("square", 100'000, 10), std::invalid_argument);
+}
+
+TEST(LoadProfileTest, ParsesSegmentsFromASpecOrAFile) {
+    const LoadProfile p = LoadProfile::parse("hold 1000 2; ramp 1000 3000 1.5 # up\n\nsine 100 300 1 4");
+    ASSERT_EQ(p.segments().size(), 3u);
+    EXPECT_EQ(p.rate_at(at(1.9)), 1'000u);
+    EXPECT_EQ(p.rate_at(at(2.75)), 2'000u);
+    EXPECT_EQ(p.rate_at(at(3.75)), 300u);
+    EXPECT_DOUBLE_EQ(p.seconds(), 7.5);
+    EXPECT_EQ(p.peak(), 3'000u);
+
+    const std::string path = ::testing::TempDir() + "profile.txt";
+    {
+        std::ofstream out(path);
+        out << "# warm, burst, recover\nhold 500 1\nhold 5000 0.5\nhold 500 3\n";
+    }
+    const LoadProfile from_file = LoadProfile::load(path, 1, 1);
+    EXPECT_EQ(from_file.segments().size(), 3u);
+    EXPECT_EQ(from_file.rate_at(at(1.2)), 5'000u);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(LoadProfile::load("spike", 40'000, 10).peak(), 40'000u);
+    EXPECT_THROW(LoadProfile::parse("hold 1000"), std::invalid_argument);
+    EXPECT_THROW(LoadProfile::parse("hold 0 5"), std::invalid_argument);
+    EXPECT_THROW(LoadProfile::parse("ramp 10 20 abc"), std::invalid_argument);
+    EXPECT_THROW(LoadProfile::parse("burst 1000 5"), std::invalid_argument);
+    EXPECT_THROW(LoadProfile::parse("sine 300 100 1 4"), std::invalid_argument);
+    EXPECT_THROW(LoadProfile::parse("# nothing"), std::invalid_argument);
+}
+
+// the running generator changes pace without a restart, by profile and by set_rate(), and says so in the stats
+TEST(LoadProfileTest, GeneratorFollowsTheRateWhileRunning) {
+    const std::string symbols = ::testing::TempDir() + "profile_symbols.txt";
+    {
+        std::ofstream out(symbols);
+        out << "AAPL\nMSFT\n";
+    }
+
+    CountingQueue queue;
+    shm::GeneratorStats stats{};
+    const LoadProfile profile = LoadProfile::parse("hold 1000 0.3; hold 50000 10");
+    RandomWalkGenerator<CountingQueue> generator(queue);
+    generator.configure(1, symbols);
+    generator.set_stats(&stats);
+    generator.set_profile(&profile);
+    generator.start();
+
+    std::this_thread::sleep_for(150ms);
+    EXPECT_EQ(stats.target_rate.load(), 1'000u);
+    EXPECT_LT(queue.pushed.load(), 1'000u);
+    std::this_thread::sleep_for(450ms);
+    EXPECT_EQ(stats.target_rate.load(), 50'000u);
+    EXPECT_GT(queue.pushed.load(), 2'000u);
+    generator.stop();
+
+    RandomWalkGenerator<CountingQueue> manual(queue);
+    manual.configure(1'000, symbols);
+    manual.set_stats(&stats);
+    manual.start();
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(stats.target_rate.load(), 1'000u);
+    const uint64_t before = queue.pushed.load();
+    manual.set_rate(50'000);
+    std::this_thread::sleep_for(200ms);
+    EXPECT_EQ(stats.target_rate.load(), 50'000u);
+    EXPECT_GT(queue.pushed.load() - before, 2'000u);
+    manual.stop();
+    std::filesystem::remove(symbols);
+}
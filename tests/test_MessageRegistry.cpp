@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+
+#include "../src/utils/types.h"
+
+namespace {
+    struct TagVisitor {
+        char seen{0};
+        uint32_t size{0};
+
+        template <typename T>
+        void operator()(const T& msg) {
+            seen = types::MessageTraits<T>::tag;
+            if constexpr (std::is_same_v<T, types::OrderAdd>) {
+                size = msg.size;
+            }
+        }
+    };
+}
+
+TEST(MessageRegistryTest, TagsAreUniqueAndMatchVariant) {
+    static_assert(types::Messages::count == std::variant_size_v<types::MarketDataMsg>);
+    static_assert(types::Messages::tag_of<types::Quote> == 'Q');
+    static_assert(types::Messages::contains<types::OrderExecute>);
+    static_assert(!types::Messages::contains<int>);
+
+    std::string names;
+    types::Messages::for_each_type([&]<typename T>() {
+        names += types::MessageTraits<T>::name;
+        names += ',';
+    });
+    EXPECT_EQ(names, "Quote,Trade,OrderAdd,OrderModify,OrderCancel,OrderExecute,");
+}
+
+TEST(MessageRegistryTest, EncodeThenDispatchRoundTrips) {
+    types::OrderAdd add{};
+    std::strncpy(add.symbol, "MSFT", sizeof(add.symbol) - 1);
+    add.size = 300;
+
+    char topic[types::topic_header_size];
+    types::Messages::encode_topic(add, topic);
+    EXPECT_EQ(topic[0], 'A');
+    EXPECT_EQ(topic[1], ':');
+    EXPECT_EQ(std::memcmp(topic + 2, "MSFT", 4), 0);
+
+    TagVisitor visitor;
+    EXPECT_TRUE(types::Messages::dispatch(topic[0], &add, sizeof(add), visitor));
+    EXPECT_EQ(visitor.seen, 'A');
+    EXPECT_EQ(visitor.size, 300);
+}
+
+TEST(MessageRegistryTest, DispatchRejectsUnknownTagAndWrongSize) {
+    types::Quote quote{};
+    TagVisitor visitor;
+    EXPECT_FALSE(types::Messages::dispatch('Z', &quote, sizeof(quote), visitor));
+    EXPECT_FALSE(types::Messages::dispatch('Q', &quote, sizeof(quote) - 1, visitor));
+    EXPECT_EQ(visitor.seen, 0);
+}
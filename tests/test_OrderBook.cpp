@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "../src/book/BookBuilder.h"
+#include "../src/book/PriceLevelBook.h"
+#include "../src/generator/OrderBookGenerator.h"
+#include "../src/utils/types.h"
+
+namespace {
+    struct MockQueue {
+        std::vector<types::MarketDataMsg> items;
+
+        bool push(const types::MarketDataMsg& item) {
+            items.push_back(item);
+            return true;
+        }
+    };
+
+    template <typename Msg>
+    Msg make(const char* symbol, uint64_t order_id) {
+        Msg msg{};
+        std::strncpy(msg.symbol, symbol, sizeof(msg.symbol) - 1);
+        msg.order_id = order_id;
+        return msg;
+    }
+}
+
+TEST(PriceLevelBookTest, TracksBestLevelsAndRefillsTouch) {
+    PriceLevelBook book;
+    book.add(types::Side::Buy, 9990, 100);
+    book.add(types::Side::Buy, 9995, 200);
+    book.add(types::Side::Sell, 10005, 300);
+
+    EXPECT_EQ(book.best_bid().price, 9995);
+    EXPECT_EQ(book.best_bid().quantity, 200);
+    EXPECT_EQ(book.best_ask().price, 10005);
+
+    book.remove(types::Side::Buy, 9995, 200, true);
+    EXPECT_EQ(book.best_bid().price, 9990);
+    EXPECT_EQ(book.best_bid().orders, 1);
+    EXPECT_FALSE(book.crossed());
+}
+
+TEST(PriceLevelBookTest, GrowsWindowInBothDirections) {
+    PriceLevelBook book;
+    book.add(types::Side::Sell, 10'000, 1);
+    book.add(types::Side::Sell, 5'000, 2);   // far below the initial window
+    book.add(types::Side::Sell, 20'000, 3);  // far above
+
+    EXPECT_EQ(book.best_ask().price, 5'000);
+    EXPECT_EQ(book.quantity_at(types::Side::Sell, 10'000), 1);
+    EXPECT_EQ(book.quantity_at(types::Side::Sell, 20'000), 3);
+}
+
+TEST(PriceLevelBookTest, RefusesPricesPastTheMaxWindow) {
+    PriceLevelBook book;
+    book.add(types::Side::Buy, 10'000, 1);
+    EXPECT_FALSE(book.add(types::Side::Buy, 10'000 + PriceLevelBook::max_window, 2));
+    EXPECT_FALSE(book.add(types::Side::Buy, 10'000 - PriceLevelBook::max_window, 2));
+    EXPECT_TRUE(book.add(types::Side::Buy, 10'000 + PriceLevelBook::max_window / 2, 3));
+
+    EXPECT_EQ(book.best_bid().price, 10'000 + PriceLevelBook::max_window / 2);
+    EXPECT_EQ(book.quantity_at(types::Side::Buy, 10'000), 1);
+}
+
+TEST(BookBuilderTest, AppliesAddModifyCancelExecute) {
+    BookBuilder builder;
+
+    auto add = make<types::OrderAdd>("AAPL", 0);
+    add.price = 100.00; add.size = 500; add.side = types::Side::Buy;
+    builder.apply(add);
+
+    auto add2 = make<types::OrderAdd>("AAPL", 1);
+    add2.price = 100.05; add2.size = 300; add2.side = types::Side::Sell;
+    builder.apply(add2);
+
+    const PriceLevelBook* book = builder.book("AAPL");
+    ASSERT_NE(book, nullptr);
+    EXPECT_EQ(book->best_bid().price, 10'000);
+    EXPECT_EQ(book->best_bid().quantity, 500);
+    EXPECT_EQ(book->best_ask().price, 10'005);
+
+    auto modify = make<types::OrderModify>("AAPL", 0);
+    modify.price = 99.99; modify.size = 200;
+    builder.apply(modify);
+    EXPECT_EQ(book->best_bid().price, 9'999);
+    EXPECT_EQ(book->best_bid().quantity, 200);
+
+    auto execute = make<types::OrderExecute>("AAPL", 1);
+    execute.executed_size = 100;
+    builder.apply(execute);
+    EXPECT_EQ(book->best_ask().quantity, 200);
+
+    builder.apply(make<types::OrderCancel>("AAPL", 1));
+    EXPECT_EQ(book->best_ask().quantity, 0);
+    EXPECT_EQ(builder.live_orders(), 1);
+
+    // cancelling twice is tolerated but counted
+    builder.apply(make<types::OrderCancel>("AAPL", 1));
+    EXPECT_EQ(builder.unknown_orders(), 1);
+}
+
+TEST(BookBuilderTest, FindsBooksBySymbolIdAndFallsBackToSymbol) {
+    BookBuilder builder;
+
+    auto add = make<types::OrderAdd>("AAPL", 0);
+    add.symbol_id = 7;
+    add.price = 100.00; add.size = 100; add.side = types::Side::Buy;
+    builder.apply(add);
+
+    // same symbol without an id, and the id again: one book
+    auto add2 = make<types::OrderAdd>("AAPL", 1);
+    add2.price = 100.00; add2.size = 50; add2.side = types::Side::Buy;
+    builder.apply(add2);
+    auto add3 = make<types::OrderAdd>("AAPL", 2);
+    add3.symbol_id = 7;
+    add3.price = 100.00; add3.size = 25; add3.side = types::Side::Buy;
+    builder.apply(add3);
+
+    auto other = make<types::OrderAdd>("MSFT", 3);
+    other.symbol_id = 2;
+    other.price = 50.00; other.size = 10; other.side = types::Side::Sell;
+    builder.apply(other);
+
+    EXPECT_EQ(builder.book_count(), 2);
+    ASSERT_NE(builder.book("AAPL"), nullptr);
+    EXPECT_EQ(builder.book("AAPL")->best_bid().quantity, 175);
+    ASSERT_NE(builder.book("MSFT"), nullptr);
+    EXPECT_EQ(builder.book("MSFT")->best_ask().quantity, 10);
+}
+
+TEST(BookBuilderTest, BoundsIdsFromTheWire) {
+    BookBuilder builder(0, 0, 16, 1024);
+
+    // a foreign symbol id does not size the id table, the book is found by symbol
+    auto add = make<types::OrderAdd>("AAPL", 1);
+    add.symbol_id = 3'000'000'000u;
+    add.price = 100.00; add.size = 100; add.side = types::Side::Buy;
+    builder.apply(add);
+    ASSERT_NE(builder.book("AAPL"), nullptr);
+    EXPECT_EQ(builder.book("AAPL")->best_bid().quantity, 100);
+
+    // an order id past the limit is dropped, later messages for it are unknown
+    auto huge = make<types::OrderAdd>("AAPL", uint64_t{1} << 40);
+    huge.symbol_id = 1;
+    huge.price = 101.00; huge.size = 10; huge.side = types::Side::Buy;
+    builder.apply(huge);
+    EXPECT_EQ(builder.dropped(), 1);
+    builder.apply(make<types::OrderCancel>("AAPL", uint64_t{1} << 40));
+    EXPECT_EQ(builder.unknown_orders(), 1);
+    EXPECT_EQ(builder.book("AAPL")->best_bid().quantity, 100);
+    EXPECT_EQ(builder.live_orders(), 1);
+}
+
+TEST(BookBuilderTest, DropsUnusablePrices) {
+    BookBuilder builder;
+    auto add = make<types::OrderAdd>("AAPL", 1);
+    add.price = 100.00; add.size = 100; add.side = types::Side::Buy;
+    builder.apply(add);
+
+    auto nan = make<types::OrderAdd>("AAPL", 2);
+    nan.price = std::numeric_limits<double>::quiet_NaN(); nan.size = 10; nan.side = types::Side::Buy;
+    builder.apply(nan);
+    auto far = make<types::OrderAdd>("AAPL", 3);
+    far.price = 1e7; far.size = 10; far.side = types::Side::Buy;
+    builder.apply(far);
+
+    // a modify to such a price leaves the order where it was
+    auto move_far = make<types::OrderModify>("AAPL", 1);
+    move_far.price = 1e7; move_far.size = 100;
+    builder.apply(move_far);
+    auto move_inf = make<types::OrderModify>("AAPL", 1);
+    move_inf.price = std::numeric_limits<double>::infinity(); move_inf.size = 100;
+    builder.apply(move_inf);
+
+    EXPECT_EQ(builder.dropped(), 4);
+    EXPECT_EQ(builder.applied(), 1);
+    EXPECT_EQ(builder.live_orders(), 1);
+    ASSERT_NE(builder.book("AAPL"), nullptr);
+    EXPECT_EQ(builder.book("AAPL")->best_bid().quantity, 100);
+    EXPECT_EQ(builder.book("AAPL")->best_bid().price, std::llround(100.00 / types::price_tick));
+}
+
+TEST(OrderBookGeneratorTest, StreamRebuildsIntoConsistentBooks) {
+    const std::filesystem::path symbols = "test_orderbook_tickers.txt";
+    {
+        std::ofstream file(symbols);
+        file << "AAPL\n" << "MSFT\n" << "NVDA\n";
+    }
+
+    MockQueue queue;
+    OrderBookGenerator<MockQueue> generator(queue);
+    generator.configure(1000, symbols);
+    for (int i = 0; i < 50'000; ++i) {
+        queue.push(generator.generate_msg_impl());
+    }
+
+    BookBuilder builder;
+    for (const auto& msg : queue.items) {
+        std::visit([&](const auto& m) {
+            using T = std::decay_t<decltype(m)>;
+            if constexpr (!std::is_same_v<T, types::Quote> && !std::is_same_v<T, types::Trade>) {
+                builder.apply(m);
+            }
+        }, msg);
+        for (const char* sym : {"AAPL", "MSFT", "NVDA"}) {
+            if (const auto* book = builder.book(sym)) {
+                ASSERT_FALSE(book->crossed()) << sym;
+            }
+        }
+    }
+
+    EXPECT_EQ(builder.unknown_orders(), 0);
+    EXPECT_EQ(builder.live_orders(), generator.live_orders());
+    EXPECT_EQ(builder.book_count(), 3);
+    EXPECT_GT(builder.executed_volume(), 0);
+
+    std::filesystem::remove(symbols);
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "../src/generator/ReplayGenerator.h"
+#include "../src/recorder/CaptureRecorder.h"
+#include "../src/utils/types.h"
+
+namespace {
+    struct MockQueue {
+        std::vector<types::MarketDataMsg> items;
+        size_t capacity_limit = std::numeric_limits<size_t>::max();
+        std::atomic<size_t> count{0};   // items.size() for the test thread while the generator is still pushing
+
+        bool push(const types::MarketDataMsg& item) {
+            if (items.size() >= capacity_limit) {
+                return false;
+            }
+            items.push_back(item);
+            count.store(items.size(), std::memory_order_release);
+            return true;
+        }
+
+        size_t size() const { return items.size(); }
+    };
+}
+
+class ReplayGeneratorTest : public ::testing::Test {
+protected:
+    std::filesystem::path path_ = "test_replay.mdcap";
+    MockQueue queue_;
+
+    // alternating quotes and trades, bid_price/price carries the index, gap_ns apart
+    void write_capture(int count, uint64_t gap_ns) {
+        CaptureRecorder recorder(path_, 1 << 20);
+        recorder.start();
+        char topic[types::topic_header_size]{};
+        topic[1] = ':';
+        for (int i = 0; i < count; ++i) {
+            if (i % 2 == 0) {
+                types::Quote q{};
+                std::strncpy(q.symbol, "AAPL", sizeof(q.symbol) - 1);
+                q.bid_price = i;
+                topic[0] = 'Q';
+                recorder.record(topic, &q, sizeof(q), i * gap_ns);
+            } else {
+                types::Trade t{};
+                std::strncpy(t.symbol, "AAPL", sizeof(t.symbol) - 1);
+                t.price = i;
+                topic[0] = 'T';
+                recorder.record(topic, &t, sizeof(t), i * gap_ns);
+            }
+        }
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(path_)) std::filesystem::remove(path_);
+    }
+};
+
+TEST_F(ReplayGeneratorTest, ReplaysEveryRecordInOrderAndStops) {
+    write_capture(1000, 1000);
+
+    ReplayGenerator<MockQueue> generator(queue_);
+    generator.configure(path_, 0.0, false);
+    generator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    generator.stop();
+
+    ASSERT_EQ(queue_.size(), 1000);
+    for (int i = 0; i < 1000; ++i) {
+        const double value = std::visit([](auto&& m) {
+            using T = std::decay_t<decltype(m)>;
+            if constexpr (std::is_same_v<T, types::Quote>) return m.bid_price;
+            else if constexpr (std::is_same_v<T, types::Trade>) return m.price;
+            else return -1.0;
+        }, queue_.items[i]);
+        ASSERT_DOUBLE_EQ(value, i);
+        ASSERT_EQ(queue_.items[i].index(), static_cast<size_t>(i % 2));
+    }
+}
+
+TEST_F(ReplayGeneratorTest, OriginalTimingIsRespected) {
+    // 11 records 10ms apart -> 100ms of capture time
+    write_capture(11, 10'000'000);
+
+    ReplayGenerator<MockQueue> generator(queue_);
+    generator.configure(path_, 1.0, false);
+    generator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const size_t half_way = queue_.count.load(std::memory_order_acquire);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    generator.stop();
+
+    EXPECT_GT(half_way, 2);
+    EXPECT_LT(half_way, 10);
+    EXPECT_EQ(queue_.size(), 11);
+}
+
+TEST_F(ReplayGeneratorTest, SpeedMultipleCompressesTime) {
+    // 1s of capture replayed at 20x -> ~50ms
+    write_capture(11, 100'000'000);
+
+    ReplayGenerator<MockQueue> generator(queue_);
+    generator.configure(path_, 20.0, false);
+    generator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    generator.stop();
+
+    EXPECT_EQ(queue_.size(), 11);
+}
+
+TEST_F(ReplayGeneratorTest, LoopsWhenConfigured) {
+    write_capture(10, 1000);
+    queue_.capacity_limit = 1000;
+
+    ReplayGenerator<MockQueue> generator(queue_);
+    generator.configure(path_, 0.0, true);
+    generator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    generator.stop();
+
+    EXPECT_EQ(queue_.size(), 1000);
+}
+
+TEST_F(ReplayGeneratorTest, MissingCaptureThrows) {
+    ReplayGenerator<MockQueue> generator(queue_);
+    EXPECT_THROW(generator.configure("does_not_exist.mdcap"), std::runtime_error);
+}
+
+TEST_F(ReplayGeneratorTest, SeekStopsAtTornTail) {
+    write_capture(100, 1000);
+
+    // turn it into a capture that crashed mid-write: no index, the records from 50 on zero-filled
+    std::vector<char> bytes;
+    {
+        std::ifstream f(path_, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+    capture::FileHeader hdr;
+    std::memcpy(&hdr, bytes.data(), sizeof(hdr));
+    uint64_t offset = hdr.data_offset;
+    for (int i = 0; i < 50; ++i) {
+        capture::RecordHeader rh;
+        std::memcpy(&rh, bytes.data() + offset, sizeof(rh));
+        offset += rh.record_size;
+    }
+    std::memset(bytes.data() + offset, 0, hdr.data_end - offset);
+    hdr.index_offset = 0;
+    hdr.index_count = 0;
+    std::memcpy(bytes.data(), &hdr, sizeof(hdr));
+    {
+        std::ofstream f(path_, std::ios::binary | std::ios::trunc);
+        f.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    CaptureReader reader(path_);
+    reader.seek(40'000);
+    capture::RecordView view;
+    ASSERT_TRUE(reader.next(view));
+    EXPECT_EQ(view.header->timestamp_ns, 40'000);
+
+    reader.seek(99'000);   // past the tear, must not spin on the zero record_size
+    EXPECT_TRUE(reader.at_end());
+    EXPECT_FALSE(reader.next(view));
+
+    // a record header cut short by data_end
+    hdr.data_end = offset + sizeof(capture::RecordHeader) / 2;
+    std::memcpy(bytes.data(), &hdr, sizeof(hdr));
+    {
+        std::ofstream f(path_, std::ios::binary | std::ios::trunc);
+        f.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    CaptureReader truncated(path_);
+    truncated.seek(99'000);
+    EXPECT_TRUE(truncated.at_end());
+    EXPECT_FALSE(truncated.next(view));
+}
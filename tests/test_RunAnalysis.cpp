@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/monitor/RunAnalysis.h"
+
+namespace {
+    std::filesystem::path fresh_dir(const std::string& name) {
+        const std::filesystem::path dir = std::filesystem::path(::testing::TempDir()) / name;
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir;
+    }
+
+    // 1000 quotes, total_ns 1..1000 us, one every ms, sequences 1..1010 with 100..109 missing
+    void write_binary_run(const std::filesystem::path& dir, uint64_t flags = 0) {
+        LatencyColumnWriter writer(dir / analysis::binary_file, 4096, flags);
+        uint64_t sequence = 0;
+        for (uint64_t i = 1; i <= 1000; ++i) {
+            if (++sequence == 100) sequence += 10;
+            writer.append('Q', 1, sequence, 5'000'000'000 + i * 1'000'000, 100, i * 1000 - 100, i * 1000);
+        }
+        writer.append('T', 2, sequence + 1, 5'000'000'000 + 1'100'000'000, 100, 900, 1000);
+        writer.close();
+    }
+}
+
+TEST(RunAnalysisTest, BinaryRunPercentilesThroughputAndLoss) {
+    const std::filesystem::path dir = fresh_dir("analysis_binary");
+    write_binary_run(dir);
+
+    analysis::Options opts;
+    opts.window_ns = 100'000'000;
+    analysis::RunData data = analysis::load_run(dir, opts);
+    const analysis::RunSummary s = analysis::summarize(data);
+    EXPECT_EQ(s.source, "binary");
+    EXPECT_EQ(s.messages, 1001u);
+    EXPECT_EQ(s.p50_ns, 500'000u);
+    EXPECT_EQ(s.p99_ns, 990'000u);
+    EXPECT_EQ(s.max_ns, 1'000'000u);
+    EXPECT_NEAR(static_cast<double>(s.hist_p99_ns), 990'000.0, 990'000.0 * 0.04);
+    EXPECT_NEAR(s.mean_queue_ns, 100.0, 1e-9);
+    // 100 messages in each 100 ms window, the trade alone in the cut-off last one
+    EXPECT_EQ(s.windows, 10u);
+    EXPECT_NEAR(s.rate_mean, 1000.0, 1e-6);
+    ASSERT_TRUE(s.loss_known);
+    EXPECT_EQ(s.lost, 10u);
+    EXPECT_NEAR(s.loss_pct, 100.0 * 10 / 1011, 1e-9);
+
+    // the first 300 ms are warm-up
+    opts.skip_ns = 300'000'000;
+    analysis::RunData warm = analysis::load_run(dir, opts);
+    const analysis::RunSummary w = analysis::summarize(warm);
+    EXPECT_EQ(w.messages, 701u);
+    EXPECT_EQ(w.windows, 7u);
+    EXPECT_EQ(w.lost, 0u);
+
+    opts.skip_ns = 0;
+    opts.type = 'T';
+    analysis::RunData trades = analysis::load_run(dir, opts);
+    EXPECT_EQ(analysis::summarize(trades).messages, 1u);
+    EXPECT_FALSE(trades.loss_known);
+}
+
+TEST(RunAnalysisTest, ConflatedBinaryRunReportsNoSequenceLoss) {
+    const std::filesystem::path dir = fresh_dir("analysis_conflated");
+    write_binary_run(dir, latency_columns::conflated_sequences);
+
+    analysis::RunData data = analysis::load_run(dir);
+    const analysis::RunSummary s = analysis::summarize(data);
+    EXPECT_EQ(s.messages, 1001u);
+    EXPECT_FALSE(s.loss_known);
+    EXPECT_EQ(s.lost, 0u);
+}
+
+TEST(RunAnalysisTest, CsvRunWithLiveWindows) {
+    const std::filesystem::path dir = fresh_dir("analysis_csv");
+    {
+        std::ofstream q(dir / "quote_latencies.csv");
+        q << "queue_ns,network_ns,total_ns,tx_stack_ns,wire_ns,rx_stack_ns\n";
+        for (uint64_t i = 1; i <= 100; ++i) q << 10 << "," << i * 100 - 10 << "," << i * 100 << ",0,0,0\n";
+        std::ofstream t(dir / "trade_latencies.csv");
+        t << "queue_ns,network_ns,total_ns,tx_stack_ns,wire_ns,rx_stack_ns\n" << "10,99990,100000,0,0,0\n";
+        std::ofstream live(dir / analysis::live_file);
+        live << "elapsed_s,messages,rate,p50_ns,p99_ns,p999_ns,max_ns,drops\n"
+             << "1,60,60,0,0,0,0,0\n"
+             << "2,41,40,0,0,0,0,4\n";
+    }
+
+    analysis::RunData data = analysis::load_run(dir);
+    const analysis::RunSummary s = analysis::summarize(data);
+    EXPECT_EQ(s.source, "csv");
+    EXPECT_EQ(s.messages, 101u);
+    EXPECT_EQ(s.p50_ns, 5'100u);
+    EXPECT_EQ(s.max_ns, 100'000u);
+    EXPECT_EQ(s.windows, 2u);
+    EXPECT_DOUBLE_EQ(s.rate_mean, 50.0);
+    EXPECT_DOUBLE_EQ(s.rate_min, 40.0);
+    ASSERT_TRUE(s.loss_known);
+    EXPECT_EQ(s.lost, 4u);
+}
+
+TEST(RunAnalysisTest, SweepDirectoryInParallel) {
+    const std::filesystem::path sweep = fresh_dir("analysis_sweep");
+    for (const char* run : {"rate_1000", "rate_2000", "rate_4000"}) {
+        std::filesystem::create_directories(sweep / run);
+        write_binary_run(sweep / run);
+    }
+    std::filesystem::create_directories(sweep / "broken");
+    std::ofstream(sweep / "broken" / analysis::binary_file) << "not a latency file";
+    std::filesystem::create_directories(sweep / "no_output");
+
+    const std::vector<std::filesystem::path> runs = analysis::find_runs({sweep.string()});
+    ASSERT_EQ(runs.size(), 4u);
+    const std::vector<analysis::RunSummary> rows = analysis::analyze(runs, {}, 3);
+    ASSERT_EQ(rows.size(), 4u);
+    EXPECT_FALSE(rows[0].error.empty());
+    EXPECT_EQ(rows[0].run, (sweep / "broken").string());
+    for (std::size_t i = 1; i < rows.size(); ++i) {
+        EXPECT_TRUE(rows[i].error.empty()) << rows[i].error;
+        EXPECT_EQ(rows[i].p50_ns, 500'000u);
+    }
+
+    std::ostringstream csv;
+    analysis::write_csv(csv, rows);
+    const std::string table = csv.str();
+    EXPECT_EQ(std::count(table.begin(), table.end(), '\n'), 4);
+    EXPECT_NE(table.find("rate_2000,binary,1001,500,"), std::string::npos);
+}
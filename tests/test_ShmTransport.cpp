@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "../src/disseminator/ShmDisseminator.h"
+#include "../src/feedhandler/ShmFeedHandler.h"
+#include "../src/utils/CustomSpscQueue.h"
+#include "../src/utils/SpinSpscQueue.h"
+
+namespace {
+    std::string test_segment(const char* what) {
+        return "/mdds_test_" + std::string(what) + "_" + std::to_string(getpid());
+    }
+
+    void publish_quote(ShmRingWriter& writer, uint64_t sequence, const char* symbol = "AAPL") {
+        types::Quote q{};
+        std::strncpy(q.symbol, symbol, sizeof(q.symbol) - 1);
+        q.sequence = sequence;
+        char topic[types::topic_header_size];
+        types::Messages::encode_topic(q, topic);
+        writer.publish(topic, &q, sizeof(q));
+    }
+
+    // sequences of every quote poll hands out
+    std::vector<uint64_t> drain(ShmRingReader& reader) {
+        std::vector<uint64_t> seqs;
+        while (reader.poll([&](char tag, const char* topic, const std::byte* payload, std::size_t size) {
+            EXPECT_EQ(tag, 'Q');
+            EXPECT_EQ(topic[0], 'Q');
+            EXPECT_EQ(size, sizeof(types::Quote));
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(payload) % alignof(types::Quote), 0u);
+            types::Quote q;
+            std::memcpy(&q, payload, sizeof(q));
+            seqs.push_back(q.sequence);
+        }) > 0) {}
+        return seqs;
+    }
+}
+
+TEST(ShmRingTest, ReadersJoinLiveAndEachGetsEveryRecord) {
+    const std::string name = test_segment("ring");
+    ShmRingWriter writer(name, 64);
+    publish_quote(writer, 1); // before anyone joined
+
+    ShmRingReader a(name);
+    ShmRingReader b(name);
+    for (uint64_t i = 2; i <= 40; ++i) publish_quote(writer, i);
+
+    std::vector<uint64_t> expected;
+    for (uint64_t i = 2; i <= 40; ++i) expected.push_back(i);
+    EXPECT_EQ(drain(a), expected);
+    EXPECT_EQ(b.backlog(), 39u);
+    EXPECT_EQ(drain(b), expected);
+    EXPECT_EQ(a.lost(), 0u);
+    EXPECT_EQ(b.backlog(), 0u);
+}
+
+TEST(ShmRingTest, LappedReaderCountsLossAndResyncs) {
+    const std::string name = test_segment("lap");
+    ShmRingWriter writer(name, 16);
+    ShmRingReader reader(name);
+
+    for (uint64_t i = 0; i < 100; ++i) publish_quote(writer, i);
+    const std::vector<uint64_t> got = drain(reader);
+
+    // resyncs half a ring behind the writer and reads from there without gaps
+    ASSERT_EQ(got.size(), 8u);
+    EXPECT_EQ(got.front(), 92u);
+    EXPECT_EQ(got.back(), 99u);
+    EXPECT_EQ(reader.lost(), 92u);
+    EXPECT_EQ(reader.overruns(), 1u);
+
+    publish_quote(writer, 100);
+    EXPECT_EQ(drain(reader), std::vector<uint64_t>{100});
+}
+
+TEST(ShmRingTest, RejectsBadSizesAndMissingSegments) {
+    EXPECT_THROW(ShmRingWriter(test_segment("bad"), 100), std::invalid_argument);
+    EXPECT_THROW(ShmRingReader(test_segment("missing")), std::runtime_error);
+
+    // the writer removes its segment when it goes away
+    const std::string name = test_segment("gone");
+    { ShmRingWriter writer(name, 16); }
+    EXPECT_THROW(ShmRingReader{name}, std::runtime_error);
+}
+
+TEST(ShmRingTest, ConcurrentReaderSeesAnInOrderStreamWithoutTornRecords) {
+    const std::string name = test_segment("race");
+    ShmRingWriter writer(name, 256);
+    ShmRingReader reader(name);
+    constexpr uint64_t total = 200'000;
+
+    std::atomic<bool> done{false};
+    uint64_t last = 0, bad = 0, got = 0;
+    std::thread consumer([&] {
+        auto check = [&](char, const char*, const std::byte* payload, std::size_t) {
+            types::Quote q;
+            std::memcpy(&q, payload, sizeof(q));
+            // every field written from the same counter, a torn copy would mix two records
+            if (q.sequence <= last || q.bid_price != static_cast<double>(q.sequence) || q.ask_size != q.sequence) ++bad;
+            last = q.sequence;
+            ++got;
+        };
+        while (!done.load(std::memory_order_acquire)) {
+            if (reader.poll(check) == 0) std::this_thread::yield();
+        }
+        reader.poll(check, ~std::size_t{0});
+    });
+
+    for (uint64_t i = 1; i <= total; ++i) {
+        types::Quote q{};
+        std::strncpy(q.symbol, "AAPL", sizeof(q.symbol) - 1);
+        q.sequence = i;
+        q.bid_price = static_cast<double>(i);
+        q.ask_size = static_cast<decltype(q.ask_size)>(i);
+        char topic[types::topic_header_size];
+        types::Messages::encode_topic(q, topic);
+        writer.publish(topic, &q, sizeof(q));
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    EXPECT_EQ(bad, 0u);
+    EXPECT_EQ(got + reader.lost(), total);
+}
+
+TEST(ShmTransportTest, DisseminatorToFeedHandlerWithFiltering) {
+    using Queue = SpinSpscQueue<types::MarketDataMsg, CustomSpscQueue<types::MarketDataMsg, 1024>>;
+    const std::string name = test_segment("pipeline");
+    Queue queue;
+    ShmDisseminator<Queue> disseminator(queue, name, 1024);
+    ShmFeedHandler feed_handler(name);
+
+    std::atomic<int> quotes{0}, trades{0};
+    std::atomic<bool> other_symbol{false};
+    feed_handler.set_quote_callback([&](const types::Quote& q, uint64_t) {
+        if (std::string_view(q.symbol) != "AAPL") other_symbol = true;
+        quotes++;
+    });
+    feed_handler.set_trade_callback([&](const types::Trade&, uint64_t) { trades++; });
+    feed_handler.subscribe("AAPL");
+    feed_handler.start();
+    disseminator.start();
+
+    for (int i = 0; i < 50; ++i) {
+        types::Quote q{};
+        std::strncpy(q.symbol, i % 2 ? "MSFT" : "AAPL", sizeof(q.symbol) - 1);
+        while (!queue.push(q)) std::this_thread::yield();
+        types::Trade t{};
+        std::strncpy(t.symbol, "AAPL", sizeof(t.symbol) - 1);
+        while (!queue.push(t)) std::this_thread::yield();
+    }
+    for (int i = 0; i < 200 && (quotes.load() < 25 || trades.load() < 50); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    disseminator.stop();
+    feed_handler.stop();
+
+    EXPECT_EQ(quotes.load(), 25);
+    EXPECT_EQ(trades.load(), 50);
+    EXPECT_FALSE(other_symbol.load());
+    EXPECT_EQ(feed_handler.lost(), 0u);
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/feedhandler/SnapshotSplicer.h"
+#include "../src/feedhandler/SubscriptionFilter.h"
+#include "../src/snapshot/SnapshotClient.h"
+#include "../src/snapshot/SnapshotServer.h"
+
+namespace {
+    types::Quote snapshot_quote(const char* symbol, uint32_t id, uint64_t sequence, double bid) {
+        types::Quote q{};
+        std::strncpy(q.symbol, symbol, sizeof(q.symbol) - 1);
+        q.symbol_id = id;
+        q.sequence = sequence;
+        q.bid_price = bid;
+        return q;
+    }
+
+    template <typename T>
+    void append_record(snapshot::Snapshot& snap, const T& msg) {
+        const snapshot::RecordHeader rh{static_cast<uint16_t>(sizeof(T)), types::Messages::tag_of<T>, 0};
+        const std::size_t at = snap.records.size();
+        snap.records.resize(at + sizeof(rh) + types::topic_header_size + sizeof(T));
+        std::memcpy(snap.records.data() + at, &rh, sizeof(rh));
+        types::Messages::encode_topic(msg, reinterpret_cast<char*>(snap.records.data() + at + sizeof(rh)));
+        std::memcpy(snap.records.data() + at + sizeof(rh) + types::topic_header_size, &msg, sizeof(T));
+        ++snap.record_count;
+    }
+
+    std::vector<types::Quote> decode_quotes(const snapshot::Snapshot& snap) {
+        std::vector<types::Quote> quotes;
+        snap.for_each([&](char tag, const std::byte*, const std::byte* payload, std::size_t size) {
+            types::Messages::dispatch(tag, payload, size, [&](const auto& msg) {
+                if constexpr (std::is_same_v<std::decay_t<decltype(msg)>, types::Quote>) quotes.push_back(msg);
+            });
+        });
+        return quotes;
+    }
+}
+
+TEST(SnapshotServerTest, ServesLatestPerSymbolOverTcp) {
+    SnapshotServer server(0, 8);
+    server.record(snapshot_quote("AAPL", 1, 1, 10.0));
+    server.record(snapshot_quote("MSFT", 2, 2, 20.0));
+    server.record(snapshot_quote("AAPL", 1, 3, 11.0));
+    types::OrderCancel cancel{};
+    cancel.symbol_id = 2;
+    cancel.sequence = 4;
+    server.record(cancel);   // not cached, still moves the sequence
+    server.start();
+
+    const snapshot::Snapshot snap = snapshot::fetch("127.0.0.1", server.port());
+    EXPECT_EQ(snap.sequence, 4);
+    ASSERT_EQ(snap.record_count, 2);
+
+    const std::vector<types::Quote> quotes = decode_quotes(snap);
+    ASSERT_EQ(quotes.size(), 2);
+    EXPECT_STREQ(quotes[0].symbol, "AAPL");
+    EXPECT_DOUBLE_EQ(quotes[0].bid_price, 11.0);
+    EXPECT_EQ(quotes[0].sequence, 3);
+    EXPECT_STREQ(quotes[1].symbol, "MSFT");
+    EXPECT_EQ(quotes[1].sequence, 2);
+
+    // trades only, there are none
+    const snapshot::Snapshot trades = snapshot::fetch("127.0.0.1", server.port(), types::Messages::mask_of<types::Trade>);
+    EXPECT_EQ(trades.record_count, 0);
+    // counted once the send returned, which can be after the client already has it
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (server.served() < 2 && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+    EXPECT_EQ(server.served(), 2);
+    server.stop();
+}
+
+TEST(SnapshotServerTest, FetchThrowsWithoutServer) {
+    unsigned short port;
+    {
+        SnapshotServer closed(0, 2);
+        port = closed.port();
+    }
+    EXPECT_THROW(snapshot::fetch("127.0.0.1", port), std::runtime_error);
+}
+
+TEST(SnapshotServerTest, FetchRejectsImplausiblePayloadSize) {
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    socklen_t len = sizeof(addr);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len);
+
+    // one record claiming a terabyte behind it
+    std::jthread fake([listener] {
+        const int client = accept(listener, nullptr, nullptr);
+        snapshot::Request request{};
+        snapshot::recv_all(client, &request, sizeof(request));
+        const snapshot::ResponseHeader header{snapshot::magic, 1, 7, 1ull << 40};
+        snapshot::send_all(client, &header, sizeof(header));
+        close(client);
+    });
+    EXPECT_THROW(snapshot::fetch("127.0.0.1", ntohs(addr.sin_port)), std::runtime_error);
+    fake.join();
+    close(listener);
+}
+
+TEST(SnapshotServerTest, ClientThatStopsReadingDoesNotStallTheNextOne) {
+    constexpr uint32_t symbols = 200'000;   // a snapshot well past the loopback socket buffers
+    SnapshotServer server(0, symbols + 1);
+    for (uint32_t id = 1; id <= symbols; ++id) server.record(snapshot_quote("SYM", id, id, 1.0));
+    server.start();
+
+    const int stuck = socket(AF_INET, SOCK_STREAM, 0);
+    int rcvbuf = 4096;
+    setsockopt(stuck, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server.port());
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    ASSERT_EQ(connect(stuck, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    const snapshot::Request request{snapshot::magic, types::Messages::all_types};
+    ASSERT_TRUE(snapshot::send_all(stuck, &request, sizeof(request)));
+
+    const snapshot::Snapshot snap = snapshot::fetch("127.0.0.1", server.port(), types::Messages::all_types, 10'000);
+    EXPECT_EQ(snap.record_count, symbols);
+
+    const auto start = std::chrono::steady_clock::now();
+    server.stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(3));
+    close(stuck);
+}
+
+TEST(SnapshotSplicerTest, ReplaysOnlyPacketsNewerThanTheSnapshot) {
+    SubscriptionFilter filter;
+    filter.add("AAPL");
+    filter.add("MSFT");
+    filter.seal(1);
+
+    SnapshotSplicer splicer;
+    splicer.begin();
+    EXPECT_THROW(splicer.begin(), std::logic_error);
+    ASSERT_FALSE(splicer.live());
+
+    // live packets arriving while the request is out
+    for (const auto& q : {snapshot_quote("AAPL", 1, 3, 1.0), snapshot_quote("MSFT", 2, 5, 2.0),
+                          snapshot_quote("AAPL", 1, 6, 3.0), snapshot_quote("MSFT", 2, 7, 4.0)}) {
+        splicer.buffer('Q', &q, sizeof(q));
+    }
+
+    std::vector<uint64_t> delivered;
+    auto deliver = [&](char tag, const void* payload, std::size_t size) {
+        types::Messages::dispatch(tag, payload, size, [&](const auto& msg) { delivered.push_back(msg.sequence); });
+    };
+    EXPECT_FALSE(splicer.splice(filter, deliver));
+
+    // taken at 5, MSFT was updated again at 7 while the server was reading, IBM is not subscribed
+    snapshot::Snapshot snap;
+    snap.sequence = 5;
+    append_record(snap, snapshot_quote("AAPL", 1, 3, 1.0));
+    append_record(snap, snapshot_quote("MSFT", 2, 7, 4.0));
+    append_record(snap, snapshot_quote("IBM", 3, 4, 9.0));
+    splicer.hand_over(std::move(snap));
+
+    ASSERT_TRUE(splicer.splice(filter, deliver));
+    EXPECT_EQ(delivered, (std::vector<uint64_t>{3, 7, 6}));
+    EXPECT_TRUE(splicer.idle());
+    EXPECT_EQ(splicer.stats().sequence, 5);
+    EXPECT_EQ(splicer.stats().snapshot_records, 2);
+    EXPECT_EQ(splicer.stats().buffered, 4);
+    EXPECT_EQ(splicer.stats().replayed, 1);
+}
+
+TEST(SnapshotSplicerTest, EmptyHandOverReleasesBufferedPackets) {
+    SubscriptionFilter filter;
+    filter.add("*");
+    filter.seal(1);
+
+    SnapshotSplicer splicer;
+    splicer.begin();
+    const types::Quote q = snapshot_quote("AAPL", 1, 9, 1.0);
+    splicer.buffer('Q', &q, sizeof(q));
+    splicer.hand_over({});
+
+    int delivered = 0;
+    EXPECT_TRUE(splicer.splice(filter, [&](char, const void*, std::size_t) { ++delivered; }));
+    EXPECT_EQ(delivered, 1);
+    EXPECT_TRUE(splicer.live());
+}
+
+TEST(SnapshotSplicerTest, ReplaysBufferedOrderEventsTheSnapshotDoesNotCover) {
+    SubscriptionFilter filter;
+    filter.add("AAPL");
+    filter.seal(1);
+
+    SnapshotSplicer splicer;
+    splicer.begin();
+
+    // the add is older than the snapshot but only quotes and trades are in it
+    types::OrderAdd add{};
+    std::strncpy(add.symbol, "AAPL", sizeof(add.symbol) - 1);
+    add.symbol_id = 1;
+    add.sequence = 2;
+    add.order_id = 42;
+    splicer.buffer('A', &add, sizeof(add));
+    const types::Quote stale = snapshot_quote("AAPL", 1, 3, 1.0);
+    splicer.buffer('Q', &stale, sizeof(stale));
+
+    snapshot::Snapshot snap;
+    snap.sequence = 4;
+    append_record(snap, snapshot_quote("AAPL", 1, 3, 1.0));
+    splicer.hand_over(std::move(snap));
+
+    std::vector<char> tags;
+    uint64_t order_id = 0;
+    ASSERT_TRUE(splicer.splice(filter, [&](char tag, const void* payload, std::size_t size) {
+        tags.push_back(tag);
+        types::Messages::dispatch(tag, payload, size, [&](const auto& msg) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(msg)>, types::OrderAdd>) order_id = msg.order_id;
+        });
+    }));
+    EXPECT_EQ(tags, (std::vector<char>{'Q', 'A'}));
+    EXPECT_EQ(order_id, 42);
+    EXPECT_EQ(splicer.stats().replayed, 1);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "../src/disseminator/ShmDisseminator.h"
+#include "../src/feedhandler/ShmFeedHandler.h"
+#include "../src/generator/RandomWalkGenerator.h"
+#include "../src/monitor/LiveLatency.h"
+#include "../src/shm/StatsSegment.h"
+#include "../src/utils/CustomSpscQueue.h"
+#include "../src/utils/SpinSpscQueue.h"
+
+namespace {
+    using Queue = SpinSpscQueue<types::MarketDataMsg, CustomSpscQueue<types::MarketDataMsg, 1024>>;
+
+    std::string test_segment(const char* what) {
+        return "/mdds_test_" + std::string(what) + "_" + std::to_string(getpid());
+    }
+}
+
+TEST(StatsSegmentTest, ReaderSeesHeaderAndCounters) {
+    const std::string name = test_segment("stats");
+    StatsSegment segment(name, "UDP", "spin", 4096, 50'000);
+    StatsReader reader(name);
+
+    const shm::StatsHeader& h = reader.header();
+    EXPECT_EQ(h.version, shm::stats_version);
+    EXPECT_EQ(h.pid, getpid());
+    EXPECT_EQ(h.queue_capacity, 4096u);
+    EXPECT_EQ(h.target_rate, 50'000u);
+    EXPECT_STREQ(h.transport, "UDP");
+    EXPECT_STREQ(h.queue, "spin");
+
+    shm::bump(segment.generator().pushed, 10);
+    shm::bump(segment.disseminator().sent, 7);
+    shm::bump(segment.feed_handler().sequence_gaps, 2);
+    LatencyHistogram total;
+    for (uint64_t ns = 1'000; ns <= 100'000; ns += 1'000) total.record(ns);
+    const LiveAggregator::Report window{1.0, 100, 100.0, 50'000, 99'000, 100'000, 100'000, 3, 25'000.4};
+    shm::publish_latency(segment.latency(), total, 3, &window);
+
+    const StatsReader::Snapshot s = reader.snapshot();
+    EXPECT_EQ(s.pushed, 10u);
+    EXPECT_EQ(s.sent, 7u);
+    EXPECT_EQ(s.queue_depth(), 3u);
+    EXPECT_EQ(s.sequence_gaps, 2u);
+    EXPECT_EQ(s.latency_drops, 3u);
+    EXPECT_EQ(s.window_p99_ns, 99'000u);
+    EXPECT_EQ(s.window_target_rate, 25'000u);
+    EXPECT_NE(s.latency_updated_ns, 0u);
+    EXPECT_EQ(s.latency.count(), 100u);
+    EXPECT_EQ(s.latency.percentile(0.5), total.percentile(0.5));
+    EXPECT_FALSE(reader.replaced(name));
+}
+
+TEST(StatsSegmentTest, RejectsMissingAndForeignSegments) {
+    EXPECT_THROW(StatsReader(test_segment("absent")), std::runtime_error);
+
+    // a market data ring under the name is not a stats segment
+    const std::string name = test_segment("not_stats");
+    ShmRingWriter ring(name, 16);
+    EXPECT_THROW(StatsReader{name}, std::runtime_error);
+}
+
+TEST(StatsSegmentTest, NoticesTheRunEnding) {
+    const std::string name = test_segment("ending");
+    auto segment = std::make_unique<StatsSegment>(name, "SHM", "spin", 1024, 1000);
+    StatsReader reader(name);
+    segment.reset();
+    EXPECT_TRUE(reader.replaced(name));
+}
+
+// every stage counts into its block while the pipeline runs
+TEST(StatsSegmentTest, PipelineStagesCount) {
+    const std::string ring = test_segment("stats_ring");
+    const std::string name = test_segment("stats_pipeline");
+    const std::string symbols = ::testing::TempDir() + "stats_symbols.txt";
+    std::ofstream(symbols) << "AAPL\nMSFT\nNVDA\n";
+
+    StatsSegment segment(name, "SHM", "spin", 1024, 5000);
+    Queue queue;
+    ShmDisseminator<Queue> disseminator(queue, ring, 1024);
+    ShmFeedHandler feed_handler(ring);
+    disseminator.set_stats(&segment.disseminator());
+    feed_handler.set_stats(&segment.feed_handler());
+    feed_handler.set_quote_callback([](const types::Quote&, uint64_t) {});
+    feed_handler.set_trade_callback([](const types::Trade&, uint64_t) {});
+    feed_handler.subscribe("*");
+    feed_handler.start();
+    disseminator.start();
+
+    RandomWalkGenerator<Queue> generator(queue);
+    generator.configure(5000, symbols);
+    generator.set_stats(&segment.generator());
+    generator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    generator.stop();
+    const shm::Drain drain = shm::wait_drained(segment.generator(), segment.disseminator(), segment.feed_handler());
+    EXPECT_TRUE(drain.complete);
+    EXPECT_EQ(drain.received, drain.pushed);
+    disseminator.stop();
+    feed_handler.stop();
+
+    const StatsReader::Snapshot s = StatsReader(name).snapshot();
+    EXPECT_GT(s.pushed, 100u);
+    EXPECT_EQ(s.sent, s.pushed);
+    EXPECT_EQ(s.received, s.sent);
+    EXPECT_EQ(s.sequence_gaps, 0u);
+    EXPECT_EQ(s.queue_depth(), 0u);
+    EXPECT_GT(s.sent_bytes, s.sent * sizeof(types::Trade) / 2);
+    EXPECT_EQ(s.received_bytes, s.sent_bytes);
+}
+
+// a receiver that lost the tail of the stream never catches up, the wait ends once nothing moves
+TEST(StatsSegmentTest, DrainGivesUpOnLostTail) {
+    shm::GeneratorStats generator{};
+    shm::DisseminatorStats disseminator{};
+    shm::FeedHandlerStats feed_handler{};
+    shm::bump(generator.pushed, 100);
+    shm::bump(disseminator.sent, 100);
+    shm::bump(feed_handler.received, 90);
+    shm::bump(feed_handler.sequence_gaps, 5);
+
+    const shm::Drain drain = shm::wait_drained(generator, disseminator, feed_handler, std::chrono::milliseconds(30));
+    EXPECT_FALSE(drain.complete);
+    EXPECT_GE(drain.waited.count(), 30);
+    EXPECT_LT(drain.waited.count(), 1000);
+    EXPECT_EQ(drain.received, 90u);
+
+    // a hole in the middle is accounted for by the gap counter, the last sequence did arrive
+    shm::bump(feed_handler.received, 5);
+    EXPECT_TRUE(shm::wait_drained(generator, disseminator, feed_handler).complete);
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <thread>
+#include <vector>
+
+#include "../src/feedhandler/SubscriptionFilter.h"
+
+namespace {
+    constexpr auto quotes = types::Messages::mask_of<types::Quote>;
+    constexpr auto trades = types::Messages::mask_of<types::Trade>;
+}
+
+TEST(SubscriptionFilterTest, ExactPrefixAndGlobPatterns) {
+    SubscriptionFilter filter;
+    filter.add("AAPL");
+    filter.add("MS*");
+    filter.add("N?DA");
+    filter.seal(1);
+
+    EXPECT_TRUE(filter.matches('Q', pack_symbol("AAPL")));
+    EXPECT_FALSE(filter.matches('Q', pack_symbol("AAP")));
+    EXPECT_TRUE(filter.matches('T', pack_symbol("MSFT")));
+    EXPECT_TRUE(filter.matches('T', pack_symbol("MS")));
+    EXPECT_FALSE(filter.matches('T', pack_symbol("M")));
+    EXPECT_TRUE(filter.matches('Q', pack_symbol("NVDA")));
+    EXPECT_FALSE(filter.matches('Q', pack_symbol("NVDAX")));
+    EXPECT_FALSE(filter.matches('Z', pack_symbol("AAPL"))); // unknown tag
+
+    SubscriptionFilter everything;
+    everything.add("*");
+    everything.seal(1);
+    EXPECT_TRUE(everything.matches('E', pack_symbol("ANYTHING")));
+}
+
+TEST(SubscriptionFilterTest, TypeMasksAndRemoval) {
+    SubscriptionFilter filter;
+    filter.add("AAPL", quotes);
+    filter.add("AAPL", trades);
+    filter.add("GO*", trades);
+    filter.seal(1);
+    EXPECT_TRUE(filter.matches('Q', pack_symbol("AAPL")));
+    EXPECT_FALSE(filter.matches('A', pack_symbol("AAPL")));
+    EXPECT_FALSE(filter.matches('Q', pack_symbol("GOOG")));
+    EXPECT_TRUE(filter.matches('T', pack_symbol("GOOG")));
+
+    filter.remove("AAPL", quotes);
+    filter.remove("GO*");
+    filter.seal(2);
+    EXPECT_FALSE(filter.matches('Q', pack_symbol("AAPL")));
+    EXPECT_TRUE(filter.matches('T', pack_symbol("AAPL")));
+    EXPECT_FALSE(filter.matches('T', pack_symbol("GOOG")));
+    EXPECT_EQ(filter.pattern_count(), 0);
+}
+
+TEST(SubscriptionFilterTest, ZmqTopicsFallBackToTypePrefixes) {
+    SubscriptionFilter few;
+    few.add("AAPL", quotes | trades);
+    few.add("MS*", quotes);
+    few.seal(1);
+    EXPECT_EQ(few.zmq_topics(), (std::vector<std::string>{"Q:AAPL", "Q:MS", "T:AAPL"}));
+
+    SubscriptionFilter many;
+    for (int i = 0; i < 1000; ++i) {
+        many.add("S" + std::to_string(i), quotes);
+    }
+    many.seal(1);
+    EXPECT_EQ(many.zmq_topics(), (std::vector<std::string>{"Q:"}));
+}
+
+TEST(FlatSymbolSetTest, AgreesWithUnorderedMapUnderChurn) {
+    FlatSymbolSet flat;
+    std::unordered_map<uint64_t, SymbolTypeMask> reference;
+    std::mt19937 rng(1);
+
+    // small key space so erase/reinsert hits tombstones and rehashes
+    for (int i = 0; i < 50'000; ++i) {
+        const uint64_t key = pack_symbol("K" + std::to_string(rng() % 3000));
+        const SymbolTypeMask mask = rng() % 4 == 0 ? 0 : (rng() % 7) + 1;
+        flat.set(key, mask);
+        if (mask == 0) reference.erase(key);
+        else reference[key] = mask;
+    }
+
+    EXPECT_EQ(flat.size(), reference.size());
+    for (const auto& [key, mask] : reference) {
+        ASSERT_EQ(flat.find(key), mask);
+    }
+    EXPECT_EQ(flat.find(pack_symbol("MISSING")), 0);
+
+    std::size_t visited = 0;
+    flat.for_each([&](uint64_t key, SymbolTypeMask mask) {
+        ++visited;
+        EXPECT_EQ(reference.at(key), mask);
+    });
+    EXPECT_EQ(visited, reference.size());
+}
+
+TEST(SubscriptionFilterTest, BitmapByIdAgreesWithSymbolLookup) {
+    auto directory = std::make_shared<const SymbolDirectory>(
+        std::vector<std::string>{"AAPL", "MSFT", "NVDA", "GOOG", "AMZN"});
+    SubscriptionFilter filter;
+    filter.add("AAPL", quotes);
+    filter.add("A*", trades);
+    filter.add("?SFT");
+    filter.set_directory(directory);
+    filter.seal(1);
+
+    std::vector<SubscriptionFilter::PacketKey> keys;
+    for (uint32_t id = 1; id < directory->id_limit(); ++id) {
+        const uint64_t symbol = pack_symbol(directory->symbol(id));
+        for (const char tag : {'Q', 'T', 'A'}) {
+            EXPECT_EQ(filter.matches(tag, symbol, id), filter.matches(tag, symbol)) << directory->symbol(id) << tag;
+            keys.push_back({symbol, id, tag});
+            keys.push_back({symbol, types::no_symbol_id, tag});
+        }
+    }
+    EXPECT_TRUE(filter.matches('T', pack_symbol("AMZN"), directory->id_of("AMZN")));
+    EXPECT_FALSE(filter.matches('Q', pack_symbol("AMZN"), directory->id_of("AMZN")));
+    EXPECT_TRUE(filter.matches('A', pack_symbol("MSFT"), directory->id_of("MSFT")));
+
+    auto out = std::make_unique<bool[]>(keys.size());
+    filter.matches_batch(keys.data(), keys.size(), out.get());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(out[i], filter.matches(keys[i].tag, keys[i].symbol, keys[i].symbol_id));
+    }
+}
+
+TEST(FilterPublisherTest, ReaderSeesWholeBatchesOnly) {
+    FilterPublisher publisher;
+    std::vector<std::string> universe;
+    for (int i = 0; i < 10'000; ++i) {
+        universe.push_back("S" + std::to_string(i));
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<bool> torn{false};
+    std::thread reader([&] {
+        while (!done.load(std::memory_order_acquire)) {
+            const SubscriptionFilter& filter = publisher.acquire();
+            // every published generation has either none or all of the universe
+            const std::size_t n = filter.symbol_count();
+            if (n != 0 && n != universe.size()) torn.store(true);
+        }
+    });
+
+    for (int round = 0; round < 20; ++round) {
+        publisher.update([&](SubscriptionFilter& f) { for (const auto& s : universe) f.add(s); });
+        publisher.update([&](SubscriptionFilter& f) { f.clear(); });
+    }
+    while (publisher.acknowledged_generation() < publisher.published_generation()) {
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    EXPECT_FALSE(torn.load());
+    EXPECT_EQ(publisher.published_generation(), 40);
+}
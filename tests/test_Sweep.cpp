@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/utils/Sweep.h"
+
+TEST(SweepTest, ExpandsGridLastAxisFastest) {
+    const std::vector<sweep::Axis> axes = sweep::parse("transport=udp,shm; size = 1024, 65536 ;rate=100000");
+    ASSERT_EQ(axes.size(), 3u);
+    EXPECT_EQ(axes[1].key, "size");
+    EXPECT_EQ(axes[1].values, (std::vector<std::string>{"1024", "65536"}));
+
+    const std::vector<sweep::Point> points = sweep::expand(axes);
+    ASSERT_EQ(points.size(), 4u);
+    EXPECT_EQ(points[1][0].second, "udp");
+    EXPECT_EQ(points[1][1].second, "65536");
+    EXPECT_EQ(points[2][0].second, "shm");
+    EXPECT_EQ(sweep::label(2, points[2]), "003_transport-shm_size-1024_rate-100000");
+
+    BenchmarkConfig config;
+    for (const auto& [key, value] : points[3]) sweep::apply(config, key, value);
+    EXPECT_EQ(config.transport, TransportProtocol::SharedMemory);
+    EXPECT_EQ(config.queue_size, 65536u);
+    EXPECT_EQ(config.message_rate, 100000u);
+    EXPECT_EQ(config.queue_strategy, QueueWaitStrategy::Spin); // not swept, stays as given
+}
+
+TEST(SweepTest, ReadsGridFile) {
+    const std::string path = ::testing::TempDir() + "sweep_grid.txt";
+    std::ofstream(path) << "# queue matrix\n"
+                           "--queue = spin, waitable\n"
+                           "\n"
+                           "underlying = custom, boost   # both backends\n"
+                           "latency-format = binary\n";
+    const std::vector<sweep::Axis> axes = sweep::load(path);
+    ASSERT_EQ(axes.size(), 3u);
+    EXPECT_EQ(axes[0].key, "queue");
+    EXPECT_EQ(sweep::expand(axes).size(), 4u);
+
+    BenchmarkConfig config;
+    sweep::apply(config, "latency-format", "binary");
+    sweep::apply(config, "conflate", "on");
+    EXPECT_TRUE(config.binary_latencies);
+    EXPECT_TRUE(config.conflate);
+}
+
+TEST(SweepTest, RejectsBadGridsUpFront) {
+    EXPECT_THROW(sweep::parse("transport=udp,tcp"), std::invalid_argument);
+    EXPECT_THROW(sweep::parse("rate=100k"), std::invalid_argument);
+    EXPECT_THROW(sweep::parse("colour=red"), std::invalid_argument);
+    EXPECT_THROW(sweep::parse("rate=1000;rate=2000"), std::invalid_argument);
+    EXPECT_THROW(sweep::parse("rate="), std::invalid_argument);
+    EXPECT_THROW(sweep::parse("rate"), std::invalid_argument);
+    EXPECT_THROW(sweep::parse(" ; "), std::invalid_argument);
+}
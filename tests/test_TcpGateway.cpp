@@ -0,0 +1,314 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/gateway/ClientConnection.h"
+
+#include "../src/gateway/TcpGateway.h"
+
+namespace {
+    struct ReceivedFrame {
+        gateway::FrameHeader header;
+        types::Quote quote;
+        std::string topic;
+    };
+
+    int connect_gateway(unsigned short port, int rcvbuf = 0) {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (rcvbuf > 0) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        timeval timeout{0, 200'000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void send_line(int fd, const std::string& line) {
+        const std::string with_newline = line + "\n";
+        ASSERT_EQ(send(fd, with_newline.data(), with_newline.size(), 0), static_cast<ssize_t>(with_newline.size()));
+    }
+
+    bool recv_exact(int fd, void* data, std::size_t size) {
+        auto* p = static_cast<char*>(data);
+        while (size > 0) {
+            const ssize_t n = recv(fd, p, size, 0);
+            if (n <= 0) return false;
+            p += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    // reads quote frames until the gateway goes quiet for the receive timeout
+    std::vector<ReceivedFrame> read_quotes(int fd) {
+        std::vector<ReceivedFrame> frames;
+        ReceivedFrame frame{};
+        char topic[types::topic_header_size];
+        while (recv_exact(fd, &frame.header, sizeof(frame.header))) {
+            std::vector<char> payload(frame.header.payload_size);
+            if (!recv_exact(fd, topic, sizeof(topic)) || !recv_exact(fd, payload.data(), payload.size())) break;
+            frame.topic.assign(topic, 2 + ::strnlen(topic + 2, 8));
+            if (frame.header.tag == 'Q' && payload.size() == sizeof(types::Quote)) std::memcpy(&frame.quote, payload.data(), sizeof(types::Quote));
+            frames.push_back(frame);
+        }
+        return frames;
+    }
+
+    types::Quote gateway_quote(const char* symbol, double bid) {
+        types::Quote q{};
+        std::strncpy(q.symbol, symbol, sizeof(q.symbol) - 1);
+        q.bid_price = bid;
+        return q;
+    }
+
+    template <typename Pred>
+    bool wait_for(Pred&& pred, std::chrono::milliseconds limit = std::chrono::milliseconds(3000)) {
+        const auto deadline = std::chrono::steady_clock::now() + limit;
+        while (!pred()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+}
+
+TEST(GatewayProtocolTest, ParsesCommands) {
+    const auto sub = gateway::parse_command("SUB AAPL");
+    ASSERT_TRUE(sub);
+    EXPECT_TRUE(sub->subscribe);
+    EXPECT_EQ(sub->pattern, "AAPL");
+    EXPECT_EQ(sub->types, types::Messages::all_types);
+
+    const auto unsub = gateway::parse_command("UNSUB MS* QT\r");
+    ASSERT_TRUE(unsub);
+    EXPECT_FALSE(unsub->subscribe);
+    EXPECT_EQ(unsub->types, (types::Messages::mask_of<types::Quote, types::Trade>));
+
+    EXPECT_FALSE(gateway::parse_command("SUB"));
+    EXPECT_FALSE(gateway::parse_command("SUB AAPL Z"));
+    EXPECT_FALSE(gateway::parse_command("HELLO AAPL"));
+}
+
+TEST(TcpGatewayTest, FansOutToSubscribedClientsOnly) {
+    GatewayConfig config;
+    config.loops = 2;
+    TcpGateway gw(config);
+    gw.start();
+
+    const int aapl = connect_gateway(gw.port());
+    const int ms = connect_gateway(gw.port());
+    ASSERT_GE(aapl, 0);
+    ASSERT_GE(ms, 0);
+    send_line(aapl, "SUB AAPL");
+    send_line(ms, "SUB MS* Q");
+    ASSERT_TRUE(wait_for([&] { return gw.stats().clients == 2; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));   // commands are applied by the loops
+
+    gw.publish(gateway_quote("AAPL", 1.0), 11);
+    gw.publish(gateway_quote("MSFT", 2.0), 12);
+    types::Trade trade{};
+    std::strncpy(trade.symbol, "MSFT", sizeof(trade.symbol) - 1);
+    gw.publish(trade, 13);
+
+    const auto a_frames = read_quotes(aapl);
+    ASSERT_EQ(a_frames.size(), 1);
+    EXPECT_EQ(a_frames[0].topic, "Q:AAPL");
+    EXPECT_EQ(a_frames[0].header.gateway_ts, 11);
+    EXPECT_DOUBLE_EQ(a_frames[0].quote.bid_price, 1.0);
+
+    const auto m_frames = read_quotes(ms);
+    ASSERT_EQ(m_frames.size(), 1);
+    EXPECT_EQ(m_frames[0].topic, "Q:MSFT");
+
+    close(aapl);
+    close(ms);
+    EXPECT_TRUE(wait_for([&] { return gw.stats().clients == 0; }));
+    gw.stop();
+}
+
+TEST(TcpGatewayTest, DisconnectsClientThatStopsReading) {
+    GatewayConfig config;
+    config.client_buffer_bytes = 4096;
+    config.socket_send_buffer = 4096;
+    config.policy = gateway::SlowClientPolicy::Disconnect;
+    TcpGateway gw(config);
+    gw.start();
+
+    const int fd = connect_gateway(gw.port(), 4096);
+    send_line(fd, "SUB *");
+    ASSERT_TRUE(wait_for([&] { return gw.stats().clients == 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    for (int burst = 0; burst < 100 && gw.stats().slow_disconnects == 0; ++burst) {
+        for (int i = 0; i < 500; ++i) gw.publish(gateway_quote("AAPL", i), 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_TRUE(wait_for([&] { return gw.stats().slow_disconnects == 1 && gw.stats().clients == 0; }));
+    close(fd);
+    gw.stop();
+}
+
+TEST(TcpGatewayTest, ConflatesForSlowClientUntilItCatchesUp) {
+    GatewayConfig config;
+    config.client_buffer_bytes = 4096;
+    config.socket_send_buffer = 4096;
+    config.policy = gateway::SlowClientPolicy::Conflate;
+    TcpGateway gw(config);
+    gw.start();
+
+    const int fd = connect_gateway(gw.port(), 4096);
+    send_line(fd, "SUB *");
+    ASSERT_TRUE(wait_for([&] { return gw.stats().clients == 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    constexpr int updates = 20'000;
+    for (int i = 1; i <= updates; ++i) {
+        gw.publish(gateway_quote(i % 2 ? "AAPL" : "MSFT", i), 0);
+        if (i % 500 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(wait_for([&] { const auto s = gw.stats(); return s.frames + s.conflated + s.dropped >= updates; }));
+    EXPECT_GT(gw.stats().conflated, 0);
+
+    const auto frames = read_quotes(fd);
+    ASSERT_FALSE(frames.empty());
+    EXPECT_LT(frames.size(), static_cast<std::size_t>(updates));
+    EXPECT_EQ(gw.stats().slow_disconnects, 0);
+
+    // the last word for each symbol is its latest update, and it never went backwards on the way
+    double last_aapl = 0, last_msft = 0;
+    bool any_conflated = false;
+    for (const auto& f : frames) {
+        double& last = f.topic == "Q:AAPL" ? last_aapl : last_msft;
+        EXPECT_GT(f.quote.bid_price, last);
+        last = f.quote.bid_price;
+        any_conflated |= (f.header.flags & gateway::frame_conflated) != 0;
+    }
+    EXPECT_TRUE(any_conflated);
+    if (gw.stats().dropped == 0) {
+        EXPECT_DOUBLE_EQ(last_aapl, updates - 1);
+        EXPECT_DOUBLE_EQ(last_msft, updates);
+    }
+    close(fd);
+    gw.stop();
+}
+
+TEST(TcpGatewayTest, ConflatePolicyDisconnectsOnOrderEvents) {
+    GatewayConfig config;
+    config.client_buffer_bytes = 4096;
+    config.socket_send_buffer = 4096;
+    config.policy = gateway::SlowClientPolicy::Conflate;
+    TcpGateway gw(config);
+    gw.start();
+
+    const int fd = connect_gateway(gw.port(), 4096);
+    send_line(fd, "SUB *");
+    ASSERT_TRUE(wait_for([&] { return gw.stats().clients == 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    types::OrderAdd add{};
+    std::strncpy(add.symbol, "AAPL", sizeof(add.symbol) - 1);
+    for (int burst = 0; burst < 100 && gw.stats().slow_disconnects == 0; ++burst) {
+        for (int i = 0; i < 500; ++i) {
+            add.order_id = static_cast<uint64_t>(burst) * 500 + i;
+            gw.publish(add, 0);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_TRUE(wait_for([&] { return gw.stats().slow_disconnects == 1 && gw.stats().clients == 0; }));
+    EXPECT_EQ(gw.stats().conflated, 0);
+    close(fd);
+    gw.stop();
+}
+
+TEST(TcpGatewayTest, RejectsClientBufferSmallerThanAFrame) {
+    GatewayConfig config;
+    config.client_buffer_bytes = 32;
+    config.policy = gateway::SlowClientPolicy::Conflate;
+    EXPECT_THROW(TcpGateway{config}, std::invalid_argument);
+}
+
+TEST(TcpGatewayTest, OrderEventGoesOutBehindParkedQuotes) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+    int small = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    ClientConnection conn(fds[0], 256 * 1024, nullptr);
+
+    auto append_or_park = [&conn](char tag, const void* msg, std::size_t size) {
+        char topic[types::topic_header_size];
+        topic[0] = tag;
+        topic[1] = ':';
+        std::memcpy(topic + 2, msg, 8);
+        const gateway::FrameHeader header{static_cast<uint16_t>(size), tag, 0, 0, 0};
+        if (conn.append(header, topic, msg)) return true;
+        if (gateway::ConflatedTypes::bit_of_tag(tag) != 0) conn.conflate(header, topic, msg);
+        return false;
+    };
+
+    // fill the ring, then park one quote behind it
+    double bid = 1;
+    while (true) {
+        const auto q = gateway_quote("AAPL", bid);
+        if (!append_or_park('Q', &q, sizeof(q))) break;
+        ++bid;
+    }
+    ASSERT_TRUE(conn.conflating());
+
+    // the socket takes only part of the ring, the quote stays parked but there is room again
+    uint64_t calls = 0, bytes = 0;
+    ASSERT_TRUE(conn.flush(calls, bytes));
+    ASSERT_GT(conn.pending(), 0);
+    ASSERT_TRUE(conn.conflating());
+
+    types::OrderAdd add{};
+    std::strncpy(add.symbol, "AAPL", sizeof(add.symbol) - 1);
+    add.order_id = 7;
+    EXPECT_TRUE(append_or_park('A', &add, sizeof(add)));
+    EXPECT_FALSE(conn.conflating());
+
+    // the client sees every quote in order, the parked one last, then the order event
+    std::vector<char> received;
+    char chunk[4096];
+    while (conn.has_output() || received.empty()) {
+        ASSERT_TRUE(conn.flush(calls, bytes));
+        for (ssize_t n; (n = recv(fds[1], chunk, sizeof(chunk), 0)) > 0;) received.insert(received.end(), chunk, chunk + n);
+    }
+    for (ssize_t n; (n = recv(fds[1], chunk, sizeof(chunk), 0)) > 0;) received.insert(received.end(), chunk, chunk + n);
+
+    std::vector<char> tags;
+    double last_bid = 0;
+    for (std::size_t at = 0; at < received.size();) {
+        gateway::FrameHeader header;
+        std::memcpy(&header, received.data() + at, sizeof(header));
+        const char* payload = received.data() + at + sizeof(header) + types::topic_header_size;
+        if (header.tag == 'Q') {
+            types::Quote q;
+            std::memcpy(&q, payload, sizeof(q));
+            EXPECT_DOUBLE_EQ(q.bid_price, last_bid + 1);
+            last_bid = q.bid_price;
+        }
+        tags.push_back(header.tag);
+        at += sizeof(header) + types::topic_header_size + header.payload_size;
+    }
+    EXPECT_DOUBLE_EQ(last_bid, bid);
+    ASSERT_FALSE(tags.empty());
+    EXPECT_EQ(tags.back(), 'A');
+    EXPECT_EQ(std::count(tags.begin(), tags.end(), 'A'), 1);
+    close(fds[1]);
+}
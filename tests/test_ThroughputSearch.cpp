@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "../src/utils/ThroughputSearch.h"
+
+namespace {
+    search::Trial trial(double p99_us, double loss_pct = 0.0, double delivered = 1.0) {
+        return {100'000, p99_us / 2, p99_us, p99_us * 2, loss_pct, delivered};
+    }
+
+    // drives a search against a pipeline whose knee is at `knee` msg/s, returns the rates it tried
+    std::vector<uint32_t> search_for(search::RateSearch& rates, uint32_t knee) {
+        std::vector<uint32_t> tried;
+        while (const auto rate = rates.next()) {
+            tried.push_back(*rate);
+            rates.report(*rate, *rate <= knee);
+            if (tried.size() > 100) break;
+        }
+        return tried;
+    }
+}
+
+TEST(ThroughputSearchTest, JudgesOnTheConfidenceInterval) {
+    const search::Slo slo{50.0, 0.1};
+    EXPECT_EQ(search::judge({trial(20), trial(22), trial(21)}, slo), search::Verdict::Pass);
+    EXPECT_EQ(search::judge({trial(80), trial(85), trial(90)}, slo), search::Verdict::Fail);
+    // mean under the limit, but too spread out to be sure
+    EXPECT_EQ(search::judge({trial(10), trial(60), trial(45)}, slo), search::Verdict::Unsure);
+    EXPECT_TRUE(search::passes_on_means({trial(10), trial(60), trial(45)}, slo));
+
+    // latency fine, but losing messages or not keeping up
+    EXPECT_EQ(search::judge({trial(20, 0.5), trial(20, 0.6), trial(20, 0.55)}, slo), search::Verdict::Fail);
+    EXPECT_EQ(search::judge({trial(20, 0, 0.90), trial(20, 0, 0.91), trial(20, 0, 0.90)}, slo), search::Verdict::Fail);
+    EXPECT_EQ(search::judge({}, slo), search::Verdict::Unsure);
+}
+
+TEST(ThroughputSearchTest, RampsThenBisectsToTheKnee) {
+    search::RateSearch rates(100'000, 5'000'000);
+    const std::vector<uint32_t> tried = search_for(rates, 730'000);
+    ASSERT_GE(tried.size(), 4u);
+    EXPECT_EQ(tried[0], 100'000u);
+    EXPECT_EQ(tried[1], 200'000u);
+    EXPECT_EQ(tried[3], 800'000u);  // first failure, then bisecting
+    EXPECT_LE(rates.best(), 730'000u);
+    EXPECT_GE(rates.best(), 730'000u * 0.95);
+    EXPECT_GT(rates.first_failed(), 730'000u);
+    EXPECT_LE(rates.first_failed() - rates.best(), rates.best() * 0.05 + 1);
+    EXPECT_FALSE(rates.capped());
+    EXPECT_LT(tried.size(), 12u);
+}
+
+TEST(ThroughputSearchTest, StopsAtTheEnds) {
+    search::RateSearch capped(100'000, 300'000);
+    EXPECT_EQ(search_for(capped, 10'000'000), (std::vector<uint32_t>{100'000, 200'000, 300'000}));
+    EXPECT_TRUE(capped.capped());
+    EXPECT_EQ(capped.best(), 300'000u);
+
+    search::RateSearch hopeless(100'000, 5'000'000);
+    EXPECT_EQ(search_for(hopeless, 50'000).size(), 1u);
+    EXPECT_EQ(hopeless.best(), 0u);
+
+    EXPECT_THROW(search::RateSearch(0, 100), std::invalid_argument);
+    EXPECT_THROW(search::RateSearch(200, 100), std::invalid_argument);
+}
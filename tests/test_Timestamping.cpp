@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/disseminator/UdpDisseminator.h"
+#include "../src/feedhandler/UdpFeedHandler.h"
+#include "../src/monitor/LatencyMonitor.h"
+#include "../src/utils/CustomSpscQueue.h"
+#include "../src/utils/SpinSpscQueue.h"
+#include "../src/utils/Timestamping.h"
+
+namespace {
+    using TestQueue = SpinSpscQueue<types::MarketDataMsg, CustomSpscQueue<types::MarketDataMsg, 1024>>;
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+// software stamps over loopback multicast: every datagram gets an RX stamp, the TX stamps come back off the
+// error queue and are matched to their messages by sequence
+struct StampCase {
+    const char* name;
+    UdpIoOptions io;
+};
+
+class KernelTimestampTest : public ::testing::TestWithParam<StampCase> {};
+
+TEST_P(KernelTimestampTest, SplitsNetworkTimeIntoStages) {
+    UdpIoOptions io = GetParam().io;
+    io.timestamps = KernelTimestamps::Software;
+    TestQueue queue;
+    UdpFeedHandler feedhandler("239.255.0.4", 55590, FunctionSink{}, io);
+    UdpDisseminator<TestQueue> disseminator(queue, "239.255.0.4", 55590, io);
+    LatencyMonitor monitor(1000, ::testing::TempDir() + "kernel_timestamps");
+
+    std::atomic<std::size_t> n{0};
+    uint64_t missing_rx = 0;
+    feedhandler.set_quote_callback([&](const types::Quote& q, uint64_t recv_ts) {
+        const uint64_t kernel_ts = feedhandler.kernel_receive_timestamp();
+        if (kernel_ts == 0) ++missing_rx;
+        monitor.on_quote(q, recv_ts, kernel_ts);
+        n.fetch_add(1, std::memory_order_release);
+    });
+    feedhandler.subscribe("NVDA    ");
+    feedhandler.start();
+    disseminator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    constexpr std::size_t count = 300;
+    for (std::size_t i = 0; i < count; ++i) {
+        types::Quote q{};
+        std::memcpy(q.symbol, "NVDA    ", sizeof(q.symbol));
+        q.enqueue_timestamp = now_ns();
+        queue.push(q);
+        if (i % 50 == 49) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (n.load(std::memory_order_acquire) < count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    disseminator.stop();
+    feedhandler.stop();
+
+    TxTimestampCollector* tx = disseminator.tx_timestamps();
+    ASSERT_NE(tx, nullptr);
+    tx->stop();
+    ASSERT_EQ(n.load(), count);
+    EXPECT_EQ(missing_rx, 0u);
+    EXPECT_EQ(tx->collected(), count);
+    EXPECT_EQ(tx->unmatched(), 0u);
+    EXPECT_EQ(monitor.resolve_tx_timestamps([tx](uint64_t sequence) { return tx->tx_ns(sequence); }), count);
+
+    for (const LatencyRecord& rec : monitor.quote_latencies()) {
+        EXPECT_GT(rec.rx_stack_ns, 0);
+        EXPECT_GT(rec.tx_stack_ns, 0);
+        // the stages add up to the user space send -> receive time
+        EXPECT_EQ(rec.tx_stack_ns + rec.wire_ns + rec.rx_stack_ns, static_cast<int64_t>(rec.network_ns));
+        EXPECT_LT(rec.network_ns, 1'000'000'000u);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Paths, KernelTimestampTest,
+                         ::testing::Values(StampCase{"syscall", {.mode = UdpIoMode::Syscall}},
+                                           StampCase{"batched", {.mode = UdpIoMode::Batched, .batch = 16}},
+                                           StampCase{"gso_gro", {.mode = UdpIoMode::Syscall, .batch = 16, .gso = true, .gro = true}}),
+                         [](const auto& info) { return std::string(info.param.name); });
+
+TEST(KernelTimestampsTest, ParsesNames) {
+    EXPECT_EQ(parse_kernel_timestamps("off"), KernelTimestamps::Off);
+    EXPECT_EQ(parse_kernel_timestamps("software"), KernelTimestamps::Software);
+    EXPECT_EQ(parse_kernel_timestamps("sw"), KernelTimestamps::Software);
+    EXPECT_EQ(parse_kernel_timestamps("hardware"), KernelTimestamps::Hardware);
+    EXPECT_THROW(parse_kernel_timestamps("ptp"), std::invalid_argument);
+}
+
+TEST(KernelTimestampsTest, RejectsIoUring) {
+    TestQueue queue;
+    const UdpIoOptions io{.mode = UdpIoMode::IoUring, .timestamps = KernelTimestamps::Software};
+    EXPECT_THROW(UdpDisseminator<TestQueue>(queue, "239.255.0.4", 55591, io), std::invalid_argument);
+    EXPECT_THROW(UdpFeedHandler("239.255.0.4", 55591, FunctionSink{}, io), std::invalid_argument);
+}
+
+TEST(KernelTimestampsTest, MonitorLeavesStagesWithoutStampsAtZero) {
+    LatencyMonitor monitor(4, ::testing::TempDir() + "kernel_timestamps");
+    types::Quote q{};
+    q.enqueue_timestamp = 1'000;
+    q.disseminate_timestamp = 2'000;
+    q.sequence = 1;
+    monitor.on_quote(q, 10'000);          // no RX stamp
+    q.sequence = 2;
+    monitor.on_quote(q, 10'000, 9'000);   // RX stamp, TX stamp below
+    q.sequence = 3;
+    monitor.on_quote(q, 10'000, 9'500);   // RX stamp, no TX stamp
+
+    EXPECT_EQ(monitor.resolve_tx_timestamps([](uint64_t sequence) -> uint64_t { return sequence == 2 ? 2'500 : 0; }), 1u);
+    const auto& recs = monitor.quote_latencies();
+    ASSERT_EQ(recs.size(), 3u);
+    EXPECT_EQ(recs[0].tx_stack_ns, 0);
+    EXPECT_EQ(recs[0].rx_stack_ns, 0);
+    EXPECT_EQ(recs[1].tx_stack_ns, 500);
+    EXPECT_EQ(recs[1].wire_ns, 6'500);
+    EXPECT_EQ(recs[1].rx_stack_ns, 1'000);
+    EXPECT_EQ(recs[2].tx_stack_ns, 0);
+    EXPECT_EQ(recs[2].wire_ns, 0);
+    EXPECT_EQ(recs[2].rx_stack_ns, 500);
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "../src/disseminator/ShmDisseminator.h"
+#include "../src/feedhandler/ShmFeedHandler.h"
+#include "../src/generator/RandomWalkGenerator.h"
+#include "../src/monitor/LatencyMonitor.h"
+#include "../src/utils/CustomSpscQueue.h"
+#include "../src/utils/SpinSpscQueue.h"
+#include "../src/utils/Trace.h"
+
+namespace {
+    using Queue = SpinSpscQueue<types::MarketDataMsg, CustomSpscQueue<types::MarketDataMsg, 1024>>;
+    using types::TracePoint;
+
+    std::string test_segment(const char* what) {
+        return "/mdds_test_" + std::string(what) + "_" + std::to_string(getpid());
+    }
+
+    std::string symbols_file() {
+        const std::string path = ::testing::TempDir() + "trace_symbols.txt";
+        std::ofstream(path) << "AAPL\nMSFT\nNVDA\n";
+        return path;
+    }
+
+    // refuses every push while blocked, a consumer that has stalled
+    struct StallingQueue {
+        std::vector<types::MarketDataMsg> items;
+        std::atomic<bool> blocked{true};
+
+        bool push(const types::MarketDataMsg& item) {
+            if (blocked.load(std::memory_order_acquire)) return false;
+            items.push_back(item);
+            return true;
+        }
+    };
+}
+
+TEST(TraceTest, ParsesPointLists) {
+    EXPECT_EQ(trace::parse_points("off"), 0u);
+    EXPECT_EQ(trace::parse_points("all"), trace::all_points);
+    EXPECT_EQ(trace::parse_points("intended,delivered"),
+              trace::bit(TracePoint::Intended) | trace::bit(TracePoint::Delivered));
+    EXPECT_EQ(trace::parse_points("pre_send"), trace::bit(TracePoint::PreSend));
+    EXPECT_THROW(trace::parse_points("intended,wire"), std::invalid_argument);
+}
+
+// generator -> queue -> disseminator -> shared memory -> feed handler, every point stamped and in order
+TEST(TraceTest, StampsEveryStageThroughThePipeline) {
+    const std::string name = test_segment("trace");
+    Queue queue;
+    TraceLog log(trace::all_points, 1024, 1000);
+    ShmDisseminator<Queue> disseminator(queue, name, 1024);
+    ShmFeedHandler feed_handler(name);
+    disseminator.set_trace(&log);
+
+    struct Seen {
+        uint64_t sequence;
+        types::TraceTrailer trailer;
+    };
+    std::vector<Seen> seen;
+    std::atomic<std::size_t> untraced{0};
+    auto take = [&](const auto& msg, uint64_t) {
+        const types::TraceTrailer* t = feed_handler.current_trace();
+        if (t == nullptr) {
+            ++untraced;
+            return;
+        }
+        Seen s{msg.sequence, *t};
+        trace::stamp(s.trailer, TracePoint::Delivered);
+        seen.push_back(s);
+    };
+    feed_handler.set_quote_callback(take);
+    feed_handler.set_trade_callback(take);
+    feed_handler.subscribe("*");
+    feed_handler.start();
+    disseminator.start();
+
+    RandomWalkGenerator<Queue> generator(queue);
+    generator.configure(2000, symbols_file());
+    generator.set_trace(&log);
+    generator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    generator.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    disseminator.stop();
+    feed_handler.stop();
+
+    ASSERT_GT(seen.size(), 50u);
+    EXPECT_EQ(untraced.load(), 0u);
+    for (std::size_t i = 0; i < seen.size(); ++i) {
+        const types::TraceTrailer& t = seen[i].trailer;
+        EXPECT_EQ(seen[i].sequence, i + 1);
+        for (std::size_t p = 0; p < types::trace_point_count; ++p) {
+            if (p == static_cast<std::size_t>(TracePoint::PostSend)) continue;
+            EXPECT_NE(t.stamps[p], 0u) << trace::point_names[p];
+            if (p > 0 && p != static_cast<std::size_t>(TracePoint::Received)) {
+                EXPECT_LE(t.stamps[p - 1], t.stamps[p]) << trace::point_names[p];
+            }
+        }
+        EXPECT_LE(trace::at(t, TracePoint::PreSend), trace::at(t, TracePoint::Received));
+        const uint64_t post_send = log.post_send(seen[i].sequence);
+        EXPECT_GE(post_send, trace::at(t, TracePoint::PreSend));
+    }
+}
+
+TEST(TraceTest, UntracedMessagesCarryNoTrailer) {
+    const std::string name = test_segment("untraced");
+    Queue queue;
+    ShmDisseminator<Queue> disseminator(queue, name, 1024);
+    ShmFeedHandler feed_handler(name);
+
+    std::atomic<int> quotes{0};
+    std::atomic<int> traced{0};
+    feed_handler.set_quote_callback([&](const types::Quote&, uint64_t) {
+        if (feed_handler.current_trace() != nullptr) ++traced;
+        ++quotes;
+    });
+    feed_handler.subscribe("AAPL");
+    feed_handler.start();
+    disseminator.start();
+    for (int i = 0; i < 20; ++i) {
+        types::Quote q{};
+        std::strncpy(q.symbol, "AAPL", sizeof(q.symbol) - 1);
+        q.enqueue_timestamp = trace::now_ns();
+        while (!queue.push(q)) std::this_thread::yield();
+    }
+    for (int i = 0; i < 200 && quotes.load() < 20; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    disseminator.stop();
+    feed_handler.stop();
+
+    EXPECT_EQ(quotes.load(), 20);
+    EXPECT_EQ(traced.load(), 0);
+}
+
+// a generator held up by a full queue: the enqueue timestamps of the backlog are taken after the stall, the
+// intended times still follow the schedule
+TEST(TraceTest, IntendedTimeExposesAStalledGenerator) {
+    StallingQueue queue;
+    TraceLog log(trace::all_points, 64);
+    RandomWalkGenerator<StallingQueue> generator(queue);
+    generator.configure(1000, symbols_file());
+    generator.set_trace(&log);
+    generator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.blocked.store(false, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    generator.stop();
+
+    ASSERT_GT(queue.items.size(), 20u);
+    const uint64_t interval = 1'000'000;
+    const types::TraceTrailer& first = log.slot(1);
+    const types::TraceTrailer& tenth = log.slot(10);
+    EXPECT_EQ(trace::at(tenth, TracePoint::Intended) - trace::at(first, TracePoint::Intended), 9 * interval);
+    // the tenth was due 9 ms in but only generated once the first got through after ~50 ms
+    EXPECT_GT(trace::at(tenth, TracePoint::Enqueued) - trace::at(tenth, TracePoint::Intended), 30 * interval);
+    const uint64_t enqueue_ts = std::visit([](const auto& m) { return m.enqueue_timestamp; }, queue.items[9]);
+    EXPECT_LT(trace::at(tenth, TracePoint::Enqueued) - enqueue_ts, 5 * interval);
+}
+
+TEST(TraceTest, MonitorCorrectsAgainstIntendedTime) {
+    LatencyMonitor monitor(4, ::testing::TempDir() + "trace_monitor");
+    for (uint64_t i = 1; i <= 100; ++i) {
+        types::Quote q{};
+        q.sequence = i;
+        q.enqueue_timestamp = 10'000'000 + i * 1'000;
+        types::TraceTrailer t{};
+        t.points = trace::bit(TracePoint::Intended) | trace::bit(TracePoint::PostSend) | trace::bit(TracePoint::Delivered);
+        t.stamps[static_cast<std::size_t>(TracePoint::Intended)] = q.enqueue_timestamp - i * 100; // fell behind by 100 ns per message
+        monitor.on_trace(q, t, q.enqueue_timestamp + 5'000);
+    }
+    monitor.resolve_post_send([](uint64_t sequence) { return sequence == 1 ? uint64_t{10'002'000} : 0; });
+
+    const LatencyMonitor::TraceSummary s = monitor.trace_summary();
+    EXPECT_EQ(s.count, 100u);
+    EXPECT_DOUBLE_EQ(s.uncorrected_us[0], 5.0);
+    EXPECT_DOUBLE_EQ(s.uncorrected_us[2], 5.0);
+    // the backlog grows 100 ns per message, the median message is 5 us behind its schedule
+    EXPECT_DOUBLE_EQ(s.corrected_us[0], 10.0);
+    EXPECT_DOUBLE_EQ(s.corrected_us[2], 14.9);
+
+    monitor.save_to_csv();
+    std::ifstream csv(::testing::TempDir() + "trace_monitor/trace_latencies.csv");
+    std::string header, first;
+    std::getline(csv, header);
+    std::getline(csv, first);
+    EXPECT_EQ(header, "sequence,intended_ns,generated_ns,enqueued_ns,dequeued_ns,pre_send_ns,post_send_ns,received_ns,"
+                      "delivered_ns,corrected_ns,uncorrected_ns");
+    // intended 10'000'900, post send 10'002'000, delivered 10'006'000, enqueued 10'001'000
+    EXPECT_EQ(first, "1,0,,,,,1100,,5100,5100,5000");
+}
@@ -2,6 +2,8 @@
 // Created by paul on 09-Apr-26.
 //
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
 #include "../src/feedhandler/UdpFeedHandler.h"
 
 TEST(UdpFeedHandlerTest, StartsAndStopsCleanly) {
@@ -23,4 +25,49 @@ TEST(UdpFeedHandlerTest, CanSubmitSubscriptionsWithoutCrash) {
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
 
     handler.stop();
-}
\ No newline at end of file
+}
+
+namespace {
+    // template sink: only handles quotes, everything else is dropped at compile time
+    struct QuoteCountingSink {
+        std::atomic<int>* received;
+        std::atomic<bool>* in_place;
+
+        void operator()(const types::Quote& q, uint64_t) {
+            in_place->store(reinterpret_cast<std::uintptr_t>(&q) % BasicUdpFeedHandler<QuoteCountingSink>::payload_alignment == 0);
+            received->fetch_add(1, std::memory_order_release);
+        }
+    };
+}
+
+TEST(UdpFeedHandlerTest, TemplateSinkReceivesAlignedView) {
+    std::atomic<int> received{0};
+    std::atomic<bool> in_place{false};
+    BasicUdpFeedHandler<QuoteCountingSink> handler("239.255.0.1", 55554, QuoteCountingSink{&received, &in_place});
+    handler.subscribe("AAPL");
+    handler.start();
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ASSERT_GE(sock, 0);
+    sockaddr_in dest{};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(55554);
+    inet_pton(AF_INET, "239.255.0.1", &dest.sin_addr);
+
+    types::Quote quote{};
+    std::strncpy(quote.symbol, "AAPL", sizeof(quote.symbol) - 1);
+    std::byte packet[types::topic_header_size + sizeof(types::Quote)];
+    types::Messages::encode_topic(quote, reinterpret_cast<char*>(packet));
+    std::memcpy(packet + types::topic_header_size, &quote, sizeof(quote));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (received.load(std::memory_order_acquire) == 0 && std::chrono::steady_clock::now() < deadline) {
+        sendto(sock, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    close(sock);
+    handler.stop();
+
+    ASSERT_GT(received.load(), 0) << "Timed out waiting for UDP packet.";
+    EXPECT_TRUE(in_place.load());
+}
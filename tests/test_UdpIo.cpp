@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../src/disseminator/UdpDisseminator.h"
+#include "../src/feedhandler/UdpFeedHandler.h"
+#include "../src/utils/CustomSpscQueue.h"
+#include "../src/utils/SpinSpscQueue.h"
+
+namespace {
+    using TestQueue = SpinSpscQueue<types::MarketDataMsg, CustomSpscQueue<types::MarketDataMsg, 1024>>;
+
+    types::Quote make_quote(const char* symbol, uint64_t sequence) {
+        types::Quote q{};
+        std::memcpy(q.symbol, symbol, sizeof(q.symbol));   // callers pass 8 char padded symbols
+        q.bid_price = 100.0 + static_cast<double>(sequence);
+        q.sequence = sequence;
+        return q;
+    }
+}
+
+// loopback multicast round trip through every disseminator/feed handler I/O mode pairing
+class UdpIoModeTest : public ::testing::TestWithParam<UdpIoMode> {
+protected:
+    void SetUp() override {
+        io_.mode = GetParam();
+        io_.batch = 16;
+        io_.ring_entries = 256;
+        port_ = static_cast<uint16_t>(55570 + static_cast<int>(GetParam()));
+        try {
+            feedhandler_ = std::make_unique<UdpFeedHandler>("239.255.0.2", port_, FunctionSink{}, io_);
+            disseminator_ = std::make_unique<UdpDisseminator<TestQueue>>(queue_, "239.255.0.2", port_, io_);
+        } catch (const std::runtime_error& e) {
+            if (GetParam() == UdpIoMode::IoUring) GTEST_SKIP() << "io_uring unavailable: " << e.what();
+            throw;
+        }
+    }
+
+    void TearDown() override {
+        if (disseminator_) disseminator_->stop();
+        if (feedhandler_) feedhandler_->stop();
+    }
+
+    UdpIoOptions io_;
+    uint16_t port_{0};
+    TestQueue queue_;
+    std::unique_ptr<UdpFeedHandler> feedhandler_;
+    std::unique_ptr<UdpDisseminator<TestQueue>> disseminator_;
+};
+
+TEST_P(UdpIoModeTest, DeliversEveryDatagramInOrder) {
+    constexpr uint64_t count = 500;
+    std::vector<uint64_t> received;
+    std::atomic<std::size_t> n{0};
+    feedhandler_->set_quote_callback([&](const types::Quote& q, uint64_t) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(&q) % alignof(types::Quote), 0u);
+        received.push_back(static_cast<uint64_t>(q.bid_price - 100.0));
+        n.store(received.size(), std::memory_order_release);
+    });
+    feedhandler_->subscribe("NVDA    ");
+    feedhandler_->start();
+    disseminator_->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    for (uint64_t i = 0; i < count; ++i) {
+        queue_.push(make_quote("NVDA    ", i));
+        if (i % 64 == 63) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (n.load(std::memory_order_acquire) < count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    disseminator_->stop();
+    feedhandler_->stop();
+
+    ASSERT_EQ(received.size(), count);
+    for (uint64_t i = 0; i < count; ++i) EXPECT_EQ(received[i], i);
+
+    const UdpIoStats tx = disseminator_->io_stats();
+    const UdpIoStats rx = feedhandler_->io_stats();
+    EXPECT_EQ(tx.messages, count);
+    EXPECT_EQ(tx.errors, 0u);
+    EXPECT_GE(rx.messages, count);
+    if (GetParam() == UdpIoMode::Syscall) {
+        EXPECT_GE(tx.syscalls, count);
+    } else {
+        EXPECT_LT(tx.syscalls, count);
+    }
+}
+
+TEST_P(UdpIoModeTest, FiltersWithinABatch) {
+    std::atomic<int> nvda{0};
+    std::atomic<int> other{0};
+    feedhandler_->set_quote_callback([&](const types::Quote& q, uint64_t) {
+        (std::strncmp(q.symbol, "NVDA", 4) == 0 ? nvda : other).fetch_add(1, std::memory_order_relaxed);
+    });
+    feedhandler_->subscribe("NVDA    ");
+    feedhandler_->start();
+    disseminator_->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // interleaved so every batch holds both
+    for (uint64_t i = 0; i < 100; ++i) {
+        queue_.push(make_quote(i % 2 ? "NVDA    " : "AAPL    ", i));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (nvda.load() < 50 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(nvda.load(), 50);
+    EXPECT_EQ(other.load(), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, UdpIoModeTest,
+                         ::testing::Values(UdpIoMode::Syscall, UdpIoMode::Batched, UdpIoMode::IoUring),
+                         [](const auto& info) { return std::string(udp_io_mode_name(info.param)); });
+
+// GSO on the send side, GRO on the receive side, with quotes and the shorter trades interleaved so the GSO runs
+// get cut at every size change
+struct OffloadCase {
+    const char* name;
+    UdpIoMode mode;
+    bool gso;
+    bool gro;
+};
+
+class UdpOffloadTest : public ::testing::TestWithParam<OffloadCase> {};
+
+TEST_P(UdpOffloadTest, SplitsCoalescedRunsBackIntoMessages) {
+    const OffloadCase& c = GetParam();
+    const UdpIoOptions io{.mode = c.mode, .batch = 32, .gso = c.gso, .gro = c.gro};
+    TestQueue queue;
+    UdpFeedHandler feedhandler("239.255.0.3", 55580, FunctionSink{}, io);
+    UdpDisseminator<TestQueue> disseminator(queue, "239.255.0.3", 55580, io);
+
+    std::vector<uint64_t> quotes;
+    std::vector<uint64_t> trades;
+    std::atomic<std::size_t> n{0};
+    feedhandler.set_quote_callback([&](const types::Quote& q, uint64_t) {
+        quotes.push_back(static_cast<uint64_t>(q.bid_price - 100.0));
+        n.fetch_add(1, std::memory_order_release);
+    });
+    feedhandler.set_trade_callback([&](const types::Trade& t, uint64_t) {
+        trades.push_back(t.size);
+        n.fetch_add(1, std::memory_order_release);
+    });
+    feedhandler.subscribe("NVDA    ");
+    feedhandler.start();
+    disseminator.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    constexpr uint64_t count = 600;
+    uint64_t sent_quotes = 0, sent_trades = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (i % 10 == 9) {
+            types::Trade t{};
+            std::memcpy(t.symbol, "NVDA    ", sizeof(t.symbol));
+            t.size = static_cast<uint32_t>(sent_trades++);
+            queue.push(t);
+        } else {
+            queue.push(make_quote("NVDA    ", sent_quotes++));
+        }
+        if (i % 100 == 99) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (n.load(std::memory_order_acquire) < count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    disseminator.stop();
+    feedhandler.stop();
+
+    ASSERT_EQ(quotes.size(), sent_quotes);
+    ASSERT_EQ(trades.size(), sent_trades);
+    for (uint64_t i = 0; i < sent_quotes; ++i) EXPECT_EQ(quotes[i], i);
+    for (uint64_t i = 0; i < sent_trades; ++i) EXPECT_EQ(trades[i], i);
+    if (c.gso) {
+        EXPECT_LT(disseminator.io_stats().syscalls, count / 2);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Offload, UdpOffloadTest,
+                         ::testing::Values(OffloadCase{"gso", UdpIoMode::Syscall, true, false},
+                                           OffloadCase{"gro", UdpIoMode::Syscall, false, true},
+                                           OffloadCase{"gso_gro", UdpIoMode::Syscall, true, true},
+                                           OffloadCase{"batched_gso_gro", UdpIoMode::Batched, true, true}),
+                         [](const auto& info) { return std::string(info.param.name); });
+
+TEST(UdpIoOptionsTest, ParsesModeNames) {
+    EXPECT_EQ(parse_udp_io_mode("syscall"), UdpIoMode::Syscall);
+    EXPECT_EQ(parse_udp_io_mode("batched"), UdpIoMode::Batched);
+    EXPECT_EQ(parse_udp_io_mode("mmsg"), UdpIoMode::Batched);
+    EXPECT_EQ(parse_udp_io_mode("uring"), UdpIoMode::IoUring);
+    EXPECT_EQ(parse_udp_io_mode("io_uring"), UdpIoMode::IoUring);
+    EXPECT_THROW(parse_udp_io_mode("epoll"), std::invalid_argument);
+}
+
+TEST(UdpIoOptionsTest, RejectsEmptyBatch) {
+    TestQueue queue;
+    UdpIoOptions io{.mode = UdpIoMode::Batched, .batch = 0};
+    EXPECT_THROW(UdpDisseminator<TestQueue>(queue, "239.255.0.2", 55579, io), std::invalid_argument);
+    EXPECT_THROW(UdpFeedHandler("239.255.0.2", 55579, FunctionSink{}, io), std::invalid_argument);
+}
+
+TEST(UdpIoOptionsTest, RejectsOffloadWithIoUring) {
+    TestQueue queue;
+    EXPECT_THROW(UdpDisseminator<TestQueue>(queue, "239.255.0.2", 55579, {.mode = UdpIoMode::IoUring, .gso = true}),
+                 std::invalid_argument);
+    EXPECT_THROW(UdpFeedHandler("239.255.0.2", 55579, FunctionSink{}, {.mode = UdpIoMode::IoUring, .gro = true}),
+                 std::invalid_argument);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "../src/disseminator/ZmqBufferPool.h"
+
+TEST(ZmqBufferPoolTest, SlotsFitAnyMessageAndStayAligned) {
+    static_assert(ZmqBufferPool::slot_size >= types::single_frame_header_size + types::max_payload_size);
+    ZmqBufferPool pool(4);
+    void* hint = nullptr;
+    for (int i = 0; i < 4; ++i) {
+        char* buf = pool.acquire(hint);
+        ASSERT_NE(buf, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buf) % 64, 0u);
+        ZmqBufferPool::release(buf, hint);
+    }
+}
+
+TEST(ZmqBufferPoolTest, RingStopsAtSlotsStillInFlight) {
+    ZmqBufferPool pool(3);
+    std::vector<std::pair<char*, void*>> taken;
+    std::set<char*> distinct;
+    for (int i = 0; i < 3; ++i) {
+        void* hint = nullptr;
+        char* buf = pool.acquire(hint);
+        ASSERT_NE(buf, nullptr);
+        taken.emplace_back(buf, hint);
+        distinct.insert(buf);
+    }
+    EXPECT_EQ(distinct.size(), 3u);
+    EXPECT_EQ(pool.in_flight(), 3u);
+
+    void* hint = nullptr;
+    EXPECT_EQ(pool.acquire(hint), nullptr);
+    EXPECT_EQ(pool.exhausted(), 1u);
+
+    // ring order: freeing a later slot doesn't help, the oldest one has to come back first
+    ZmqBufferPool::release(taken[1].first, taken[1].second);
+    EXPECT_EQ(pool.acquire(hint), nullptr);
+
+    ZmqBufferPool::release(taken[0].first, taken[0].second);
+    EXPECT_EQ(pool.acquire(hint), taken[0].first);
+    EXPECT_EQ(pool.acquire(hint), taken[1].first);
+    EXPECT_EQ(pool.exhausted(), 2u);
+}
+
+TEST(ZmqBufferPoolTest, ReleaseFromAnotherThreadHandsTheSlotBack) {
+    ZmqBufferPool pool(1);
+    void* hint = nullptr;
+    char* buf = pool.acquire(hint);
+    ASSERT_NE(buf, nullptr);
+    buf[0] = 'x';
+
+    // zmq frees from its io thread
+    std::thread io([buf, hint] { ZmqBufferPool::release(buf, hint); });
+    io.join();
+
+    void* again = nullptr;
+    EXPECT_EQ(pool.acquire(again), buf);
+    EXPECT_EQ(again, hint);
+    EXPECT_EQ(pool.in_flight(), 1u);
+}
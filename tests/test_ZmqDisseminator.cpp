@@ -93,4 +93,15 @@ TEST_F(ZmqDisseminatorUnitTest, HandlesEmptyQueues) {
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
     EXPECT_NO_THROW(disseminator_.stop());
     EXPECT_EQ(disseminator_.messages_sent.load(), 0);
-}
\ No newline at end of file
+}
+
+TEST(ZmqDisseminatorEndpointsTest, SplitsCommaSeparatedEndpoints) {
+    using Storage = boost::lockfree::spsc_queue<types::MarketDataMsg, boost::lockfree::capacity<16>>;
+    using Disseminator = ZmqDisseminator<WaitableSpscQueue<types::MarketDataMsg, Storage>>;
+
+    EXPECT_EQ(Disseminator::split_endpoints("tcp://127.0.0.1:5555"), std::vector<std::string>{"tcp://127.0.0.1:5555"});
+    EXPECT_EQ(Disseminator::split_endpoints("ipc:///tmp/a.ipc,,inproc://md,"),
+              (std::vector<std::string>{"ipc:///tmp/a.ipc", "inproc://md"}));
+    EXPECT_THROW(Disseminator::split_endpoints(""), std::invalid_argument);
+    EXPECT_THROW(Disseminator::split_endpoints(","), std::invalid_argument);
+}
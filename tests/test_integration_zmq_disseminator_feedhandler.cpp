@@ -4,6 +4,8 @@
 #include <atomic>
 #include <memory>
 #include <cstring>
+#include <algorithm>
+#include <vector>
 #include <boost/lockfree/spsc_queue.hpp>
 
 #include "../src/disseminator/ZmqDisseminator.h"
@@ -90,4 +92,98 @@ TEST_F(IntegrationTest, NativeZmqFilteringDropsUnwantedData) {
     std::this_thread::sleep_for(std::chrono::milliseconds(200));
 
     EXPECT_EQ(messages_received.load(), 0);
-}
\ No newline at end of file
+}
+
+TEST(ZmqFramingTest, EveryModeDeliversAndKeepsPrefixFiltering) {
+    using Storage = boost::lockfree::spsc_queue<types::MarketDataMsg, boost::lockfree::capacity<1024>>;
+    using TestQueue = WaitableSpscQueue<types::MarketDataMsg, Storage>;
+
+    const ZmqPublishOptions modes[] = {
+        {.single_frame = false, .zero_copy = true, .pool_slots = 16},
+        {.single_frame = true, .zero_copy = false},
+        {.single_frame = true, .zero_copy = true, .pool_slots = 16},
+    };
+    int port = 5580;
+    for (const ZmqPublishOptions& mode : modes) {
+        SCOPED_TRACE(std::string(mode.single_frame ? "single frame" : "two frames") + (mode.zero_copy ? ", zero copy" : ""));
+        const std::string addr = "tcp://127.0.0.1:" + std::to_string(port++);
+
+        TestQueue queue;
+        ZmqDisseminator<TestQueue> disseminator(queue, addr, mode);
+        disseminator.start();
+        ZmqFeedHandler feed_handler(addr);
+
+        std::atomic<int> received{0};
+        std::atomic<double> bid{0.0};
+        std::atomic<bool> other_symbol{false};
+        feed_handler.set_quote_callback([&](const types::Quote& q, int64_t) {
+            if (std::string_view(q.symbol, 4) != "AAPL") other_symbol = true;
+            bid = q.bid_price;
+            received++;
+        });
+        feed_handler.subscribe("AAPL");
+        feed_handler.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        // more than the pool holds, so zero copy wraps around the ring
+        for (int i = 0; i < 40; ++i) {
+            types::Quote q{};
+            std::strncpy(q.symbol, i % 2 ? "MSFT" : "AAPL", sizeof(q.symbol) - 1);
+            q.bid_price = 100.0 + i;
+            while (!queue.push(q)) std::this_thread::yield();
+        }
+
+        for (int i = 0; i < 100 && received.load() < 20; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        feed_handler.stop();
+        disseminator.stop();
+
+        EXPECT_EQ(received.load(), 20);
+        EXPECT_FALSE(other_symbol.load());
+        EXPECT_DOUBLE_EQ(bid.load(), 138.0);
+    }
+}
+
+TEST(ZmqTransportTest, EverySubscriberGetsTheStreamOverIpcAndInproc) {
+    using Storage = boost::lockfree::spsc_queue<types::MarketDataMsg, boost::lockfree::capacity<1024>>;
+    using TestQueue = WaitableSpscQueue<types::MarketDataMsg, Storage>;
+
+    // one PUB bound twice, subscribers alternate between the two endpoints
+    zmq::context_t shared(2);
+    const std::string ipc = "ipc:///tmp/mdds_test_zmq_transport.ipc";
+    const std::string inproc = "inproc://mdds_test_zmq_transport";
+    TestQueue queue;
+    ZmqDisseminator<TestQueue> disseminator(queue, ipc + "," + inproc, {.context = &shared, .sndhwm = 0});
+    disseminator.start();
+
+    constexpr int subscribers = 4;
+    std::vector<std::unique_ptr<ZmqFeedHandler>> handlers;
+    std::vector<std::unique_ptr<std::atomic<int>>> counts;
+    for (int i = 0; i < subscribers; ++i) {
+        auto& count = counts.emplace_back(std::make_unique<std::atomic<int>>(0));
+        auto& fh = handlers.emplace_back(std::make_unique<ZmqFeedHandler>(i % 2 ? inproc : ipc, FunctionSink{},
+                                                                          ZmqSubscribeOptions{.context = &shared, .rcvhwm = 0}));
+        fh->set_quote_callback([c = count.get()](const types::Quote&, uint64_t) { (*c)++; });
+        fh->subscribe("AAPL");
+        fh->start();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    constexpr int messages = 100;
+    for (int i = 0; i < messages; ++i) {
+        types::Quote q{};
+        std::strncpy(q.symbol, "AAPL", sizeof(q.symbol) - 1);
+        while (!queue.push(q)) std::this_thread::yield();
+    }
+    for (int i = 0; i < 100; ++i) {
+        if (std::ranges::all_of(counts, [](const auto& c) { return c->load() == messages; })) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (auto& fh : handlers) fh->stop();
+    disseminator.stop();
+    for (int i = 0; i < subscribers; ++i) {
+        EXPECT_EQ(counts[i]->load(), messages) << "subscriber " << i;
+    }
+}